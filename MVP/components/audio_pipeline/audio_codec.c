@@ -0,0 +1,703 @@
+#include "audio_codec.h"
+
+#include <string.h>
+
+// ---------------------------------------------------------------------------
+// Shared helpers
+
+static inline void put_le16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+const char *audio_codec_name(audio_codec_t codec) {
+  switch (codec) {
+    case AUDIO_CODEC_IMA_ADPCM:
+      return "ima-adpcm";
+    case AUDIO_CODEC_FLAC:
+      return "flac";
+    case AUDIO_CODEC_PCM:
+    default:
+      return "pcm";
+  }
+}
+
+const char *audio_codec_extension(audio_codec_t codec) {
+  return codec == AUDIO_CODEC_FLAC ? "flac" : "wav";
+}
+
+size_t audio_codec_block_samples(audio_codec_t codec) {
+  switch (codec) {
+    case AUDIO_CODEC_IMA_ADPCM:
+      return IMA_ADPCM_BLOCK_SAMPLES;
+    case AUDIO_CODEC_FLAC:
+      return FLAC_BLOCK_SAMPLES;
+    case AUDIO_CODEC_PCM:
+    default:
+      return 1;
+  }
+}
+
+size_t audio_codec_header_bytes(audio_codec_t codec) {
+  switch (codec) {
+    case AUDIO_CODEC_IMA_ADPCM:
+      return IMA_ADPCM_HEADER_BYTES;
+    case AUDIO_CODEC_FLAC:
+      return FLAC_HEADER_BYTES;
+    case AUDIO_CODEC_PCM:
+    default:
+      return 44;
+  }
+}
+
+size_t audio_codec_max_block_bytes(audio_codec_t codec) {
+  switch (codec) {
+    case AUDIO_CODEC_IMA_ADPCM:
+      return IMA_ADPCM_BLOCK_BYTES;
+    case AUDIO_CODEC_FLAC:
+      return FLAC_MAX_FRAME_BYTES(FLAC_BLOCK_SAMPLES);
+    case AUDIO_CODEC_PCM:
+    default:
+      return 2;
+  }
+}
+
+size_t audio_codec_build_header(audio_codec_t codec, uint8_t *out, uint32_t sample_rate, uint32_t total_samples,
+                                uint32_t data_bytes, uint32_t min_frame_bytes, uint32_t max_frame_bytes) {
+  if (codec == AUDIO_CODEC_IMA_ADPCM) {
+    // RIFF/WAVE with the 20-byte IMA fmt chunk and a fact chunk carrying
+    // the true sample count (the last block is padded).
+    memcpy(out + 0, "RIFF", 4);
+    put_le32(out + 4, IMA_ADPCM_HEADER_BYTES - 8U + data_bytes);
+    memcpy(out + 8, "WAVE", 4);
+    memcpy(out + 12, "fmt ", 4);
+    put_le32(out + 16, 20U);
+    put_le16(out + 20, 0x0011U);
+    put_le16(out + 22, 1U);
+    put_le32(out + 24, sample_rate);
+    put_le32(out + 28, sample_rate * IMA_ADPCM_BLOCK_BYTES / IMA_ADPCM_BLOCK_SAMPLES);
+    put_le16(out + 32, IMA_ADPCM_BLOCK_BYTES);
+    put_le16(out + 34, 4U);
+    put_le16(out + 36, 2U);
+    put_le16(out + 38, IMA_ADPCM_BLOCK_SAMPLES);
+    memcpy(out + 40, "fact", 4);
+    put_le32(out + 44, 4U);
+    put_le32(out + 48, total_samples);
+    memcpy(out + 52, "data", 4);
+    put_le32(out + 56, data_bytes);
+    return IMA_ADPCM_HEADER_BYTES;
+  }
+
+  if (codec == AUDIO_CODEC_FLAC) {
+    // "fLaC", then a single (last) STREAMINFO block. MD5 is left unset.
+    memset(out, 0, FLAC_HEADER_BYTES);
+    memcpy(out, "fLaC", 4);
+    out[4] = 0x80;
+    out[7] = 34;
+    uint8_t *si = out + 8;
+    si[0] = (uint8_t)(FLAC_BLOCK_SAMPLES >> 8);
+    si[1] = (uint8_t)FLAC_BLOCK_SAMPLES;
+    si[2] = (uint8_t)(FLAC_BLOCK_SAMPLES >> 8);
+    si[3] = (uint8_t)FLAC_BLOCK_SAMPLES;
+    si[4] = (uint8_t)(min_frame_bytes >> 16);
+    si[5] = (uint8_t)(min_frame_bytes >> 8);
+    si[6] = (uint8_t)min_frame_bytes;
+    si[7] = (uint8_t)(max_frame_bytes >> 16);
+    si[8] = (uint8_t)(max_frame_bytes >> 8);
+    si[9] = (uint8_t)max_frame_bytes;
+    // 20-bit rate, 3-bit channels-1 (0), 5-bit bps-1 (15), 36-bit samples.
+    uint64_t packed = ((uint64_t)(sample_rate & 0xFFFFFU) << 44) | (0ULL << 41) | (15ULL << 36) |
+                      (uint64_t)total_samples;
+    for (int i = 0; i < 8; i++) {
+      si[10 + i] = (uint8_t)(packed >> (56 - 8 * i));
+    }
+    return FLAC_HEADER_BYTES;
+  }
+  return 0;
+}
+
+// ---------------------------------------------------------------------------
+// IMA-ADPCM
+
+static const int16_t s_ima_step[89] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t s_ima_index[16] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+typedef struct {
+  int32_t predictor;
+  int32_t index;
+} ima_state_t;
+
+static inline int32_t clamp16(int32_t v) {
+  return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v);
+}
+
+static inline void ima_apply(ima_state_t *st, uint8_t nibble) {
+  int32_t step = s_ima_step[st->index];
+  int32_t diff = step >> 3;
+  if (nibble & 4) {
+    diff += step;
+  }
+  if (nibble & 2) {
+    diff += step >> 1;
+  }
+  if (nibble & 1) {
+    diff += step >> 2;
+  }
+  st->predictor = clamp16((nibble & 8) ? st->predictor - diff : st->predictor + diff);
+  st->index += s_ima_index[nibble];
+  st->index = st->index < 0 ? 0 : (st->index > 88 ? 88 : st->index);
+}
+
+static inline uint8_t ima_encode_sample(ima_state_t *st, int32_t sample) {
+  int32_t step = s_ima_step[st->index];
+  int32_t diff = sample - st->predictor;
+  uint8_t nibble = 0;
+  if (diff < 0) {
+    nibble = 8;
+    diff = -diff;
+  }
+  if (diff >= step) {
+    nibble |= 4;
+    diff -= step;
+  }
+  if (diff >= (step >> 1)) {
+    nibble |= 2;
+    diff -= step >> 1;
+  }
+  if (diff >= (step >> 2)) {
+    nibble |= 1;
+  }
+  // Update through the decoder's arithmetic so both sides stay in lockstep.
+  ima_apply(st, nibble);
+  return nibble;
+}
+
+size_t ima_adpcm_encode_block(uint8_t *step_index, const int16_t *pcm, size_t count, uint8_t *out, int16_t *recon) {
+  if (count == 0) {
+    return 0;
+  }
+  if (count > IMA_ADPCM_BLOCK_SAMPLES) {
+    count = IMA_ADPCM_BLOCK_SAMPLES;
+  }
+
+  ima_state_t st = {.predictor = pcm[0], .index = *step_index > 88 ? 88 : *step_index};
+  put_le16(out, (uint16_t)pcm[0]);
+  out[2] = (uint8_t)st.index;
+  out[3] = 0;
+  if (recon) {
+    recon[0] = pcm[0];
+  }
+
+  int16_t pad = pcm[count - 1];
+  uint8_t *dst = out + 4;
+  for (size_t i = 1; i < IMA_ADPCM_BLOCK_SAMPLES; i += 2) {
+    int32_t a = i < count ? pcm[i] : pad;
+    uint8_t lo = ima_encode_sample(&st, a);
+    if (recon && i < count) {
+      recon[i] = (int16_t)st.predictor;
+    }
+    int32_t b = i + 1 < count ? pcm[i + 1] : pad;
+    uint8_t hi = ima_encode_sample(&st, b);
+    if (recon && i + 1 < count) {
+      recon[i + 1] = (int16_t)st.predictor;
+    }
+    *dst++ = (uint8_t)(lo | (hi << 4));
+  }
+  *step_index = (uint8_t)st.index;
+  return IMA_ADPCM_BLOCK_BYTES;
+}
+
+size_t ima_adpcm_decode_block(const uint8_t *in, size_t len, int16_t *out) {
+  if (len < 4) {
+    return 0;
+  }
+  ima_state_t st = {.predictor = (int16_t)(in[0] | (in[1] << 8)), .index = in[2] > 88 ? 88 : in[2]};
+  size_t n = 0;
+  out[n++] = (int16_t)st.predictor;
+  for (size_t i = 4; i < len; i++) {
+    ima_apply(&st, in[i] & 0x0F);
+    out[n++] = (int16_t)st.predictor;
+    ima_apply(&st, in[i] >> 4);
+    out[n++] = (int16_t)st.predictor;
+  }
+  return n;
+}
+
+// ---------------------------------------------------------------------------
+// FLAC
+
+#define FLAC_MAX_FIXED_ORDER     4
+#define FLAC_MAX_PARTITION_ORDER 6
+#define FLAC_MAX_RICE_PARAM      14
+
+typedef struct {
+  uint8_t *out;
+  size_t pos;
+  uint64_t acc;
+  uint32_t bits;
+} bit_writer_t;
+
+static inline void bw_put(bit_writer_t *w, uint32_t value, uint32_t nbits) {
+  if (nbits == 0) {
+    return;
+  }
+  w->acc = (w->acc << nbits) | (nbits == 32 ? value : (value & ((1U << nbits) - 1U)));
+  w->bits += nbits;
+  while (w->bits >= 8) {
+    w->bits -= 8;
+    w->out[w->pos++] = (uint8_t)(w->acc >> w->bits);
+  }
+}
+
+static inline void bw_align(bit_writer_t *w) {
+  if (w->bits) {
+    bw_put(w, 0, 8 - w->bits);
+  }
+}
+
+static inline void bw_rice(bit_writer_t *w, uint32_t u, uint32_t k) {
+  uint32_t q = u >> k;
+  if (q + 1U + k <= 32U) {
+    bw_put(w, (1U << k) | (u & ((1U << k) - 1U)), q + 1U + k);
+    return;
+  }
+  while (q >= 32U) {
+    bw_put(w, 0, 32);
+    q -= 32U;
+  }
+  bw_put(w, 1, q + 1U);
+  bw_put(w, u, k);
+}
+
+static uint8_t crc8(const uint8_t *p, size_t len) {
+  uint8_t crc = 0;
+  while (len--) {
+    crc ^= *p++;
+    for (int i = 0; i < 8; i++) {
+      crc = (uint8_t)((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+    }
+  }
+  return crc;
+}
+
+static uint16_t crc16(const uint8_t *p, size_t len) {
+  uint16_t crc = 0;
+  while (len--) {
+    crc ^= (uint16_t)(*p++ << 8);
+    for (int i = 0; i < 8; i++) {
+      crc = (uint16_t)((crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1);
+    }
+  }
+  return crc;
+}
+
+static uint8_t flac_rate_code(uint32_t rate) {
+  switch (rate) {
+    case 8000:
+      return 4;
+    case 16000:
+      return 5;
+    case 22050:
+      return 6;
+    case 24000:
+      return 7;
+    case 32000:
+      return 8;
+    case 44100:
+      return 9;
+    case 48000:
+      return 10;
+    default:
+      return 0;  // take it from STREAMINFO
+  }
+}
+
+static inline int32_t fixed_residual(const int16_t *x, size_t i, int order) {
+  switch (order) {
+    case 0:
+      return x[i];
+    case 1:
+      return x[i] - x[i - 1];
+    case 2:
+      return x[i] - 2 * x[i - 1] + x[i - 2];
+    case 3:
+      return x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];
+    default:
+      return x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4];
+  }
+}
+
+static inline uint32_t zigzag(int32_t r) {
+  return ((uint32_t)r << 1) ^ (uint32_t)(r >> 31);
+}
+
+// Bits for n zigzagged residuals summing to sum with Rice parameter k.
+static inline uint64_t rice_bits(uint64_t sum, uint32_t n, uint32_t k) {
+  return (uint64_t)n * (k + 1U) + (sum >> k);
+}
+
+static uint32_t best_rice_param(uint64_t sum, uint32_t n, uint64_t *bits) {
+  uint32_t k = 0;
+  while (k < FLAC_MAX_RICE_PARAM && ((uint64_t)n << (k + 1)) < sum) {
+    k++;
+  }
+  uint64_t best = rice_bits(sum, n, k);
+  if (k > 0 && rice_bits(sum, n, k - 1) < best) {
+    k--;
+    best = rice_bits(sum, n, k);
+  }
+  *bits = best;
+  return k;
+}
+
+// Picks the Rice partition order and parameters with the fewest estimated
+// bits: sums are taken once at the finest order and merged pairwise upward.
+static uint32_t choose_partitions(const uint32_t *u, size_t count, int order, uint32_t *params, uint64_t *bits_out) {
+  uint32_t max_porder = 0;
+  while (max_porder < FLAC_MAX_PARTITION_ORDER && (count % (2U << max_porder)) == 0 &&
+         (count >> (max_porder + 1)) > (size_t)order) {
+    max_porder++;
+  }
+
+  uint64_t sums[1U << FLAC_MAX_PARTITION_ORDER];
+  uint32_t parts = 1U << max_porder;
+  size_t psize = count >> max_porder;
+  for (uint32_t p = 0; p < parts; p++) {
+    size_t start = p == 0 ? (size_t)order : p * psize;
+    uint64_t s = 0;
+    for (size_t i = start; i < (p + 1) * psize; i++) {
+      s += u[i];
+    }
+    sums[p] = s;
+  }
+
+  uint64_t best_bits = UINT64_MAX;
+  uint32_t best_porder = 0;
+  uint32_t trial[1U << FLAC_MAX_PARTITION_ORDER];
+  for (int32_t po = (int32_t)max_porder; po >= 0; po--) {
+    uint32_t n_parts = 1U << po;
+    size_t n = count >> po;
+    uint64_t total = 6;  // coding method and partition order fields
+    for (uint32_t p = 0; p < n_parts; p++) {
+      uint64_t b;
+      trial[p] = best_rice_param(sums[p], (uint32_t)(p == 0 ? n - (size_t)order : n), &b);
+      total += 4 + b;
+    }
+    if (total < best_bits) {
+      best_bits = total;
+      best_porder = (uint32_t)po;
+      memcpy(params, trial, n_parts * sizeof(uint32_t));
+    }
+    // Merge neighbours for the next (coarser) order.
+    for (uint32_t p = 0; p < n_parts / 2; p++) {
+      sums[p] = sums[2 * p] + sums[2 * p + 1];
+    }
+  }
+  *bits_out = best_bits;
+  return best_porder;
+}
+
+static void put_utf8(bit_writer_t *w, uint32_t v) {
+  if (v < 0x80) {
+    bw_put(w, v, 8);
+    return;
+  }
+  int extra = v < 0x800 ? 1 : v < 0x10000 ? 2 : v < 0x200000 ? 3 : v < 0x4000000 ? 4 : 5;
+  uint32_t lead_mask = (0xFF00U >> (extra + 1)) & 0xFFU;
+  bw_put(w, lead_mask | (v >> (6 * extra)), 8);
+  for (int i = extra - 1; i >= 0; i--) {
+    bw_put(w, 0x80U | ((v >> (6 * i)) & 0x3FU), 8);
+  }
+}
+
+size_t flac_encode_frame(const int16_t *pcm, size_t count, uint32_t frame_number, uint32_t sample_rate,
+                         uint32_t *scratch, uint8_t *out) {
+  if (count == 0 || count > 65536) {
+    return 0;
+  }
+
+  bit_writer_t w = {.out = out};
+
+  // Frame header.
+  uint8_t bs_code = count == FLAC_BLOCK_SAMPLES ? 12 : 7;
+  uint8_t sr_code = flac_rate_code(sample_rate);
+  bw_put(&w, 0xFFF8, 16);
+  bw_put(&w, bs_code, 4);
+  bw_put(&w, sr_code, 4);
+  bw_put(&w, 0, 4);  // mono
+  bw_put(&w, 4, 3);  // 16 bits per sample
+  bw_put(&w, 0, 1);
+  put_utf8(&w, frame_number);
+  if (bs_code == 7) {
+    bw_put(&w, (uint32_t)(count - 1), 16);
+  }
+  bw_put(&w, crc8(out, w.pos), 8);
+
+  bool constant = true;
+  for (size_t i = 1; i < count && constant; i++) {
+    constant = pcm[i] == pcm[0];
+  }
+
+  if (constant) {
+    bw_put(&w, 0x00, 8);  // pad, type 000000, no wasted bits
+    bw_put(&w, (uint16_t)pcm[0], 16);
+  } else {
+    // Pick the fixed predictor with the smallest absolute residual sum.
+    int order = 0;
+    if (count > FLAC_MAX_FIXED_ORDER) {
+      uint64_t err[FLAC_MAX_FIXED_ORDER + 1] = {0};
+      for (size_t i = FLAC_MAX_FIXED_ORDER; i < count; i++) {
+        int32_t e0 = pcm[i];
+        int32_t e1 = e0 - pcm[i - 1];
+        int32_t e2 = e1 - (pcm[i - 1] - pcm[i - 2]);
+        int32_t e3 = e2 - (pcm[i - 1] - 2 * pcm[i - 2] + pcm[i - 3]);
+        int32_t e4 = e3 - (pcm[i - 1] - 3 * pcm[i - 2] + 3 * pcm[i - 3] - pcm[i - 4]);
+        err[0] += (uint32_t)(e0 < 0 ? -e0 : e0);
+        err[1] += (uint32_t)(e1 < 0 ? -e1 : e1);
+        err[2] += (uint32_t)(e2 < 0 ? -e2 : e2);
+        err[3] += (uint32_t)(e3 < 0 ? -e3 : e3);
+        err[4] += (uint32_t)(e4 < 0 ? -e4 : e4);
+      }
+      for (int o = 1; o <= FLAC_MAX_FIXED_ORDER; o++) {
+        if (err[o] < err[order]) {
+          order = o;
+        }
+      }
+    }
+
+    for (size_t i = (size_t)order; i < count; i++) {
+      scratch[i] = zigzag(fixed_residual(pcm, i, order));
+    }
+    uint32_t params[1U << FLAC_MAX_PARTITION_ORDER];
+    uint64_t residual_bits = 0;
+    uint32_t porder = choose_partitions(scratch, count, order, params, &residual_bits);
+
+    if (residual_bits + 16U * (uint64_t)order >= 16U * (uint64_t)count) {
+      bw_put(&w, 0x02, 8);  // verbatim
+      for (size_t i = 0; i < count; i++) {
+        bw_put(&w, (uint16_t)pcm[i], 16);
+      }
+    } else {
+      bw_put(&w, (uint32_t)(0x10 | (order << 1)), 8);  // pad, 001ooo, no wasted bits
+      for (int i = 0; i < order; i++) {
+        bw_put(&w, (uint16_t)pcm[i], 16);
+      }
+      bw_put(&w, 0, 2);  // Rice, 4-bit parameters
+      bw_put(&w, porder, 4);
+      uint32_t n_parts = 1U << porder;
+      size_t psize = count >> porder;
+      for (uint32_t p = 0; p < n_parts; p++) {
+        uint32_t k = params[p];
+        bw_put(&w, k, 4);
+        size_t start = p == 0 ? (size_t)order : p * psize;
+        for (size_t i = start; i < (p + 1) * psize; i++) {
+          bw_rice(&w, scratch[i], k);
+        }
+      }
+    }
+  }
+
+  bw_align(&w);
+  uint16_t crc = crc16(out, w.pos);
+  bw_put(&w, crc, 16);
+  return w.pos;
+}
+
+// ---------------------------------------------------------------------------
+// FLAC decoder (subset emitted above)
+
+typedef struct {
+  const uint8_t *in;
+  size_t len;
+  size_t bitpos;
+  bool overrun;
+} bit_reader_t;
+
+static inline uint32_t br_get(bit_reader_t *r, uint32_t nbits) {
+  uint32_t v = 0;
+  for (uint32_t i = 0; i < nbits; i++) {
+    size_t byte = r->bitpos >> 3;
+    if (byte >= r->len) {
+      r->overrun = true;
+      return 0;
+    }
+    v = (v << 1) | ((r->in[byte] >> (7 - (r->bitpos & 7))) & 1U);
+    r->bitpos++;
+  }
+  return v;
+}
+
+static inline int32_t br_get_signed(bit_reader_t *r, uint32_t nbits) {
+  uint32_t v = br_get(r, nbits);
+  return (int32_t)(v << (32 - nbits)) >> (32 - nbits);
+}
+
+static inline uint32_t br_rice(bit_reader_t *r, uint32_t k) {
+  uint32_t q = 0;
+  while (!r->overrun && br_get(r, 1) == 0) {
+    q++;
+  }
+  return (q << k) | br_get(r, k);
+}
+
+static bool br_utf8(bit_reader_t *r, uint32_t *out) {
+  uint32_t b = br_get(r, 8);
+  int extra = 0;
+  if (b & 0x80) {
+    while (b & (0x40U >> extra)) {
+      extra++;
+    }
+    if (extra == 0 || extra > 5) {
+      return false;
+    }
+    b &= 0x3FU >> extra;
+  }
+  for (int i = 0; i < extra; i++) {
+    uint32_t c = br_get(r, 8);
+    if ((c & 0xC0) != 0x80) {
+      return false;
+    }
+    b = (b << 6) | (c & 0x3F);
+  }
+  *out = b;
+  return !r->overrun;
+}
+
+size_t flac_decode_frame(const uint8_t *in, size_t len, int16_t *out, size_t out_cap, size_t *samples) {
+  bit_reader_t r = {.in = in, .len = len};
+  if (br_get(&r, 15) != 0x7FFC || br_get(&r, 1) != 0) {
+    return 0;
+  }
+  uint32_t bs_code = br_get(&r, 4);
+  uint32_t sr_code = br_get(&r, 4);
+  uint32_t channels = br_get(&r, 4);
+  uint32_t ss_code = br_get(&r, 3);
+  br_get(&r, 1);
+  uint32_t frame_number = 0;
+  if (channels != 0 || (ss_code != 4 && ss_code != 0) || !br_utf8(&r, &frame_number)) {
+    return 0;
+  }
+
+  size_t count = 0;
+  if (bs_code == 1) {
+    count = 192;
+  } else if (bs_code >= 2 && bs_code <= 5) {
+    count = 576U << (bs_code - 2);
+  } else if (bs_code == 6) {
+    count = br_get(&r, 8) + 1U;
+  } else if (bs_code == 7) {
+    count = br_get(&r, 16) + 1U;
+  } else if (bs_code >= 8) {
+    count = 256U << (bs_code - 8);
+  } else {
+    return 0;
+  }
+  if (sr_code == 12) {
+    br_get(&r, 8);
+  } else if (sr_code == 13 || sr_code == 14) {
+    br_get(&r, 16);
+  } else if (sr_code == 15) {
+    return 0;
+  }
+  size_t hdr_bytes = r.bitpos >> 3;
+  if (r.overrun || br_get(&r, 8) != crc8(in, hdr_bytes) || count > out_cap) {
+    return 0;
+  }
+
+  if (br_get(&r, 1) != 0) {
+    return 0;
+  }
+  uint32_t type = br_get(&r, 6);
+  if (br_get(&r, 1) != 0) {
+    return 0;  // wasted bits are never emitted
+  }
+
+  if (type == 0) {
+    int16_t v = (int16_t)br_get_signed(&r, 16);
+    for (size_t i = 0; i < count; i++) {
+      out[i] = v;
+    }
+  } else if (type == 1) {
+    for (size_t i = 0; i < count; i++) {
+      out[i] = (int16_t)br_get_signed(&r, 16);
+    }
+  } else if (type >= 8 && type <= 12) {
+    int order = (int)(type & 7U);
+    for (int i = 0; i < order; i++) {
+      out[i] = (int16_t)br_get_signed(&r, 16);
+    }
+    uint32_t method = br_get(&r, 2);
+    if (method > 1) {
+      return 0;
+    }
+    uint32_t param_bits = method == 0 ? 4 : 5;
+    uint32_t escape = method == 0 ? 15 : 31;
+    uint32_t porder = br_get(&r, 4);
+    uint32_t n_parts = 1U << porder;
+    size_t psize = count >> porder;
+    size_t i = (size_t)order;
+    for (uint32_t p = 0; p < n_parts && !r.overrun; p++) {
+      uint32_t k = br_get(&r, param_bits);
+      size_t end = (p + 1) * psize;
+      for (; i < end && !r.overrun; i++) {
+        int32_t res;
+        if (k == escape) {
+          uint32_t raw = br_get(&r, 5);
+          res = raw ? br_get_signed(&r, raw) : 0;
+        } else {
+          uint32_t u = br_rice(&r, k);
+          res = (int32_t)(u >> 1) ^ -(int32_t)(u & 1U);
+        }
+        int32_t pred = 0;
+        switch (order) {
+          case 1:
+            pred = out[i - 1];
+            break;
+          case 2:
+            pred = 2 * out[i - 1] - out[i - 2];
+            break;
+          case 3:
+            pred = 3 * out[i - 1] - 3 * out[i - 2] + out[i - 3];
+            break;
+          case 4:
+            pred = 4 * out[i - 1] - 6 * out[i - 2] + 4 * out[i - 3] - out[i - 4];
+            break;
+          default:
+            break;
+        }
+        out[i] = (int16_t)(pred + res);
+      }
+    }
+  } else {
+    return 0;
+  }
+
+  if (r.bitpos & 7U) {
+    r.bitpos += 8U - (r.bitpos & 7U);
+  }
+  size_t body = r.bitpos >> 3;
+  if (r.overrun || body + 2 > len) {
+    return 0;
+  }
+  uint16_t crc = (uint16_t)((in[body] << 8) | in[body + 1]);
+  if (crc != crc16(in, body)) {
+    return 0;
+  }
+  *samples = count;
+  return body + 2;
+}
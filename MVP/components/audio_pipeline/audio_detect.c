@@ -0,0 +1,145 @@
+#include "audio_detect.h"
+
+#include <string.h>
+
+void audio_detect_default_config(audio_detect_config_t *cfg) {
+  if (!cfg) {
+    return;
+  }
+  cfg->trigger_snr_q8 = 10U * AUDIO_DETECT_Q8_ONE;  // +10 dB
+  cfg->release_snr_q8 = 643U;                       // +4 dB
+  cfg->hold_frames = 8;                             // ~256 ms of 512-sample frames at 16 kHz
+  cfg->warmup_frames = 8;
+  cfg->floor_rise_shift = 6;
+  cfg->floor_fall_shift = 2;
+  cfg->min_floor_ms = 50U * 50U;
+}
+
+void audio_detect_init(audio_detect_t *det, const audio_detect_config_t *cfg) {
+  if (!det) {
+    return;
+  }
+  memset(det, 0, sizeof(*det));
+  if (cfg) {
+    det->cfg = *cfg;
+  } else {
+    audio_detect_default_config(&det->cfg);
+  }
+}
+
+void audio_detect_reset(audio_detect_t *det) {
+  if (!det) {
+    return;
+  }
+  det->floor_ms = 0;
+  det->frames = 0;
+  det->quiet_frames = 0;
+  det->active = false;
+}
+
+uint32_t audio_detect_isqrt(uint64_t v) {
+  uint64_t res = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > v) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (v >= res + bit) {
+      v -= res + bit;
+      res = (res >> 1) + bit;
+    } else {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)res;
+}
+
+static inline uint32_t ema_step(uint32_t avg, uint32_t x, uint8_t shift) {
+  if (x >= avg) {
+    return avg + ((x - avg) >> shift);
+  }
+  return avg - ((avg - x) >> shift);
+}
+
+bool audio_detect_process(audio_detect_t *det, const int16_t *pcm, size_t count, audio_detect_frame_t *out) {
+  if (!det || !pcm || count == 0) {
+    return false;
+  }
+
+  int32_t sum = 0;
+  uint64_t sumsq = 0;
+  int32_t lo = INT16_MAX;
+  int32_t hi = INT16_MIN;
+  size_t i = 0;
+
+  // Two squares fit in 32 bits, so the 64-bit accumulate runs once per pair.
+  for (; i + 1 < count; i += 2) {
+    int32_t a = pcm[i];
+    int32_t b = pcm[i + 1];
+    sum += a + b;
+    sumsq += (uint32_t)(a * a) + (uint32_t)(b * b);
+    lo = a < lo ? a : lo;
+    hi = a > hi ? a : hi;
+    lo = b < lo ? b : lo;
+    hi = b > hi ? b : hi;
+  }
+  if (i < count) {
+    int32_t a = pcm[i];
+    sum += a;
+    sumsq += (uint32_t)(a * a);
+    lo = a < lo ? a : lo;
+    hi = a > hi ? a : hi;
+  }
+
+  // Variance rather than raw mean square: the SPH0645 carries a DC offset
+  // that would otherwise read as constant signal energy.
+  int64_t n = (int64_t)count;
+  int64_t centered = (int64_t)sumsq - ((int64_t)sum * sum) / n;
+  uint32_t ms = centered > 0 ? (uint32_t)(centered / n) : 0;
+  int32_t mean = sum / (int32_t)count;
+  uint32_t peak = (uint32_t)((hi - mean) > (mean - lo) ? (hi - mean) : (mean - lo));
+
+  bool onset = false;
+  uint32_t snr_q8 = AUDIO_DETECT_Q8_ONE;
+  if (det->frames < det->cfg.warmup_frames) {
+    det->floor_ms = det->frames == 0 ? ms : ema_step(det->floor_ms, ms, 1);
+    det->frames++;
+  } else {
+    uint32_t floor_ms = det->floor_ms > det->cfg.min_floor_ms ? det->floor_ms : det->cfg.min_floor_ms;
+    snr_q8 = (uint32_t)(((uint64_t)ms << 8) / floor_ms);
+
+    if (!det->active) {
+      if (snr_q8 >= det->cfg.trigger_snr_q8) {
+        det->active = true;
+        det->quiet_frames = 0;
+        onset = true;
+      }
+    } else if (snr_q8 < det->cfg.release_snr_q8) {
+      if (++det->quiet_frames >= det->cfg.hold_frames) {
+        det->active = false;
+      }
+    } else {
+      det->quiet_frames = 0;
+    }
+
+    // During an event the floor rises 8x slower, so a long call barely moves
+    // it but sustained wind that tripped the detector still releases it.
+    uint8_t shift = det->cfg.floor_fall_shift;
+    if (ms > det->floor_ms) {
+      shift = det->active ? (uint8_t)(det->cfg.floor_rise_shift + 3U) : det->cfg.floor_rise_shift;
+    }
+    det->floor_ms = ema_step(det->floor_ms, ms, shift);
+  }
+
+  if (out) {
+    out->snr_q8 = snr_q8;
+    out->rms = audio_detect_isqrt(ms);
+    out->peak = peak;
+    out->floor_rms = audio_detect_isqrt(det->floor_ms);
+    out->active = det->active;
+    out->onset = onset;
+  }
+  return onset;
+}
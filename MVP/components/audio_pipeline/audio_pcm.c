@@ -0,0 +1,83 @@
+#include "audio_pcm.h"
+
+#include <string.h>
+
+static inline int32_t saturate(int32_t v, int32_t lo, int32_t hi) {
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+size_t audio_pcm_bytes_per_sample(audio_sample_format_t format) {
+  switch (format) {
+    case AUDIO_SAMPLE_PCM16:
+      return 2;
+    case AUDIO_SAMPLE_PCM24:
+      return 3;
+    case AUDIO_SAMPLE_RAW32:
+    default:
+      return 4;
+  }
+}
+
+static void pcm16_from_i2s(const int32_t *src, int16_t *dest, size_t count, int shift) {
+  for (size_t i = 0; i < count; i++) {
+    dest[i] = (int16_t)saturate(src[i] >> shift, INT16_MIN, INT16_MAX);
+  }
+}
+
+void audio_pcm16_from_i2s_strided(const int32_t *src, size_t stride, int16_t *dest, size_t count, int shift) {
+  for (size_t i = 0; i < count; i++) {
+    dest[i] = (int16_t)saturate(src[i * stride] >> shift, INT16_MIN, INT16_MAX);
+  }
+}
+
+static void pcm24_from_i2s(const int32_t *src, uint8_t *dest, size_t count, int shift) {
+  int shift24 = shift > 8 ? shift - 8 : 0;
+  for (size_t i = 0; i < count; i++) {
+    int32_t v = saturate(src[i] >> shift24, -8388608, 8388607);
+    dest[0] = (uint8_t)v;
+    dest[1] = (uint8_t)(v >> 8);
+    dest[2] = (uint8_t)(v >> 16);
+    dest += 3;
+  }
+}
+
+void audio_pcm_from_i2s(audio_sample_format_t format, const int32_t *src, void *dest,
+                        size_t count, int shift) {
+  switch (format) {
+    case AUDIO_SAMPLE_PCM16:
+      pcm16_from_i2s(src, (int16_t *)dest, count, shift);
+      break;
+    case AUDIO_SAMPLE_PCM24:
+      pcm24_from_i2s(src, (uint8_t *)dest, count, shift);
+      break;
+    case AUDIO_SAMPLE_RAW32:
+    default:
+      memcpy(dest, src, count * sizeof(int32_t));
+      break;
+  }
+}
+
+size_t audio_pcm_ring_ingest(audio_ring_t *rb, audio_sample_format_t format, const int32_t *src,
+                             size_t count, int shift, bool overwrite) {
+  if (!src || count == 0 || rb->elem_size != audio_pcm_bytes_per_sample(format)) {
+    return 0;
+  }
+
+  // Oversized overwrite writes only need the newest capacity samples.
+  if (overwrite && count > rb->capacity) {
+    src += count - rb->capacity;
+    count = rb->capacity;
+  }
+
+  audio_ring_wspan_t spans[2];
+  size_t reserved = audio_ring_reserve(rb, count, overwrite, spans);
+  if (reserved == 0) {
+    return 0;
+  }
+  audio_pcm_from_i2s(format, src, spans[0].data, spans[0].count, shift);
+  if (spans[1].count > 0) {
+    audio_pcm_from_i2s(format, src + spans[0].count, spans[1].data, spans[1].count, shift);
+  }
+  audio_ring_commit(rb, reserved);
+  return reserved;
+}
@@ -0,0 +1,251 @@
+#include "audio_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "AUDIO_RING";
+
+static inline size_t ring_pos(const audio_ring_t *rb, size_t idx) {
+  return idx >= rb->capacity ? idx - rb->capacity : idx;
+}
+
+static inline size_t ring_advance(const audio_ring_t *rb, size_t idx, size_t count) {
+  idx += count;
+  if (idx >= 2 * rb->capacity) {
+    idx -= 2 * rb->capacity;
+  }
+  return idx;
+}
+
+static inline size_t ring_distance(const audio_ring_t *rb, size_t head, size_t tail) {
+  return head >= tail ? head - tail : head + 2 * rb->capacity - tail;
+}
+
+// Copies count elements (count <= capacity) starting at index idx, in at most
+// two memcpy segments.
+static void ring_copy_in(audio_ring_t *rb, size_t idx, const uint8_t *src, size_t count) {
+  size_t pos = ring_pos(rb, idx);
+  size_t first = rb->capacity - pos;
+  if (first > count) {
+    first = count;
+  }
+  memcpy(rb->data + pos * rb->elem_size, src, first * rb->elem_size);
+  if (count > first) {
+    memcpy(rb->data, src + first * rb->elem_size, (count - first) * rb->elem_size);
+  }
+}
+
+esp_err_t audio_ring_init(audio_ring_t *rb, size_t capacity, size_t elem_size) {
+  if (!rb || capacity == 0 || elem_size == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  size_t bytes = capacity * elem_size;
+  rb->data = (uint8_t *)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+  if (!rb->data) {
+    rb->data = (uint8_t *)malloc(bytes);
+  }
+  if (!rb->data) {
+    ESP_LOGE(TAG, "Ring allocation failed (%zu x %zu bytes)", capacity, elem_size);
+    return ESP_ERR_NO_MEM;
+  }
+
+  memset(rb->data, 0, bytes);
+  rb->elem_size = elem_size;
+  rb->capacity = capacity;
+  atomic_init(&rb->head, 0);
+  atomic_init(&rb->tail, 0);
+  return ESP_OK;
+}
+
+void audio_ring_free(audio_ring_t *rb) {
+  if (!rb) {
+    return;
+  }
+  heap_caps_free(rb->data);
+  rb->data = NULL;
+  rb->capacity = 0;
+  atomic_store(&rb->head, 0);
+  atomic_store(&rb->tail, 0);
+}
+
+void audio_ring_reset(audio_ring_t *rb) {
+  atomic_store_explicit(&rb->tail, 0, memory_order_relaxed);
+  atomic_store_explicit(&rb->head, 0, memory_order_release);
+}
+
+size_t audio_ring_used(const audio_ring_t *rb) {
+  if (!rb->data) {
+    return 0;
+  }
+  size_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+  size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+  return ring_distance(rb, head, tail);
+}
+
+size_t audio_ring_free_space(const audio_ring_t *rb) {
+  return rb->capacity - audio_ring_used(rb);
+}
+
+size_t audio_ring_write(audio_ring_t *rb, const void *src, size_t count) {
+  if (!rb->data || !src || count == 0) {
+    return 0;
+  }
+
+  size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+  size_t space = rb->capacity - ring_distance(rb, head, tail);
+  if (count > space) {
+    count = space;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  ring_copy_in(rb, head, (const uint8_t *)src, count);
+  atomic_store_explicit(&rb->head, ring_advance(rb, head, count), memory_order_release);
+  return count;
+}
+
+size_t audio_ring_write_overwrite(audio_ring_t *rb, const void *src, size_t count) {
+  if (!rb->data || !src || count == 0) {
+    return 0;
+  }
+
+  size_t accepted = count;
+  const uint8_t *bytes = (const uint8_t *)src;
+  if (count > rb->capacity) {
+    bytes += (count - rb->capacity) * rb->elem_size;
+    count = rb->capacity;
+  }
+
+  size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+  size_t space = rb->capacity - ring_distance(rb, head, tail);
+  if (count > space) {
+    atomic_store_explicit(&rb->tail, ring_advance(rb, tail, count - space), memory_order_release);
+  }
+
+  ring_copy_in(rb, head, bytes, count);
+  atomic_store_explicit(&rb->head, ring_advance(rb, head, count), memory_order_release);
+  return accepted;
+}
+
+size_t audio_ring_reserve(audio_ring_t *rb, size_t count, bool overwrite, audio_ring_wspan_t spans[2]) {
+  spans[0].data = NULL;
+  spans[0].count = 0;
+  spans[1].data = NULL;
+  spans[1].count = 0;
+  if (!rb->data || count == 0) {
+    return 0;
+  }
+
+  if (count > rb->capacity) {
+    count = rb->capacity;
+  }
+
+  size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+  size_t space = rb->capacity - ring_distance(rb, head, tail);
+  if (count > space) {
+    if (overwrite) {
+      atomic_store_explicit(&rb->tail, ring_advance(rb, tail, count - space), memory_order_release);
+    } else {
+      count = space;
+    }
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  size_t pos = ring_pos(rb, head);
+  size_t first = rb->capacity - pos;
+  if (first > count) {
+    first = count;
+  }
+  spans[0].data = rb->data + pos * rb->elem_size;
+  spans[0].count = first;
+  if (count > first) {
+    spans[1].data = rb->data;
+    spans[1].count = count - first;
+  }
+  return count;
+}
+
+void audio_ring_commit(audio_ring_t *rb, size_t count) {
+  if (!rb->data || count == 0) {
+    return;
+  }
+  size_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+  atomic_store_explicit(&rb->head, ring_advance(rb, head, count), memory_order_release);
+}
+
+size_t audio_ring_peek(const audio_ring_t *rb, audio_ring_span_t spans[2]) {
+  spans[0].data = NULL;
+  spans[0].count = 0;
+  spans[1].data = NULL;
+  spans[1].count = 0;
+  if (!rb->data) {
+    return 0;
+  }
+
+  size_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+  size_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+  size_t used = ring_distance(rb, head, tail);
+  if (used == 0) {
+    return 0;
+  }
+
+  size_t pos = ring_pos(rb, tail);
+  size_t first = rb->capacity - pos;
+  if (first > used) {
+    first = used;
+  }
+  spans[0].data = rb->data + pos * rb->elem_size;
+  spans[0].count = first;
+  if (used > first) {
+    spans[1].data = rb->data;
+    spans[1].count = used - first;
+  }
+  return used;
+}
+
+void audio_ring_consume(audio_ring_t *rb, size_t count) {
+  if (!rb->data || count == 0) {
+    return;
+  }
+
+  size_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+  size_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+  size_t used = ring_distance(rb, head, tail);
+  if (count > used) {
+    count = used;
+  }
+  atomic_store_explicit(&rb->tail, ring_advance(rb, tail, count), memory_order_release);
+}
+
+size_t audio_ring_read(audio_ring_t *rb, void *dest, size_t max_count) {
+  if (!dest || max_count == 0) {
+    return 0;
+  }
+
+  audio_ring_span_t spans[2];
+  audio_ring_peek(rb, spans);
+
+  uint8_t *out = (uint8_t *)dest;
+  size_t copied = 0;
+  for (int i = 0; i < 2 && copied < max_count; i++) {
+    size_t n = spans[i].count;
+    if (n > max_count - copied) {
+      n = max_count - copied;
+    }
+    memcpy(out + copied * rb->elem_size, spans[i].data, n * rb->elem_size);
+    copied += n;
+  }
+
+  audio_ring_consume(rb, copied);
+  return copied;
+}
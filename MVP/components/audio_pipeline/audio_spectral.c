@@ -0,0 +1,248 @@
+#include "audio_spectral.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Per-bin floor for a ~1 LSB white-noise input after windowing and the 1/N
+// FFT scaling; stops digital silence from producing huge SNRs.
+#define SPECTRAL_MIN_BIN_POWER 16384ULL
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+void audio_spectral_default_config(audio_spectral_config_t *cfg, uint32_t sample_rate) {
+  if (!cfg) {
+    return;
+  }
+  memset(cfg, 0, sizeof(*cfg));
+  cfg->sample_rate = sample_rate;
+  cfg->fft_size = 512;
+  cfg->band_count = 1;
+  cfg->bands[0].lo_hz = 2000;
+  cfg->bands[0].hi_hz = 8000;
+  cfg->trigger_snr_q8 = 2036;  // +9 dB
+  cfg->release_snr_q8 = 511;   // +3 dB
+  cfg->window_frames = 4;
+  cfg->min_hot_frames = 2;
+  cfg->hold_frames = 8;
+  cfg->warmup_frames = 8;
+  cfg->floor_rise_shift = 6;
+  cfg->floor_fall_shift = 2;
+}
+
+void audio_spectral_free(audio_spectral_t *sp) {
+  if (!sp) {
+    return;
+  }
+  free(sp->re);
+  free(sp->im);
+  free(sp->cos_q15);
+  free(sp->sin_q15);
+  free(sp->window_q15);
+  sp->re = sp->im = NULL;
+  sp->cos_q15 = sp->sin_q15 = sp->window_q15 = NULL;
+}
+
+bool audio_spectral_init(audio_spectral_t *sp, const audio_spectral_config_t *cfg) {
+  if (!sp || !cfg || cfg->sample_rate == 0 || cfg->fft_size < 64 || cfg->fft_size > AUDIO_SPECTRAL_MAX_FFT ||
+      (cfg->fft_size & (cfg->fft_size - 1)) != 0 || cfg->band_count == 0 ||
+      cfg->band_count > AUDIO_SPECTRAL_MAX_BANDS || cfg->window_frames == 0 || cfg->window_frames > 32 ||
+      cfg->min_hot_frames == 0 || cfg->min_hot_frames > cfg->window_frames) {
+    return false;
+  }
+
+  memset(sp, 0, sizeof(*sp));
+  sp->cfg = *cfg;
+  size_t n = cfg->fft_size;
+  while ((1U << sp->log2n) < n) {
+    sp->log2n++;
+  }
+
+  sp->re = (int32_t *)malloc(n * sizeof(int32_t));
+  sp->im = (int32_t *)malloc(n * sizeof(int32_t));
+  sp->cos_q15 = (int16_t *)malloc(n / 2 * sizeof(int16_t));
+  sp->sin_q15 = (int16_t *)malloc(n / 2 * sizeof(int16_t));
+  sp->window_q15 = (int16_t *)malloc(n * sizeof(int16_t));
+  if (!sp->re || !sp->im || !sp->cos_q15 || !sp->sin_q15 || !sp->window_q15) {
+    audio_spectral_free(sp);
+    return false;
+  }
+
+  for (size_t k = 0; k < n / 2; k++) {
+    double a = 2.0 * M_PI * (double)k / (double)n;
+    sp->cos_q15[k] = (int16_t)lround(32767.0 * cos(a));
+    sp->sin_q15[k] = (int16_t)lround(32767.0 * sin(a));
+  }
+  for (size_t i = 0; i < n; i++) {
+    sp->window_q15[i] = (int16_t)lround(32767.0 * 0.5 * (1.0 - cos(2.0 * M_PI * (double)i / (double)n)));
+  }
+
+  uint32_t nyquist_bin = (uint32_t)(n / 2);
+  for (uint8_t b = 0; b < cfg->band_count; b++) {
+    uint32_t lo = ((uint32_t)cfg->bands[b].lo_hz * n + cfg->sample_rate - 1) / cfg->sample_rate;
+    uint32_t hi = (uint32_t)cfg->bands[b].hi_hz * n / cfg->sample_rate;
+    lo = lo < 1 ? 1 : lo;
+    hi = hi > nyquist_bin ? nyquist_bin : hi;
+    if (hi < lo) {
+      hi = lo;
+    }
+    sp->bin_lo[b] = (uint16_t)lo;
+    sp->bin_hi[b] = (uint16_t)hi;
+  }
+  return true;
+}
+
+void audio_spectral_reset(audio_spectral_t *sp) {
+  if (!sp) {
+    return;
+  }
+  memset(sp->floor, 0, sizeof(sp->floor));
+  sp->hot_history = 0;
+  sp->frames = 0;
+  sp->quiet_frames = 0;
+  sp->active = false;
+}
+
+static inline uint32_t bit_reverse(uint32_t v, uint8_t bits) {
+  uint32_t r = 0;
+  for (uint8_t i = 0; i < bits; i++) {
+    r = (r << 1) | (v & 1U);
+    v >>= 1;
+  }
+  return r;
+}
+
+void audio_spectral_fft(audio_spectral_t *sp) {
+  const size_t n = sp->cfg.fft_size;
+  int32_t *re = sp->re;
+  int32_t *im = sp->im;
+
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t j = bit_reverse(i, sp->log2n);
+    if (j > i) {
+      int32_t t = re[i];
+      re[i] = re[j];
+      re[j] = t;
+      t = im[i];
+      im[i] = im[j];
+      im[j] = t;
+    }
+  }
+
+  // Decimation in time with W = cos - j*sin. Every stage halves, so inputs
+  // up to 2^27 can never overflow the 32-bit accumulators.
+  for (size_t len = 2, step = n / 2; len <= n; len <<= 1, step >>= 1) {
+    size_t half = len / 2;
+    for (size_t j = 0; j < half; j++) {
+      int32_t wr = sp->cos_q15[j * step];
+      int32_t wi = sp->sin_q15[j * step];
+      for (size_t i = j; i < n; i += len) {
+        size_t k = i + half;
+        int32_t tr = (int32_t)(((int64_t)re[k] * wr + (int64_t)im[k] * wi) >> 15);
+        int32_t ti = (int32_t)(((int64_t)im[k] * wr - (int64_t)re[k] * wi) >> 15);
+        int32_t ur = re[i];
+        int32_t ui = im[i];
+        re[i] = (ur + tr) >> 1;
+        im[i] = (ui + ti) >> 1;
+        re[k] = (ur - tr) >> 1;
+        im[k] = (ui - ti) >> 1;
+      }
+    }
+  }
+}
+
+static inline uint64_t ema_step64(uint64_t avg, uint64_t x, uint8_t shift) {
+  if (x >= avg) {
+    return avg + ((x - avg) >> shift);
+  }
+  return avg - ((avg - x) >> shift);
+}
+
+bool audio_spectral_process(audio_spectral_t *sp, const int16_t *pcm, size_t count, audio_spectral_frame_t *out) {
+  if (!sp || !sp->re || !pcm || count == 0) {
+    return false;
+  }
+
+  const size_t n = sp->cfg.fft_size;
+  size_t used = count < n ? count : n;
+  // pcm << 12 scaled by the Q15 window leaves 2^27 of headroom for the FFT.
+  for (size_t i = 0; i < used; i++) {
+    sp->re[i] = ((int32_t)pcm[i] * sp->window_q15[i]) >> 3;
+  }
+  if (used < n) {
+    memset(sp->re + used, 0, (n - used) * sizeof(int32_t));
+  }
+  memset(sp->im, 0, n * sizeof(int32_t));
+  audio_spectral_fft(sp);
+
+  const audio_spectral_config_t *cfg = &sp->cfg;
+  bool warm = false;
+  bool hot = false;
+  bool warming_up = sp->frames < cfg->warmup_frames;
+  uint64_t energy[AUDIO_SPECTRAL_MAX_BANDS] = {0};
+  uint32_t snr_q8[AUDIO_SPECTRAL_MAX_BANDS] = {0};
+
+  for (uint8_t b = 0; b < cfg->band_count; b++) {
+    uint64_t e = 0;
+    for (uint32_t k = sp->bin_lo[b]; k <= sp->bin_hi[b]; k++) {
+      e += (uint64_t)((int64_t)sp->re[k] * sp->re[k] + (int64_t)sp->im[k] * sp->im[k]);
+    }
+    energy[b] = e;
+
+    uint64_t min_floor = SPECTRAL_MIN_BIN_POWER * (uint64_t)(sp->bin_hi[b] - sp->bin_lo[b] + 1U);
+    uint64_t floor = sp->floor[b] > min_floor ? sp->floor[b] : min_floor;
+    uint64_t ratio = e / ((floor >> 8) ? (floor >> 8) : 1U);
+    snr_q8[b] = ratio > UINT32_MAX ? UINT32_MAX : (uint32_t)ratio;
+    if (!warming_up) {
+      hot |= snr_q8[b] >= cfg->trigger_snr_q8;
+      warm |= snr_q8[b] >= cfg->release_snr_q8;
+    }
+  }
+
+  bool onset = false;
+  if (warming_up) {
+    for (uint8_t b = 0; b < cfg->band_count; b++) {
+      sp->floor[b] = sp->frames == 0 ? energy[b] : ema_step64(sp->floor[b], energy[b], 1);
+    }
+    sp->frames++;
+  } else {
+    uint32_t mask = cfg->window_frames >= 32 ? UINT32_MAX : ((1U << cfg->window_frames) - 1U);
+    sp->hot_history = ((sp->hot_history << 1) | (hot ? 1U : 0U)) & mask;
+
+    if (!sp->active) {
+      if ((uint32_t)__builtin_popcount(sp->hot_history) >= cfg->min_hot_frames) {
+        sp->active = true;
+        sp->quiet_frames = 0;
+        onset = true;
+      }
+    } else if (!warm) {
+      if (++sp->quiet_frames >= cfg->hold_frames) {
+        sp->active = false;
+        sp->hot_history = 0;
+      }
+    } else {
+      sp->quiet_frames = 0;
+    }
+
+    // Same floor policy as audio_detect: slow rise, fast fall, and a much
+    // slower rise while active so long songs do not raise their own floor.
+    for (uint8_t b = 0; b < cfg->band_count; b++) {
+      uint8_t shift = cfg->floor_fall_shift;
+      if (energy[b] > sp->floor[b]) {
+        shift = sp->active ? (uint8_t)(cfg->floor_rise_shift + 3U) : cfg->floor_rise_shift;
+      }
+      sp->floor[b] = ema_step64(sp->floor[b], energy[b], shift);
+    }
+  }
+
+  if (out) {
+    memcpy(out->energy, energy, sizeof(out->energy));
+    memcpy(out->snr_q8, snr_q8, sizeof(out->snr_q8));
+    out->hot = hot;
+    out->active = sp->active;
+    out->onset = onset;
+  }
+  return onset;
+}
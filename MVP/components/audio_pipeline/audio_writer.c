@@ -0,0 +1,247 @@
+#include "audio_writer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "AUDIO_WRITER";
+
+typedef enum {
+  WRITER_MSG_BEGIN = 0,
+  WRITER_MSG_DATA,
+  WRITER_MSG_END,
+  WRITER_MSG_STOP,
+} writer_msg_type_t;
+
+typedef struct {
+  uint8_t type;
+  uint16_t block;
+  const audio_ring_t *pre_roll;
+  audio_writer_sink_t sink;
+} writer_msg_t;
+
+static void write_timed(audio_writer_t *aw, const audio_writer_sink_t *sink, const void *data, size_t len) {
+  int64_t t0 = esp_timer_get_time();
+  esp_err_t err = sink->write(sink->ctx, data, len);
+  uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+
+  atomic_store_explicit(&aw->stats.last_write_us, us, memory_order_relaxed);
+  atomic_fetch_add_explicit(&aw->stats.total_write_us, us, memory_order_relaxed);
+  if (us > atomic_load_explicit(&aw->stats.max_write_us, memory_order_relaxed)) {
+    atomic_store_explicit(&aw->stats.max_write_us, us, memory_order_relaxed);
+  }
+  if (err != ESP_OK) {
+    atomic_fetch_add_explicit(&aw->stats.write_errors, 1, memory_order_relaxed);
+  }
+}
+
+static void writer_task(void *arg) {
+  audio_writer_t *aw = (audio_writer_t *)arg;
+  bool open = false;
+  audio_writer_sink_t sink = {0};
+  writer_msg_t msg;
+
+  while (1) {
+    if (xQueueReceive(aw->work_queue, &msg, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+
+    switch (msg.type) {
+      case WRITER_MSG_BEGIN:
+        sink = msg.sink;
+        open = sink.open(sink.ctx) == ESP_OK;
+        if (!open) {
+          ESP_LOGW(TAG, "Sink open failed; dropping clip");
+        } else if (msg.pre_roll) {
+          audio_ring_span_t spans[2];
+          audio_ring_peek(msg.pre_roll, spans);
+          for (int i = 0; i < 2; i++) {
+            if (spans[i].count > 0) {
+              write_timed(aw, &sink, spans[i].data, spans[i].count * msg.pre_roll->elem_size);
+            }
+          }
+        }
+        if (msg.pre_roll) {
+          atomic_store(&aw->ring_busy, false);
+        }
+        break;
+
+      case WRITER_MSG_DATA: {
+        audio_writer_block_t *blk = &aw->blocks[msg.block];
+        if (open) {
+          write_timed(aw, &sink, blk->data, blk->len);
+          atomic_fetch_add_explicit(&aw->stats.blocks_written, 1, memory_order_relaxed);
+        }
+        blk->len = 0;
+        xQueueSend(aw->free_queue, &msg.block, portMAX_DELAY);
+        break;
+      }
+
+      case WRITER_MSG_END:
+        if (open && sink.close(sink.ctx) != ESP_OK) {
+          atomic_fetch_add_explicit(&aw->stats.write_errors, 1, memory_order_relaxed);
+        }
+        open = false;
+        atomic_fetch_sub(&aw->clips_pending, 1);
+        break;
+
+      case WRITER_MSG_STOP:
+      default:
+        if (open) {
+          sink.close(sink.ctx);
+        }
+        aw->task = NULL;
+        vTaskDelete(NULL);
+        return;
+    }
+  }
+}
+
+esp_err_t audio_writer_init(audio_writer_t *aw, const audio_writer_config_t *cfg) {
+  if (!aw || !cfg || cfg->block_count == 0 || cfg->block_count > UINT16_MAX || cfg->block_bytes == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  memset(aw, 0, sizeof(*aw));
+  aw->block_count = cfg->block_count;
+  aw->block_bytes = cfg->block_bytes;
+  atomic_init(&aw->clips_pending, 0);
+  atomic_init(&aw->ring_busy, false);
+
+  aw->pool = (uint8_t *)heap_caps_malloc(cfg->block_count * cfg->block_bytes, MALLOC_CAP_SPIRAM);
+  if (!aw->pool) {
+    aw->pool = (uint8_t *)malloc(cfg->block_count * cfg->block_bytes);
+  }
+  aw->blocks = (audio_writer_block_t *)calloc(cfg->block_count, sizeof(audio_writer_block_t));
+  // One slot per block plus the BEGIN/END/STOP markers that can be in flight.
+  aw->free_queue = xQueueCreate(cfg->block_count, sizeof(uint16_t));
+  aw->work_queue = xQueueCreate(cfg->block_count + 4, sizeof(writer_msg_t));
+  if (!aw->pool || !aw->blocks || !aw->free_queue || !aw->work_queue) {
+    ESP_LOGE(TAG, "Allocation failed (%zu blocks of %zu bytes)", cfg->block_count, cfg->block_bytes);
+    audio_writer_deinit(aw);
+    return ESP_ERR_NO_MEM;
+  }
+
+  for (size_t i = 0; i < cfg->block_count; i++) {
+    uint16_t idx = (uint16_t)i;
+    aw->blocks[i].data = aw->pool + i * cfg->block_bytes;
+    xQueueSend(aw->free_queue, &idx, 0);
+  }
+
+  if (xTaskCreatePinnedToCore(writer_task, "AudioWriter", cfg->task_stack, aw, cfg->task_priority, &aw->task,
+                              cfg->task_core) != pdPASS) {
+    ESP_LOGE(TAG, "Writer task creation failed");
+    audio_writer_deinit(aw);
+    return ESP_ERR_NO_MEM;
+  }
+  return ESP_OK;
+}
+
+void audio_writer_deinit(audio_writer_t *aw) {
+  if (!aw) {
+    return;
+  }
+  if (aw->task) {
+    writer_msg_t msg = {.type = WRITER_MSG_STOP};
+    xQueueSend(aw->work_queue, &msg, portMAX_DELAY);
+    while (*(volatile TaskHandle_t *)&aw->task) {
+      vTaskDelay(pdMS_TO_TICKS(10));
+    }
+  }
+  if (aw->work_queue) {
+    vQueueDelete(aw->work_queue);
+  }
+  if (aw->free_queue) {
+    vQueueDelete(aw->free_queue);
+  }
+  free(aw->blocks);
+  heap_caps_free(aw->pool);
+  memset(aw, 0, sizeof(*aw));
+}
+
+esp_err_t audio_writer_begin(audio_writer_t *aw, const audio_writer_sink_t *sink, const audio_ring_t *pre_roll) {
+  if (!aw->task || !sink || !sink->open || !sink->write || !sink->close) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (pre_roll && atomic_load(&aw->ring_busy)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  if (pre_roll) {
+    atomic_store(&aw->ring_busy, true);
+  }
+  atomic_fetch_add(&aw->clips_pending, 1);
+
+  writer_msg_t msg = {.type = WRITER_MSG_BEGIN, .pre_roll = pre_roll, .sink = *sink};
+  if (xQueueSend(aw->work_queue, &msg, 0) != pdTRUE) {
+    if (pre_roll) {
+      atomic_store(&aw->ring_busy, false);
+    }
+    atomic_fetch_sub(&aw->clips_pending, 1);
+    return ESP_ERR_TIMEOUT;
+  }
+  return ESP_OK;
+}
+
+esp_err_t audio_writer_end(audio_writer_t *aw) {
+  writer_msg_t msg = {.type = WRITER_MSG_END};
+  // The work queue has room for every block plus markers, so this only
+  // blocks if the caller ends a clip twice.
+  return xQueueSend(aw->work_queue, &msg, portMAX_DELAY) == pdTRUE ? ESP_OK : ESP_FAIL;
+}
+
+audio_writer_block_t *audio_writer_acquire(audio_writer_t *aw) {
+  uint16_t idx = 0;
+  if (xQueueReceive(aw->free_queue, &idx, 0) != pdTRUE) {
+    atomic_fetch_add_explicit(&aw->stats.overruns, 1, memory_order_relaxed);
+    return NULL;
+  }
+  aw->blocks[idx].len = 0;
+  return &aw->blocks[idx];
+}
+
+esp_err_t audio_writer_submit(audio_writer_t *aw, audio_writer_block_t *block) {
+  if (!block || block < aw->blocks || block >= aw->blocks + aw->block_count) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  writer_msg_t msg = {.type = WRITER_MSG_DATA, .block = (uint16_t)(block - aw->blocks)};
+  if (xQueueSend(aw->work_queue, &msg, 0) != pdTRUE) {
+    // The chunk is lost either way; keep the block. The free queue has a
+    // slot for every block, so this cannot fail.
+    block->len = 0;
+    xQueueSend(aw->free_queue, &msg.block, 0);
+    atomic_fetch_add_explicit(&aw->stats.overruns, 1, memory_order_relaxed);
+    return ESP_ERR_TIMEOUT;
+  }
+
+  uint32_t waiting = (uint32_t)uxQueueMessagesWaiting(aw->work_queue);
+  if (waiting > atomic_load_explicit(&aw->stats.queue_high_water, memory_order_relaxed)) {
+    atomic_store_explicit(&aw->stats.queue_high_water, waiting, memory_order_relaxed);
+  }
+  return ESP_OK;
+}
+
+bool audio_writer_ring_busy(const audio_writer_t *aw) {
+  return atomic_load(&aw->ring_busy);
+}
+
+bool audio_writer_clip_active(const audio_writer_t *aw) {
+  return atomic_load(&aw->clips_pending) > 0;
+}
+
+void audio_writer_get_stats(const audio_writer_t *aw, audio_writer_stats_t *out) {
+  if (!out) {
+    return;
+  }
+  out->blocks_written = atomic_load_explicit(&aw->stats.blocks_written, memory_order_relaxed);
+  out->overruns = atomic_load_explicit(&aw->stats.overruns, memory_order_relaxed);
+  out->queue_high_water = atomic_load_explicit(&aw->stats.queue_high_water, memory_order_relaxed);
+  out->write_errors = atomic_load_explicit(&aw->stats.write_errors, memory_order_relaxed);
+  out->last_write_us = atomic_load_explicit(&aw->stats.last_write_us, memory_order_relaxed);
+  out->max_write_us = atomic_load_explicit(&aw->stats.max_write_us, memory_order_relaxed);
+  out->total_write_us = atomic_load_explicit(&aw->stats.total_write_us, memory_order_relaxed);
+}
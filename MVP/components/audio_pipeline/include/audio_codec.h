@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Clip encoders for mono PCM16. IMA-ADPCM (4:1) goes in a WAV container
+// (format tag 0x0011); the lossless mode writes a native FLAC stream using
+// fixed polynomial predictors (orders 0-4) and partitioned Rice residuals.
+// Both open in stock tools (sox, ffmpeg, flac, Audacity). Pure C with no IDF
+// dependencies; decoders are included for tests and host tools.
+
+typedef enum {
+  AUDIO_CODEC_PCM = 0,
+  AUDIO_CODEC_IMA_ADPCM,
+  AUDIO_CODEC_FLAC,
+} audio_codec_t;
+
+// IMA-ADPCM block layout: 4-byte header (first sample, step index) then two
+// samples per byte. 512-byte blocks hold 1017 samples (~64 ms at 16 kHz).
+#define IMA_ADPCM_BLOCK_BYTES   512U
+#define IMA_ADPCM_BLOCK_SAMPLES (1U + (IMA_ADPCM_BLOCK_BYTES - 4U) * 2U)
+#define IMA_ADPCM_HEADER_BYTES  60U
+
+#define FLAC_BLOCK_SAMPLES 4096U
+#define FLAC_HEADER_BYTES  42U
+// Worst case for one frame: header, verbatim subframe and footer.
+#define FLAC_MAX_FRAME_BYTES(samples) (32U + (samples) * 2U)
+
+const char *audio_codec_name(audio_codec_t codec);
+const char *audio_codec_extension(audio_codec_t codec);
+// Samples the encoder consumes per block (1 for PCM).
+size_t audio_codec_block_samples(audio_codec_t codec);
+size_t audio_codec_header_bytes(audio_codec_t codec);
+// Largest encoded size of one full block.
+size_t audio_codec_max_block_bytes(audio_codec_t codec);
+
+// Builds the file header. total_samples and the frame size range may be 0
+// while streaming; the writer patches the header at finalize.
+size_t audio_codec_build_header(audio_codec_t codec, uint8_t *out, uint32_t sample_rate, uint32_t total_samples,
+                                uint32_t data_bytes, uint32_t min_frame_bytes, uint32_t max_frame_bytes);
+
+// Encodes one block of up to IMA_ADPCM_BLOCK_SAMPLES; a short block is
+// padded with its last sample. step_index carries the quantizer state from
+// block to block. recon (optional) receives what a decoder will produce.
+// Returns IMA_ADPCM_BLOCK_BYTES.
+size_t ima_adpcm_encode_block(uint8_t *step_index, const int16_t *pcm, size_t count, uint8_t *out, int16_t *recon);
+// Decodes one block; returns the number of samples written.
+size_t ima_adpcm_decode_block(const uint8_t *in, size_t len, int16_t *out);
+
+// Encodes one frame of up to FLAC_BLOCK_SAMPLES (shorter only for the last
+// frame of a stream). scratch must hold count entries. Returns bytes written,
+// at most FLAC_MAX_FRAME_BYTES(count).
+size_t flac_encode_frame(const int16_t *pcm, size_t count, uint32_t frame_number, uint32_t sample_rate,
+                         uint32_t *scratch, uint8_t *out);
+// Decodes one frame of the subset flac_encode_frame emits (constant,
+// verbatim and fixed subframes). Checks both CRCs. Returns bytes consumed,
+// 0 on a malformed frame; *samples receives the frame's sample count.
+size_t flac_decode_frame(const uint8_t *in, size_t len, int16_t *out, size_t out_cap, size_t *samples);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Block-based event detector on PCM16 frames. Each frame's DC-removed mean
+// square (Q30) is compared against an exponential noise-floor estimate; the
+// detector goes active when the energy ratio crosses trigger_snr and stays
+// active until it falls below release_snr for hold_frames frames. Pure
+// integer code with no IDF dependencies, so it also builds on the host.
+
+// Energy ratios are Q8 (256 == 0 dB). 10 dB is 2560, 4 dB is ~643.
+#define AUDIO_DETECT_Q8_ONE 256U
+
+typedef struct {
+  uint32_t trigger_snr_q8;
+  uint32_t release_snr_q8;
+  uint16_t hold_frames;    // frames below release_snr before going inactive
+  uint16_t warmup_frames;  // frames used only to seed the noise floor
+  uint8_t floor_rise_shift;  // slow: floor creeps up over ~2^shift frames
+  uint8_t floor_fall_shift;  // fast: floor drops quickly when it gets quieter
+  uint32_t min_floor_ms;     // Q30 mean square; keeps silence from dividing by ~0
+} audio_detect_config_t;
+
+typedef struct {
+  uint32_t rms;       // PCM16 units, DC removed
+  uint32_t peak;      // largest excursion from the frame mean
+  uint32_t floor_rms; // noise floor in PCM16 units
+  uint32_t snr_q8;    // frame energy / floor energy
+  bool active;
+  bool onset;         // active went from false to true on this frame
+} audio_detect_frame_t;
+
+typedef struct {
+  audio_detect_config_t cfg;
+  uint32_t floor_ms;
+  uint32_t frames;  // counts up to warmup_frames, then stops
+  uint16_t quiet_frames;
+  bool active;
+} audio_detect_t;
+
+void audio_detect_default_config(audio_detect_config_t *cfg);
+void audio_detect_init(audio_detect_t *det, const audio_detect_config_t *cfg);
+void audio_detect_reset(audio_detect_t *det);
+
+// Runs one frame. Returns true on onset; out (optional) receives the frame's
+// energy figures for logging.
+bool audio_detect_process(audio_detect_t *det, const int16_t *pcm, size_t count, audio_detect_frame_t *out);
+
+uint32_t audio_detect_isqrt(uint64_t v);
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio_ring.h"
+
+// Storage format for captured audio. Conversion from the raw 32-bit I2S words
+// happens once, at ingest, so everything downstream (ring, WAV writer) works
+// on samples that are already in their final on-disk layout.
+typedef enum {
+  AUDIO_SAMPLE_PCM16 = 0,  // int16_t, I2S word >> shift, saturated
+  AUDIO_SAMPLE_PCM24,      // packed 3-byte little endian, 8 more bits than PCM16
+  AUDIO_SAMPLE_RAW32,      // untouched I2S word
+} audio_sample_format_t;
+
+size_t audio_pcm_bytes_per_sample(audio_sample_format_t format);
+
+// Converts count I2S words to format. shift is the PCM16 gain shift
+// (bsp_audio_config_t.pcm_shift); PCM24 uses shift - 8 and RAW32 ignores it.
+void audio_pcm_from_i2s(audio_sample_format_t format, const int32_t *src, void *dest,
+                        size_t count, int shift);
+
+// PCM16 from every stride-th word of src (one channel of interleaved I2S
+// frames); count is the number of output samples.
+void audio_pcm16_from_i2s_strided(const int32_t *src, size_t stride, int16_t *dest, size_t count, int shift);
+
+// Converts straight into the ring's storage (no staging buffer) and commits.
+// The ring must have been initialised with audio_pcm_bytes_per_sample(format).
+size_t audio_pcm_ring_ingest(audio_ring_t *rb, audio_sample_format_t format, const int32_t *src,
+                             size_t count, int shift, bool overwrite);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Single-producer/single-consumer ring of fixed-size elements.
+//
+// head and tail run over [0, 2 * capacity) so a full ring and an empty ring
+// are distinguishable without a separate flag, and capacity does not have to
+// be a power of two (5 s at 16 kHz is 80000 samples). The producer only
+// stores head and the consumer only stores tail, so one task may fill the
+// ring while another drains it.
+typedef struct {
+  uint8_t *data;
+  size_t elem_size;
+  size_t capacity;
+  _Atomic size_t head;
+  _Atomic size_t tail;
+} audio_ring_t;
+
+// A contiguous run of elements inside the ring storage.
+typedef struct {
+  const void *data;
+  size_t count;
+} audio_ring_span_t;
+
+typedef struct {
+  void *data;
+  size_t count;
+} audio_ring_wspan_t;
+
+esp_err_t audio_ring_init(audio_ring_t *rb, size_t capacity, size_t elem_size);
+void audio_ring_free(audio_ring_t *rb);
+void audio_ring_reset(audio_ring_t *rb);
+
+size_t audio_ring_used(const audio_ring_t *rb);
+size_t audio_ring_free_space(const audio_ring_t *rb);
+
+// Producer side. audio_ring_write() stores at most the free space and returns
+// the number of elements accepted. audio_ring_write_overwrite() always keeps
+// the newest elements and drops the oldest; it moves tail, so it is only safe
+// when the producer also owns the read side (the rolling pre-trigger window).
+size_t audio_ring_write(audio_ring_t *rb, const void *src, size_t count);
+size_t audio_ring_write_overwrite(audio_ring_t *rb, const void *src, size_t count);
+
+// Zero-copy producer path: reserve up to count slots as two writable spans,
+// fill them, then publish with audio_ring_commit(). With overwrite set the
+// oldest elements are dropped to make room (same ownership rule as above).
+size_t audio_ring_reserve(audio_ring_t *rb, size_t count, bool overwrite, audio_ring_wspan_t spans[2]);
+void audio_ring_commit(audio_ring_t *rb, size_t count);
+
+// Consumer side. audio_ring_peek() exposes up to two spans in chronological
+// order without copying; the data stays valid until audio_ring_consume().
+size_t audio_ring_peek(const audio_ring_t *rb, audio_ring_span_t spans[2]);
+void audio_ring_consume(audio_ring_t *rb, size_t count);
+size_t audio_ring_read(audio_ring_t *rb, void *dest, size_t max_count);
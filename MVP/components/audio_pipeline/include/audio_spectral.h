@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Band-limited trigger stage: a Hann-windowed radix-2 fixed-point FFT per
+// frame, energy summed over a few configured bands, and a noise floor per
+// band. A frame is "hot" when any band sits trigger_snr above its own floor;
+// the stage goes active once min_hot_frames of the last window_frames were
+// hot, and releases after hold_frames with every band below release_snr.
+// Like audio_detect, pure C with no IDF dependencies.
+
+#define AUDIO_SPECTRAL_MAX_BANDS 4
+#define AUDIO_SPECTRAL_MAX_FFT   1024U
+
+typedef struct {
+  uint16_t lo_hz;
+  uint16_t hi_hz;
+} audio_band_t;
+
+typedef struct {
+  uint32_t sample_rate;
+  uint16_t fft_size;  // power of two; longer frames are truncated, shorter zero-padded
+  uint8_t band_count;
+  audio_band_t bands[AUDIO_SPECTRAL_MAX_BANDS];
+  uint32_t trigger_snr_q8;  // 256 == 0 dB, as in audio_detect
+  uint32_t release_snr_q8;
+  uint8_t window_frames;    // <= 32
+  uint8_t min_hot_frames;
+  uint16_t hold_frames;
+  uint16_t warmup_frames;
+  uint8_t floor_rise_shift;
+  uint8_t floor_fall_shift;
+} audio_spectral_config_t;
+
+typedef struct {
+  uint64_t energy[AUDIO_SPECTRAL_MAX_BANDS];
+  uint32_t snr_q8[AUDIO_SPECTRAL_MAX_BANDS];
+  bool hot;
+  bool active;
+  bool onset;
+} audio_spectral_frame_t;
+
+typedef struct {
+  audio_spectral_config_t cfg;
+  uint8_t log2n;
+  int32_t *re;
+  int32_t *im;
+  int16_t *cos_q15;  // fft_size / 2 twiddles
+  int16_t *sin_q15;
+  int16_t *window_q15;
+  uint16_t bin_lo[AUDIO_SPECTRAL_MAX_BANDS];
+  uint16_t bin_hi[AUDIO_SPECTRAL_MAX_BANDS];
+  uint64_t floor[AUDIO_SPECTRAL_MAX_BANDS];
+  uint32_t hot_history;
+  uint32_t frames;  // counts up to warmup_frames, then stops
+  uint16_t quiet_frames;
+  bool active;
+} audio_spectral_t;
+
+// 512-point FFT at 16 kHz with one 2-8 kHz (birdsong) band.
+void audio_spectral_default_config(audio_spectral_config_t *cfg, uint32_t sample_rate);
+// Allocates the FFT buffers and tables; false on a bad config or no memory.
+bool audio_spectral_init(audio_spectral_t *sp, const audio_spectral_config_t *cfg);
+void audio_spectral_free(audio_spectral_t *sp);
+void audio_spectral_reset(audio_spectral_t *sp);
+
+// Runs one frame. Returns true on onset; out (optional) receives band energy
+// and SNR for logging.
+bool audio_spectral_process(audio_spectral_t *sp, const int16_t *pcm, size_t count, audio_spectral_frame_t *out);
+
+// In-place fixed-point FFT on sp's buffers, halving at every stage so the
+// output is the DFT divided by fft_size. Exposed for tests and benchmarks.
+void audio_spectral_fft(audio_spectral_t *sp);
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "audio_ring.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+// Capture/writer split: the capture task fills preallocated blocks and
+// submits them; a lower-priority writer task drains them to a sink. Capture
+// never touches storage, so a slow SD write costs pool headroom instead of
+// I2S DMA headroom.
+
+// Storage backend driven by the writer task. open/close bracket one clip.
+typedef struct {
+  esp_err_t (*open)(void *ctx);
+  esp_err_t (*write)(void *ctx, const void *data, size_t len);
+  esp_err_t (*close)(void *ctx);
+  void *ctx;
+} audio_writer_sink_t;
+
+typedef struct {
+  uint8_t *data;
+  size_t len;
+} audio_writer_block_t;
+
+typedef struct {
+  size_t block_count;
+  size_t block_bytes;
+  UBaseType_t task_priority;
+  BaseType_t task_core;
+  uint32_t task_stack;
+} audio_writer_config_t;
+
+typedef struct {
+  uint32_t blocks_written;
+  uint32_t overruns;          // chunks dropped: no free block, or no room to queue one
+  uint32_t queue_high_water;  // most blocks ever waiting for the writer
+  uint32_t write_errors;
+  uint32_t last_write_us;
+  uint32_t max_write_us;
+  uint64_t total_write_us;
+} audio_writer_stats_t;
+
+// Live counters behind audio_writer_stats_t. Each field has one writer
+// (overruns and queue_high_water the producer, the rest the writer task), so
+// relaxed atomics are enough for either task to read whole values.
+typedef struct {
+  _Atomic uint32_t blocks_written;
+  _Atomic uint32_t overruns;
+  _Atomic uint32_t queue_high_water;
+  _Atomic uint32_t write_errors;
+  _Atomic uint32_t last_write_us;
+  _Atomic uint32_t max_write_us;
+  _Atomic uint64_t total_write_us;
+} audio_writer_counters_t;
+
+typedef struct {
+  audio_writer_block_t *blocks;
+  uint8_t *pool;
+  size_t block_count;
+  size_t block_bytes;
+  QueueHandle_t free_queue;
+  QueueHandle_t work_queue;
+  TaskHandle_t task;
+  atomic_int clips_pending;
+  atomic_bool ring_busy;
+  audio_writer_counters_t stats;
+} audio_writer_t;
+
+esp_err_t audio_writer_init(audio_writer_t *aw, const audio_writer_config_t *cfg);
+void audio_writer_deinit(audio_writer_t *aw);
+
+// Starts a clip. If pre_roll is set, the writer copies its readable region
+// before any submitted block; the producer must not write to that ring while
+// audio_writer_ring_busy() is true. A new clip may begin while the previous
+// one is still draining (back-to-back segments); the sink is copied, but its
+// ctx must stay valid until that clip's close callback has run.
+esp_err_t audio_writer_begin(audio_writer_t *aw, const audio_writer_sink_t *sink, const audio_ring_t *pre_roll);
+esp_err_t audio_writer_end(audio_writer_t *aw);
+
+// Producer side. acquire returns NULL (and counts an overrun) when every
+// block is still queued for the writer; the caller drops that chunk. If
+// submit fails the block goes back to the pool, also as an overrun.
+audio_writer_block_t *audio_writer_acquire(audio_writer_t *aw);
+esp_err_t audio_writer_submit(audio_writer_t *aw, audio_writer_block_t *block);
+
+bool audio_writer_ring_busy(const audio_writer_t *aw);
+// True while any begun clip has not been closed by the writer yet.
+bool audio_writer_clip_active(const audio_writer_t *aw);
+// Each field is read whole, but the fields are not one snapshot:
+// total_write_us can already include a block blocks_written does not count.
+void audio_writer_get_stats(const audio_writer_t *aw, audio_writer_stats_t *out);
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "audio_codec.h"
+#include "audio_ring.h"
+#include "esp_err.h"
+
+#define WAV_HEADER_BYTES 44U
+
+// Incremental clip sink: open, append any number of spans, then finalize to
+// patch the header sizes. The header lives at the start of the staging
+// buffer, so every flush after the first lands on a multiple of buffer_size
+// in the file; pass the FAT cluster size to keep writes aligned.
+//
+// wav_writer_open writes plain PCM WAV. wav_writer_open_codec takes mono
+// PCM16 and encodes it block by block as it streams (IMA-ADPCM WAV or FLAC;
+// see audio_codec.h), so only one encoded block is ever held in RAM.
+typedef struct {
+  FILE *file;
+  uint8_t *buf;
+  size_t buf_size;
+  size_t buf_used;
+  uint32_t data_bytes;
+  uint32_t samples;
+  uint32_t sample_rate;
+  uint16_t channels;
+  uint16_t bits_per_sample;
+  audio_codec_t codec;
+  // Encoder state, compressed codecs only.
+  int16_t *pending;
+  size_t pending_count;
+  size_t block_samples;
+  uint8_t *frame;
+  uint32_t *scratch;
+  uint32_t frames;
+  uint32_t min_frame_bytes;
+  uint32_t max_frame_bytes;
+  uint8_t ima_index;
+} wav_writer_t;
+
+void wav_build_header(uint8_t out[WAV_HEADER_BYTES], uint32_t sample_rate, uint16_t channels,
+                      uint16_t bits_per_sample, uint32_t data_size);
+
+esp_err_t wav_writer_open(wav_writer_t *w, const char *path, uint32_t sample_rate, uint16_t channels,
+                          uint16_t bits_per_sample, size_t buffer_size);
+esp_err_t wav_writer_open_codec(wav_writer_t *w, const char *path, uint32_t sample_rate, audio_codec_t codec,
+                                size_t buffer_size);
+// len is in bytes of input PCM (whole samples for compressed codecs).
+esp_err_t wav_writer_append(wav_writer_t *w, const void *data, size_t len);
+// Appends the readable part of rb (oldest first) without consuming it.
+esp_err_t wav_writer_append_ring(wav_writer_t *w, const audio_ring_t *rb);
+esp_err_t wav_writer_finalize(wav_writer_t *w);
+// Closes the file without patching the header and releases the buffer.
+void wav_writer_abort(wav_writer_t *w);
@@ -0,0 +1,190 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "unity.h"
+
+#include "audio_codec.h"
+
+#define TEST_RATE 16000U
+
+static uint32_t s_lcg = 42;
+
+static int32_t noise(int32_t amplitude) {
+  s_lcg = s_lcg * 1664525U + 1013904223U;
+  return ((int32_t)(s_lcg >> 16) - 32768) * amplitude / 32768;
+}
+
+// Field-like signal: hiss, a chirp, and optional full-scale clipping.
+static void make_signal(int16_t *out, size_t n, int32_t hiss, int32_t tone, bool clip) {
+  for (size_t i = 0; i < n; i++) {
+    double f = 2000.0 + 2000.0 * (double)(i % 4800) / 4800.0;
+    int32_t v = noise(hiss) + (int32_t)(tone * sin(2.0 * M_PI * f * (double)i / TEST_RATE));
+    if (clip) {
+      v *= 8;
+    }
+    out[i] = (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+  }
+}
+
+// Encodes pcm as consecutive FLAC frames and decodes them back.
+static size_t flac_round_trip(const int16_t *pcm, size_t n, int16_t *decoded) {
+  uint8_t *frame = malloc(FLAC_MAX_FRAME_BYTES(FLAC_BLOCK_SAMPLES));
+  uint32_t *scratch = malloc(FLAC_BLOCK_SAMPLES * sizeof(uint32_t));
+  TEST_ASSERT_NOT_NULL(frame);
+  TEST_ASSERT_NOT_NULL(scratch);
+
+  size_t encoded = 0;
+  uint32_t frame_number = 0;
+  for (size_t off = 0; off < n; off += FLAC_BLOCK_SAMPLES, frame_number++) {
+    size_t count = n - off < FLAC_BLOCK_SAMPLES ? n - off : FLAC_BLOCK_SAMPLES;
+    size_t bytes = flac_encode_frame(pcm + off, count, frame_number, TEST_RATE, scratch, frame);
+    TEST_ASSERT_GREATER_THAN(0, bytes);
+    TEST_ASSERT_LESS_OR_EQUAL(FLAC_MAX_FRAME_BYTES(count), bytes);
+
+    size_t got = 0;
+    TEST_ASSERT_EQUAL(bytes, flac_decode_frame(frame, bytes, decoded + off, FLAC_BLOCK_SAMPLES, &got));
+    TEST_ASSERT_EQUAL(count, got);
+    encoded += bytes;
+  }
+  free(frame);
+  free(scratch);
+  return encoded;
+}
+
+TEST_CASE("FLAC frames decode bit-exact", "[audio_codec]")
+{
+  const size_t n = 3 * FLAC_BLOCK_SAMPLES + 1000;  // short last frame
+  int16_t *pcm = malloc(n * sizeof(int16_t));
+  int16_t *out = malloc(n * sizeof(int16_t));
+  TEST_ASSERT_NOT_NULL(pcm);
+  TEST_ASSERT_NOT_NULL(out);
+
+  make_signal(pcm, n, 60, 3000, false);
+  size_t bytes = flac_round_trip(pcm, n, out);
+  TEST_ASSERT_EQUAL_MEMORY(pcm, out, n * sizeof(int16_t));
+  TEST_ASSERT_LESS_THAN(n * 2, bytes);
+
+  // Clipped full-scale noise pushes residuals past 16 bits (verbatim path).
+  make_signal(pcm, n, 30000, 30000, true);
+  flac_round_trip(pcm, n, out);
+  TEST_ASSERT_EQUAL_MEMORY(pcm, out, n * sizeof(int16_t));
+
+  // Digital silence and DC become constant subframes.
+  for (size_t i = 0; i < n; i++) {
+    pcm[i] = i < 2 * FLAC_BLOCK_SAMPLES ? 0 : -1234;
+  }
+  bytes = flac_round_trip(pcm, n, out);
+  TEST_ASSERT_EQUAL_MEMORY(pcm, out, n * sizeof(int16_t));
+  TEST_ASSERT_LESS_THAN(100, bytes);
+
+  // A one-sample stream still forms a valid frame.
+  flac_round_trip(pcm + n - 1, 1, out);
+  TEST_ASSERT_EQUAL_INT16(pcm[n - 1], out[0]);
+
+  free(pcm);
+  free(out);
+}
+
+TEST_CASE("FLAC decoder rejects corrupted frames", "[audio_codec]")
+{
+  int16_t pcm[FLAC_BLOCK_SAMPLES];
+  int16_t out[FLAC_BLOCK_SAMPLES];
+  make_signal(pcm, FLAC_BLOCK_SAMPLES, 200, 2000, false);
+
+  uint8_t *frame = malloc(FLAC_MAX_FRAME_BYTES(FLAC_BLOCK_SAMPLES));
+  uint32_t *scratch = malloc(FLAC_BLOCK_SAMPLES * sizeof(uint32_t));
+  size_t bytes = flac_encode_frame(pcm, FLAC_BLOCK_SAMPLES, 7, TEST_RATE, scratch, frame);
+
+  size_t got = 0;
+  frame[bytes / 2] ^= 0x10;
+  TEST_ASSERT_EQUAL(0, flac_decode_frame(frame, bytes, out, FLAC_BLOCK_SAMPLES, &got));
+  frame[bytes / 2] ^= 0x10;
+  frame[4] ^= 0x01;  // header byte, caught by CRC-8
+  TEST_ASSERT_EQUAL(0, flac_decode_frame(frame, bytes, out, FLAC_BLOCK_SAMPLES, &got));
+  frame[4] ^= 0x01;
+  TEST_ASSERT_EQUAL(bytes, flac_decode_frame(frame, bytes, out, FLAC_BLOCK_SAMPLES, &got));
+
+  free(frame);
+  free(scratch);
+}
+
+TEST_CASE("IMA-ADPCM decode matches encoder reconstruction", "[audio_codec]")
+{
+  const size_t blocks = 6;
+  const size_t n = blocks * IMA_ADPCM_BLOCK_SAMPLES - 100;  // short last block
+  int16_t *pcm = malloc(n * sizeof(int16_t));
+  int16_t *recon = malloc(n * sizeof(int16_t));
+  int16_t decoded[IMA_ADPCM_BLOCK_SAMPLES];
+  uint8_t block[IMA_ADPCM_BLOCK_BYTES];
+  TEST_ASSERT_NOT_NULL(pcm);
+  TEST_ASSERT_NOT_NULL(recon);
+  make_signal(pcm, n, 100, 4000, false);
+
+  uint8_t index = 0;
+  double err2 = 0.0;
+  double sig2 = 0.0;
+  for (size_t off = 0; off < n; off += IMA_ADPCM_BLOCK_SAMPLES) {
+    size_t count = n - off < IMA_ADPCM_BLOCK_SAMPLES ? n - off : IMA_ADPCM_BLOCK_SAMPLES;
+    TEST_ASSERT_EQUAL(IMA_ADPCM_BLOCK_BYTES, ima_adpcm_encode_block(&index, pcm + off, count, block, recon + off));
+    TEST_ASSERT_EQUAL(IMA_ADPCM_BLOCK_SAMPLES, ima_adpcm_decode_block(block, sizeof(block), decoded));
+    TEST_ASSERT_EQUAL_MEMORY(recon + off, decoded, count * sizeof(int16_t));
+  }
+  for (size_t i = 0; i < n; i++) {
+    double e = (double)pcm[i] - recon[i];
+    err2 += e * e;
+    sig2 += (double)pcm[i] * pcm[i];
+  }
+  double snr_db = 10.0 * log10(sig2 / err2);
+  printf("ima_adpcm: SNR %.1f dB\n", snr_db);
+  // A 2-4 kHz chirp is ADPCM's hard case (~6 dB lost per octave); low tones
+  // reach 30-40 dB.
+  TEST_ASSERT_GREATER_THAN(15, (int)snr_db);
+
+  free(pcm);
+  free(recon);
+}
+
+TEST_CASE("Audio codec encode throughput and ratio", "[audio_codec]")
+{
+  const size_t n = 8 * FLAC_BLOCK_SAMPLES;
+  int16_t *pcm = malloc(n * sizeof(int16_t));
+  uint8_t *frame = malloc(FLAC_MAX_FRAME_BYTES(FLAC_BLOCK_SAMPLES));
+  uint32_t *scratch = malloc(FLAC_BLOCK_SAMPLES * sizeof(uint32_t));
+  TEST_ASSERT_NOT_NULL(pcm);
+  TEST_ASSERT_NOT_NULL(frame);
+  TEST_ASSERT_NOT_NULL(scratch);
+  make_signal(pcm, n, 60, 2000, false);
+
+  size_t flac_bytes = 0;
+  int64_t t0 = esp_timer_get_time();
+  for (size_t off = 0; off < n; off += FLAC_BLOCK_SAMPLES) {
+    flac_bytes += flac_encode_frame(pcm + off, FLAC_BLOCK_SAMPLES, (uint32_t)(off / FLAC_BLOCK_SAMPLES), TEST_RATE,
+                                    scratch, frame);
+  }
+  int64_t flac_us = esp_timer_get_time() - t0;
+
+  size_t ima_bytes = 0;
+  uint8_t index = 0;
+  t0 = esp_timer_get_time();
+  for (size_t off = 0; off + IMA_ADPCM_BLOCK_SAMPLES <= n; off += IMA_ADPCM_BLOCK_SAMPLES) {
+    ima_bytes += ima_adpcm_encode_block(&index, pcm + off, IMA_ADPCM_BLOCK_SAMPLES, frame, NULL);
+  }
+  int64_t ima_us = esp_timer_get_time() - t0;
+  size_t ima_samples = n - n % IMA_ADPCM_BLOCK_SAMPLES;
+
+  printf("flac: %.2f Msamples/s, ratio %.2f:1\n", (double)n / (double)flac_us, (double)(n * 2) / flac_bytes);
+  printf("ima_adpcm: %.2f Msamples/s, ratio %.2f:1\n", (double)ima_samples / (double)ima_us,
+         (double)(ima_samples * 2) / ima_bytes);
+
+  // Both must run far faster than the 16 kHz capture rate on one core.
+  TEST_ASSERT_LESS_THAN((int64_t)n * 1000000 / TEST_RATE / 10, flac_us);
+  TEST_ASSERT_LESS_THAN((int64_t)ima_samples * 1000000 / TEST_RATE / 10, ima_us);
+
+  free(pcm);
+  free(frame);
+  free(scratch);
+}
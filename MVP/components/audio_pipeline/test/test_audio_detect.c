@@ -0,0 +1,117 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "unity.h"
+
+#include "audio_detect.h"
+
+#define TEST_FRAME 512U
+
+static uint32_t s_lcg = 12345;
+
+static int16_t noise(int32_t amplitude) {
+  s_lcg = s_lcg * 1664525U + 1013904223U;
+  return (int16_t)(((int32_t)(s_lcg >> 16) - 32768) * amplitude / 32768);
+}
+
+// Fills one frame: DC offset + white noise + optional square-ish tone.
+static void make_frame(int16_t *out, int16_t dc, int32_t noise_amp, int32_t tone_amp) {
+  for (size_t i = 0; i < TEST_FRAME; i++) {
+    int32_t v = dc + noise(noise_amp) + (((i / 8) & 1) ? tone_amp : -tone_amp);
+    out[i] = (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+  }
+}
+
+TEST_CASE("Audio detect fires once per burst with hysteresis", "[audio_detect]")
+{
+  int16_t frame[TEST_FRAME];
+  audio_detect_t det;
+  audio_detect_init(&det, NULL);
+  s_lcg = 1;
+
+  int onsets = 0;
+  audio_detect_frame_t info = {0};
+  for (int f = 0; f < 40; f++) {
+    make_frame(frame, 0, 200, 0);
+    onsets += audio_detect_process(&det, frame, TEST_FRAME, &info);
+  }
+  TEST_ASSERT_EQUAL(0, onsets);
+  TEST_ASSERT_FALSE(info.active);
+
+  // A 10-frame burst well above the floor, with one quieter frame in the
+  // middle that must not split it into two events.
+  for (int f = 0; f < 10; f++) {
+    make_frame(frame, 0, 200, f == 5 ? 400 : 3000);
+    onsets += audio_detect_process(&det, frame, TEST_FRAME, &info);
+    TEST_ASSERT_TRUE(info.active);
+  }
+  TEST_ASSERT_EQUAL(1, onsets);
+  TEST_ASSERT_GREATER_THAN(2500, info.rms);
+  TEST_ASSERT_GREATER_OR_EQUAL(info.rms, info.peak);
+
+  for (int f = 0; f < 20; f++) {
+    make_frame(frame, 0, 200, 0);
+    onsets += audio_detect_process(&det, frame, TEST_FRAME, &info);
+  }
+  TEST_ASSERT_FALSE(info.active);
+  TEST_ASSERT_EQUAL(1, onsets);
+}
+
+TEST_CASE("Audio detect ignores DC offset and slowly rising noise", "[audio_detect]")
+{
+  int16_t frame[TEST_FRAME];
+  audio_detect_t det;
+  audio_detect_init(&det, NULL);
+  s_lcg = 7;
+
+  // The old per-sample threshold of 2500 would fire on every frame here.
+  int onsets = 0;
+  audio_detect_frame_t info = {0};
+  for (int f = 0; f < 20; f++) {
+    make_frame(frame, 4000, 150, 0);
+    onsets += audio_detect_process(&det, frame, TEST_FRAME, &info);
+  }
+  TEST_ASSERT_EQUAL(0, onsets);
+  TEST_ASSERT_LESS_THAN(200, info.rms);
+
+  // Wind-like build-up: noise grows ~3% per frame up to 10x.
+  int32_t amp = 150;
+  for (int f = 0; f < 200; f++) {
+    make_frame(frame, 4000, amp, 0);
+    onsets += audio_detect_process(&det, frame, TEST_FRAME, &info);
+    if (amp < 1500) {
+      amp = amp * 103 / 100;
+    }
+  }
+  TEST_ASSERT_EQUAL(0, onsets);
+  TEST_ASSERT_GREATER_THAN(400, info.floor_rms);
+}
+
+TEST_CASE("Audio detect throughput", "[audio_detect]")
+{
+  const int frames = 2000;
+  int16_t *pcm = malloc(TEST_FRAME * sizeof(int16_t));
+  TEST_ASSERT_NOT_NULL(pcm);
+  s_lcg = 3;
+  make_frame(pcm, 100, 2000, 500);
+
+  audio_detect_t det;
+  audio_detect_init(&det, NULL);
+  audio_detect_frame_t info;
+
+  int64_t t0 = esp_timer_get_time();
+  for (int f = 0; f < frames; f++) {
+    audio_detect_process(&det, pcm, TEST_FRAME, &info);
+  }
+  int64_t us = esp_timer_get_time() - t0;
+  double msps = (double)frames * TEST_FRAME / (double)us;
+  printf("audio_detect: %.2f Msamples/s (%.1f us per %u-sample frame)\n", msps, (double)us / frames,
+         (unsigned)TEST_FRAME);
+
+  // 16 kHz realtime is 0.016 Msamples/s; demand well over 100x headroom.
+  TEST_ASSERT_GREATER_THAN(2, (int)msps);
+  free(pcm);
+}
@@ -0,0 +1,151 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "unity.h"
+
+#include "audio_pcm.h"
+#include "audio_ring.h"
+
+static void fill_ramp(int32_t *buf, size_t count, int32_t start) {
+  for (size_t i = 0; i < count; i++) {
+    buf[i] = start + (int32_t)i;
+  }
+}
+
+TEST_CASE("Audio ring write/read preserves order across wrap", "[audio_ring]")
+{
+  audio_ring_t rb = {0};
+  TEST_ESP_OK(audio_ring_init(&rb, 10, sizeof(int32_t)));
+
+  int32_t in[7];
+  int32_t out[10];
+  int32_t next = 0;
+  int32_t expect = 0;
+  for (int round = 0; round < 20; round++) {
+    fill_ramp(in, 7, next);
+    TEST_ASSERT_EQUAL(7, audio_ring_write(&rb, in, 7));
+    next += 7;
+
+    size_t n = audio_ring_read(&rb, out, 7);
+    TEST_ASSERT_EQUAL(7, n);
+    for (size_t i = 0; i < n; i++) {
+      TEST_ASSERT_EQUAL_INT32(expect++, out[i]);
+    }
+  }
+  TEST_ASSERT_EQUAL(0, audio_ring_used(&rb));
+  audio_ring_free(&rb);
+}
+
+TEST_CASE("Audio ring write stops when full", "[audio_ring]")
+{
+  audio_ring_t rb = {0};
+  TEST_ESP_OK(audio_ring_init(&rb, 8, sizeof(int32_t)));
+
+  int32_t in[12];
+  fill_ramp(in, 12, 0);
+  TEST_ASSERT_EQUAL(8, audio_ring_write(&rb, in, 12));
+  TEST_ASSERT_EQUAL(8, audio_ring_used(&rb));
+  TEST_ASSERT_EQUAL(0, audio_ring_free_space(&rb));
+  TEST_ASSERT_EQUAL(0, audio_ring_write(&rb, in, 1));
+  audio_ring_free(&rb);
+}
+
+TEST_CASE("Audio ring overwrite keeps newest samples and peeks two spans", "[audio_ring]")
+{
+  audio_ring_t rb = {0};
+  TEST_ESP_OK(audio_ring_init(&rb, 10, sizeof(int32_t)));
+
+  int32_t in[25];
+  fill_ramp(in, 25, 100);
+  audio_ring_write_overwrite(&rb, in, 6);
+  audio_ring_write_overwrite(&rb, in + 6, 6);
+  TEST_ASSERT_EQUAL(10, audio_ring_used(&rb));
+
+  audio_ring_span_t spans[2];
+  TEST_ASSERT_EQUAL(10, audio_ring_peek(&rb, spans));
+  TEST_ASSERT_EQUAL(8, spans[0].count);
+  TEST_ASSERT_EQUAL(2, spans[1].count);
+  const int32_t *a = (const int32_t *)spans[0].data;
+  const int32_t *b = (const int32_t *)spans[1].data;
+  TEST_ASSERT_EQUAL_INT32(102, a[0]);
+  TEST_ASSERT_EQUAL_INT32(109, a[7]);
+  TEST_ASSERT_EQUAL_INT32(110, b[0]);
+  TEST_ASSERT_EQUAL_INT32(111, b[1]);
+
+  // A single write larger than the ring keeps only its tail.
+  audio_ring_write_overwrite(&rb, in, 25);
+  int32_t out[10];
+  TEST_ASSERT_EQUAL(10, audio_ring_read(&rb, out, 10));
+  for (int i = 0; i < 10; i++) {
+    TEST_ASSERT_EQUAL_INT32(115 + i, out[i]);
+  }
+  audio_ring_free(&rb);
+}
+
+TEST_CASE("Audio ring ingest converts I2S words once with saturation", "[audio_ring]")
+{
+  const int32_t words[4] = {1000 << 11, -(1000 << 11), INT32_MAX, INT32_MIN};
+
+  audio_ring_t rb = {0};
+  TEST_ESP_OK(audio_ring_init(&rb, 3, audio_pcm_bytes_per_sample(AUDIO_SAMPLE_PCM16)));
+  TEST_ASSERT_EQUAL(3, audio_pcm_ring_ingest(&rb, AUDIO_SAMPLE_PCM16, words, 3, 11, true));
+  TEST_ASSERT_EQUAL(1, audio_pcm_ring_ingest(&rb, AUDIO_SAMPLE_PCM16, words + 3, 1, 11, true));
+
+  int16_t pcm16[3];
+  TEST_ASSERT_EQUAL(3, audio_ring_read(&rb, pcm16, 3));
+  TEST_ASSERT_EQUAL_INT16(-1000, pcm16[0]);
+  TEST_ASSERT_EQUAL_INT16(INT16_MAX, pcm16[1]);
+  TEST_ASSERT_EQUAL_INT16(INT16_MIN, pcm16[2]);
+  audio_ring_free(&rb);
+
+  uint8_t pcm24[6];
+  audio_pcm_from_i2s(AUDIO_SAMPLE_PCM24, words, pcm24, 2, 11);
+  TEST_ASSERT_EQUAL_HEX8(0x00, pcm24[0]);
+  TEST_ASSERT_EQUAL_HEX8(0xE8, pcm24[1]);
+  TEST_ASSERT_EQUAL_HEX8(0x03, pcm24[2]);
+  TEST_ASSERT_EQUAL_HEX8(0x00, pcm24[3]);
+  TEST_ASSERT_EQUAL_HEX8(0x18, pcm24[4]);
+  TEST_ASSERT_EQUAL_HEX8(0xFC, pcm24[5]);
+
+  // Left channel of interleaved stereo frames.
+  int16_t left[2];
+  audio_pcm16_from_i2s_strided(words, 2, left, 2, 11);
+  TEST_ASSERT_EQUAL_INT16(1000, left[0]);
+  TEST_ASSERT_EQUAL_INT16(INT16_MAX, left[1]);
+}
+
+TEST_CASE("Audio ring throughput", "[audio_ring]")
+{
+  const size_t capacity = 16000 * 5;
+  const size_t chunk = 512;
+  const size_t rounds = 2000;
+
+  audio_ring_t rb = {0};
+  TEST_ESP_OK(audio_ring_init(&rb, capacity, sizeof(int32_t)));
+  int32_t *buf = malloc(chunk * sizeof(int32_t));
+  TEST_ASSERT_NOT_NULL(buf);
+  fill_ramp(buf, chunk, 0);
+
+  int64_t t0 = esp_timer_get_time();
+  for (size_t i = 0; i < rounds; i++) {
+    audio_ring_write_overwrite(&rb, buf, chunk);
+  }
+  int64_t t_write = esp_timer_get_time() - t0;
+
+  t0 = esp_timer_get_time();
+  for (size_t i = 0; i < rounds; i++) {
+    audio_ring_write(&rb, buf, chunk);
+    audio_ring_read(&rb, buf, chunk);
+  }
+  int64_t t_rw = esp_timer_get_time() - t0;
+
+  double mbytes = (double)(rounds * chunk * sizeof(int32_t)) / (1024.0 * 1024.0);
+  printf("audio_ring overwrite: %.2f MB/s\n", mbytes / ((double)t_write / 1e6));
+  printf("audio_ring write+read: %.2f MB/s\n", mbytes / ((double)t_rw / 1e6));
+
+  free(buf);
+  audio_ring_free(&rb);
+}
@@ -0,0 +1,135 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_timer.h"
+#include "unity.h"
+
+#include "audio_spectral.h"
+
+#define TEST_RATE  16000U
+#define TEST_FRAME 512U
+
+static uint32_t s_lcg = 99;
+
+static int32_t noise(int32_t amplitude) {
+  s_lcg = s_lcg * 1664525U + 1013904223U;
+  return ((int32_t)(s_lcg >> 16) - 32768) * amplitude / 32768;
+}
+
+static int16_t clamp16(int32_t v) {
+  return (int16_t)(v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v));
+}
+
+// Wind stand-in (white noise through three ~160 Hz poles, so almost nothing
+// reaches 2 kHz) plus mic hiss and an optional 3 kHz tone (birdsong band).
+static void make_frame(int16_t *out, int32_t lp[3], int32_t wind_amp, int32_t tone_amp, uint32_t *phase) {
+  for (size_t i = 0; i < TEST_FRAME; i++) {
+    lp[0] += (noise(wind_amp * 32) - lp[0]) / 16;
+    lp[1] += (lp[0] - lp[1]) / 16;
+    lp[2] += (lp[1] - lp[2]) / 16;
+    int32_t tone = (int32_t)(tone_amp * sin(2.0 * M_PI * 3000.0 * (double)(*phase)++ / TEST_RATE));
+    out[i] = clamp16(lp[2] + noise(40) + tone);
+  }
+}
+
+TEST_CASE("Audio spectral FFT puts a tone in its bin", "[audio_spectral]")
+{
+  audio_spectral_config_t cfg;
+  audio_spectral_default_config(&cfg, TEST_RATE);
+  audio_spectral_t sp;
+  TEST_ASSERT_TRUE(audio_spectral_init(&sp, &cfg));
+
+  // Bin 48 of a 512-point FFT at 16 kHz is 1500 Hz; amplitude 2^26 in the
+  // FFT input domain should come out as 2^26 / 2 in bins 48 and 512-48.
+  // Q15 twiddles bound the error: peak within 1/4096, spurs below -90 dB.
+  const uint32_t bin = 48;
+  for (size_t i = 0; i < TEST_FRAME; i++) {
+    sp.re[i] = (int32_t)lround(67108864.0 * cos(2.0 * M_PI * bin * i / TEST_FRAME));
+    sp.im[i] = 0;
+  }
+  audio_spectral_fft(&sp);
+
+  TEST_ASSERT_INT32_WITHIN(8192, 33554432, sp.re[bin]);
+  TEST_ASSERT_INT32_WITHIN(8192, 33554432, sp.re[TEST_FRAME - bin]);
+  TEST_ASSERT_INT32_WITHIN(1024, 0, sp.im[bin]);
+  for (uint32_t k = 0; k < TEST_FRAME; k++) {
+    if (k != bin && k != TEST_FRAME - bin) {
+      TEST_ASSERT_INT32_WITHIN(1024, 0, sp.re[k]);
+      TEST_ASSERT_INT32_WITHIN(1024, 0, sp.im[k]);
+    }
+  }
+  audio_spectral_free(&sp);
+}
+
+TEST_CASE("Audio spectral triggers on in-band tone, not on wind", "[audio_spectral]")
+{
+  audio_spectral_config_t cfg;
+  audio_spectral_default_config(&cfg, TEST_RATE);
+  audio_spectral_t sp;
+  TEST_ASSERT_TRUE(audio_spectral_init(&sp, &cfg));
+
+  int16_t frame[TEST_FRAME];
+  int32_t lp[3] = {0};
+  uint32_t phase = 0;
+  int onsets = 0;
+  audio_spectral_frame_t info = {0};
+  s_lcg = 5;
+
+  for (int f = 0; f < 30; f++) {
+    make_frame(frame, lp, 100, 0, &phase);
+    onsets += audio_spectral_process(&sp, frame, TEST_FRAME, &info);
+  }
+  // Wind gust 10x louder: broadband energy jumps, the 2-8 kHz band does not.
+  for (int f = 0; f < 30; f++) {
+    make_frame(frame, lp, 1000, 0, &phase);
+    onsets += audio_spectral_process(&sp, frame, TEST_FRAME, &info);
+  }
+  TEST_ASSERT_EQUAL(0, onsets);
+
+  for (int f = 0; f < 10; f++) {
+    make_frame(frame, lp, 1000, 800, &phase);
+    onsets += audio_spectral_process(&sp, frame, TEST_FRAME, &info);
+  }
+  TEST_ASSERT_EQUAL(1, onsets);
+  TEST_ASSERT_TRUE(info.active);
+
+  for (int f = 0; f < 20; f++) {
+    make_frame(frame, lp, 1000, 0, &phase);
+    audio_spectral_process(&sp, frame, TEST_FRAME, &info);
+  }
+  TEST_ASSERT_FALSE(info.active);
+  audio_spectral_free(&sp);
+}
+
+TEST_CASE("Audio spectral throughput and CPU per audio second", "[audio_spectral]")
+{
+  audio_spectral_config_t cfg;
+  audio_spectral_default_config(&cfg, TEST_RATE);
+  audio_spectral_t sp;
+  TEST_ASSERT_TRUE(audio_spectral_init(&sp, &cfg));
+
+  int16_t frame[TEST_FRAME];
+  int32_t lp[3] = {0};
+  uint32_t phase = 0;
+  make_frame(frame, lp, 500, 500, &phase);
+
+  const int frames = 200;
+  audio_spectral_frame_t info;
+  int64_t t0 = esp_timer_get_time();
+  for (int f = 0; f < frames; f++) {
+    audio_spectral_process(&sp, frame, TEST_FRAME, &info);
+  }
+  int64_t us = esp_timer_get_time() - t0;
+
+  double audio_s = (double)frames * TEST_FRAME / TEST_RATE;
+  double cpu_ms_per_s = (double)us / 1000.0 / audio_s;
+  printf("audio_spectral: %.1f us per %u-point frame, %.2f Msamples/s, %.1f ms CPU per audio second\n",
+         (double)us / frames, (unsigned)TEST_FRAME, (double)frames * TEST_FRAME / (double)us, cpu_ms_per_s);
+
+  // Must stay well inside real time on one core: under 10% at 16 kHz.
+  TEST_ASSERT_LESS_THAN(100, (int)cpu_ms_per_s);
+  audio_spectral_free(&sp);
+}
@@ -0,0 +1,215 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+
+#include "audio_ring.h"
+#include "audio_writer.h"
+
+#define TEST_BLOCK_BYTES 64U
+
+typedef struct {
+  uint8_t *out;
+  size_t out_cap;
+  size_t out_len;
+  uint32_t latency_ms;
+  int opens;
+  int closes;
+} fake_sink_t;
+
+static esp_err_t fake_open(void *ctx) {
+  ((fake_sink_t *)ctx)->opens++;
+  return ESP_OK;
+}
+
+// Stands in for the SD card: copies the data and sleeps for the injected
+// storage latency.
+static esp_err_t fake_write(void *ctx, const void *data, size_t len) {
+  fake_sink_t *sink = (fake_sink_t *)ctx;
+  if (sink->latency_ms > 0) {
+    vTaskDelay(pdMS_TO_TICKS(sink->latency_ms));
+  }
+  if (sink->out_len + len > sink->out_cap) {
+    return ESP_FAIL;
+  }
+  memcpy(sink->out + sink->out_len, data, len);
+  sink->out_len += len;
+  return ESP_OK;
+}
+
+static esp_err_t fake_close(void *ctx) {
+  ((fake_sink_t *)ctx)->closes++;
+  return ESP_OK;
+}
+
+static void run_clip(audio_writer_t *aw, fake_sink_t *sink, const audio_ring_t *pre_roll, uint32_t blocks,
+                     uint32_t interval_ms) {
+  audio_writer_sink_t s = {.open = fake_open, .write = fake_write, .close = fake_close, .ctx = sink};
+  TEST_ESP_OK(audio_writer_begin(aw, &s, pre_roll));
+
+  // Every block carries its sequence number so ordering can be checked.
+  for (uint32_t seq = 0; seq < blocks; seq++) {
+    audio_writer_block_t *blk = audio_writer_acquire(aw);
+    if (blk) {
+      memset(blk->data, 0, TEST_BLOCK_BYTES);
+      memcpy(blk->data, &seq, sizeof(seq));
+      blk->len = TEST_BLOCK_BYTES;
+      TEST_ESP_OK(audio_writer_submit(aw, blk));
+    }
+    vTaskDelay(pdMS_TO_TICKS(interval_ms));
+  }
+  TEST_ESP_OK(audio_writer_end(aw));
+
+  while (audio_writer_clip_active(aw)) {
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+}
+
+TEST_CASE("Audio writer streams pre-roll then blocks in order", "[audio_writer]")
+{
+  audio_ring_t ring = {0};
+  TEST_ESP_OK(audio_ring_init(&ring, 50, sizeof(int16_t)));
+  int16_t pre[80];
+  for (int i = 0; i < 80; i++) {
+    pre[i] = (int16_t)i;
+  }
+  audio_ring_write_overwrite(&ring, pre, 80);
+
+  fake_sink_t sink = {.out_cap = 8192};
+  sink.out = malloc(sink.out_cap);
+  TEST_ASSERT_NOT_NULL(sink.out);
+
+  audio_writer_t aw;
+  audio_writer_config_t cfg = {
+      .block_count = 8,
+      .block_bytes = TEST_BLOCK_BYTES,
+      .task_priority = 2,
+      .task_core = tskNO_AFFINITY,
+      .task_stack = 4096,
+  };
+  TEST_ESP_OK(audio_writer_init(&aw, &cfg));
+  run_clip(&aw, &sink, &ring, 20, 2);
+  TEST_ASSERT_FALSE(audio_writer_ring_busy(&aw));
+
+  audio_writer_stats_t stats;
+  audio_writer_get_stats(&aw, &stats);
+  TEST_ASSERT_EQUAL(0, stats.overruns);
+  TEST_ASSERT_EQUAL(20, stats.blocks_written);
+  TEST_ASSERT_EQUAL(1, sink.opens);
+  TEST_ASSERT_EQUAL(1, sink.closes);
+
+  TEST_ASSERT_EQUAL(50 * sizeof(int16_t) + 20 * TEST_BLOCK_BYTES, sink.out_len);
+  const int16_t *pcm = (const int16_t *)sink.out;
+  TEST_ASSERT_EQUAL_INT16(30, pcm[0]);
+  TEST_ASSERT_EQUAL_INT16(79, pcm[49]);
+  for (uint32_t seq = 0; seq < 20; seq++) {
+    uint32_t got;
+    memcpy(&got, sink.out + 50 * sizeof(int16_t) + seq * TEST_BLOCK_BYTES, sizeof(got));
+    TEST_ASSERT_EQUAL_UINT32(seq, got);
+  }
+
+  audio_writer_deinit(&aw);
+  audio_ring_free(&ring);
+  free(sink.out);
+}
+
+TEST_CASE("Audio writer counts overruns under injected storage latency", "[audio_writer]")
+{
+  fake_sink_t sink = {.out_cap = 8192, .latency_ms = 20};
+  sink.out = malloc(sink.out_cap);
+  TEST_ASSERT_NOT_NULL(sink.out);
+
+  audio_writer_t aw;
+  audio_writer_config_t cfg = {
+      .block_count = 8,
+      .block_bytes = TEST_BLOCK_BYTES,
+      .task_priority = 2,
+      .task_core = tskNO_AFFINITY,
+      .task_stack = 4096,
+  };
+  TEST_ESP_OK(audio_writer_init(&aw, &cfg));
+  run_clip(&aw, &sink, NULL, 40, 2);
+
+  audio_writer_stats_t stats;
+  audio_writer_get_stats(&aw, &stats);
+  printf("audio_writer: written=%u overruns=%u high_water=%u max_write=%u us\n", (unsigned)stats.blocks_written,
+         (unsigned)stats.overruns, (unsigned)stats.queue_high_water, (unsigned)stats.max_write_us);
+
+  TEST_ASSERT_GREATER_THAN(0, stats.overruns);
+  TEST_ASSERT_EQUAL(40, stats.blocks_written + stats.overruns);
+  TEST_ASSERT_LESS_OR_EQUAL(cfg.block_count, stats.queue_high_water);
+  TEST_ASSERT_GREATER_OR_EQUAL(20000, stats.max_write_us);
+
+  // Dropped blocks leave gaps, but what was written is still in order.
+  uint32_t prev = 0;
+  for (size_t off = 0; off < sink.out_len; off += TEST_BLOCK_BYTES) {
+    uint32_t got;
+    memcpy(&got, sink.out + off, sizeof(got));
+    if (off > 0) {
+      TEST_ASSERT_GREATER_THAN(prev, got);
+    }
+    prev = got;
+  }
+
+  audio_writer_deinit(&aw);
+  free(sink.out);
+}
+
+TEST_CASE("Audio writer opens the next clip while the previous one drains", "[audio_writer]")
+{
+  fake_sink_t sinks[2] = {{.out_cap = 4096, .latency_ms = 2}, {.out_cap = 4096}};
+  sinks[0].out = malloc(sinks[0].out_cap);
+  sinks[1].out = malloc(sinks[1].out_cap);
+  TEST_ASSERT_NOT_NULL(sinks[0].out);
+  TEST_ASSERT_NOT_NULL(sinks[1].out);
+
+  audio_writer_t aw;
+  audio_writer_config_t cfg = {
+      .block_count = 16,
+      .block_bytes = TEST_BLOCK_BYTES,
+      .task_priority = 2,
+      .task_core = tskNO_AFFINITY,
+      .task_stack = 4096,
+  };
+  TEST_ESP_OK(audio_writer_init(&aw, &cfg));
+
+  // One sequence split across two clips with no wait at the boundary, the
+  // way continuous recording rolls segments.
+  uint32_t seq = 0;
+  for (int clip = 0; clip < 2; clip++) {
+    audio_writer_sink_t s = {.open = fake_open, .write = fake_write, .close = fake_close, .ctx = &sinks[clip]};
+    TEST_ESP_OK(audio_writer_begin(&aw, &s, NULL));
+    for (int i = 0; i < 6; i++, seq++) {
+      audio_writer_block_t *blk = audio_writer_acquire(&aw);
+      TEST_ASSERT_NOT_NULL(blk);
+      memset(blk->data, 0, TEST_BLOCK_BYTES);
+      memcpy(blk->data, &seq, sizeof(seq));
+      blk->len = TEST_BLOCK_BYTES;
+      TEST_ESP_OK(audio_writer_submit(&aw, blk));
+    }
+    TEST_ESP_OK(audio_writer_end(&aw));
+  }
+  TEST_ASSERT_TRUE(audio_writer_clip_active(&aw));
+  while (audio_writer_clip_active(&aw)) {
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+
+  for (int clip = 0; clip < 2; clip++) {
+    TEST_ASSERT_EQUAL(1, sinks[clip].opens);
+    TEST_ASSERT_EQUAL(1, sinks[clip].closes);
+    TEST_ASSERT_EQUAL(6 * TEST_BLOCK_BYTES, sinks[clip].out_len);
+    for (uint32_t i = 0; i < 6; i++) {
+      uint32_t got;
+      memcpy(&got, sinks[clip].out + i * TEST_BLOCK_BYTES, sizeof(got));
+      TEST_ASSERT_EQUAL_UINT32(clip * 6 + i, got);
+    }
+  }
+
+  audio_writer_deinit(&aw);
+  free(sinks[0].out);
+  free(sinks[1].out);
+}
@@ -0,0 +1,267 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "esp_vfs.h"
+#include "unity.h"
+
+#include "audio_codec.h"
+#include "audio_ring.h"
+#include "wav_writer.h"
+
+#define TEST_RATE      16000U
+#define TEST_MOUNT     "/wavmem"
+#define TEST_PATH      TEST_MOUNT "/clip"
+#define TEST_FILE_CAP  (64U * 1024U)
+// Not a multiple of any span below, so appends split across flushes and
+// some go straight to the file.
+#define TEST_BUF_BYTES 512U
+
+// Uneven spans around the codecs' block sizes; 0 marks where the ring goes.
+static const size_t k_spans[] = {1, 7, 300, IMA_ADPCM_BLOCK_SAMPLES, FLAC_BLOCK_SAMPLES - 1, 2, 2500, 0, 33, 3000};
+#define RING_CAPACITY 1000U
+#define RING_DROPPED  700U   // written before the kept part, so the ring wraps
+
+static int16_t *s_pcm;
+static size_t s_pcm_count;
+
+// One-file RAM filesystem standing in for the SD card, so the header patch
+// (seek back to 0 and rewrite) can be checked byte for byte.
+static struct {
+  uint8_t *data;
+  size_t size;
+  size_t pos;
+  bool open;
+} s_file;
+
+static int mem_open(const char *path, int flags, int mode) {
+  (void)path;
+  (void)mode;
+  if (s_file.open) {
+    errno = EBUSY;
+    return -1;
+  }
+  s_file.open = true;
+  s_file.pos = 0;
+  if (flags & O_TRUNC) {
+    s_file.size = 0;
+  }
+  return 0;
+}
+
+static ssize_t mem_write(int fd, const void *data, size_t size) {
+  (void)fd;
+  if (s_file.pos + size > TEST_FILE_CAP) {
+    errno = ENOSPC;
+    return -1;
+  }
+  memcpy(s_file.data + s_file.pos, data, size);
+  s_file.pos += size;
+  if (s_file.pos > s_file.size) {
+    s_file.size = s_file.pos;
+  }
+  return (ssize_t)size;
+}
+
+static off_t mem_lseek(int fd, off_t offset, int whence) {
+  (void)fd;
+  off_t base = whence == SEEK_CUR ? (off_t)s_file.pos : (whence == SEEK_END ? (off_t)s_file.size : 0);
+  if (base + offset < 0 || base + offset > (off_t)TEST_FILE_CAP) {
+    errno = EINVAL;
+    return -1;
+  }
+  s_file.pos = (size_t)(base + offset);
+  return (off_t)s_file.pos;
+}
+
+static int mem_close(int fd) {
+  (void)fd;
+  s_file.open = false;
+  return 0;
+}
+
+static int mem_fstat(int fd, struct stat *st) {
+  (void)fd;
+  memset(st, 0, sizeof(*st));
+  st->st_mode = S_IFREG | 0666;
+  st->st_size = (off_t)s_file.size;
+  return 0;
+}
+
+static void mem_fs_mount(void) {
+  static const esp_vfs_t vfs = {
+      .flags = ESP_VFS_FLAG_DEFAULT,
+      .write = mem_write,
+      .lseek = mem_lseek,
+      .open = mem_open,
+      .close = mem_close,
+      .fstat = mem_fstat,
+  };
+  memset(&s_file, 0, sizeof(s_file));
+  s_file.data = malloc(TEST_FILE_CAP);
+  TEST_ASSERT_NOT_NULL(s_file.data);
+  TEST_ESP_OK(esp_vfs_register(TEST_MOUNT, &vfs, NULL));
+}
+
+static void mem_fs_unmount(void) {
+  TEST_ESP_OK(esp_vfs_unregister(TEST_MOUNT));
+  free(s_file.data);
+  s_file.data = NULL;
+}
+
+static uint32_t le32(const uint8_t *p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint32_t be24(const uint8_t *p) {
+  return (uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | (uint32_t)p[2];
+}
+
+// Hiss plus a slow ramp, so no FLAC frame collapses to a constant.
+static void make_pcm(void) {
+  s_pcm_count = 0;
+  for (size_t i = 0; i < sizeof(k_spans) / sizeof(k_spans[0]); i++) {
+    s_pcm_count += k_spans[i] ? k_spans[i] : RING_CAPACITY;
+  }
+  s_pcm = malloc(s_pcm_count * sizeof(int16_t));
+  TEST_ASSERT_NOT_NULL(s_pcm);
+  uint32_t lcg = 7;
+  for (size_t i = 0; i < s_pcm_count; i++) {
+    lcg = lcg * 1664525U + 1013904223U;
+    s_pcm[i] = (int16_t)((int32_t)(lcg >> 22) - 512 + (int32_t)(i % 4000) * 4 - 8000);
+  }
+}
+
+// Streams s_pcm through the writer as uneven spans and one wrapped ring,
+// the way a clip gets its pre-roll and then the capture blocks.
+static void append_stream(wav_writer_t *w) {
+  audio_ring_t ring = {0};
+  TEST_ESP_OK(audio_ring_init(&ring, RING_CAPACITY, sizeof(int16_t)));
+  size_t pos = 0;
+  for (size_t i = 0; i < sizeof(k_spans) / sizeof(k_spans[0]); i++) {
+    if (k_spans[i] == 0) {
+      static const int16_t dropped[RING_DROPPED] = {0};
+      audio_ring_write_overwrite(&ring, dropped, RING_DROPPED);
+      audio_ring_write_overwrite(&ring, s_pcm + pos, RING_CAPACITY);
+      audio_ring_span_t spans[2];
+      TEST_ASSERT_EQUAL(RING_CAPACITY, audio_ring_peek(&ring, spans));
+      TEST_ASSERT_GREATER_THAN(0, spans[1].count);
+      TEST_ESP_OK(wav_writer_append_ring(w, &ring));
+      pos += RING_CAPACITY;
+    } else {
+      TEST_ESP_OK(wav_writer_append(w, s_pcm + pos, k_spans[i] * sizeof(int16_t)));
+      pos += k_spans[i];
+    }
+  }
+  TEST_ASSERT_EQUAL(s_pcm_count, pos);
+  audio_ring_free(&ring);
+}
+
+TEST_CASE("WAV writer patches PCM header sizes at finalize", "[wav_writer]")
+{
+  mem_fs_mount();
+  make_pcm();
+
+  wav_writer_t w;
+  TEST_ESP_OK(wav_writer_open(&w, TEST_PATH, TEST_RATE, 1, 16, TEST_BUF_BYTES));
+  append_stream(&w);
+  TEST_ESP_OK(wav_writer_finalize(&w));
+
+  const uint8_t *f = s_file.data;
+  const uint32_t data_bytes = (uint32_t)(s_pcm_count * sizeof(int16_t));
+  TEST_ASSERT_EQUAL(WAV_HEADER_BYTES + data_bytes, s_file.size);
+  TEST_ASSERT_EQUAL_MEMORY("RIFF", f, 4);
+  TEST_ASSERT_EQUAL_UINT32(s_file.size - 8, le32(f + 4));
+  TEST_ASSERT_EQUAL_MEMORY("data", f + 36, 4);
+  TEST_ASSERT_EQUAL_UINT32(data_bytes, le32(f + 40));
+  TEST_ASSERT_EQUAL_MEMORY(s_pcm, f + WAV_HEADER_BYTES, data_bytes);
+
+  free(s_pcm);
+  mem_fs_unmount();
+}
+
+TEST_CASE("WAV writer patches IMA-ADPCM sizes and fact sample count", "[wav_writer]")
+{
+  mem_fs_mount();
+  make_pcm();
+
+  wav_writer_t w;
+  TEST_ESP_OK(wav_writer_open_codec(&w, TEST_PATH, TEST_RATE, AUDIO_CODEC_IMA_ADPCM, TEST_BUF_BYTES));
+  append_stream(&w);
+  TEST_ESP_OK(wav_writer_finalize(&w));
+
+  // The last block is padded; fact carries the true length.
+  const uint8_t *f = s_file.data;
+  const uint32_t blocks = (uint32_t)((s_pcm_count + IMA_ADPCM_BLOCK_SAMPLES - 1) / IMA_ADPCM_BLOCK_SAMPLES);
+  const uint32_t data_bytes = blocks * IMA_ADPCM_BLOCK_BYTES;
+  TEST_ASSERT_EQUAL(IMA_ADPCM_HEADER_BYTES + data_bytes, s_file.size);
+  TEST_ASSERT_EQUAL_MEMORY("RIFF", f, 4);
+  TEST_ASSERT_EQUAL_UINT32(s_file.size - 8, le32(f + 4));
+  TEST_ASSERT_EQUAL_MEMORY("fact", f + 40, 4);
+  TEST_ASSERT_EQUAL_UINT32(s_pcm_count, le32(f + 48));
+  TEST_ASSERT_EQUAL_MEMORY("data", f + 52, 4);
+  TEST_ASSERT_EQUAL_UINT32(data_bytes, le32(f + 56));
+
+  int16_t *decoded = malloc(IMA_ADPCM_BLOCK_SAMPLES * sizeof(int16_t));
+  TEST_ASSERT_NOT_NULL(decoded);
+  for (uint32_t b = 0; b < blocks; b++) {
+    const uint8_t *block = f + IMA_ADPCM_HEADER_BYTES + b * IMA_ADPCM_BLOCK_BYTES;
+    TEST_ASSERT_EQUAL(IMA_ADPCM_BLOCK_SAMPLES, ima_adpcm_decode_block(block, IMA_ADPCM_BLOCK_BYTES, decoded));
+    // The block header stores its first sample as is.
+    TEST_ASSERT_EQUAL_INT16(s_pcm[b * IMA_ADPCM_BLOCK_SAMPLES], decoded[0]);
+  }
+
+  free(decoded);
+  free(s_pcm);
+  mem_fs_unmount();
+}
+
+TEST_CASE("WAV writer patches FLAC STREAMINFO at finalize", "[wav_writer]")
+{
+  mem_fs_mount();
+  make_pcm();
+
+  wav_writer_t w;
+  TEST_ESP_OK(wav_writer_open_codec(&w, TEST_PATH, TEST_RATE, AUDIO_CODEC_FLAC, TEST_BUF_BYTES));
+  append_stream(&w);
+  TEST_ESP_OK(wav_writer_finalize(&w));
+
+  const uint8_t *f = s_file.data;
+  const uint8_t *si = f + 8;
+  TEST_ASSERT_EQUAL_MEMORY("fLaC", f, 4);
+  TEST_ASSERT_EQUAL_HEX8(0x80, f[4]);  // last metadata block, STREAMINFO
+  // 36-bit total samples in the low bits of bytes 13-17.
+  uint64_t total = (uint64_t)(si[13] & 0x0F) << 32 | (uint64_t)be24(si + 14) << 8 | si[17];
+  TEST_ASSERT_EQUAL_UINT32(s_pcm_count, (uint32_t)total);
+  // MD5 is left unset (all zero), which decoders read as "not computed".
+  static const uint8_t no_md5[16] = {0};
+  TEST_ASSERT_EQUAL_MEMORY(no_md5, si + 18, sizeof(no_md5));
+
+  // Every frame decodes back to the input, and the frame size range in
+  // STREAMINFO covers the frames actually written.
+  const uint32_t min_frame = be24(si + 4);
+  const uint32_t max_frame = be24(si + 7);
+  int16_t *decoded = malloc(FLAC_BLOCK_SAMPLES * sizeof(int16_t));
+  TEST_ASSERT_NOT_NULL(decoded);
+  size_t off = FLAC_HEADER_BYTES;
+  size_t pos = 0;
+  while (off < s_file.size) {
+    size_t count = 0;
+    size_t bytes = flac_decode_frame(f + off, s_file.size - off, decoded, FLAC_BLOCK_SAMPLES, &count);
+    TEST_ASSERT_GREATER_THAN(0, bytes);
+    TEST_ASSERT_GREATER_OR_EQUAL(min_frame, bytes);
+    TEST_ASSERT_LESS_OR_EQUAL(max_frame, bytes);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(s_pcm + pos, decoded, count);
+    off += bytes;
+    pos += count;
+  }
+  TEST_ASSERT_EQUAL(s_pcm_count, pos);
+
+  free(decoded);
+  free(s_pcm);
+  mem_fs_unmount();
+}
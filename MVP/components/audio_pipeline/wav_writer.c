@@ -0,0 +1,300 @@
+#include "wav_writer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+static const char *TAG = "WAV_WRITER";
+
+static inline void put_le16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+void wav_build_header(uint8_t out[WAV_HEADER_BYTES], uint32_t sample_rate, uint16_t channels,
+                      uint16_t bits_per_sample, uint32_t data_size) {
+  uint16_t block_align = (uint16_t)(channels * bits_per_sample / 8U);
+
+  memcpy(out + 0, "RIFF", 4);
+  put_le32(out + 4, 36U + data_size);
+  memcpy(out + 8, "WAVE", 4);
+  memcpy(out + 12, "fmt ", 4);
+  put_le32(out + 16, 16U);
+  put_le16(out + 20, 1U);
+  put_le16(out + 22, channels);
+  put_le32(out + 24, sample_rate);
+  put_le32(out + 28, sample_rate * block_align);
+  put_le16(out + 32, block_align);
+  put_le16(out + 34, bits_per_sample);
+  memcpy(out + 36, "data", 4);
+  put_le32(out + 40, data_size);
+}
+
+static esp_err_t flush_buffer(wav_writer_t *w) {
+  if (w->buf_used == 0) {
+    return ESP_OK;
+  }
+  size_t written = fwrite(w->buf, 1, w->buf_used, w->file);
+  if (written != w->buf_used) {
+    ESP_LOGE(TAG, "Short write (%zu of %zu bytes)", written, w->buf_used);
+    return ESP_FAIL;
+  }
+  w->buf_used = 0;
+  return ESP_OK;
+}
+
+// Encoder buffers prefer internal RAM for speed; PSRAM is the fallback.
+static void *codec_alloc(size_t size) {
+  void *p = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  return p ? p : heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+}
+
+static void release_buffers(wav_writer_t *w) {
+  heap_caps_free(w->buf);
+  heap_caps_free(w->pending);
+  heap_caps_free(w->frame);
+  heap_caps_free(w->scratch);
+  w->buf = NULL;
+  w->pending = NULL;
+  w->frame = NULL;
+  w->scratch = NULL;
+}
+
+static esp_err_t open_file(wav_writer_t *w, const char *path, uint32_t sample_rate, uint16_t channels,
+                           uint16_t bits_per_sample, audio_codec_t codec, size_t buffer_size) {
+  if (!w || !path || channels == 0 || bits_per_sample == 0 ||
+      buffer_size < audio_codec_header_bytes(codec) || buffer_size < WAV_HEADER_BYTES) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  memset(w, 0, sizeof(*w));
+  w->codec = codec;
+
+  if (codec != AUDIO_CODEC_PCM) {
+    w->block_samples = audio_codec_block_samples(codec);
+    w->pending = (int16_t *)codec_alloc(w->block_samples * sizeof(int16_t));
+    w->frame = (uint8_t *)codec_alloc(audio_codec_max_block_bytes(codec));
+    if (codec == AUDIO_CODEC_FLAC) {
+      w->scratch = (uint32_t *)codec_alloc(w->block_samples * sizeof(uint32_t));
+    }
+    if (!w->pending || !w->frame || (codec == AUDIO_CODEC_FLAC && !w->scratch)) {
+      ESP_LOGE(TAG, "%s encoder allocation failed", audio_codec_name(codec));
+      release_buffers(w);
+      return ESP_ERR_NO_MEM;
+    }
+  }
+
+  // Internal DMA-capable RAM lets the SD driver transfer straight from the
+  // buffer; fall back to PSRAM when internal memory is tight.
+  w->buf = (uint8_t *)heap_caps_aligned_alloc(4, buffer_size, MALLOC_CAP_DMA);
+  if (!w->buf) {
+    w->buf = (uint8_t *)heap_caps_aligned_alloc(4, buffer_size, MALLOC_CAP_SPIRAM);
+  }
+  if (!w->buf) {
+    ESP_LOGE(TAG, "Write buffer allocation failed (%zu bytes)", buffer_size);
+    release_buffers(w);
+    return ESP_ERR_NO_MEM;
+  }
+
+  w->file = fopen(path, "wb+");
+  if (!w->file) {
+    release_buffers(w);
+    ESP_LOGW(TAG, "Failed to open %s", path);
+    return ESP_FAIL;
+  }
+  // The staging buffer already batches writes; skip the stdio copy.
+  setvbuf(w->file, NULL, _IONBF, 0);
+
+  w->buf_size = buffer_size;
+  w->sample_rate = sample_rate;
+  w->channels = channels;
+  w->bits_per_sample = bits_per_sample;
+
+  if (codec == AUDIO_CODEC_PCM) {
+    wav_build_header(w->buf, sample_rate, channels, bits_per_sample, 0);
+    w->buf_used = WAV_HEADER_BYTES;
+  } else {
+    w->buf_used = audio_codec_build_header(codec, w->buf, sample_rate, 0, 0, 0, 0);
+  }
+  return ESP_OK;
+}
+
+esp_err_t wav_writer_open(wav_writer_t *w, const char *path, uint32_t sample_rate, uint16_t channels,
+                          uint16_t bits_per_sample, size_t buffer_size) {
+  return open_file(w, path, sample_rate, channels, bits_per_sample, AUDIO_CODEC_PCM, buffer_size);
+}
+
+esp_err_t wav_writer_open_codec(wav_writer_t *w, const char *path, uint32_t sample_rate, audio_codec_t codec,
+                                size_t buffer_size) {
+  return open_file(w, path, sample_rate, 1, 16, codec, buffer_size);
+}
+
+// Stages encoded (or PCM) bytes for the file.
+static esp_err_t stage_bytes(wav_writer_t *w, const uint8_t *src, size_t len) {
+  w->data_bytes += (uint32_t)len;
+
+  while (len > 0) {
+    // Whole buffers' worth of input go straight to the file once the
+    // staging buffer is empty, keeping the cluster alignment.
+    if (w->buf_used == 0 && len >= w->buf_size) {
+      size_t direct = len - (len % w->buf_size);
+      if (fwrite(src, 1, direct, w->file) != direct) {
+        ESP_LOGE(TAG, "Short direct write (%zu bytes)", direct);
+        return ESP_FAIL;
+      }
+      src += direct;
+      len -= direct;
+      continue;
+    }
+
+    size_t n = w->buf_size - w->buf_used;
+    if (n > len) {
+      n = len;
+    }
+    memcpy(w->buf + w->buf_used, src, n);
+    w->buf_used += n;
+    src += n;
+    len -= n;
+
+    if (w->buf_used == w->buf_size) {
+      esp_err_t err = flush_buffer(w);
+      if (err != ESP_OK) {
+        return err;
+      }
+    }
+  }
+  return ESP_OK;
+}
+
+static esp_err_t encode_pending(wav_writer_t *w) {
+  if (w->pending_count == 0) {
+    return ESP_OK;
+  }
+
+  size_t bytes = 0;
+  if (w->codec == AUDIO_CODEC_IMA_ADPCM) {
+    bytes = ima_adpcm_encode_block(&w->ima_index, w->pending, w->pending_count, w->frame, NULL);
+  } else {
+    bytes = flac_encode_frame(w->pending, w->pending_count, w->frames, w->sample_rate, w->scratch, w->frame);
+  }
+  if (bytes == 0) {
+    return ESP_FAIL;
+  }
+
+  if (w->frames == 0 || bytes < w->min_frame_bytes) {
+    w->min_frame_bytes = (uint32_t)bytes;
+  }
+  if (bytes > w->max_frame_bytes) {
+    w->max_frame_bytes = (uint32_t)bytes;
+  }
+  w->frames++;
+  w->samples += (uint32_t)w->pending_count;
+  w->pending_count = 0;
+  return stage_bytes(w, w->frame, bytes);
+}
+
+esp_err_t wav_writer_append(wav_writer_t *w, const void *data, size_t len) {
+  if (!w || !w->file || (!data && len > 0)) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  if (w->codec == AUDIO_CODEC_PCM) {
+    w->samples += (uint32_t)(len / ((size_t)w->channels * w->bits_per_sample / 8U));
+    return stage_bytes(w, (const uint8_t *)data, len);
+  }
+
+  if (len % sizeof(int16_t) != 0) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  // Copy rather than cast: ring spans carry no alignment guarantee.
+  const uint8_t *src = (const uint8_t *)data;
+  size_t count = len / sizeof(int16_t);
+  while (count > 0) {
+    size_t n = w->block_samples - w->pending_count;
+    if (n > count) {
+      n = count;
+    }
+    memcpy(w->pending + w->pending_count, src, n * sizeof(int16_t));
+    w->pending_count += n;
+    src += n * sizeof(int16_t);
+    count -= n;
+
+    if (w->pending_count == w->block_samples) {
+      esp_err_t err = encode_pending(w);
+      if (err != ESP_OK) {
+        return err;
+      }
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t wav_writer_append_ring(wav_writer_t *w, const audio_ring_t *rb) {
+  audio_ring_span_t spans[2];
+  audio_ring_peek(rb, spans);
+
+  for (int i = 0; i < 2; i++) {
+    if (spans[i].count == 0) {
+      continue;
+    }
+    esp_err_t err = wav_writer_append(w, spans[i].data, spans[i].count * rb->elem_size);
+    if (err != ESP_OK) {
+      return err;
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t wav_writer_finalize(wav_writer_t *w) {
+  if (!w || !w->file) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  // The final short block is encoded here; FLAC frames may be short, IMA
+  // blocks are padded and the fact chunk carries the true length.
+  esp_err_t err = w->codec == AUDIO_CODEC_PCM ? ESP_OK : encode_pending(w);
+  if (err == ESP_OK) {
+    err = flush_buffer(w);
+  }
+  if (err == ESP_OK) {
+    uint8_t header[IMA_ADPCM_HEADER_BYTES];
+    size_t header_bytes = WAV_HEADER_BYTES;
+    if (w->codec == AUDIO_CODEC_PCM) {
+      wav_build_header(header, w->sample_rate, w->channels, w->bits_per_sample, w->data_bytes);
+    } else {
+      header_bytes = audio_codec_build_header(w->codec, header, w->sample_rate, w->samples, w->data_bytes,
+                                              w->min_frame_bytes, w->max_frame_bytes);
+    }
+    if (fseek(w->file, 0, SEEK_SET) != 0 || fwrite(header, 1, header_bytes, w->file) != header_bytes) {
+      ESP_LOGE(TAG, "Header patch failed");
+      err = ESP_FAIL;
+    }
+  }
+
+  if (fclose(w->file) != 0 && err == ESP_OK) {
+    err = ESP_FAIL;
+  }
+  w->file = NULL;
+  release_buffers(w);
+  return err;
+}
+
+void wav_writer_abort(wav_writer_t *w) {
+  if (!w) {
+    return;
+  }
+  if (w->file) {
+    fclose(w->file);
+    w->file = NULL;
+  }
+  release_buffers(w);
+}
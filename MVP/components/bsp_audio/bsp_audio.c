@@ -4,30 +4,118 @@
 
 #include "driver/i2s_std.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 static const char *TAG = "BSP_AUDIO";
 
+#define SETTLE_TIMEOUT_MS     (BSP_AUDIO_SETTLE_MS + 500)
+// The I2S DMA descriptor limit for a single buffer.
+#define DMA_BUFFER_MAX_BYTES  4092U
+
 static i2s_chan_handle_t s_rx_chan = NULL;
 static bool s_ready = false;
+static bool s_suspended = false;
+static bsp_audio_config_t s_cfg = BSP_AUDIO_CONFIG_DEFAULT();
+static bsp_audio_stats_t s_stats = {0};
+
+static size_t frame_bytes(const bsp_audio_config_t *cfg) {
+  return (size_t)cfg->channels * cfg->slot_bits / 8U;
+}
+
+static bool config_equal(const bsp_audio_config_t *a, const bsp_audio_config_t *b) {
+  return a->sample_rate_hz == b->sample_rate_hz && a->slot_bits == b->slot_bits && a->channels == b->channels &&
+         a->dma_desc_num == b->dma_desc_num && a->dma_frame_num == b->dma_frame_num && a->pcm_shift == b->pcm_shift;
+}
+
+esp_err_t bsp_audio_config_validate(const bsp_audio_config_t *cfg) {
+  if (!cfg || cfg->sample_rate_hz < 8000 || cfg->sample_rate_hz > 48000 ||
+      (cfg->slot_bits != 16 && cfg->slot_bits != 32) || (cfg->channels != 1 && cfg->channels != 2) ||
+      cfg->dma_desc_num < 2 || cfg->dma_desc_num > 16 || cfg->dma_frame_num < 8 ||
+      cfg->dma_frame_num * frame_bytes(cfg) > DMA_BUFFER_MAX_BYTES || cfg->pcm_shift > 24) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  return ESP_OK;
+}
+
+esp_err_t bsp_audio_profile_info(const bsp_audio_config_t *cfg, bsp_audio_profile_info_t *out) {
+  esp_err_t err = bsp_audio_config_validate(cfg);
+  if (err != ESP_OK || !out) {
+    return err != ESP_OK ? err : ESP_ERR_INVALID_ARG;
+  }
+  uint32_t buffer_bytes = (uint32_t)(cfg->dma_frame_num * frame_bytes(cfg));
+  out->dma_bytes = buffer_bytes * cfg->dma_desc_num;
+  out->dma_buffer_us = (uint32_t)((uint64_t)cfg->dma_frame_num * 1000000U / cfg->sample_rate_hz);
+  out->overrun_us = out->dma_buffer_us * cfg->dma_desc_num;
+  // Philips framing clocks both slots even in mono.
+  out->bclk_hz = cfg->sample_rate_hz * cfg->slot_bits * 2U;
+  out->word_bytes_per_s = cfg->sample_rate_hz * cfg->channels * (uint32_t)sizeof(int32_t);
+  out->pcm16_bytes_per_s = cfg->sample_rate_hz * cfg->channels * (uint32_t)sizeof(int16_t);
+  return ESP_OK;
+}
+
+const bsp_audio_config_t *bsp_audio_get_config(void) {
+  return &s_cfg;
+}
+
+// Reads and drops samples until the microphone has been clocked for
+// BSP_AUDIO_SETTLE_MS. Buffers still queued from before a suspend return
+// immediately, so both the sample count and the wall time must be reached.
+static esp_err_t discard_settling(int64_t start_us) {
+  int32_t scratch[64];
+  uint32_t dropped = 0;
+  while (dropped < s_stats.settle_samples || (esp_timer_get_time() - start_us) < (int64_t)BSP_AUDIO_SETTLE_MS * 1000) {
+    if ((esp_timer_get_time() - start_us) > (int64_t)SETTLE_TIMEOUT_MS * 1000) {
+      return ESP_ERR_TIMEOUT;
+    }
+    size_t bytes_read = 0;
+    esp_err_t err = i2s_channel_read(s_rx_chan, scratch, sizeof(scratch), &bytes_read, SETTLE_TIMEOUT_MS);
+    if (err != ESP_OK) {
+      return err;
+    }
+    dropped += (uint32_t)(bytes_read / frame_bytes(&s_cfg));
+  }
+  return ESP_OK;
+}
+
+esp_err_t bsp_audio_init(const bsp_audio_config_t *cfg) {
+  bsp_audio_config_t wanted = BSP_AUDIO_CONFIG_DEFAULT();
+  if (cfg) {
+    wanted = *cfg;
+  }
+  esp_err_t err = bsp_audio_config_validate(&wanted);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Invalid audio profile (%u Hz, %u-bit, %u ch, %ux%u DMA)", (unsigned)wanted.sample_rate_hz,
+             (unsigned)wanted.slot_bits, (unsigned)wanted.channels, (unsigned)wanted.dma_desc_num,
+             (unsigned)wanted.dma_frame_num);
+    return err;
+  }
 
-esp_err_t bsp_audio_init(void) {
   if (s_ready) {
-    return ESP_OK;
+    if (config_equal(&wanted, &s_cfg)) {
+      return s_suspended ? bsp_audio_resume() : ESP_OK;
+    }
+    bsp_audio_deinit();
   }
 
+  int64_t start_us = esp_timer_get_time();
+  s_cfg = wanted;
+  s_stats.settle_samples = s_cfg.sample_rate_hz * BSP_AUDIO_SETTLE_MS / 1000U;
+
   i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_1, I2S_ROLE_MASTER);
-  chan_cfg.dma_desc_num = 4;
-  chan_cfg.dma_frame_num = 512;
+  chan_cfg.dma_desc_num = s_cfg.dma_desc_num;
+  chan_cfg.dma_frame_num = s_cfg.dma_frame_num;
 
-  esp_err_t err = i2s_new_channel(&chan_cfg, NULL, &s_rx_chan);
+  err = i2s_new_channel(&chan_cfg, NULL, &s_rx_chan);
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "i2s_new_channel failed: %s", esp_err_to_name(err));
     return err;
   }
 
+  i2s_data_bit_width_t width = s_cfg.slot_bits == 16 ? I2S_DATA_BIT_WIDTH_16BIT : I2S_DATA_BIT_WIDTH_32BIT;
+  i2s_slot_mode_t mode = s_cfg.channels == 2 ? I2S_SLOT_MODE_STEREO : I2S_SLOT_MODE_MONO;
   i2s_std_config_t std_cfg = {
-      .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(BSP_AUDIO_RATE_HZ),
-      .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_MONO),
+      .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(s_cfg.sample_rate_hz),
+      .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(width, mode),
       .gpio_cfg = {
           .mclk = I2S_GPIO_UNUSED,
           .bclk = BSP_AUDIO_BCLK_IO,
@@ -41,7 +129,7 @@ esp_err_t bsp_audio_init(void) {
           },
       },
   };
-  std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_LEFT;
+  std_cfg.slot_cfg.slot_mask = s_cfg.channels == 2 ? I2S_STD_SLOT_BOTH : I2S_STD_SLOT_LEFT;
 
   err = i2s_channel_init_std_mode(s_rx_chan, &std_cfg);
   if (err != ESP_OK) {
@@ -59,25 +147,116 @@ esp_err_t bsp_audio_init(void) {
     return err;
   }
 
+  err = discard_settling(start_us);
+  if (err != ESP_OK) {
+    i2s_channel_disable(s_rx_chan);
+    i2s_del_channel(s_rx_chan);
+    s_rx_chan = NULL;
+    ESP_LOGE(TAG, "Microphone did not start: %s", esp_err_to_name(err));
+    return err;
+  }
+
   s_ready = true;
-  ESP_LOGI(TAG, "I2S microphone initialized");
+  s_suspended = false;
+  s_stats.cold_start_us = (uint32_t)(esp_timer_get_time() - start_us);
+  ESP_LOGI(TAG, "I2S microphone initialized (%u Hz, %u-bit, %u ch, %u us to first sample)",
+           (unsigned)s_cfg.sample_rate_hz, (unsigned)s_cfg.slot_bits, (unsigned)s_cfg.channels,
+           (unsigned)s_stats.cold_start_us);
   return ESP_OK;
 }
 
 esp_err_t bsp_audio_read(void *dest, size_t len, size_t *bytes_read, uint32_t timeout_ms) {
+  if (!s_ready || !s_rx_chan || s_suspended) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (s_cfg.slot_bits == 32) {
+    return i2s_channel_read(s_rx_chan, dest, len, bytes_read, timeout_ms);
+  }
+
+  // 16-bit slots: read into the front half of dest, then widen in place from
+  // the back so no sample is overwritten before it is moved.
+  size_t raw = 0;
+  esp_err_t err = i2s_channel_read(s_rx_chan, dest, (len / sizeof(int32_t)) * sizeof(int16_t), &raw, timeout_ms);
+  const int16_t *in = (const int16_t *)dest;
+  int32_t *out = (int32_t *)dest;
+  for (size_t i = raw / sizeof(int16_t); i-- > 0;) {
+    out[i] = (int32_t)in[i] * 65536;
+  }
+  if (bytes_read) {
+    *bytes_read = raw * 2U;
+  }
+  return err;
+}
+
+esp_err_t bsp_audio_suspend(void) {
   if (!s_ready || !s_rx_chan) {
     return ESP_ERR_INVALID_STATE;
   }
-  return i2s_channel_read(s_rx_chan, dest, len, bytes_read, timeout_ms);
+  if (s_suspended) {
+    return ESP_OK;
+  }
+  esp_err_t err = i2s_channel_disable(s_rx_chan);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "i2s_channel_disable failed: %s", esp_err_to_name(err));
+    return err;
+  }
+  s_suspended = true;
+  return ESP_OK;
+}
+
+esp_err_t bsp_audio_resume(void) {
+  if (!s_ready || !s_rx_chan) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (!s_suspended) {
+    return ESP_OK;
+  }
+
+  int64_t start_us = esp_timer_get_time();
+  esp_err_t err = i2s_channel_enable(s_rx_chan);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "i2s_channel_enable failed: %s", esp_err_to_name(err));
+    return err;
+  }
+  s_suspended = false;
+
+  err = discard_settling(start_us);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Microphone did not settle after resume: %s", esp_err_to_name(err));
+    bsp_audio_suspend();
+    return err;
+  }
+
+  uint32_t latency_us = (uint32_t)(esp_timer_get_time() - start_us);
+  s_stats.last_resume_us = latency_us;
+  if (latency_us > s_stats.max_resume_us) {
+    s_stats.max_resume_us = latency_us;
+  }
+  s_stats.resumes++;
+  return ESP_OK;
+}
+
+bool bsp_audio_is_suspended(void) {
+  return s_ready && s_suspended;
+}
+
+void bsp_audio_get_stats(bsp_audio_stats_t *out) {
+  if (out) {
+    *out = s_stats;
+  }
 }
 
 void bsp_audio_deinit(void) {
   if (!s_rx_chan) {
     s_ready = false;
+    s_suspended = false;
     return;
   }
-  i2s_channel_disable(s_rx_chan);
+  if (!s_suspended) {
+    i2s_channel_disable(s_rx_chan);
+  }
   i2s_del_channel(s_rx_chan);
   s_rx_chan = NULL;
   s_ready = false;
+  s_suspended = false;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -9,9 +10,70 @@
 #define BSP_AUDIO_BCLK_IO   (GPIO_NUM_4)  // D3
 #define BSP_AUDIO_WS_IO     (GPIO_NUM_2)  // D1
 #define BSP_AUDIO_DIN_IO    (GPIO_NUM_3)  // D2
-#define BSP_AUDIO_RATE_HZ   (16000)
-#define BSP_AUDIO_PCM_SHIFT (11)
+// SPH0645 start-up time once BCLK runs (cold power-up or leaving sleep);
+// samples before this are discarded by init and resume.
+#define BSP_AUDIO_SETTLE_MS (50)
 
-esp_err_t bsp_audio_init(void);
+// Capture profile. The SPH0645 needs 32-bit slots (18 data bits at the top
+// of each word); 16-bit slots are for other I2S mics. bsp_audio_read() always
+// returns one left-justified int32 word per channel per frame (stereo
+// interleaved, left first), so pcm_shift is the right shift that turns a word
+// into PCM16: 11 for the SPH0645, 16 for unity gain from a 16-bit slot.
+typedef struct {
+  uint32_t sample_rate_hz;  // 8000..48000
+  uint8_t slot_bits;        // 16 or 32
+  uint8_t channels;         // 1 (left slot) or 2
+  uint8_t dma_desc_num;     // DMA buffers in the ring, 2..16
+  uint16_t dma_frame_num;   // frames per DMA buffer (one buffer <= 4092 bytes)
+  uint8_t pcm_shift;        // word >> pcm_shift = PCM16
+} bsp_audio_config_t;
+
+#define BSP_AUDIO_CONFIG_DEFAULT() \
+  {                                \
+      .sample_rate_hz = 16000,     \
+      .slot_bits = 32,             \
+      .channels = 1,               \
+      .dma_desc_num = 4,           \
+      .dma_frame_num = 512,        \
+      .pcm_shift = 11,             \
+  }
+
+// What a profile costs before anything downstream is allocated.
+typedef struct {
+  uint32_t dma_bytes;          // all DMA buffers (internal RAM)
+  uint32_t dma_buffer_us;      // one DMA buffer: read granularity / added latency
+  uint32_t overrun_us;         // all buffers: how long a reader may stall
+  uint32_t bclk_hz;
+  uint32_t word_bytes_per_s;   // bsp_audio_read() output rate
+  uint32_t pcm16_bytes_per_s;  // after conversion, e.g. ring or WAV cost
+} bsp_audio_profile_info_t;
+
+// Start latency, in microseconds from the call until the first valid
+// sample can be read (settling samples already discarded).
+typedef struct {
+  uint32_t cold_start_us;
+  uint32_t last_resume_us;
+  uint32_t max_resume_us;
+  uint32_t resumes;
+  uint32_t settle_samples;  // discarded per start
+} bsp_audio_stats_t;
+
+esp_err_t bsp_audio_config_validate(const bsp_audio_config_t *cfg);
+esp_err_t bsp_audio_profile_info(const bsp_audio_config_t *cfg, bsp_audio_profile_info_t *out);
+
+// cfg NULL uses BSP_AUDIO_CONFIG_DEFAULT(). If the channel already exists with
+// a different profile it is recreated; otherwise init only resumes it.
+esp_err_t bsp_audio_init(const bsp_audio_config_t *cfg);
+// Active profile (the default before the first init).
+const bsp_audio_config_t *bsp_audio_get_config(void);
+// len and *bytes_read are in bytes of int32 words; see bsp_audio_config_t.
 esp_err_t bsp_audio_read(void *dest, size_t len, size_t *bytes_read, uint32_t timeout_ms);
+// Stops the I2S clock, which also drops the SPH0645 into its sleep mode, but
+// keeps the channel and its DMA descriptors allocated. Reads fail with
+// ESP_ERR_INVALID_STATE until bsp_audio_resume().
+esp_err_t bsp_audio_suspend(void);
+// Restarts the clock and returns once the microphone has settled.
+esp_err_t bsp_audio_resume(void);
+bool bsp_audio_is_suspended(void);
+void bsp_audio_get_stats(bsp_audio_stats_t *out);
 void bsp_audio_deinit(void);
@@ -1,14 +1,32 @@
 #include "bsp_camera.h"
 
 #include <stdbool.h>
+#include <string.h>
 
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 static const char *TAG = "BSP_CAMERA";
 static bool s_camera_ready = false;
 static const int s_capture_retries = 5;
+// Output size after init; frame buffers are sized for this or the largest
+// profile, whichever is bigger (s_buffer_size once running).
+static framesize_t s_frame_size = FRAMESIZE_SVGA;
+static framesize_t s_buffer_size = FRAMESIZE_INVALID;
+// Grab mode outside bursts; CAMERA_GRAB_LATEST while pre-roll is streaming.
+static camera_grab_mode_t s_idle_grab_mode = CAMERA_GRAB_WHEN_EMPTY;
+
+// OV2640 quality below ~8 can overrun the JPEG buffer (w*h/5) on busy scenes.
+static bsp_camera_profile_config_t s_profiles[BSP_CAMERA_PROFILE_COUNT] = {
+    [BSP_CAMERA_PROFILE_PIR] = {FRAMESIZE_SVGA, 12, 10, 40, 40000},
+    [BSP_CAMERA_PROFILE_TIMELAPSE] = {FRAMESIZE_QVGA, 12, 8, 40, 10000},
+};
+static jpeg_quality_ctl_t s_quality[BSP_CAMERA_PROFILE_COUNT];
+static bool s_quality_ready = false;
+static bsp_camera_profile_stats_t s_profile_stats = {.active = BSP_CAMERA_PROFILE_PIR};
+static camera_recovery_stats_t s_recovery_stats;
 
 static bool is_valid_jpeg(const camera_fb_t *fb) {
   if (!fb || !fb->buf || fb->len < 4) {
@@ -18,10 +36,85 @@ static bool is_valid_jpeg(const camera_fb_t *fb) {
          fb->buf[fb->len - 2] == 0xFF && fb->buf[fb->len - 1] == 0xD9;
 }
 
+// Frame size from the JPEG SOF header, so a frame exposed before a size
+// change can be told apart (fb->width reflects the sensor setting at
+// esp_camera_fb_get() time, not at exposure).
+static bool jpeg_dimensions(const camera_fb_t *fb, uint16_t *width, uint16_t *height) {
+  size_t i = 2;
+  while (i + 4 <= fb->len) {
+    if (fb->buf[i] != 0xFF) {
+      return false;
+    }
+    uint8_t marker = fb->buf[i + 1];
+    if (marker == 0xFF) {
+      i++;
+      continue;
+    }
+    size_t seg_len = ((size_t)fb->buf[i + 2] << 8) | fb->buf[i + 3];
+    if (marker >= 0xC0 && marker <= 0xC2) {
+      if (i + 9 > fb->len) {
+        return false;
+      }
+      *height = (uint16_t)((fb->buf[i + 5] << 8) | fb->buf[i + 6]);
+      *width = (uint16_t)((fb->buf[i + 7] << 8) | fb->buf[i + 8]);
+      return true;
+    }
+    if (marker == 0xDA) {
+      return false;
+    }
+    i += 2 + seg_len;
+  }
+  return false;
+}
+
+static void init_quality(bsp_camera_profile_t profile) {
+  const bsp_camera_profile_config_t *p = &s_profiles[profile];
+  jpeg_quality_init(&s_quality[profile], p->target_bytes, p->quality, p->best_quality, p->worst_quality);
+}
+
+static framesize_t largest_frame_size(void) {
+  framesize_t size = s_frame_size;
+  for (int i = 0; i < BSP_CAMERA_PROFILE_COUNT; i++) {
+    if (s_profiles[i].frame_size > size) {
+      size = s_profiles[i].frame_size;
+    }
+  }
+  return size;
+}
+
+// Feeds a returned frame to the active profile's controller and applies the
+// new quality from the next frame on.
+static void profile_frame_done(const camera_fb_t *fb) {
+  int active = s_profile_stats.active;
+  if (active < 0 || fb->width != resolution[s_profiles[active].frame_size].width) {
+    return;
+  }
+  uint8_t before = s_quality[active].quality;
+  uint8_t after = jpeg_quality_update(&s_quality[active], fb->len);
+  if (after != before) {
+    sensor_t *sensor = esp_camera_sensor_get();
+    if (sensor) {
+      sensor->set_quality(sensor, after);
+    }
+  }
+}
+
 esp_err_t bsp_camera_init(void) {
   if (s_camera_ready) {
     return ESP_OK;
   }
+  if (!s_quality_ready) {
+    for (int i = 0; i < BSP_CAMERA_PROFILE_COUNT; i++) {
+      init_quality((bsp_camera_profile_t)i);
+    }
+    s_quality_ready = true;
+  }
+  // The first profile switch after init always goes through the drain.
+  if (s_profile_stats.active >= 0 && s_profiles[s_profile_stats.active].frame_size != s_frame_size) {
+    s_profile_stats.active = -1;
+  }
+  s_buffer_size = largest_frame_size();
+  int quality = s_profile_stats.active >= 0 ? s_quality[s_profile_stats.active].quality : 12;
 
   camera_config_t cfg = {
       .pin_pwdn = CAM_PIN_PWDN,
@@ -44,11 +137,11 @@ esp_err_t bsp_camera_init(void) {
       .ledc_timer = LEDC_TIMER_0,
       .ledc_channel = LEDC_CHANNEL_0,
       .pixel_format = PIXFORMAT_JPEG,
-      .frame_size = FRAMESIZE_QVGA,
-      .jpeg_quality = 12,
+      .frame_size = s_buffer_size,
+      .jpeg_quality = quality,
       .fb_count = 2,
       .fb_location = CAMERA_FB_IN_PSRAM,
-      .grab_mode = CAMERA_GRAB_WHEN_EMPTY,
+      .grab_mode = s_idle_grab_mode,
   };
 
   esp_err_t err = esp_camera_init(&cfg);
@@ -65,8 +158,8 @@ esp_err_t bsp_camera_init(void) {
 
   sensor_t *sensor = esp_camera_sensor_get();
   if (sensor) {
-    sensor->set_framesize(sensor, FRAMESIZE_QVGA);
-    sensor->set_quality(sensor, 12);
+    sensor->set_framesize(sensor, s_frame_size);
+    sensor->set_quality(sensor, quality);
   }
 
   s_camera_ready = true;
@@ -74,6 +167,54 @@ esp_err_t bsp_camera_init(void) {
   return ESP_OK;
 }
 
+static esp_err_t recovery_reset(void *ctx, camera_recovery_tier_t tier) {
+  (void)ctx;
+  switch (tier) {
+    case CAMERA_RECOVERY_DMA:
+      return esp_camera_recover(CAMERA_RECOVER_DMA);
+    case CAMERA_RECOVERY_SENSOR:
+      return esp_camera_recover(CAMERA_RECOVER_SENSOR);
+    default: {
+      esp_err_t err = bsp_camera_deinit();
+      return err == ESP_OK ? bsp_camera_init() : err;
+    }
+  }
+}
+
+// Keeps the first valid frame for the caller.
+static bool recovery_probe(void *ctx) {
+  camera_fb_t **out = ctx;
+  camera_fb_t *fb = esp_camera_fb_get();
+  if (fb && is_valid_jpeg(fb)) {
+    *out = fb;
+    return true;
+  }
+  if (fb) {
+    esp_camera_fb_return(fb);
+  }
+  return false;
+}
+
+// Capture has failed s_capture_retries times in a row: escalate from a DMA
+// restart through a sensor soft reset to a full reinit, and return the
+// first valid frame.
+static camera_fb_t *recover_capture(void) {
+  camera_fb_t *fb = NULL;
+  camera_recovery_ops_t ops = {
+      .reset = recovery_reset,
+      .probe = recovery_probe,
+      .ctx = &fb,
+  };
+  camera_recovery_tier_t tier = CAMERA_RECOVERY_DMA;
+  if (camera_recovery_run(&ops, &s_recovery_stats, &tier) != ESP_OK) {
+    ESP_LOGE(TAG, "Camera recovery failed at every tier (%u failures)", (unsigned)s_recovery_stats.failures);
+    return NULL;
+  }
+  ESP_LOGW(TAG, "Camera recovered by %s reset in %u ms", camera_recovery_tier_name(tier),
+           (unsigned)(s_recovery_stats.tier[tier].last_us / 1000U));
+  return fb;
+}
+
 camera_fb_t *bsp_camera_capture(void) {
   if (!s_camera_ready) {
     if (bsp_camera_init() != ESP_OK) {
@@ -85,6 +226,7 @@ camera_fb_t *bsp_camera_capture(void) {
   for (int i = 0; i < s_capture_retries; i++) {
     fb = esp_camera_fb_get();
     if (fb && is_valid_jpeg(fb)) {
+      profile_frame_done(fb);
       return fb;
     }
     if (fb) {
@@ -95,32 +237,211 @@ camera_fb_t *bsp_camera_capture(void) {
     vTaskDelay(pdMS_TO_TICKS(80));
   }
 
-  ESP_LOGW(TAG, "Capture failed, reinitializing camera");
-  bsp_camera_deinit();
-  if (bsp_camera_init() != ESP_OK) {
+  camera_fb_t *recovered = recover_capture();
+  if (recovered) {
+    profile_frame_done(recovered);
+  }
+  return recovered;
+}
+
+esp_err_t bsp_camera_burst_begin(void) {
+  if (!s_camera_ready) {
+    esp_err_t err = bsp_camera_init();
+    if (err != ESP_OK) {
+      return err;
+    }
+  }
+  esp_err_t err = esp_camera_set_grab_mode(CAMERA_GRAB_LATEST);
+  if (err != ESP_OK) {
+    return err;
+  }
+  // In GRAB_WHEN_EMPTY both buffers may hold frames from before the trigger.
+  while (esp_camera_available_frames()) {
+    camera_fb_t *stale = esp_camera_fb_get();
+    if (!stale) {
+      break;
+    }
+    esp_camera_fb_return(stale);
+  }
+  return ESP_OK;
+}
+
+camera_fb_t *bsp_camera_burst_next(void) {
+  if (!s_camera_ready) {
     return NULL;
   }
+  // No delay or reinit between attempts: a burst that stalls is over.
   for (int i = 0; i < s_capture_retries; i++) {
-    fb = esp_camera_fb_get();
-    if (fb && is_valid_jpeg(fb)) {
-      return fb;
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb) {
+      return NULL;
     }
-    if (fb) {
-      ESP_LOGW(TAG, "Invalid JPEG frame discarded after reinit (len=%u)", (unsigned)fb->len);
-      esp_camera_fb_return(fb);
-      fb = NULL;
+    if (is_valid_jpeg(fb)) {
+      profile_frame_done(fb);
+      return fb;
     }
-    vTaskDelay(pdMS_TO_TICKS(80));
+    ESP_LOGW(TAG, "Invalid JPEG frame discarded in burst (len=%u)", (unsigned)fb->len);
+    esp_camera_fb_return(fb);
   }
   return NULL;
 }
 
+void bsp_camera_burst_end(void) {
+  if (s_camera_ready) {
+    (void)esp_camera_set_grab_mode(s_idle_grab_mode);
+  }
+}
+
+esp_err_t bsp_camera_set_streaming(bool enable) {
+  s_idle_grab_mode = enable ? CAMERA_GRAB_LATEST : CAMERA_GRAB_WHEN_EMPTY;
+  return s_camera_ready ? esp_camera_set_grab_mode(s_idle_grab_mode) : ESP_OK;
+}
+
+esp_err_t bsp_camera_reinit(framesize_t frame_size) {
+  esp_err_t err = bsp_camera_deinit();
+  if (err != ESP_OK) {
+    return err;
+  }
+  s_frame_size = frame_size;
+  return bsp_camera_init();
+}
+
 esp_err_t bsp_camera_set_framesize(framesize_t frame_size) {
   sensor_t *sensor = esp_camera_sensor_get();
   if (!sensor) {
     return ESP_ERR_INVALID_STATE;
   }
-  return sensor->set_framesize(sensor, frame_size);
+  if (frame_size > s_buffer_size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  if (sensor->set_framesize(sensor, frame_size) != 0) {
+    return ESP_FAIL;
+  }
+  s_frame_size = frame_size;
+  s_profile_stats.active = -1;
+  return ESP_OK;
+}
+
+esp_err_t bsp_camera_set_profile_config(bsp_camera_profile_t profile, const bsp_camera_profile_config_t *cfg) {
+  if (profile >= BSP_CAMERA_PROFILE_COUNT || !cfg) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (s_camera_ready && cfg->frame_size > s_buffer_size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  s_profiles[profile] = *cfg;
+  init_quality(profile);
+  if (s_profile_stats.active == (int)profile) {
+    s_profile_stats.active = -1;  // reapply on the next use
+  }
+  return ESP_OK;
+}
+
+// Drops frames until one that was exposed entirely at the new size arrives.
+// Frames already queued, and the one the sensor was exposing when the
+// registers changed, still carry the old window.
+static esp_err_t drain_to_size(framesize_t frame_size, int64_t start_us, uint32_t max_switch_ms) {
+  const uint16_t width = resolution[frame_size].width;
+  const uint16_t height = resolution[frame_size].height;
+  (void)esp_camera_set_grab_mode(CAMERA_GRAB_LATEST);
+  esp_err_t err = ESP_ERR_TIMEOUT;
+  while (true) {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb) {
+      err = ESP_FAIL;
+      break;
+    }
+    uint16_t w = 0;
+    uint16_t h = 0;
+    int64_t frame_us = (int64_t)fb->timestamp.tv_sec * 1000000LL + fb->timestamp.tv_usec;
+    bool ok = frame_us >= start_us && is_valid_jpeg(fb) && jpeg_dimensions(fb, &w, &h) && w == width &&
+              h == height;
+    esp_camera_fb_return(fb);
+    if (ok) {
+      err = ESP_OK;
+      break;
+    }
+    s_profile_stats.drained_frames++;
+    if (max_switch_ms && esp_timer_get_time() - start_us > (int64_t)max_switch_ms * 1000) {
+      break;
+    }
+  }
+  (void)esp_camera_set_grab_mode(s_idle_grab_mode);
+  return err;
+}
+
+esp_err_t bsp_camera_use_profile(bsp_camera_profile_t profile, uint32_t max_switch_ms) {
+  if (profile >= BSP_CAMERA_PROFILE_COUNT) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  esp_err_t err = bsp_camera_init();
+  if (err != ESP_OK) {
+    return err;
+  }
+  sensor_t *sensor = esp_camera_sensor_get();
+  if (!sensor) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  const bsp_camera_profile_config_t *p = &s_profiles[profile];
+  if (p->frame_size > s_buffer_size) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  if (s_profile_stats.active == (int)profile) {
+    return ESP_OK;
+  }
+
+  if (p->frame_size == s_frame_size) {
+    sensor->set_quality(sensor, s_quality[profile].quality);
+    s_profile_stats.active = profile;
+    return ESP_OK;
+  }
+  if (max_switch_ms && s_profile_stats.est_switch_us > max_switch_ms * 1000U) {
+    s_profile_stats.deferred++;
+    return ESP_ERR_TIMEOUT;
+  }
+
+  int64_t start_us = esp_timer_get_time();
+  if (sensor->set_framesize(sensor, p->frame_size) != 0) {
+    return ESP_FAIL;
+  }
+  sensor->set_quality(sensor, s_quality[profile].quality);
+  s_frame_size = p->frame_size;
+  s_profile_stats.active = profile;
+  s_profile_stats.switches++;
+  err = drain_to_size(p->frame_size, start_us, max_switch_ms);
+  if (err != ESP_OK) {
+    s_profile_stats.timeouts++;
+    ESP_LOGW(TAG, "Profile %d: no frame at the new size within %u ms", (int)profile, (unsigned)max_switch_ms);
+    return err;
+  }
+
+  uint32_t switch_us = (uint32_t)(esp_timer_get_time() - start_us);
+  s_profile_stats.last_switch_us = switch_us;
+  if (switch_us > s_profile_stats.max_switch_us) {
+    s_profile_stats.max_switch_us = switch_us;
+  }
+  // Weight 1/4: one slow switch (AEC catching up) does not block the next.
+  s_profile_stats.est_switch_us = s_profile_stats.est_switch_us
+                                      ? s_profile_stats.est_switch_us - s_profile_stats.est_switch_us / 4U + switch_us / 4U
+                                      : switch_us;
+  ESP_LOGI(TAG, "Profile %d: frame size switch took %u ms", (int)profile, (unsigned)(switch_us / 1000U));
+  return ESP_OK;
+}
+
+void bsp_camera_get_recovery_stats(camera_recovery_stats_t *out) {
+  *out = s_recovery_stats;
+}
+
+void bsp_camera_get_profile_stats(bsp_camera_profile_stats_t *out) {
+  *out = s_profile_stats;
+}
+
+void bsp_camera_get_profile_quality(bsp_camera_profile_t profile, jpeg_quality_ctl_t *out) {
+  if (profile < BSP_CAMERA_PROFILE_COUNT) {
+    *out = s_quality[profile];
+  } else {
+    memset(out, 0, sizeof(*out));
+  }
 }
 
 esp_err_t bsp_camera_deinit(void) {
@@ -0,0 +1,60 @@
+#include "camera_recovery.h"
+
+#include "esp_timer.h"
+
+static int64_t now_us(const camera_recovery_ops_t *ops) {
+  return ops->now_us ? ops->now_us(ops->ctx) : esp_timer_get_time();
+}
+
+static void record(camera_recovery_tier_stats_t *st, int64_t elapsed_us, bool fixed) {
+  uint32_t us = elapsed_us > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed_us;
+  st->attempts++;
+  st->last_us = us;
+  st->total_us += us;
+  if (us > st->max_us) {
+    st->max_us = us;
+  }
+  if (fixed) {
+    st->fixes++;
+  }
+}
+
+esp_err_t camera_recovery_run(const camera_recovery_ops_t *ops, camera_recovery_stats_t *stats,
+                              camera_recovery_tier_t *fixed_by) {
+  if (!ops || !ops->reset || !ops->probe || !stats) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  const uint8_t probes = ops->probes_per_tier ? ops->probes_per_tier : 2U;
+  stats->runs++;
+  for (int t = CAMERA_RECOVERY_DMA; t < CAMERA_RECOVERY_TIERS; t++) {
+    int64_t start = now_us(ops);
+    bool fixed = false;
+    if (ops->reset(ops->ctx, (camera_recovery_tier_t)t) == ESP_OK) {
+      for (uint8_t i = 0; i < probes && !fixed; i++) {
+        fixed = ops->probe(ops->ctx);
+      }
+    }
+    record(&stats->tier[t], now_us(ops) - start, fixed);
+    if (fixed) {
+      if (fixed_by) {
+        *fixed_by = (camera_recovery_tier_t)t;
+      }
+      return ESP_OK;
+    }
+  }
+  stats->failures++;
+  return ESP_FAIL;
+}
+
+const char *camera_recovery_tier_name(camera_recovery_tier_t tier) {
+  switch (tier) {
+    case CAMERA_RECOVERY_DMA:
+      return "dma";
+    case CAMERA_RECOVERY_SENSOR:
+      return "sensor";
+    case CAMERA_RECOVERY_REINIT:
+      return "reinit";
+    default:
+      return "?";
+  }
+}
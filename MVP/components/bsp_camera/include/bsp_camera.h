@@ -1,7 +1,11 @@
 #pragma once
 
+#include <stdbool.h>
+
 #include "esp_camera.h"
+#include "camera_recovery.h"
 #include "esp_err.h"
+#include "jpeg_quality.h"
 
 // XIAO ESP32S3 Sense (OV2640)
 #define CAM_PIN_PWDN  (-1)
@@ -22,6 +26,73 @@
 #define CAM_PIN_PCLK  (13)
 
 esp_err_t bsp_camera_init(void);
+// After s_capture_retries invalid frames in a row, capture runs the tiered
+// recovery in camera_recovery.h (DMA restart, sensor reset, full reinit).
 camera_fb_t *bsp_camera_capture(void);
+// Attempts, fixes and latency per recovery tier.
+void bsp_camera_get_recovery_stats(camera_recovery_stats_t *out);
+
+// Burst capture at the sensor's frame rate. begin() switches the driver to
+// CAMERA_GRAB_LATEST and drops frames queued before the call, so while the
+// caller holds frame i (e.g. writing it to SD) the second frame buffer is
+// already receiving frame i+1. Frames the caller is too slow for are
+// overwritten rather than queued, so every frame returned is current.
+// Return each frame with esp_camera_fb_return() before taking the next.
+esp_err_t bsp_camera_burst_begin(void);
+camera_fb_t *bsp_camera_burst_next(void);
+void bsp_camera_burst_end(void);
+// Stays in CAMERA_GRAB_LATEST between bursts, so periodic captures (the
+// pre-trigger ring) always get the newest frame instead of a queued one.
+esp_err_t bsp_camera_set_streaming(bool enable);
+
+// Capture profiles: a frame size and a byte-budgeted quality per use. Frame
+// buffers are sized at init for the largest profile, so a profile switch is
+// a sensor register write plus draining the frames already exposed with the
+// old window, never a driver restart. While a profile is active, every frame
+// returned by capture()/burst_next() feeds its quality controller.
+typedef enum {
+  BSP_CAMERA_PROFILE_PIR = 0,    // SVGA, ~40 kB per frame
+  BSP_CAMERA_PROFILE_TIMELAPSE,  // QVGA, ~10 kB per frame
+  BSP_CAMERA_PROFILE_COUNT,
+} bsp_camera_profile_t;
+
+typedef struct {
+  framesize_t frame_size;
+  uint8_t quality;  // starting point for the controller
+  uint8_t best_quality;
+  uint8_t worst_quality;
+  uint32_t target_bytes;  // 0 keeps quality fixed
+} bsp_camera_profile_config_t;
+
+typedef struct {
+  int active;              // bsp_camera_profile_t, -1 after a manual size change
+  uint32_t switches;       // frame size changes
+  uint32_t deferred;       // switches skipped because they would exceed the budget
+  uint32_t timeouts;       // drains that ran out of budget
+  uint32_t drained_frames;  // frames dropped while switching
+  uint32_t last_switch_us;  // register write to first frame at the new size
+  uint32_t max_switch_us;
+  uint32_t est_switch_us;  // running estimate used to defer switches
+} bsp_camera_profile_stats_t;
+
+// Replaces a profile's settings and restarts its quality controller. Fails
+// with ESP_ERR_INVALID_SIZE if the camera is running with buffers too small
+// for the frame size.
+esp_err_t bsp_camera_set_profile_config(bsp_camera_profile_t profile, const bsp_camera_profile_config_t *cfg);
+// Makes profile active. When that changes the frame size, the switch is
+// skipped with ESP_ERR_TIMEOUT (the previous profile stays active) if the
+// estimated switch time exceeds max_switch_ms, and the drain gives up with
+// ESP_ERR_TIMEOUT after max_switch_ms (the new size stays set). 0 means no
+// limit. Every completed switch is measured.
+esp_err_t bsp_camera_use_profile(bsp_camera_profile_t profile, uint32_t max_switch_ms);
+void bsp_camera_get_profile_stats(bsp_camera_profile_stats_t *out);
+// Controller state of a profile (quality, last frame size, over-budget count).
+void bsp_camera_get_profile_quality(bsp_camera_profile_t profile, jpeg_quality_ctl_t *out);
+
+// Changes the sensor output size within the buffers allocated at init and
+// leaves profile control until the next bsp_camera_use_profile().
 esp_err_t bsp_camera_set_framesize(framesize_t frame_size);
+// Restarts the camera outputting frame_size, with frame buffers sized for it
+// or the largest profile, whichever is bigger.
+esp_err_t bsp_camera_reinit(framesize_t frame_size);
 esp_err_t bsp_camera_deinit(void);
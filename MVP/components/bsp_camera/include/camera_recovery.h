@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Tiered recovery for a camera that stopped delivering valid frames. Each
+// tier is tried in turn, cheapest first, and counts as a fix once a valid
+// frame comes back:
+//   DMA     restart capture (DMA channel reset, frame queue flushed)
+//   SENSOR  sensor soft reset with settings restored, then DMA
+//   REINIT  esp_camera_deinit() + esp_camera_init(): buffers reallocated,
+//           sensor reprobed, every register rewritten over SCCB
+// The hardware steps are behind camera_recovery_ops_t, so the policy runs
+// against a fake backend in test/test_camera_recovery.c.
+
+typedef enum {
+  CAMERA_RECOVERY_DMA = 0,
+  CAMERA_RECOVERY_SENSOR,
+  CAMERA_RECOVERY_REINIT,
+  CAMERA_RECOVERY_TIERS,
+} camera_recovery_tier_t;
+
+typedef struct {
+  // Performs one tier's reset.
+  esp_err_t (*reset)(void *ctx, camera_recovery_tier_t tier);
+  // Waits for one frame; true if it is valid (the backend keeps it).
+  bool (*probe)(void *ctx);
+  // Monotonic microseconds; NULL uses esp_timer_get_time().
+  int64_t (*now_us)(void *ctx);
+  void *ctx;
+  uint8_t probes_per_tier;  // frames tried after each reset, 0 means 2
+} camera_recovery_ops_t;
+
+typedef struct {
+  uint32_t attempts;
+  uint32_t fixes;
+  uint32_t last_us;  // reset start to valid frame (or to giving up)
+  uint32_t max_us;
+  uint64_t total_us;
+} camera_recovery_tier_stats_t;
+
+typedef struct {
+  camera_recovery_tier_stats_t tier[CAMERA_RECOVERY_TIERS];
+  uint32_t runs;
+  uint32_t failures;  // runs where even REINIT gave no valid frame
+} camera_recovery_stats_t;
+
+// Runs the tiers from DMA up until one yields a valid frame. Returns ESP_OK
+// with *fixed_by set (optional), or ESP_FAIL if every tier failed.
+esp_err_t camera_recovery_run(const camera_recovery_ops_t *ops, camera_recovery_stats_t *stats,
+                              camera_recovery_tier_t *fixed_by);
+const char *camera_recovery_tier_name(camera_recovery_tier_t tier);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Byte-budget JPEG quality controller. OV2640 quality runs from 0 (best,
+// largest) to 63; frame size is roughly inversely proportional to it for a
+// given scene, so the next quality is the current one scaled by
+// last size / target. Moves toward larger files are halved so a single busy
+// frame does not make the next one overshoot; moves toward smaller files are
+// taken in full so the budget is restored on the next frame.
+//
+// Pure C: bsp_camera feeds it fb->len after each frame, and the unit test
+// drives it with a synthetic scene model on the host.
+
+typedef struct {
+  uint32_t target_bytes;  // 0 keeps the quality fixed
+  uint8_t quality;        // for the next frame
+  uint8_t best_quality;   // lowest value allowed (largest frames)
+  uint8_t worst_quality;
+  uint8_t tolerance_pct;  // no change within +-tolerance of the target
+  uint8_t max_step;
+  uint32_t frames;
+  uint32_t over_budget;  // frames larger than target_bytes
+  size_t last_len;
+} jpeg_quality_ctl_t;
+
+void jpeg_quality_init(jpeg_quality_ctl_t *ctl, uint32_t target_bytes, uint8_t quality, uint8_t best_quality,
+                       uint8_t worst_quality);
+// frame_len is the size of a frame encoded at ctl->quality. Returns the
+// quality for the next frame (also left in ctl->quality).
+uint8_t jpeg_quality_update(jpeg_quality_ctl_t *ctl, size_t frame_len);
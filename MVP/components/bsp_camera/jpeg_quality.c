@@ -0,0 +1,58 @@
+#include "jpeg_quality.h"
+
+static uint8_t clamp_quality(const jpeg_quality_ctl_t *ctl, int32_t q) {
+  if (q < ctl->best_quality) {
+    return ctl->best_quality;
+  }
+  if (q > ctl->worst_quality) {
+    return ctl->worst_quality;
+  }
+  return (uint8_t)q;
+}
+
+void jpeg_quality_init(jpeg_quality_ctl_t *ctl, uint32_t target_bytes, uint8_t quality, uint8_t best_quality,
+                       uint8_t worst_quality) {
+  ctl->target_bytes = target_bytes;
+  ctl->best_quality = best_quality <= worst_quality ? best_quality : worst_quality;
+  ctl->worst_quality = worst_quality >= best_quality ? worst_quality : best_quality;
+  ctl->tolerance_pct = 10;
+  ctl->max_step = 8;
+  ctl->frames = 0;
+  ctl->over_budget = 0;
+  ctl->last_len = 0;
+  ctl->quality = clamp_quality(ctl, quality);
+}
+
+uint8_t jpeg_quality_update(jpeg_quality_ctl_t *ctl, size_t frame_len) {
+  ctl->frames++;
+  ctl->last_len = frame_len;
+  if (ctl->target_bytes == 0 || frame_len == 0) {
+    return ctl->quality;
+  }
+  const uint64_t target = ctl->target_bytes;
+  if (frame_len > target) {
+    ctl->over_budget++;
+  }
+  const uint64_t band = target * ctl->tolerance_pct / 100U;
+  if (frame_len + band >= target && frame_len <= target + band) {
+    return ctl->quality;
+  }
+
+  // Quality 0 scales like 1; keep the arithmetic away from zero.
+  const uint64_t q = ctl->quality ? ctl->quality : 1U;
+  int32_t ideal = (int32_t)((q * frame_len + target / 2U) / target);
+  int32_t delta = ideal - (int32_t)ctl->quality;
+  if (delta < 0) {
+    delta /= 2;  // improving quality: go halfway
+  }
+  if (delta == 0) {
+    delta = frame_len > target ? 1 : -1;
+  }
+  if (delta > ctl->max_step) {
+    delta = ctl->max_step;
+  } else if (delta < -(int32_t)ctl->max_step) {
+    delta = -(int32_t)ctl->max_step;
+  }
+  ctl->quality = clamp_quality(ctl, (int32_t)ctl->quality + delta);
+  return ctl->quality;
+}
@@ -0,0 +1,144 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "camera_recovery.h"
+
+// Fake capture backend: hands out JPEG-shaped frames until a fault is
+// injected, then corrupt ones until a reset deep enough clears it. Time is
+// simulated so latencies are exact.
+typedef enum {
+  FAKE_OK = 0,
+  FAKE_DMA_STALL,      // cleared by any reset
+  FAKE_SENSOR_WEDGED,  // needs a sensor reset or more
+  FAKE_DEAD,           // needs a full reinit
+  FAKE_BROKEN,         // nothing helps
+} fake_fault_t;
+
+typedef struct {
+  fake_fault_t fault;
+  int64_t now_us;
+  uint32_t resets[CAMERA_RECOVERY_TIERS];
+  uint32_t flaky_frames;  // corrupt frames still to come after a fix
+  uint8_t frame[64];
+  size_t frame_len;
+} fake_cam_t;
+
+static const int64_t k_reset_cost_us[CAMERA_RECOVERY_TIERS] = {2000, 45000, 420000};
+static const int64_t k_frame_us = 40000;
+
+static esp_err_t fake_reset(void *ctx, camera_recovery_tier_t tier) {
+  fake_cam_t *cam = ctx;
+  cam->resets[tier]++;
+  cam->now_us += k_reset_cost_us[tier];
+  fake_fault_t cleared_up_to = tier == CAMERA_RECOVERY_DMA      ? FAKE_DMA_STALL
+                               : tier == CAMERA_RECOVERY_SENSOR ? FAKE_SENSOR_WEDGED
+                                                                : FAKE_DEAD;
+  if (cam->fault != FAKE_BROKEN && cam->fault <= cleared_up_to) {
+    cam->fault = FAKE_OK;
+  }
+  return ESP_OK;
+}
+
+// Like cam_take(): one frame period per frame, garbage while faulted.
+static const uint8_t *fake_take(fake_cam_t *cam, size_t *len) {
+  cam->now_us += k_frame_us;
+  memset(cam->frame, 0x5A, sizeof(cam->frame));
+  if (cam->fault == FAKE_OK && cam->flaky_frames == 0) {
+    cam->frame[0] = 0xFF;
+    cam->frame[1] = 0xD8;
+    cam->frame[sizeof(cam->frame) - 2] = 0xFF;
+    cam->frame[sizeof(cam->frame) - 1] = 0xD9;
+  } else if (cam->flaky_frames > 0) {
+    cam->flaky_frames--;
+  }
+  *len = sizeof(cam->frame);
+  return cam->frame;
+}
+
+static bool fake_probe(void *ctx) {
+  size_t len = 0;
+  const uint8_t *buf = fake_take(ctx, &len);
+  return len >= 4 && buf[0] == 0xFF && buf[1] == 0xD8 && buf[len - 2] == 0xFF && buf[len - 1] == 0xD9;
+}
+
+static int64_t fake_now(void *ctx) {
+  return ((fake_cam_t *)ctx)->now_us;
+}
+
+static camera_recovery_ops_t fake_ops(fake_cam_t *cam) {
+  camera_recovery_ops_t ops = {
+      .reset = fake_reset,
+      .probe = fake_probe,
+      .now_us = fake_now,
+      .ctx = cam,
+      .probes_per_tier = 2,
+  };
+  return ops;
+}
+
+TEST_CASE("Camera recovery uses the cheapest tier that clears the fault", "[camera_recovery]")
+{
+  static const struct {
+    fake_fault_t fault;
+    camera_recovery_tier_t expect;
+  } cases[] = {
+      {FAKE_DMA_STALL, CAMERA_RECOVERY_DMA},
+      {FAKE_SENSOR_WEDGED, CAMERA_RECOVERY_SENSOR},
+      {FAKE_DEAD, CAMERA_RECOVERY_REINIT},
+  };
+  camera_recovery_stats_t stats;
+  memset(&stats, 0, sizeof(stats));
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    fake_cam_t cam = {.fault = cases[i].fault};
+    camera_recovery_ops_t ops = fake_ops(&cam);
+    camera_recovery_tier_t fixed_by = CAMERA_RECOVERY_TIERS;
+    TEST_ASSERT_EQUAL(ESP_OK, camera_recovery_run(&ops, &stats, &fixed_by));
+    TEST_ASSERT_EQUAL(cases[i].expect, fixed_by);
+    for (int t = 0; t < CAMERA_RECOVERY_TIERS; t++) {
+      TEST_ASSERT_EQUAL(t <= (int)cases[i].expect ? 1 : 0, cam.resets[t]);
+    }
+    // The fixing tier's latency is its reset plus one frame.
+    TEST_ASSERT_EQUAL(k_reset_cost_us[fixed_by] + k_frame_us, stats.tier[fixed_by].last_us);
+  }
+
+  TEST_ASSERT_EQUAL(3, stats.runs);
+  TEST_ASSERT_EQUAL(0, stats.failures);
+  TEST_ASSERT_EQUAL(3, stats.tier[CAMERA_RECOVERY_DMA].attempts);
+  TEST_ASSERT_EQUAL(1, stats.tier[CAMERA_RECOVERY_DMA].fixes);
+  TEST_ASSERT_EQUAL(2, stats.tier[CAMERA_RECOVERY_SENSOR].attempts);
+  TEST_ASSERT_EQUAL(1, stats.tier[CAMERA_RECOVERY_SENSOR].fixes);
+  TEST_ASSERT_EQUAL(1, stats.tier[CAMERA_RECOVERY_REINIT].attempts);
+  // A failed DMA attempt costs the reset plus both probe frames.
+  TEST_ASSERT_EQUAL(k_reset_cost_us[0] + 2 * k_frame_us, stats.tier[CAMERA_RECOVERY_DMA].max_us);
+  TEST_ASSERT_TRUE(stats.tier[CAMERA_RECOVERY_DMA].max_us < stats.tier[CAMERA_RECOVERY_REINIT].max_us);
+}
+
+TEST_CASE("Camera recovery tolerates one bad frame and reports total failure", "[camera_recovery]")
+{
+  camera_recovery_stats_t stats;
+  memset(&stats, 0, sizeof(stats));
+
+  // The first frame after the DMA reset is still torn; the second is fine.
+  fake_cam_t cam = {.fault = FAKE_DMA_STALL, .flaky_frames = 1};
+  camera_recovery_ops_t ops = fake_ops(&cam);
+  camera_recovery_tier_t fixed_by = CAMERA_RECOVERY_TIERS;
+  TEST_ASSERT_EQUAL(ESP_OK, camera_recovery_run(&ops, &stats, &fixed_by));
+  TEST_ASSERT_EQUAL(CAMERA_RECOVERY_DMA, fixed_by);
+  TEST_ASSERT_EQUAL(0, cam.resets[CAMERA_RECOVERY_SENSOR]);
+
+  fake_cam_t broken = {.fault = FAKE_BROKEN};
+  ops = fake_ops(&broken);
+  TEST_ASSERT_EQUAL(ESP_FAIL, camera_recovery_run(&ops, &stats, NULL));
+  TEST_ASSERT_EQUAL(2, stats.runs);
+  TEST_ASSERT_EQUAL(1, stats.failures);
+  for (int t = 0; t < CAMERA_RECOVERY_TIERS; t++) {
+    TEST_ASSERT_EQUAL(1, broken.resets[t]);
+  }
+  TEST_ASSERT_EQUAL(0, stats.tier[CAMERA_RECOVERY_REINIT].fixes);
+
+  camera_recovery_ops_t bad = {0};
+  TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, camera_recovery_run(&bad, &stats, NULL));
+}
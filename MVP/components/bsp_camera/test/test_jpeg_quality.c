@@ -0,0 +1,72 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include "unity.h"
+
+#include "jpeg_quality.h"
+
+// Scene model: frame bytes ~ detail / quality, plus a fixed header.
+static size_t scene_bytes(uint32_t detail, uint8_t quality) {
+  return 600U + detail / (quality ? quality : 1U);
+}
+
+static int run_until_settled(jpeg_quality_ctl_t *ctl, uint32_t detail, int max_frames) {
+  uint8_t prev = ctl->quality;
+  int stable = 0;
+  for (int i = 0; i < max_frames; i++) {
+    uint8_t q = jpeg_quality_update(ctl, scene_bytes(detail, ctl->quality));
+    stable = q == prev ? stable + 1 : 0;
+    prev = q;
+    if (stable == 3) {
+      return i + 1;
+    }
+  }
+  return -1;
+}
+
+TEST_CASE("JPEG quality controller converges on the byte budget", "[jpeg_quality]")
+{
+  jpeg_quality_ctl_t ctl;
+  jpeg_quality_init(&ctl, 20000, 12, 8, 40);
+
+  // Detail 480000: 40 kB at q12, so the budget needs about q25.
+  int frames = run_until_settled(&ctl, 480000, 30);
+  TEST_ASSERT_TRUE(frames > 0 && frames <= 8);
+  size_t len = scene_bytes(480000, ctl.quality);
+  TEST_ASSERT_TRUE(len >= 18000 && len <= 22000);
+
+  // A calmer scene hands the budget back to quality, more slowly.
+  frames = run_until_settled(&ctl, 160000, 30);
+  TEST_ASSERT_TRUE(frames > 0);
+  len = scene_bytes(160000, ctl.quality);
+  TEST_ASSERT_TRUE(len >= 18000 && len <= 22000);
+  TEST_ASSERT_TRUE(ctl.quality < 12);
+}
+
+TEST_CASE("JPEG quality controller respects limits and fixed mode", "[jpeg_quality]")
+{
+  jpeg_quality_ctl_t ctl;
+  jpeg_quality_init(&ctl, 10000, 12, 10, 30);
+
+  // An impossible budget pins to the worst quality without oscillating.
+  for (int i = 0; i < 20; i++) {
+    jpeg_quality_update(&ctl, scene_bytes(2000000, ctl.quality));
+    TEST_ASSERT_TRUE(ctl.quality >= 10 && ctl.quality <= 30);
+  }
+  TEST_ASSERT_EQUAL(30, ctl.quality);
+  TEST_ASSERT_EQUAL(20, ctl.over_budget);
+
+  // One step never exceeds max_step.
+  jpeg_quality_init(&ctl, 10000, 12, 0, 63);
+  TEST_ASSERT_EQUAL(20, jpeg_quality_update(&ctl, 100000));
+  // A near-empty frame improves quality by half the distance at most.
+  TEST_ASSERT_EQUAL(12, jpeg_quality_update(&ctl, 100));
+
+  jpeg_quality_init(&ctl, 0, 12, 0, 63);
+  TEST_ASSERT_EQUAL(12, jpeg_quality_update(&ctl, 100000));
+  TEST_ASSERT_EQUAL(12, jpeg_quality_update(&ctl, 10));
+
+  jpeg_quality_init(&ctl, 10000, 70, 40, 5);
+  TEST_ASSERT_EQUAL(5, ctl.best_quality);
+  TEST_ASSERT_EQUAL(40, ctl.quality);
+}
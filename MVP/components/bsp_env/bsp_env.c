@@ -2,7 +2,10 @@
 
 #include "driver/gpio.h"
 #include "driver/i2c_master.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "pir_trigger.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
@@ -12,6 +15,11 @@ static i2c_master_bus_handle_t s_i2c_bus = NULL;
 static i2c_master_dev_handle_t s_shtc3_dev = NULL;
 static bool s_ready = false;
 
+static void IRAM_ATTR pir_isr(void *arg) {
+  (void)arg;
+  pir_trigger_post_from_isr(esp_timer_get_time());
+}
+
 static uint8_t shtc3_crc8(const uint8_t *data, size_t len) {
   uint8_t crc = 0xFF;
   for (size_t i = 0; i < len; i++) {
@@ -70,7 +78,7 @@ esp_err_t bsp_env_init(void) {
       .mode = GPIO_MODE_INPUT,
       .pull_up_en = GPIO_PULLUP_DISABLE,
       .pull_down_en = GPIO_PULLDOWN_DISABLE,
-      .intr_type = GPIO_INTR_DISABLE,
+      .intr_type = GPIO_INTR_POSEDGE,
   };
   err = gpio_config(&pir_cfg);
   if (err != ESP_OK) {
@@ -78,6 +86,23 @@ esp_err_t bsp_env_init(void) {
     return err;
   }
 
+  err = pir_trigger_init();
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "PIR trigger queue init failed: %s", esp_err_to_name(err));
+    return err;
+  }
+  // The ISR service may already be installed by another driver.
+  err = gpio_install_isr_service(0);
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+    ESP_LOGE(TAG, "gpio_install_isr_service failed: %s", esp_err_to_name(err));
+    return err;
+  }
+  err = gpio_isr_handler_add(BSP_PIR_IO, pir_isr, NULL);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "PIR ISR install failed: %s", esp_err_to_name(err));
+    return err;
+  }
+
   vTaskDelay(pdMS_TO_TICKS(2));
   if (shtc3_write_cmd(0x3517) != ESP_OK) {
     ESP_LOGW(TAG, "SHTC3 wakeup command failed during init");
@@ -12,6 +12,9 @@
 #define BSP_SHTC3_ADDR   (0x70)
 #define BSP_PIR_IO       (GPIO_NUM_1)   // D0
 
+// Also arms the PIR rising-edge interrupt; wait for motion with
+// pir_trigger_wait() (pir_trigger.h) rather than polling bsp_pir_check().
 esp_err_t bsp_env_init(void);
 esp_err_t bsp_env_read(float *temp, float *hum);
+// Current PIR output level.
 bool bsp_pir_check(void);
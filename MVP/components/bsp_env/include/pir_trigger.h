@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// PIR trigger queue. The GPIO edge interrupt (bsp_env.c) posts a timestamped
+// event; the vision task blocks in pir_trigger_wait() instead of polling the
+// pin. Only FreeRTOS queues and esp_timer are used, so the same code runs in
+// a host build with a simulated edge source (see test/test_pir_trigger.c).
+
+#define PIR_TRIGGER_QUEUE_LEN 4
+
+typedef struct {
+  int64_t edge_us;  // esp_timer time of the rising edge
+  uint32_t number;  // 1-based edge count since pir_trigger_init()
+} pir_trigger_event_t;
+
+typedef struct {
+  uint32_t edges;            // edges posted, including dropped ones
+  uint32_t dropped;          // edges lost because the queue was full
+  uint32_t captures;         // pir_trigger_mark_captured() calls
+  uint32_t last_latency_us;  // edge to capture, most recent
+  uint32_t max_latency_us;
+  uint64_t total_latency_us;  // divide by captures for the mean
+} pir_trigger_stats_t;
+
+esp_err_t pir_trigger_init(void);
+void pir_trigger_deinit(void);
+
+// ISR-safe; edge_us is the caller's timestamp of the edge.
+void pir_trigger_post_from_isr(int64_t edge_us);
+// Task-context stand-in for the interrupt, for bench and host testing.
+esp_err_t pir_trigger_simulate(void);
+
+// Blocks up to timeout_ms for the next edge. Returns false on timeout.
+bool pir_trigger_wait(uint32_t timeout_ms, pir_trigger_event_t *out);
+
+// Records edge-to-capture latency for ev, measured now. Returns it in us.
+uint32_t pir_trigger_mark_captured(const pir_trigger_event_t *ev);
+void pir_trigger_get_stats(pir_trigger_stats_t *out);
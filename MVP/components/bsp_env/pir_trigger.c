@@ -0,0 +1,105 @@
+#include "pir_trigger.h"
+
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+static QueueHandle_t s_queue = NULL;
+static portMUX_TYPE s_mux = portMUX_INITIALIZER_UNLOCKED;
+static pir_trigger_stats_t s_stats;
+
+esp_err_t pir_trigger_init(void) {
+  if (s_queue) {
+    return ESP_OK;
+  }
+  s_queue = xQueueCreate(PIR_TRIGGER_QUEUE_LEN, sizeof(pir_trigger_event_t));
+  if (!s_queue) {
+    return ESP_ERR_NO_MEM;
+  }
+  memset(&s_stats, 0, sizeof(s_stats));
+  return ESP_OK;
+}
+
+void pir_trigger_deinit(void) {
+  if (s_queue) {
+    vQueueDelete(s_queue);
+    s_queue = NULL;
+  }
+}
+
+// Numbers the edge under the lock so ISR and simulated posts do not race.
+static IRAM_ATTR pir_trigger_event_t next_event(int64_t edge_us) {
+  pir_trigger_event_t ev = {.edge_us = edge_us};
+  portENTER_CRITICAL_SAFE(&s_mux);
+  ev.number = ++s_stats.edges;
+  portEXIT_CRITICAL_SAFE(&s_mux);
+  return ev;
+}
+
+static IRAM_ATTR void count_drop(void) {
+  portENTER_CRITICAL_SAFE(&s_mux);
+  s_stats.dropped++;
+  portEXIT_CRITICAL_SAFE(&s_mux);
+}
+
+void IRAM_ATTR pir_trigger_post_from_isr(int64_t edge_us) {
+  if (!s_queue) {
+    return;
+  }
+  pir_trigger_event_t ev = next_event(edge_us);
+  BaseType_t woken = pdFALSE;
+  if (xQueueSendFromISR(s_queue, &ev, &woken) != pdTRUE) {
+    count_drop();
+  }
+  portYIELD_FROM_ISR(woken);
+}
+
+esp_err_t pir_trigger_simulate(void) {
+  if (!s_queue) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  pir_trigger_event_t ev = next_event(esp_timer_get_time());
+  if (xQueueSend(s_queue, &ev, 0) != pdTRUE) {
+    count_drop();
+    return ESP_ERR_TIMEOUT;
+  }
+  return ESP_OK;
+}
+
+bool pir_trigger_wait(uint32_t timeout_ms, pir_trigger_event_t *out) {
+  if (!s_queue || !out) {
+    return false;
+  }
+  TickType_t ticks = timeout_ms == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+  return xQueueReceive(s_queue, out, ticks) == pdTRUE;
+}
+
+uint32_t pir_trigger_mark_captured(const pir_trigger_event_t *ev) {
+  if (!ev) {
+    return 0;
+  }
+  int64_t dt = esp_timer_get_time() - ev->edge_us;
+  uint32_t latency_us = dt < 0 ? 0U : (dt > (int64_t)UINT32_MAX ? UINT32_MAX : (uint32_t)dt);
+
+  portENTER_CRITICAL_SAFE(&s_mux);
+  s_stats.captures++;
+  s_stats.last_latency_us = latency_us;
+  if (latency_us > s_stats.max_latency_us) {
+    s_stats.max_latency_us = latency_us;
+  }
+  s_stats.total_latency_us += latency_us;
+  portEXIT_CRITICAL_SAFE(&s_mux);
+  return latency_us;
+}
+
+void pir_trigger_get_stats(pir_trigger_stats_t *out) {
+  if (!out) {
+    return;
+  }
+  portENTER_CRITICAL_SAFE(&s_mux);
+  *out = s_stats;
+  portEXIT_CRITICAL_SAFE(&s_mux);
+}
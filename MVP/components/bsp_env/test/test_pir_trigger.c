@@ -0,0 +1,90 @@
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "unity.h"
+
+#include "pir_trigger.h"
+
+// Simulated PIR: a task that raises edges through the same entry point the
+// GPIO interrupt uses.
+typedef struct {
+  uint32_t edges;
+  uint32_t interval_ms;
+  volatile bool done;
+} sim_source_t;
+
+static void sim_source_task(void *arg) {
+  sim_source_t *src = (sim_source_t *)arg;
+  for (uint32_t i = 0; i < src->edges; i++) {
+    vTaskDelay(pdMS_TO_TICKS(src->interval_ms));
+    pir_trigger_post_from_isr(esp_timer_get_time());
+  }
+  src->done = true;
+  vTaskDelete(NULL);
+}
+
+TEST_CASE("PIR wait times out without edges", "[pir_trigger]")
+{
+  TEST_ESP_OK(pir_trigger_init());
+  pir_trigger_event_t ev;
+  int64_t t0 = esp_timer_get_time();
+  TEST_ASSERT_FALSE(pir_trigger_wait(50, &ev));
+  int64_t waited_ms = (esp_timer_get_time() - t0) / 1000;
+  TEST_ASSERT_TRUE(waited_ms >= 40 && waited_ms < 500);
+  pir_trigger_deinit();
+}
+
+TEST_CASE("PIR edges wake the waiter and latency is recorded", "[pir_trigger]")
+{
+  TEST_ESP_OK(pir_trigger_init());
+  sim_source_t src = {.edges = 3, .interval_ms = 30};
+  TEST_ASSERT_EQUAL(pdPASS, xTaskCreate(sim_source_task, "pir_sim", 2048, &src, 5, NULL));
+
+  for (uint32_t i = 1; i <= src.edges; i++) {
+    pir_trigger_event_t ev;
+    TEST_ASSERT_TRUE(pir_trigger_wait(1000, &ev));
+    TEST_ASSERT_EQUAL_UINT32(i, ev.number);
+    // Blocking wake-up must be far below the old 20 ms polling period.
+    TEST_ASSERT_TRUE(esp_timer_get_time() - ev.edge_us < 10000);
+    vTaskDelay(pdMS_TO_TICKS(5));  // stands in for the camera
+    uint32_t latency_us = pir_trigger_mark_captured(&ev);
+    TEST_ASSERT_TRUE(latency_us >= 4000);
+  }
+
+  pir_trigger_stats_t st;
+  pir_trigger_get_stats(&st);
+  TEST_ASSERT_EQUAL_UINT32(3, st.edges);
+  TEST_ASSERT_EQUAL_UINT32(0, st.dropped);
+  TEST_ASSERT_EQUAL_UINT32(3, st.captures);
+  TEST_ASSERT_TRUE(st.max_latency_us >= st.last_latency_us);
+  TEST_ASSERT_TRUE(st.total_latency_us >= 3ULL * 4000ULL);
+  while (!src.done) {
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+  pir_trigger_deinit();
+}
+
+TEST_CASE("PIR edges beyond the queue are counted as dropped", "[pir_trigger]")
+{
+  TEST_ESP_OK(pir_trigger_init());
+  for (int i = 0; i < PIR_TRIGGER_QUEUE_LEN; i++) {
+    TEST_ESP_OK(pir_trigger_simulate());
+  }
+  TEST_ASSERT_EQUAL(ESP_ERR_TIMEOUT, pir_trigger_simulate());
+  pir_trigger_post_from_isr(esp_timer_get_time());
+
+  pir_trigger_stats_t st;
+  pir_trigger_get_stats(&st);
+  TEST_ASSERT_EQUAL_UINT32(PIR_TRIGGER_QUEUE_LEN + 2, st.edges);
+  TEST_ASSERT_EQUAL_UINT32(2, st.dropped);
+
+  // The oldest edges are kept so latency is measured from the first motion.
+  pir_trigger_event_t ev;
+  TEST_ASSERT_TRUE(pir_trigger_wait(0, &ev));
+  TEST_ASSERT_EQUAL_UINT32(1, ev.number);
+  pir_trigger_deinit();
+  TEST_ASSERT_EQUAL(ESP_ERR_INVALID_STATE, pir_trigger_simulate());
+}
@@ -51,7 +51,7 @@ esp_err_t bsp_storage_init(void) {
   esp_vfs_fat_sdmmc_mount_config_t mount_cfg = {
       .format_if_mount_failed = false,
       .max_files = 8,
-      .allocation_unit_size = 16 * 1024,
+      .allocation_unit_size = BSP_STORAGE_ALLOCATION_UNIT,
   };
 
   sdmmc_card_t *card = NULL;
@@ -81,12 +81,18 @@ int64_t bsp_storage_now_ms(void) {
 esp_err_t bsp_storage_make_path(char *out, size_t out_len,
                                 const char *subdir, const char *prefix,
                                 const char *extension) {
+  return bsp_storage_make_path_at(out, out_len, subdir, prefix, bsp_storage_now_ms(), extension);
+}
+
+esp_err_t bsp_storage_make_path_at(char *out, size_t out_len,
+                                   const char *subdir, const char *prefix,
+                                   int64_t timestamp_ms, const char *extension) {
   if (!s_ready || !out || !subdir || !prefix || !extension) {
     return ESP_ERR_INVALID_ARG;
   }
 
   int written = snprintf(out, out_len, "/sdcard/%s/%s_%lld.%s",
-                         subdir, prefix, (long long)bsp_storage_now_ms(), extension);
+                         subdir, prefix, (long long)timestamp_ms, extension);
   if (written < 0 || (size_t)written >= out_len) {
     return ESP_ERR_INVALID_SIZE;
   }
@@ -108,6 +114,40 @@ esp_err_t bsp_storage_write_blob(const char *path, const void *data, size_t len)
   return (written == len) ? ESP_OK : ESP_FAIL;
 }
 
+esp_err_t bsp_storage_read_text(const char *path, char *out, size_t out_len) {
+  if (!s_ready || !path || !out || out_len == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  size_t got = fread(out, 1, out_len - 1, f);
+  int err = ferror(f);
+  fclose(f);
+  out[got] = '\0';
+  return err ? ESP_FAIL : ESP_OK;
+}
+
+esp_err_t bsp_storage_append_line(const char *path, const char *line) {
+  if (!s_ready || !path || !line) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  FILE *f = fopen(path, "a");
+  if (!f) {
+    return ESP_FAIL;
+  }
+
+  int rc = fputs(line, f);
+  if (fclose(f) != 0) {
+    rc = EOF;
+  }
+  return (rc == EOF) ? ESP_FAIL : ESP_OK;
+}
+
 esp_err_t bsp_storage_append_env_log(float latitude, float longitude,
                                      float temperature_c, float humidity_pct,
                                      bool has_fix) {
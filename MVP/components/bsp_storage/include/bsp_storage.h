@@ -6,6 +6,10 @@
 
 #include "esp_err.h"
 
+// FAT cluster size used when mounting; writers that buffer in multiples of
+// this keep every fwrite cluster aligned.
+#define BSP_STORAGE_ALLOCATION_UNIT (16 * 1024)
+
 esp_err_t bsp_storage_init(void);
 bool bsp_storage_is_ready(void);
 int64_t bsp_storage_now_ms(void);
@@ -13,8 +17,17 @@ int64_t bsp_storage_now_ms(void);
 esp_err_t bsp_storage_make_path(char *out, size_t out_len,
                                 const char *subdir, const char *prefix,
                                 const char *extension);
+// Same as bsp_storage_make_path, but names the file after timestamp_ms
+// instead of the current time (e.g. the first sample of an audio segment).
+esp_err_t bsp_storage_make_path_at(char *out, size_t out_len,
+                                   const char *subdir, const char *prefix,
+                                   int64_t timestamp_ms, const char *extension);
 
 esp_err_t bsp_storage_write_blob(const char *path, const void *data, size_t len);
+esp_err_t bsp_storage_append_line(const char *path, const char *line);
+// Reads up to out_len - 1 bytes and NUL-terminates; ESP_ERR_NOT_FOUND if the
+// file does not exist.
+esp_err_t bsp_storage_read_text(const char *path, char *out, size_t out_len);
 esp_err_t bsp_storage_append_env_log(float latitude, float longitude,
                                      float temperature_c, float humidity_pct,
                                      bool has_fix);
@@ -160,6 +160,21 @@ void jpgSetChroma(chroma_t chroma);
  */
 void jpgSetRgb565BE(bool enable);
 
+/**
+ * @brief Set how many tasks share one JPEG encode.
+ *
+ * With more than one, the image is split into strips of MCU rows (16 pixel
+ * rows for 4:2:0, 8 otherwise). The calling task encodes the first strip and
+ * streams it to the output while worker tasks encode the others; their output
+ * is buffered and written in order. A restart marker ends every MCU row so
+ * the strips join into one baseline JPEG, about 2.5 bytes per row larger than
+ * a serial encode. The workers are created on first use and kept, at the
+ * caller's priority, without core affinity. One split encode runs at a time.
+ *
+ * @param workers   Tasks per encode, 1 (default, serial) to 8
+ */
+void jpgSetWorkers(uint8_t workers);
+
 #ifdef __cplusplus
 }
 #endif
@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <malloc.h>
+#include <atomic>
 #include "esp_heap_caps.h"
 
 #define JPGE_MAX(a,b) (((a)>(b))?(a):(b))
@@ -39,7 +40,7 @@ namespace jpge {
     static inline void jpge_free(void *p) { free(p); }
 
     // Various JPEG enums and tables.
-    enum { M_SOF0 = 0xC0, M_DHT = 0xC4, M_SOI = 0xD8, M_EOI = 0xD9, M_SOS = 0xDA, M_DQT = 0xDB, M_APP0 = 0xE0 };
+    enum { M_SOF0 = 0xC0, M_DHT = 0xC4, M_RST0 = 0xD0, M_SOI = 0xD8, M_EOI = 0xD9, M_SOS = 0xDA, M_DQT = 0xDB, M_DRI = 0xDD, M_APP0 = 0xE0 };
     enum { DC_LUM_CODES = 12, AC_LUM_CODES = 256, DC_CHROMA_CODES = 12, AC_CHROMA_CODES = 256, MAX_HUFF_SYMBOLS = 257, MAX_HUFF_CODESIZE = 32 };
 
     static const uint8 s_zag[64] = { 0,1,8,16,9,2,3,10,17,24,32,25,18,11,4,5,12,19,26,33,40,48,41,34,27,20,13,6,7,14,21,28,35,42,49,56,57,50,43,36,29,22,15,23,30,37,44,51,58,59,52,45,38,31,39,46,53,60,61,54,47,55,62,63 };
@@ -70,14 +71,23 @@ namespace jpge {
 
     const int YR = 19595, YG = 38470, YB = 7471, CB_R = -11059, CB_G = -21709, CB_B = 32768, CR_R = 32768, CR_G = -27439, CR_B = -5329;
 
-    static int32 m_last_quality = 0;
-    static int32 m_quantization_tables[2][64];
+    // Quantization tables for one quality. Read-only once built, so any number of encoders can share them.
+    struct quality_tables {
+        int quality;
+        int32 quant[2][64];     // zig-zag order, as DQT writes them
+        uint32 recip[2][64];    // what DCT2D_quantize() multiplies by, see compute_quant_table()
+    };
+
+    // Built tables, shared by every encoder and never freed. A slot only ever goes from NULL to its tables, so
+    // readers need no lock. Once all slots are taken, encoders at other qualities build a private copy.
+    enum { QUALITY_CACHE_SLOTS = 8 };
+    static std::atomic<const quality_tables *> s_quality_cache[QUALITY_CACHE_SLOTS];
 
-    static bool m_huff_initialized = false;
-    static uint m_huff_codes[4][256];
-    static uint8 m_huff_code_sizes[4][256];
-    static uint8 m_huff_bits[4][17];
-    static uint8 m_huff_val[4][256];
+    // The standard Huffman tables by symbol: code in bits 8 and up, size in bits 0-7, one load per symbol.
+    struct huffman_tables {
+        uint32 codes[4][256];   // DC luma, DC chroma, AC luma, AC chroma
+        huffman_tables();
+    };
 
     static inline uint8 clamp(int i) {
         if (i < 0) {
@@ -103,6 +113,19 @@ namespace jpge {
         }
     }
 
+    static void YCbCr422_to_Y(uint8* pDst, const uint8 *pSrc, int num_pixels) {
+        for ( ; num_pixels; pDst++, pSrc += 2, num_pixels--) {
+            pDst[0] = pSrc[0];
+        }
+    }
+
+    // Y0 Cb Y1 Cr to three planes.
+    static void YCbCr422_to_planes(uint8* pY, uint8* pCb, uint8* pCr, const uint8 *pSrc, int num_pairs) {
+        for ( ; num_pairs; pY += 2, pCb++, pCr++, pSrc += 4, num_pairs--) {
+            pY[0] = pSrc[0]; pCb[0] = pSrc[1]; pY[1] = pSrc[2]; pCr[0] = pSrc[3];
+        }
+    }
+
     static void Y_to_YCC(uint8* pDst, const uint8* pSrc, int num_pixels) {
         for( ; num_pixels; pDst += 3, pSrc++, num_pixels--) {
             pDst[0] = pSrc[0];
@@ -111,76 +134,88 @@ namespace jpge {
         }
     }
 
-    // Forward DCT - DCT derived from jfdctint.
-    enum { CONST_BITS = 13, ROW_BITS = 2 };
-#define DCT_DESCALE(x, n) (((x) + (((int32)1) << ((n) - 1))) >> (n))
-#define DCT_MUL(var, c) (static_cast<int16>(var) * static_cast<int32>(c))
-#define DCT1D(s0, s1, s2, s3, s4, s5, s6, s7) \
+    // Forward DCT - AAN (Arai, Agui, Nakajima) as in libjpeg's jfdctfst, 5 multiplies per 1D pass instead of
+    // jfdctint's 12, in 13-bit fixed point. Row inputs are scaled up by DCT_PASS1_BITS for precision. The
+    // outputs come out scaled by 8 * aan[u] * aan[v] << DCT_PASS1_BITS; the quantizer's reciprocals undo that.
+    enum { DCT_CONST_BITS = 13, DCT_PASS1_BITS = 2 };
+#define DCT_FIX_0_382683433 3135
+#define DCT_FIX_0_541196100 4433
+#define DCT_FIX_0_707106781 5793
+#define DCT_FIX_1_306562965 10703
+#define DCT_MUL(var, c) (((var) * static_cast<int32>(c) + (1 << (DCT_CONST_BITS - 1))) >> DCT_CONST_BITS)
+#define AAN1D(s0, s1, s2, s3, s4, s5, s6, s7) \
     int32 t0 = s0 + s7, t7 = s0 - s7, t1 = s1 + s6, t6 = s1 - s6, t2 = s2 + s5, t5 = s2 - s5, t3 = s3 + s4, t4 = s3 - s4; \
     int32 t10 = t0 + t3, t13 = t0 - t3, t11 = t1 + t2, t12 = t1 - t2; \
-    int32 u1 = DCT_MUL(t12 + t13, 4433); \
-    s2 = u1 + DCT_MUL(t13, 6270); \
-    s6 = u1 + DCT_MUL(t12, -15137); \
-    u1 = t4 + t7; \
-    int32 u2 = t5 + t6, u3 = t4 + t6, u4 = t5 + t7; \
-    int32 z5 = DCT_MUL(u3 + u4, 9633); \
-    t4 = DCT_MUL(t4, 2446); t5 = DCT_MUL(t5, 16819); \
-    t6 = DCT_MUL(t6, 25172); t7 = DCT_MUL(t7, 12299); \
-    u1 = DCT_MUL(u1, -7373); u2 = DCT_MUL(u2, -20995); \
-    u3 = DCT_MUL(u3, -16069); u4 = DCT_MUL(u4, -3196); \
-    u3 += z5; u4 += z5; \
-    s0 = t10 + t11; s1 = t7 + u1 + u4; s3 = t6 + u2 + u3; s4 = t10 - t11; s5 = t5 + u2 + u4; s7 = t4 + u1 + u3;
-
-    static void DCT2D(int32 *p) {
+    int32 z1 = DCT_MUL(t12 + t13, DCT_FIX_0_707106781); \
+    s0 = t10 + t11; s4 = t10 - t11; s2 = t13 + z1; s6 = t13 - z1; \
+    t10 = t4 + t5; t11 = t5 + t6; t12 = t6 + t7; \
+    int32 z5 = DCT_MUL(t10 - t12, DCT_FIX_0_382683433); \
+    int32 z2 = DCT_MUL(t10, DCT_FIX_0_541196100) + z5; \
+    int32 z4 = DCT_MUL(t12, DCT_FIX_1_306562965) + z5; \
+    int32 z3 = DCT_MUL(t11, DCT_FIX_0_707106781); \
+    int32 z11 = t7 + z3, z13 = t7 - z3; \
+    s5 = z13 + z2; s3 = z13 - z2; s1 = z11 + z4; s7 = z11 - z4;
+
+    // aan[k] = cos(k * pi / 16) * sqrt(2) for k > 0, 1 for k = 0, in 14-bit fixed point.
+    static const uint16 s_aan_scale[8] = { 16384, 22725, 21407, 19266, 16384, 12873, 8867, 4520 };
+
+    // Zig-zag position of each natural-order coefficient (inverse of s_zag).
+    static const uint8 s_zag_pos[64] = { 0,1,5,6,14,15,27,28,2,4,7,13,16,26,29,42,3,8,12,17,25,30,41,43,9,11,18,24,31,40,44,53,10,19,23,32,39,45,52,54,20,22,33,38,46,51,55,60,21,34,37,47,50,56,59,61,35,36,48,49,57,58,62,63 };
+
+    // The DCT of p, quantized with recip (zig-zag order, see compute_quant_table()) into pDst in zig-zag order as
+    // the column pass produces each coefficient. Returns bit i set for each nonzero zig-zag coefficient i.
+    static uint64 DCT2D_quantize(int32 *p, const uint32 *recip, int16 *pDst) {
         int32 c, *q = p;
         for (c = 7; c >= 0; c--, q += 8) {
-            int32 s0 = q[0], s1 = q[1], s2 = q[2], s3 = q[3], s4 = q[4], s5 = q[5], s6 = q[6], s7 = q[7];
-            DCT1D(s0, s1, s2, s3, s4, s5, s6, s7);
-            q[0] = s0 << ROW_BITS; q[1] = DCT_DESCALE(s1, CONST_BITS-ROW_BITS); q[2] = DCT_DESCALE(s2, CONST_BITS-ROW_BITS); q[3] = DCT_DESCALE(s3, CONST_BITS-ROW_BITS);
-            q[4] = s4 << ROW_BITS; q[5] = DCT_DESCALE(s5, CONST_BITS-ROW_BITS); q[6] = DCT_DESCALE(s6, CONST_BITS-ROW_BITS); q[7] = DCT_DESCALE(s7, CONST_BITS-ROW_BITS);
-        }
-        for (q = p, c = 7; c >= 0; c--, q++) {
-            int32 s0 = q[0*8], s1 = q[1*8], s2 = q[2*8], s3 = q[3*8], s4 = q[4*8], s5 = q[5*8], s6 = q[6*8], s7 = q[7*8];
-            DCT1D(s0, s1, s2, s3, s4, s5, s6, s7);
-            q[0*8] = DCT_DESCALE(s0, ROW_BITS+3); q[1*8] = DCT_DESCALE(s1, CONST_BITS+ROW_BITS+3); q[2*8] = DCT_DESCALE(s2, CONST_BITS+ROW_BITS+3); q[3*8] = DCT_DESCALE(s3, CONST_BITS+ROW_BITS+3);
-            q[4*8] = DCT_DESCALE(s4, ROW_BITS+3); q[5*8] = DCT_DESCALE(s5, CONST_BITS+ROW_BITS+3); q[6*8] = DCT_DESCALE(s6, CONST_BITS+ROW_BITS+3); q[7*8] = DCT_DESCALE(s7, CONST_BITS+ROW_BITS+3);
+            int32 s0 = q[0] << DCT_PASS1_BITS, s1 = q[1] << DCT_PASS1_BITS, s2 = q[2] << DCT_PASS1_BITS, s3 = q[3] << DCT_PASS1_BITS;
+            int32 s4 = q[4] << DCT_PASS1_BITS, s5 = q[5] << DCT_PASS1_BITS, s6 = q[6] << DCT_PASS1_BITS, s7 = q[7] << DCT_PASS1_BITS;
+            AAN1D(s0, s1, s2, s3, s4, s5, s6, s7);
+            q[0] = s0; q[1] = s1; q[2] = s2; q[3] = s3; q[4] = s4; q[5] = s5; q[6] = s6; q[7] = s7;
+        }
+        uint64 nonzero = 0;
+        for (q = p, c = 0; c < 8; c++, q++) {
+            int32 s[8] = { q[0*8], q[1*8], q[2*8], q[3*8], q[4*8], q[5*8], q[6*8], q[7*8] };
+            AAN1D(s[0], s[1], s[2], s[3], s[4], s[5], s[6], s[7]);
+            for (int u = 0; u < 8; u++) {
+                // round(|s| / divisor) as a multiply by 2^32 / divisor, sign put back after
+                const int z = s_zag_pos[u * 8 + c];
+                const int32 sign = s[u] >> 31;
+                const uint32 mag = uint32((s[u] ^ sign) - sign);
+                const int32 v = int32((uint64(mag) * recip[z] + 0x80000000u) >> 32);
+                pDst[z] = static_cast<int16>((v ^ sign) - sign);
+                nonzero |= uint64(v != 0) << z;
+            }
         }
+        return nonzero;
     }
 
-    // Compute the actual canonical Huffman codes/code sizes given the JPEG huff bits and val arrays.
-    static void compute_huffman_table(uint *codes, uint8 *code_sizes, uint8 *bits, uint8 *val)
+    // Compute the canonical Huffman codes given the JPEG huff bits and val arrays (JPEG Annex C): codes of one
+    // length are consecutive, and each longer length starts at twice the next code. codes[val] = code << 8 | size.
+    static void compute_huffman_table(uint32 *codes, const uint8 *bits, const uint8 *val)
     {
-        int i, l, last_p, si;
-        static uint8 huff_size[257];
-        static uint huff_code[257];
-        uint code;
-
+        uint code = 0;
         int p = 0;
-        for (l = 1; l <= 16; l++) {
-            for (i = 1; i <= bits[l]; i++) {
-                huff_size[p++] = (char)l;
+        memset(codes, 0, sizeof(codes[0])*256);
+        for (int l = 1; l <= 16; l++, code <<= 1) {
+            for (int i = 0; i < bits[l]; i++) {
+                codes[val[p++]] = (code++) << 8 | l;
             }
         }
+    }
 
-        huff_size[p] = 0;
-        last_p = p; // write sentinel
-
-        code = 0; si = huff_size[0]; p = 0;
-
-        while (huff_size[p]) {
-            while (huff_size[p] == si) {
-                huff_code[p++] = code++;
-            }
-            code <<= 1;
-            si++;
-        }
+    huffman_tables::huffman_tables()
+    {
+        compute_huffman_table(codes[0+0], s_dc_lum_bits, s_dc_lum_val);
+        compute_huffman_table(codes[0+1], s_dc_chroma_bits, s_dc_chroma_val);
+        compute_huffman_table(codes[2+0], s_ac_lum_bits, s_ac_lum_val);
+        compute_huffman_table(codes[2+1], s_ac_chroma_bits, s_ac_chroma_val);
+    }
 
-        memset(codes, 0, sizeof(codes[0])*256);
-        memset(code_sizes, 0, sizeof(code_sizes[0])*256);
-        for (p = 0; p < last_p; p++) {
-            codes[val[p]]      = huff_code[p];
-            code_sizes[val[p]] = huff_size[p];
-        }
+    // Built by the first encoder to ask; C++ makes concurrent first calls wait for it.
+    static const huffman_tables &standard_huffman_tables()
+    {
+        static const huffman_tables s_tables;
+        return s_tables;
     }
 
     void jpeg_encoder::flush_output_buffer()
@@ -200,19 +235,63 @@ namespace jpge {
         }
     }
 
-    void jpeg_encoder::put_bits(uint bits, uint len)
+    // Bits collect at the bottom of a 64-bit accumulator, MSB first, and leave it 32 at a time. len <= 32.
+    inline void jpeg_encoder::put_bits(uint bits, uint len)
+    {
+        m_bit_buffer = (m_bit_buffer << len) | bits;
+        if ((m_bits_in += len) >= 32) {
+            flush_bit_word();
+        }
+    }
+
+    // Write out the oldest 32 bits, stuffing a 0 after each 0xFF byte.
+    void jpeg_encoder::flush_bit_word()
+    {
+        m_bits_in -= 32;
+        const uint32 w = uint32(m_bit_buffer >> m_bits_in);
+        // The fast path stores up to 8 bytes and never flushes, so it needs at least one byte to spare after them:
+        // emit_byte() expects m_out_buf_left > 0 on entry, whatever runs of 0xFF the Huffman tables can produce.
+        if (m_out_buf_left <= 8) {
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                const uint8 c = uint8(w >> shift);
+                emit_byte(c);
+                if (c == 0xFF) {
+                    emit_byte(0);
+                }
+            }
+            return;
+        }
+        uint8 *p = m_pOut_buf;
+        p[0] = uint8(w >> 24); p[1] = uint8(w >> 16); p[2] = uint8(w >> 8); p[3] = uint8(w);
+        // Any 0xFF byte? (Borrows can flag a byte next to one, never miss one.)
+        if ((~w - 0x01010101u) & w & 0x80808080u) {
+            // Stuff without branching: the 0 always lands, the pointer only moves past it after 0xFF.
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                const uint8 c = uint8(w >> shift);
+                p[0] = c; p[1] = 0;
+                p += 1 + (c == 0xFF);
+            }
+        } else {
+            p += 4;
+        }
+        m_out_buf_left -= uint(p - m_pOut_buf);
+        m_pOut_buf = p;
+    }
+
+    // Pad the last byte with 1 bits and write out everything left in the accumulator.
+    void jpeg_encoder::flush_bits()
     {
-        uint8 c = 0;
-        m_bit_buffer |= ((uint32)bits << (24 - (m_bits_in += len)));
+        put_bits(0x7F, 7);
         while (m_bits_in >= 8) {
-            c = (uint8)((m_bit_buffer >> 16) & 0xFF);
+            m_bits_in -= 8;
+            const uint8 c = uint8(m_bit_buffer >> m_bits_in);
             emit_byte(c);
             if (c == 0xFF) {
                 emit_byte(0);
             }
-            m_bit_buffer <<= 8;
-            m_bits_in -= 8;
         }
+        m_bit_buffer = 0;
+        m_bits_in = 0;
     }
 
     void jpeg_encoder::emit_word(uint i)
@@ -251,7 +330,7 @@ namespace jpge {
             emit_word(64 + 1 + 2);
             emit_byte(static_cast<uint8>(i));
             for (int j = 0; j < 64; j++)
-                emit_byte(static_cast<uint8>(m_quantization_tables[i][j]));
+                emit_byte(static_cast<uint8>(m_quality_tables->quant[i][j]));
         }
     }
 
@@ -273,7 +352,7 @@ namespace jpge {
     }
 
     // Emit Huffman table.
-    void jpeg_encoder::emit_dht(uint8 *bits, uint8 *val, int index, bool ac_flag)
+    void jpeg_encoder::emit_dht(const uint8 *bits, const uint8 *val, int index, bool ac_flag)
     {
         emit_marker(M_DHT);
 
@@ -294,14 +373,22 @@ namespace jpge {
     // Emit all Huffman tables.
     void jpeg_encoder::emit_dhts()
     {
-        emit_dht(m_huff_bits[0+0], m_huff_val[0+0], 0, false);
-        emit_dht(m_huff_bits[2+0], m_huff_val[2+0], 0, true);
+        emit_dht(s_dc_lum_bits, s_dc_lum_val, 0, false);
+        emit_dht(s_ac_lum_bits, s_ac_lum_val, 0, true);
         if (m_num_components == 3) {
-            emit_dht(m_huff_bits[0+1], m_huff_val[0+1], 1, false);
-            emit_dht(m_huff_bits[2+1], m_huff_val[2+1], 1, true);
+            emit_dht(s_dc_chroma_bits, s_dc_chroma_val, 1, false);
+            emit_dht(s_ac_chroma_bits, s_ac_chroma_val, 1, true);
         }
     }
 
+    // Emit restart interval: one MCU row
+    void jpeg_encoder::emit_dri()
+    {
+        emit_marker(M_DRI);
+        emit_word(4);
+        emit_word(m_mcus_per_row);
+    }
+
     // emit start of scan
     void jpeg_encoder::emit_sos()
     {
@@ -321,6 +408,14 @@ namespace jpge {
         emit_byte(0);
     }
 
+    // End a restart interval: pad to a byte with 1 bits, emit RSTn, reset the DC predictions.
+    void jpeg_encoder::emit_restart(int n)
+    {
+        flush_bits();
+        emit_marker(M_RST0 + (n & 7));
+        memset(m_last_dc_val, 0, sizeof(m_last_dc_val));
+    }
+
     void jpeg_encoder::load_block_8_8_grey(int x)
     {
         uint8 *pSrc;
@@ -353,7 +448,7 @@ namespace jpge {
         uint8 *pSrc1, *pSrc2;
         sample_array_t *pDst = m_sample_array;
         x = (x * (16 * 3)) + c;
-        int a = 0, b = 2;
+        int a = 1, b = 2;
         for (int i = 0; i < 16; i += 2, pDst += 8)
         {
             pSrc1 = m_mcu_lines[i + 0] + x;
@@ -374,107 +469,101 @@ namespace jpge {
         for (int i = 0; i < 8; i++, pDst += 8)
         {
             pSrc1 = m_mcu_lines[i + 0] + x;
-            pDst[0] = ((pSrc1[ 0 * 3] + pSrc1[ 1 * 3]) >> 1) - 128; pDst[1] = ((pSrc1[ 2 * 3] + pSrc1[ 3 * 3]) >> 1) - 128;
-            pDst[2] = ((pSrc1[ 4 * 3] + pSrc1[ 5 * 3]) >> 1) - 128; pDst[3] = ((pSrc1[ 6 * 3] + pSrc1[ 7 * 3]) >> 1) - 128;
-            pDst[4] = ((pSrc1[ 8 * 3] + pSrc1[ 9 * 3]) >> 1) - 128; pDst[5] = ((pSrc1[10 * 3] + pSrc1[11 * 3]) >> 1) - 128;
-            pDst[6] = ((pSrc1[12 * 3] + pSrc1[13 * 3]) >> 1) - 128; pDst[7] = ((pSrc1[14 * 3] + pSrc1[15 * 3]) >> 1) - 128;
+            pDst[0] = ((pSrc1[ 0 * 3] + pSrc1[ 1 * 3]    ) >> 1) - 128; pDst[1] = ((pSrc1[ 2 * 3] + pSrc1[ 3 * 3] + 1) >> 1) - 128;
+            pDst[2] = ((pSrc1[ 4 * 3] + pSrc1[ 5 * 3]    ) >> 1) - 128; pDst[3] = ((pSrc1[ 6 * 3] + pSrc1[ 7 * 3] + 1) >> 1) - 128;
+            pDst[4] = ((pSrc1[ 8 * 3] + pSrc1[ 9 * 3]    ) >> 1) - 128; pDst[5] = ((pSrc1[10 * 3] + pSrc1[11 * 3] + 1) >> 1) - 128;
+            pDst[6] = ((pSrc1[12 * 3] + pSrc1[13 * 3]    ) >> 1) - 128; pDst[7] = ((pSrc1[14 * 3] + pSrc1[15 * 3] + 1) >> 1) - 128;
         }
     }
 
-    void jpeg_encoder::load_quantized_coefficients(int component_num)
+    // Planar rows (YCbCr 4:2:2 source): ofs is the byte offset of the block's first sample in the row.
+    void jpeg_encoder::load_block_planar_8_8(int ofs, int y)
     {
-        int32 *q = m_quantization_tables[component_num > 0];
-        int16 *pDst = m_coefficient_array;
-        for (int i = 0; i < 64; i++)
+        uint8 *pSrc;
+        sample_array_t *pDst = m_sample_array;
+        for (int i = 0; i < 8; i++, pDst += 8)
         {
-            sample_array_t j = m_sample_array[s_zag[i]];
-            if (j < 0)
-            {
-                if ((j = -j + (*q >> 1)) < *q)
-                    *pDst++ = 0;
-                else
-                    *pDst++ = static_cast<int16>(-(j / *q));
-            }
-            else
-            {
-                if ((j = j + (*q >> 1)) < *q)
-                    *pDst++ = 0;
-                else
-                    *pDst++ = static_cast<int16>((j / *q));
-            }
-            q++;
+            pSrc = m_mcu_lines[y + i] + ofs;
+            pDst[0] = pSrc[0] - 128; pDst[1] = pSrc[1] - 128; pDst[2] = pSrc[2] - 128; pDst[3] = pSrc[3] - 128;
+            pDst[4] = pSrc[4] - 128; pDst[5] = pSrc[5] - 128; pDst[6] = pSrc[6] - 128; pDst[7] = pSrc[7] - 128;
         }
     }
 
-    void jpeg_encoder::code_coefficients_pass_two(int component_num)
+    // 8 chroma samples by 16 rows, averaged in row pairs (4:2:2 to 4:2:0), rounded like load_block_16_8().
+    void jpeg_encoder::load_block_planar_8_16(int ofs)
     {
-        int i, j, run_len, nbits, temp1, temp2;
-        int16 *pSrc = m_coefficient_array;
-        uint *codes[2];
-        uint8 *code_sizes[2];
-
-        if (component_num == 0)
+        uint8 *pSrc1, *pSrc2;
+        sample_array_t *pDst = m_sample_array;
+        int a = 0, b = 1;
+        for (int i = 0; i < 16; i += 2, pDst += 8)
         {
-            codes[0] = m_huff_codes[0 + 0]; codes[1] = m_huff_codes[2 + 0];
-            code_sizes[0] = m_huff_code_sizes[0 + 0]; code_sizes[1] = m_huff_code_sizes[2 + 0];
+            pSrc1 = m_mcu_lines[i + 0] + ofs;
+            pSrc2 = m_mcu_lines[i + 1] + ofs;
+            pDst[0] = ((pSrc1[0] + pSrc2[0] + a) >> 1) - 128; pDst[1] = ((pSrc1[1] + pSrc2[1] + b) >> 1) - 128;
+            pDst[2] = ((pSrc1[2] + pSrc2[2] + a) >> 1) - 128; pDst[3] = ((pSrc1[3] + pSrc2[3] + b) >> 1) - 128;
+            pDst[4] = ((pSrc1[4] + pSrc2[4] + a) >> 1) - 128; pDst[5] = ((pSrc1[5] + pSrc2[5] + b) >> 1) - 128;
+            pDst[6] = ((pSrc1[6] + pSrc2[6] + a) >> 1) - 128; pDst[7] = ((pSrc1[7] + pSrc2[7] + b) >> 1) - 128;
+            int temp = a; a = b; b = temp;
         }
-        else
+    }
+
+    // 4 chroma samples by 8 rows, each repeated (4:2:2 to 4:4:4).
+    void jpeg_encoder::load_block_planar_4_8(int ofs)
+    {
+        uint8 *pSrc;
+        sample_array_t *pDst = m_sample_array;
+        for (int i = 0; i < 8; i++, pDst += 8)
         {
-            codes[0] = m_huff_codes[0 + 1]; codes[1] = m_huff_codes[2 + 1];
-            code_sizes[0] = m_huff_code_sizes[0 + 1]; code_sizes[1] = m_huff_code_sizes[2 + 1];
+            pSrc = m_mcu_lines[i] + ofs;
+            pDst[0] = pDst[1] = pSrc[0] - 128; pDst[2] = pDst[3] = pSrc[1] - 128;
+            pDst[4] = pDst[5] = pSrc[2] - 128; pDst[6] = pDst[7] = pSrc[3] - 128;
         }
+    }
 
-        temp1 = temp2 = pSrc[0] - m_last_dc_val[component_num];
-        m_last_dc_val[component_num] = pSrc[0];
+    static inline uint bit_length(uint x)
+    {
+        return x ? 32 - __builtin_clz(x) : 0;
+    }
 
-        if (temp1 < 0)
-        {
-            temp1 = -temp1; temp2--;
-        }
+    // Huffman code of (run, size of value) and the value's bits, in one put_bits().
+    inline void jpeg_encoder::put_symbol(const uint32 *codes, int run, int value)
+    {
+        const int32 sign = value >> 31;
+        const uint nbits = bit_length((value ^ sign) - sign);
+        const uint32 code = codes[(run << 4) + nbits];
+        put_bits(((code >> 8) << nbits) | ((value + sign) & ((1u << nbits) - 1)), (code & 0xFF) + nbits);
+    }
 
-        nbits = 0;
-        while (temp1)
-        {
-            nbits++; temp1 >>= 1;
-        }
+    // nonzero: bit i set if zig-zag coefficient i is not 0. The AC loop jumps from one to the next.
+    void jpeg_encoder::code_coefficients_pass_two(int component_num, uint64 nonzero)
+    {
+        const int16 *pSrc = m_coefficient_array;
+        const uint32 *dc_codes = m_huff_codes[0 + (component_num > 0)];
+        const uint32 *ac_codes = m_huff_codes[2 + (component_num > 0)];
 
-        put_bits(codes[0][nbits], code_sizes[0][nbits]);
-        if (nbits) put_bits(temp2 & ((1 << nbits) - 1), nbits);
+        put_symbol(dc_codes, 0, pSrc[0] - m_last_dc_val[component_num]);
+        m_last_dc_val[component_num] = pSrc[0];
 
-        for (run_len = 0, i = 1; i < 64; i++)
+        int last = 0;
+        for (nonzero &= ~uint64(1); nonzero; nonzero &= nonzero - 1)
         {
-            if ((temp1 = m_coefficient_array[i]) == 0)
-                run_len++;
-            else
+            const int i = __builtin_ctzll(nonzero);
+            int run_len = i - last - 1;
+            while (run_len >= 16)
             {
-                while (run_len >= 16)
-                {
-                    put_bits(codes[1][0xF0], code_sizes[1][0xF0]);
-                    run_len -= 16;
-                }
-                if ((temp2 = temp1) < 0)
-                {
-                    temp1 = -temp1;
-                    temp2--;
-                }
-                nbits = 1;
-                while (temp1 >>= 1)
-                    nbits++;
-                j = (run_len << 4) + nbits;
-                put_bits(codes[1][j], code_sizes[1][j]);
-                put_bits(temp2 & ((1 << nbits) - 1), nbits);
-                run_len = 0;
+                put_bits(ac_codes[0xF0] >> 8, ac_codes[0xF0] & 0xFF);
+                run_len -= 16;
             }
+            put_symbol(ac_codes, run_len, pSrc[i]);
+            last = i;
         }
-        if (run_len)
-            put_bits(codes[1][0], code_sizes[1][0]);
+        if (last != 63)
+            put_bits(ac_codes[0] >> 8, ac_codes[0] & 0xFF);
     }
 
     void jpeg_encoder::code_block(int component_num)
     {
-        DCT2D(m_sample_array);
-        load_quantized_coefficients(component_num);
-        code_coefficients_pass_two(component_num);
+        code_coefficients_pass_two(component_num, DCT2D_quantize(m_sample_array, m_quality_tables->recip[component_num > 0], m_coefficient_array));
     }
 
     void jpeg_encoder::process_mcu_row()
@@ -512,6 +601,36 @@ namespace jpge {
         }
     }
 
+    void jpeg_encoder::process_mcu_row_planar()
+    {
+        const int cb = m_image_x_mcu, cr = cb + m_image_x_mcu / 2;
+        if (m_comp_h_samp[0] == 1)
+        {
+            for (int i = 0; i < m_mcus_per_row; i++)
+            {
+                load_block_planar_8_8(i * 8, 0); code_block(0);
+                load_block_planar_4_8(cb + i * 4); code_block(1); load_block_planar_4_8(cr + i * 4); code_block(2);
+            }
+        }
+        else if (m_comp_v_samp[0] == 1)
+        {
+            for (int i = 0; i < m_mcus_per_row; i++)
+            {
+                load_block_planar_8_8(i * 16, 0); code_block(0); load_block_planar_8_8(i * 16 + 8, 0); code_block(0);
+                load_block_planar_8_8(cb + i * 8, 0); code_block(1); load_block_planar_8_8(cr + i * 8, 0); code_block(2);
+            }
+        }
+        else
+        {
+            for (int i = 0; i < m_mcus_per_row; i++)
+            {
+                load_block_planar_8_8(i * 16, 0); code_block(0); load_block_planar_8_8(i * 16 + 8, 0); code_block(0);
+                load_block_planar_8_8(i * 16, 8); code_block(0); load_block_planar_8_8(i * 16 + 8, 8); code_block(0);
+                load_block_planar_8_16(cb + i * 8); code_block(1); load_block_planar_8_16(cr + i * 8); code_block(2);
+            }
+        }
+    }
+
     void jpeg_encoder::load_mcu(const void *pSrc)
     {
         const uint8* Psrc = reinterpret_cast<const uint8*>(pSrc);
@@ -521,8 +640,14 @@ namespace jpge {
         if (m_num_components == 1) {
             if (m_image_bpp == 3)
                 RGB_to_Y(pDst, Psrc, m_image_x);
+            else if (m_image_bpp == 2)
+                YCbCr422_to_Y(pDst, Psrc, m_image_x);
             else
                 memcpy(pDst, Psrc, m_image_x);
+        } else if (m_image_bpp == 2) {
+            // Planar: Y, then Cb and Cr at half width each; see process_mcu_row_planar().
+            uint8 *pCb = pDst + m_image_x_mcu, *pCr = pCb + m_image_x_mcu / 2;
+            YCbCr422_to_planes(pDst, pCb, pCr, Psrc, m_image_x / 2);
         } else {
             if (m_image_bpp == 3)
                 RGB_to_YCC(pDst, Psrc, m_image_x);
@@ -533,6 +658,14 @@ namespace jpge {
         // Possibly duplicate pixels at end of scanline if not a multiple of 8 or 16
         if (m_num_components == 1)
             memset(m_mcu_lines[m_mcu_y_ofs] + m_image_bpl_xlt, pDst[m_image_bpl_xlt - 1], m_image_x_mcu - m_image_x);
+        else if (m_image_bpp == 2)
+        {
+            const int half = m_image_x / 2, half_mcu = m_image_x_mcu / 2;
+            uint8 *pCb = pDst + m_image_x_mcu, *pCr = pCb + half_mcu;
+            memset(pDst + m_image_x, pDst[m_image_x - 1], m_image_x_mcu - m_image_x);
+            memset(pCb + half, pCb[half - 1], half_mcu - half);
+            memset(pCr + half, pCr[half - 1], half_mcu - half);
+        }
         else
         {
             const uint8 y = pDst[m_image_bpl_xlt - 3 + 0], cb = pDst[m_image_bpl_xlt - 3 + 1], cr = pDst[m_image_bpl_xlt - 3 + 2];
@@ -545,28 +678,69 @@ namespace jpge {
 
         if (++m_mcu_y_ofs == m_mcu_y)
         {
-            process_mcu_row();
+            if (m_image_bpp == 2 && m_num_components == 3)
+                process_mcu_row_planar();
+            else
+                process_mcu_row();
             m_mcu_y_ofs = 0;
+            if (m_params.m_row_restarts && m_mcu_row + 1 < m_num_mcu_rows)
+                emit_restart(m_mcu_row);
+            m_mcu_row++;
         }
     }
 
-    // Quantization table generation.
-    void jpeg_encoder::compute_quant_table(int32 *pDst, const int16 *pSrc)
+    // Quantization table generation, zig-zag order. pRecip gets what DCT2D_quantize() multiplies by instead of
+    // dividing: 2^32 / (q * 8 * aan[u] * aan[v] << DCT_PASS1_BITS), with aan[] in 14-bit fixed point.
+    static void compute_quant_table(int quality, int32 *pDst, uint32 *pRecip, const int16 *pSrc)
     {
         int32 q;
-        if (m_params.m_quality < 50)
-            q = 5000 / m_params.m_quality;
+        if (quality < 50)
+            q = 5000 / quality;
         else
-            q = 200 - m_params.m_quality * 2;
+            q = 200 - quality * 2;
         for (int i = 0; i < 64; i++)
         {
             int32 j = *pSrc++; j = (j * q + 50L) / 100L;
-            *pDst++ = JPGE_MIN(JPGE_MAX(j, 1), 255);
+            *pDst = JPGE_MIN(JPGE_MAX(j, 1), 255);
+            const uint64 divisor = uint64(*pDst++) * s_aan_scale[s_zag[i] >> 3] * s_aan_scale[s_zag[i] & 7];
+            *pRecip++ = uint32(((uint64(1) << (32 + 28 - 3 - DCT_PASS1_BITS)) + divisor / 2) / divisor);
         }
     }
 
+    static const quality_tables *find_quality_tables(int quality)
+    {
+        for (int i = 0; i < QUALITY_CACHE_SLOTS; i++) {
+            const quality_tables *t = s_quality_cache[i].load(std::memory_order_acquire);
+            if (!t)
+                break;
+            if (t->quality == quality)
+                return t;
+        }
+        return NULL;
+    }
+
+    // Publish a copy of built in the first free slot, unless it is full or another encoder got there first.
+    static void share_quality_tables(const quality_tables &built)
+    {
+        quality_tables *copy = NULL;
+        for (int i = 0; i < QUALITY_CACHE_SLOTS; i++) {
+            const quality_tables *t = s_quality_cache[i].load(std::memory_order_acquire);
+            if (!t) {
+                if (!copy && (copy = static_cast<quality_tables*>(jpge_malloc(sizeof(quality_tables)))) == NULL)
+                    return;
+                *copy = built;
+                if (s_quality_cache[i].compare_exchange_strong(t, copy, std::memory_order_acq_rel, std::memory_order_acquire))
+                    return;
+                // lost the slot; t is the winner's
+            }
+            if (t->quality == built.quality)
+                break;
+        }
+        jpge_free(copy);
+    }
+
     // Higher-level methods.
-    bool jpeg_encoder::jpg_open(int p_x_res, int p_y_res, int src_channels)
+    bool jpeg_encoder::jpg_open(int p_x_res, int p_y_res, int src_channels, int first_mcu_row, int mcu_rows)
     {
         m_num_components = 3;
         switch (m_params.m_subsampling)
@@ -610,33 +784,41 @@ namespace jpge {
         m_image_y_mcu    = (m_image_y + m_mcu_y - 1) & (~(m_mcu_y - 1));
         m_image_bpl_xlt  = m_image_x * m_num_components;
         m_image_bpl_mcu  = m_image_x_mcu * m_num_components;
+        if (src_channels == 2 && m_num_components == 3) {
+            // planar rows: Y, then Cb and Cr at half width
+            m_image_bpl_xlt = m_image_x * 2;
+            m_image_bpl_mcu = m_image_x_mcu * 2;
+        }
         m_mcus_per_row   = m_image_x_mcu / m_mcu_x;
+        m_num_mcu_rows   = m_image_y_mcu / m_mcu_y;
+        m_mcu_row        = first_mcu_row;
+        m_mcu_row_end    = mcu_rows < 0 ? m_num_mcu_rows : first_mcu_row + mcu_rows;
 
-        if ((m_mcu_lines[0] = static_cast<uint8*>(jpge_malloc(m_image_bpl_mcu * m_mcu_y))) == NULL) {
+        // Strips other than the whole image only fit together at restart markers.
+        if (((src_channels == 2) && (m_image_x & 1)) || (first_mcu_row < 0) || (m_mcu_row_end > m_num_mcu_rows) || (m_mcu_row >= m_mcu_row_end) ||
+            ((mcu_rows >= 0) && (m_mcu_row_end - first_mcu_row < m_num_mcu_rows) && !m_params.m_row_restarts)) {
             return false;
         }
-        for (int i = 1; i < m_mcu_y; i++)
-            m_mcu_lines[i] = m_mcu_lines[i-1] + m_image_bpl_mcu;
 
-        if(m_last_quality != m_params.m_quality){
-            m_last_quality = m_params.m_quality;
-            compute_quant_table(m_quantization_tables[0], s_std_lum_quant);
-            compute_quant_table(m_quantization_tables[1], s_std_croma_quant);
+        // Tables not in the cache are built in front of the MCU lines, then offered to the cache.
+        m_quality_tables = find_quality_tables(m_params.m_quality);
+        const int own_tables = m_quality_tables ? 0 : sizeof(quality_tables);
+        if ((m_pBuf = static_cast<uint8*>(jpge_malloc(own_tables + m_image_bpl_mcu * m_mcu_y))) == NULL) {
+            return false;
         }
-
-        if(!m_huff_initialized){
-            m_huff_initialized = true;
-
-            memcpy(m_huff_bits[0+0], s_dc_lum_bits, 17);    memcpy(m_huff_val[0+0], s_dc_lum_val, DC_LUM_CODES);
-            memcpy(m_huff_bits[2+0], s_ac_lum_bits, 17);    memcpy(m_huff_val[2+0], s_ac_lum_val, AC_LUM_CODES);
-            memcpy(m_huff_bits[0+1], s_dc_chroma_bits, 17); memcpy(m_huff_val[0+1], s_dc_chroma_val, DC_CHROMA_CODES);
-            memcpy(m_huff_bits[2+1], s_ac_chroma_bits, 17); memcpy(m_huff_val[2+1], s_ac_chroma_val, AC_CHROMA_CODES);
-
-            compute_huffman_table(&m_huff_codes[0+0][0], &m_huff_code_sizes[0+0][0], m_huff_bits[0+0], m_huff_val[0+0]);
-            compute_huffman_table(&m_huff_codes[2+0][0], &m_huff_code_sizes[2+0][0], m_huff_bits[2+0], m_huff_val[2+0]);
-            compute_huffman_table(&m_huff_codes[0+1][0], &m_huff_code_sizes[0+1][0], m_huff_bits[0+1], m_huff_val[0+1]);
-            compute_huffman_table(&m_huff_codes[2+1][0], &m_huff_code_sizes[2+1][0], m_huff_bits[2+1], m_huff_val[2+1]);
+        if (!m_quality_tables) {
+            quality_tables *t = reinterpret_cast<quality_tables*>(m_pBuf);
+            t->quality = m_params.m_quality;
+            compute_quant_table(t->quality, t->quant[0], t->recip[0], s_std_lum_quant);
+            compute_quant_table(t->quality, t->quant[1], t->recip[1], s_std_croma_quant);
+            share_quality_tables(*t);
+            m_quality_tables = t;
         }
+        m_huff_codes = standard_huffman_tables().codes;
+
+        m_mcu_lines[0] = m_pBuf + own_tables;
+        for (int i = 1; i < m_mcu_y; i++)
+            m_mcu_lines[i] = m_mcu_lines[i-1] + m_image_bpl_mcu;
 
         m_out_buf_left = JPGE_OUT_BUF_SIZE;
         m_pOut_buf = m_out_buf;
@@ -647,37 +829,53 @@ namespace jpge {
         memset(m_last_dc_val, 0, 3 * sizeof(m_last_dc_val[0]));
 
         // Emit all markers at beginning of image file.
-        emit_marker(M_SOI);
-        emit_jfif_app0();
-        emit_dqt();
-        emit_sof();
-        emit_dhts();
-        emit_sos();
+        if (first_mcu_row == 0) {
+            emit_marker(M_SOI);
+            emit_jfif_app0();
+            emit_dqt();
+            emit_sof();
+            emit_dhts();
+            if (m_params.m_row_restarts)
+                emit_dri();
+            emit_sos();
+        }
 
         return m_all_stream_writes_succeeded;
     }
 
     bool jpeg_encoder::process_end_of_image()
     {
+        const bool last_strip = m_mcu_row_end == m_num_mcu_rows;
+        if (m_mcu_y_ofs && !last_strip) {
+            return false; // a partial MCU row is only allowed at the bottom of the image
+        }
         if (m_mcu_y_ofs) {
             if (m_mcu_y_ofs < 16) { // check here just to shut up static analysis
                 for (int i = m_mcu_y_ofs; i < m_mcu_y; i++) {
                     memcpy(m_mcu_lines[i], m_mcu_lines[m_mcu_y_ofs - 1], m_image_bpl_mcu);
                 }
             }
-            process_mcu_row();
+            if (m_image_bpp == 2 && m_num_components == 3)
+                process_mcu_row_planar();
+            else
+                process_mcu_row();
         }
 
-        put_bits(0x7F, 7);
-        emit_marker(M_EOI);
+        if (last_strip) {
+            flush_bits();
+            emit_marker(M_EOI);
+        }
         flush_output_buffer();
-        m_all_stream_writes_succeeded = m_all_stream_writes_succeeded && m_pStream->put_buf(NULL, 0);
+        if (last_strip) {
+            m_all_stream_writes_succeeded = m_all_stream_writes_succeeded && m_pStream->put_buf(NULL, 0);
+        }
         m_pass_num++; // purposely bump up m_pass_num, for debugging
         return true;
     }
 
     void jpeg_encoder::clear()
     {
+        m_pBuf = NULL;
         m_mcu_lines[0] = NULL;
         m_pass_num = 0;
         m_all_stream_writes_succeeded = true;
@@ -696,15 +894,25 @@ namespace jpge {
     bool jpeg_encoder::init(output_stream *pStream, int width, int height, int src_channels, const params &comp_params)
     {
         deinit();
-        if (((!pStream) || (width < 1) || (height < 1)) || ((src_channels != 1) && (src_channels != 3) && (src_channels != 4)) || (!comp_params.check())) return false;
+        if (((!pStream) || (width < 1) || (height < 1)) || ((src_channels < 1) || (src_channels > 4)) || (!comp_params.check())) return false;
         m_pStream = pStream;
         m_params = comp_params;
-        return jpg_open(width, height, src_channels);
+        return jpg_open(width, height, src_channels, 0, -1);
+    }
+
+    bool jpeg_encoder::init_strip(output_stream *pStream, int width, int height, int src_channels, const params &comp_params,
+                                  int first_mcu_row, int mcu_rows)
+    {
+        deinit();
+        if (((!pStream) || (width < 1) || (height < 1)) || ((src_channels < 1) || (src_channels > 4)) || (!comp_params.check()) || (mcu_rows < 1) || (!comp_params.m_row_restarts)) return false;
+        m_pStream = pStream;
+        m_params = comp_params;
+        return jpg_open(width, height, src_channels, first_mcu_row, mcu_rows);
     }
 
     void jpeg_encoder::deinit()
     {
-        jpge_free(m_mcu_lines[0]);
+        jpge_free(m_pBuf);
         clear();
     }
 
@@ -718,8 +926,10 @@ namespace jpge {
                 if (!process_end_of_image()) {
                     return false;
                 }
-            } else {
+            } else if (m_mcu_row < m_mcu_row_end) {
                 load_mcu(pScanline);
+            } else {
+                return false;
             }
         }
         return m_all_stream_writes_succeeded;
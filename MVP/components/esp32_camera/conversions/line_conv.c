@@ -0,0 +1,134 @@
+#include "line_conv.h"
+
+#include "esp_attr.h"
+
+/*
+ * The kernels are written for the compiler to vectorise: no table lookups, no
+ * data-dependent branches (the clamps become min/max) and, for YUYV, blocks
+ * of LINE_BLOCK pairs split into a planar pass that does the arithmetic and
+ * an interleaving pass that stores it. GCC turns the blocks into SSE2/NEON
+ * code on a host; on the ESP32 targets they still drop the per-pixel call
+ * and the five table loads of yuv2rgb().
+ */
+#define LINE_BLOCK 16
+
+static inline uint8_t clamp_u8(int v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+/* hi/lo: offsets of a pixel's high and low byte; ro/bo: of red and blue out.
+ * Always inlined with constants, so each variant gets its own loop. */
+static inline __attribute__((always_inline)) void rgb565_line(uint8_t *dst, const uint8_t *src, size_t width,
+                                                              const size_t hi, const size_t ro)
+{
+    const size_t lo = 1 - hi, bo = 2 - ro;
+    for (size_t i = 0; i < width; i++) {
+        const uint8_t h = src[2 * i + hi], l = src[2 * i + lo];
+        dst[3 * i + ro] = h & 0xF8;
+        dst[3 * i + 1] = (h & 0x07) << 5 | (l & 0xE0) >> 3;
+        dst[3 * i + bo] = (l & 0x1F) << 3;
+    }
+}
+
+void IRAM_ATTR line_rgb565_to_rgb888(uint8_t *restrict dst, const uint8_t *restrict src, size_t width, bool big_endian, bool bgr)
+{
+    if (big_endian) {
+        if (bgr) {
+            rgb565_line(dst, src, width, 0, 2);
+        } else {
+            rgb565_line(dst, src, width, 0, 0);
+        }
+    } else {
+        if (bgr) {
+            rgb565_line(dst, src, width, 1, 2);
+        } else {
+            rgb565_line(dst, src, width, 1, 0);
+        }
+    }
+}
+
+void IRAM_ATTR line_swap_rb888(uint8_t *restrict dst, const uint8_t *restrict src, size_t width)
+{
+    for (size_t i = 0; i < width; i++, dst += 3, src += 3) {
+        const uint8_t r = src[2], g = src[1], b = src[0];
+        dst[0] = r;
+        dst[1] = g;
+        dst[2] = b;
+    }
+}
+
+/*
+ * yuv2rgb()'s table entries are (x - 16) * 1.164 for Y and (x - 128) times
+ * 1.596, -0.391, -0.813 and 2.018 for the chroma terms, each truncated toward
+ * zero. In 13-bit fixed point with C's truncating division these constants
+ * reproduce every entry exactly. The table indexes the 0.813 term by U and the
+ * 0.391 term by V; kept as is, since the point is matching it.
+ */
+#define YUV_Y    9535
+#define YUV_VR   13075
+#define YUV_VG   (-3205)
+#define YUV_UG   (-6660)
+#define YUV_UB   16531
+#define YUV_ONE  8192
+
+typedef struct {
+    int32_t y0[LINE_BLOCK], y1[LINE_BLOCK];
+    int32_t r[LINE_BLOCK], g[LINE_BLOCK], b[LINE_BLOCK];
+} yuv_block_t;
+
+static inline void yuv_terms(yuv_block_t *t, size_t i, const uint8_t *s)
+{
+    const int u = s[1] - 128, v = s[3] - 128;
+    t->r[i] = v * YUV_VR / YUV_ONE;
+    t->g[i] = u * YUV_UG / YUV_ONE + v * YUV_VG / YUV_ONE;
+    t->b[i] = u * YUV_UB / YUV_ONE;
+    t->y0[i] = (s[0] - 16) * YUV_Y / YUV_ONE;
+    t->y1[i] = (s[2] - 16) * YUV_Y / YUV_ONE;
+}
+
+static inline void yuv_store(uint8_t *d, const yuv_block_t *t, size_t i, size_t ro, size_t bo)
+{
+    d[ro] = clamp_u8(t->y0[i] + t->r[i]);
+    d[1] = clamp_u8(t->y0[i] + t->g[i]);
+    d[bo] = clamp_u8(t->y0[i] + t->b[i]);
+    d[3 + ro] = clamp_u8(t->y1[i] + t->r[i]);
+    d[4] = clamp_u8(t->y1[i] + t->g[i]);
+    d[3 + bo] = clamp_u8(t->y1[i] + t->b[i]);
+}
+
+void IRAM_ATTR line_yuv422_to_rgb888(uint8_t *restrict dst, const uint8_t *restrict src, size_t width, bool bgr)
+{
+    const size_t ro = bgr ? 2 : 0, bo = 2 - ro;
+    const size_t pairs = width / 2;
+    yuv_block_t t;
+    size_t p = 0;
+    for (; p + LINE_BLOCK <= pairs; p += LINE_BLOCK) {
+        for (size_t i = 0; i < LINE_BLOCK; i++) {
+            yuv_terms(&t, i, src + 4 * (p + i));
+        }
+        for (size_t i = 0; i < LINE_BLOCK; i++) {
+            yuv_store(dst + 6 * (p + i), &t, i, ro, bo);
+        }
+    }
+    for (; p < pairs; p++) {
+        yuv_terms(&t, 0, src + 4 * p);
+        yuv_store(dst + 6 * p, &t, 0, ro, bo);
+    }
+}
+
+/* 255/219 and 255/224 in 14-bit fixed point */
+#define YCC_Y_SCALE  19077
+#define YCC_C_SCALE  18652
+#define YCC_ROUND    (1 << 13)
+
+void IRAM_ATTR line_yuv422_to_jfif(uint8_t *restrict dst, const uint8_t *restrict src, size_t width)
+{
+    for (size_t i = 0; i < width; i++) {
+        /* even bytes are Y, odd ones chroma */
+        const int y = ((src[2 * i] - 16) * YCC_Y_SCALE + YCC_ROUND) >> 14;
+        const int c = 128 + (((src[2 * i + 1] - 128) * YCC_C_SCALE + YCC_ROUND) >> 14);
+        dst[2 * i] = clamp_u8(y);
+        dst[2 * i + 1] = clamp_u8(c);
+    }
+}
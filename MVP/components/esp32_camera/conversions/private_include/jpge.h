@@ -4,6 +4,8 @@
 #ifndef JPEG_ENCODER_H
 #define JPEG_ENCODER_H
 
+#include <stddef.h>
+
 namespace jpge
 {
     typedef unsigned char  uint8;
@@ -12,13 +14,14 @@ namespace jpge
     typedef unsigned short uint16;
     typedef unsigned int   uint32;
     typedef unsigned int   uint;
+    typedef unsigned long long uint64;
 
     // JPEG chroma subsampling factors. Y_ONLY (grayscale images) and H2V2 (color images) are the most common.
     enum subsampling_t { Y_ONLY = 0, H1V1 = 1, H2V1 = 2, H2V2 = 3 };
 
     // JPEG compression parameters structure.
     struct params {
-            inline params() : m_quality(85), m_subsampling(H2V2) { }
+            inline params() : m_quality(85), m_subsampling(H2V2), m_row_restarts(false) { }
 
             inline bool check() const {
                 if ((m_quality < 1) || (m_quality > 100)) {
@@ -39,7 +42,14 @@ namespace jpge
             // 2 = H2V1 subsampling (YCbCr 2x1x1, 4 blocks per MCU)
             // 3 = H2V2 subsampling (YCbCr 4x1x1, 6 blocks per MCU-- very common)
             subsampling_t m_subsampling;
+
+            // Emit a DRI marker and an RSTn marker after every MCU row. The rows then code
+            // independently, which jpeg_encoder::init_strip() needs. Costs about 2.5 bytes per row.
+            bool m_row_restarts;
     };
+
+    // Height in pixels of one MCU row.
+    inline int mcu_height(subsampling_t subsampling) { return subsampling == H2V2 ? 16 : 8; }
     
     // Output stream abstract class - used by the jpeg_encoder class to write to the output stream.
     // put_buf() is generally called with len==JPGE_OUT_BUF_SIZE bytes, but for headers it'll be called with smaller amounts.
@@ -47,10 +57,13 @@ namespace jpge
         public:
             virtual ~output_stream() { };
             virtual bool put_buf(const void* Pbuf, int len) = 0;
-            virtual uint get_size() const = 0;
+            virtual size_t get_size() const = 0;
     };
     
+    struct quality_tables;
+
     // Lower level jpeg_encoder class - useful if more control is needed than the above helper functions.
+    // Encoders share nothing writable: any number of them may run at once, on either core.
     class jpeg_encoder {
         public:
             jpeg_encoder();
@@ -60,12 +73,22 @@ namespace jpge
             // pStream: The stream object to use for writing compressed data.
             // params - Compression parameters structure, defined above.
             // width, height  - Image dimensions.
-            // channels - May be 1, or 3. 1 indicates grayscale, 3 indicates RGB source data.
+            // channels - May be 1, 2 or 3. 1 indicates grayscale, 3 indicates RGB source data. 2 indicates
+            // JFIF YCbCr 4:2:2 packed as Y0 Cb Y1 Cr (even width only): the samples go into the MCUs as they
+            // are, with no colour conversion, and H2V1 takes the chroma as is (H2V2 averages line pairs).
             // Returns false on out of memory or if a stream write fails.
             bool init(output_stream *pStream, int width, int height, int src_channels, const params &comp_params = params());
 
+            // Initializes the compressor for MCU rows first_mcu_row .. first_mcu_row + mcu_rows - 1 of the image only.
+            // comp_params.m_row_restarts must be set. The strip starting at row 0 emits the headers and the strip
+            // holding the last row emits EOI; encoding every strip and concatenating them in order gives the same
+            // bytes as init() with the same params. Feed the strip's scanlines (mcu_height() per row), then NULL.
+            // Encoders for different strips of one image may run concurrently, like any other encoders.
+            bool init_strip(output_stream *pStream, int width, int height, int src_channels, const params &comp_params,
+                            int first_mcu_row, int mcu_rows);
+
             // Call this method with each source scanline.
-            // width * src_channels bytes per scanline is expected (RGB or Y format).
+            // width * src_channels bytes per scanline is expected (RGB, YCbCr 4:2:2 or Y format).
             // You must call with NULL after all scanlines are processed to finish compression.
             // Returns false on out of memory or if a stream write fails.
             bool process_scanline(const void* pScanline);
@@ -89,24 +112,31 @@ namespace jpge
             int m_image_bpl_xlt, m_image_bpl_mcu;
             int m_mcus_per_row;
             int m_mcu_x, m_mcu_y;
+            int m_num_mcu_rows, m_mcu_row, m_mcu_row_end;
             uint8 *m_mcu_lines[16];
             uint8 m_mcu_y_ofs;
             sample_array_t m_sample_array[64];
             int16 m_coefficient_array[64];
 
+            uint8 *m_pBuf;
+            const quality_tables *m_quality_tables;
+            const uint32 (*m_huff_codes)[256];
+
             int m_last_dc_val[3];
             uint8 m_out_buf[JPGE_OUT_BUF_SIZE];
             uint8 *m_pOut_buf;
             uint m_out_buf_left;
-            uint32 m_bit_buffer;
+            uint64 m_bit_buffer;
             uint m_bits_in;
             uint8 m_pass_num;
             bool m_all_stream_writes_succeeded;
 
-            bool jpg_open(int p_x_res, int p_y_res, int src_channels);
+            bool jpg_open(int p_x_res, int p_y_res, int src_channels, int first_mcu_row, int mcu_rows);
 
             void flush_output_buffer();
             void put_bits(uint bits, uint len);
+            void flush_bit_word();
+            void flush_bits();
 
             void emit_byte(uint8 i);
             void emit_word(uint i);
@@ -115,22 +145,26 @@ namespace jpge
             void emit_jfif_app0();
             void emit_dqt();
             void emit_sof();
-            void emit_dht(uint8 *bits, uint8 *val, int index, bool ac_flag);
+            void emit_dht(const uint8 *bits, const uint8 *val, int index, bool ac_flag);
             void emit_dhts();
+            void emit_dri();
             void emit_sos();
-
-            void compute_quant_table(int32 *dst, const int16 *src);
-            void load_quantized_coefficients(int component_num);
+            void emit_restart(int n);
 
             void load_block_8_8_grey(int x);
             void load_block_8_8(int x, int y, int c);
             void load_block_16_8(int x, int c);
             void load_block_16_8_8(int x, int c);
+            void load_block_planar_8_8(int ofs, int y);
+            void load_block_planar_8_16(int ofs);
+            void load_block_planar_4_8(int ofs);
 
-            void code_coefficients_pass_two(int component_num);
+            void put_symbol(const uint32 *codes, int run, int value);
+            void code_coefficients_pass_two(int component_num, uint64 nonzero);
             void code_block(int component_num);
 
             void process_mcu_row();
+            void process_mcu_row_planar();
             bool process_end_of_image();
             void load_mcu(const void* src);
             void clear();
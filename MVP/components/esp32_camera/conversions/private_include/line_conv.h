@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Whole-line colour conversions for the JPEG and BMP encoders. Each kernel
+ * converts `width` pixels of one line; none of them keeps state, so they are
+ * safe to call from several tasks at once. dst must not overlap src.
+ */
+
+/**
+ * @brief RGB565 to RGB888, the low bits of each channel left zero.
+ *
+ * Gives the same bytes as the per-pixel loops it replaced in to_jpg.cpp and
+ * to_bmp.c.
+ *
+ * @param dst         width * 3 bytes, R G B (B G R if bgr)
+ * @param src         width * 2 bytes
+ * @param width       Pixels
+ * @param big_endian  true if the high byte of each pixel comes first
+ * @param bgr         true to store blue first, as BMP does
+ */
+void line_rgb565_to_rgb888(uint8_t *dst, const uint8_t *src, size_t width, bool big_endian, bool bgr);
+
+/**
+ * @brief Swap the first and third byte of every 3-byte pixel (BGR <-> RGB).
+ */
+void line_swap_rb888(uint8_t *dst, const uint8_t *src, size_t width);
+
+/**
+ * @brief YUYV to RGB888, bit-exact with yuv2rgb() for every input.
+ *
+ * @param dst    width * 3 bytes, R G B (B G R if bgr)
+ * @param src    width * 2 bytes, Y0 U Y1 V
+ * @param width  Pixels, even
+ * @param bgr    true to store blue first, as BMP does
+ */
+void line_yuv422_to_rgb888(uint8_t *dst, const uint8_t *src, size_t width, bool bgr);
+
+/**
+ * @brief YUYV from BT.601 video range to JFIF full range, still packed 4:2:2.
+ *
+ * Y is stretched from 16..235 and Cb/Cr from 16..240 to the full 0..255 JFIF
+ * uses, rounded to nearest. That is a BT.601 conversion to RGB and back
+ * without the two matrix multiplies or the clipping to RGB in between, which
+ * lets the JPEG encoder take the samples as they are. It is not bit-exact
+ * with yuv2rgb() and an RGB to YCbCr conversion: besides the clipping,
+ * yuv2rgb() swaps the U and V weights of its green term.
+ *
+ * @param dst    width * 2 bytes, Y0 Cb Y1 Cr
+ * @param src    width * 2 bytes, Y0 U Y1 V
+ * @param width  Pixels, even
+ */
+void line_yuv422_to_jfif(uint8_t *dst, const uint8_t *src, size_t width);
+
+#ifdef __cplusplus
+}
+#endif
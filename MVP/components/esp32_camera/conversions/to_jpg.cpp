@@ -16,10 +16,14 @@
 #include "esp_attr.h"
 #include "soc/efuse_reg.h"
 #include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "esp_camera.h"
 #include "img_converters.h"
 #include "jpge.h"
-#include "yuv.h"
+#include "line_conv.h"
 
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include "esp32-hal-log.h"
@@ -32,6 +36,10 @@ static const char* TAG = "to_jpg";
 
 static jpge::subsampling_t default_subsampling = jpge::H2V2;
 static bool rgb565_big_endian = true;
+static uint8_t encode_workers = 1;
+
+#define JPG_MAX_WORKERS     8
+#define JPG_WORKER_STACK    (4 * 1024)
 
 static void *_malloc(size_t size)
 {
@@ -47,55 +55,297 @@ static void *_malloc(size_t size)
     return NULL;
 }
 
+// YUV422 lines go to jpge as JFIF YCbCr 4:2:2, the rest as RGB888 or grey.
 static IRAM_ATTR void convert_line_format(uint8_t * src, pixformat_t format, uint8_t * dst, size_t width, size_t in_channels, size_t line)
 {
-    int i=0, o=0, l=0;
     if(format == PIXFORMAT_GRAYSCALE) {
         memcpy(dst, src + line * width, width);
     } else if(format == PIXFORMAT_RGB888) {
-        l = width * 3;
-        src += l * line;
-        for(i=0; i<l; i+=3) {
-            dst[o++] = src[i+2];
-            dst[o++] = src[i+1];
-            dst[o++] = src[i];
-        }
+        line_swap_rb888(dst, src + line * width * 3, width);
     } else if(format == PIXFORMAT_RGB565) {
-        l = width * 2;
-        src += l * line;
-        for(i=0; i<l; i+=2) {
-            if (rgb565_big_endian) {
-                dst[o++] = src[i] & 0xF8;
-                dst[o++] = (src[i] & 0x07) << 5 | (src[i+1] & 0xE0) >> 3;
-                dst[o++] = (src[i+1] & 0x1F) << 3;
-            } else  {
-                dst[o++] = src[i+1] & 0xF8;
-                dst[o++] = (src[i+1] & 0x07) << 5 | (src[i] & 0xE0) >> 3;
-                dst[o++] = (src[i] & 0x1F) << 3;
+        line_rgb565_to_rgb888(dst, src + line * width * 2, width, rgb565_big_endian, false);
+    } else if(format == PIXFORMAT_YUV422) {
+        line_yuv422_to_jfif(dst, src + line * width * 2, width);
+    }
+}
+
+// Feeds scanlines first_line .. end_line - 1 to an initialized encoder, then finishes it.
+static bool encode_lines(jpge::jpeg_encoder *enc, uint8_t *src, uint16_t width, pixformat_t format, int num_channels,
+                         int first_line, int end_line)
+{
+    uint8_t* line = (uint8_t*)_malloc(width * num_channels);
+    if(!line) {
+        ESP_LOGE(TAG, "Scan line malloc failed");
+        return false;
+    }
+
+    for (int i = first_line; i < end_line; i++) {
+        convert_line_format(src, format, line, width, num_channels, i);
+        if (!enc->process_scanline(line)) {
+            ESP_LOGE(TAG, "JPG process line %u failed", i);
+            free(line);
+            return false;
+        }
+    }
+    free(line);
+
+    if (!enc->process_scanline(NULL)) {
+        ESP_LOGE(TAG, "JPG image finish failed");
+        return false;
+    }
+    enc->deinit();
+    return true;
+}
+
+// Output of one strip encoded by a worker, held until the strips before it
+// have been written.
+class strip_stream : public jpge::output_stream {
+protected:
+    uint8_t *buf;
+    size_t len, cap;
+
+public:
+    strip_stream() : buf(NULL), len(0), cap(0) { }
+    virtual ~strip_stream() { free(buf); }
+    void reserve(size_t size)
+    {
+        buf = (uint8_t *)_malloc(size);
+        cap = buf ? size : 0;
+    }
+    virtual bool put_buf(const void* data, int size)
+    {
+        if (!data) {
+            return true;
+        }
+        if (len + size > cap) {
+            size_t new_cap = cap * 2 > len + size ? cap * 2 : len + size;
+            uint8_t *grown = (uint8_t *)_malloc(new_cap);
+            if (!grown) {
+                return false;
             }
+            if (len) {
+                memcpy(grown, buf, len);
+            }
+            free(buf);
+            buf = grown;
+            cap = new_cap;
         }
-    } else if(format == PIXFORMAT_YUV422) {
-        uint8_t y0, y1, u, v;
-        uint8_t r, g, b;
-        l = width * 2;
-        src += l * line;
-        for(i=0; i<l; i+=4) {
-            y0 = src[i];
-            u = src[i+1];
-            y1 = src[i+2];
-            v = src[i+3];
-
-            yuv2rgb(y0, u, v, &r, &g, &b);
-            dst[o++] = r;
-            dst[o++] = g;
-            dst[o++] = b;
-
-            yuv2rgb(y1, u, v, &r, &g, &b);
-            dst[o++] = r;
-            dst[o++] = g;
-            dst[o++] = b;
+        memcpy(buf + len, data, size);
+        len += size;
+        return true;
+    }
+    virtual size_t get_size() const
+    {
+        return len;
+    }
+    const uint8_t *data() const
+    {
+        return buf;
+    }
+};
+
+typedef struct {
+    uint8_t *src;
+    uint16_t width, height;
+    pixformat_t format;
+    int num_channels;
+    jpge::params params;
+    int first_row, rows;        // MCU rows
+    int index;
+    bool ok;
+    strip_stream *out;
+    QueueHandle_t done;
+} strip_job_t;
+
+/* Strip workers, started on first use and kept: a shared job queue, one
+ * conversion at a time. */
+static SemaphoreHandle_t s_pool_lock;
+static QueueHandle_t s_pool_jobs;
+static int s_pool_size;
+static portMUX_TYPE s_pool_init_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool encode_strip(strip_job_t *job, jpge::output_stream *stream, jpge::jpeg_encoder *enc)
+{
+    const int mcu_h = jpge::mcu_height(job->params.m_subsampling);
+    if (!enc->init_strip(stream, job->width, job->height, job->num_channels, job->params, job->first_row, job->rows)) {
+        ESP_LOGE(TAG, "JPG strip init failed");
+        return false;
+    }
+    int end_line = (job->first_row + job->rows) * mcu_h;
+    if (end_line > job->height) {
+        end_line = job->height;
+    }
+    return encode_lines(enc, job->src, job->width, job->format, job->num_channels, job->first_row * mcu_h, end_line);
+}
+
+static void strip_worker_task(void *arg)
+{
+    strip_job_t *job;
+    for (;;) {
+        if (xQueueReceive(s_pool_jobs, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        jpge::jpeg_encoder enc;
+        job->ok = encode_strip(job, job->out, &enc);
+        xQueueSend(job->done, &job->index, portMAX_DELAY);
+    }
+}
+
+// Encoders on either core may get here at once; the handles are only read
+// under s_pool_init_lock, so whoever sees them also sees them set up.
+static SemaphoreHandle_t pool_lock(void)
+{
+    portENTER_CRITICAL(&s_pool_init_lock);
+    SemaphoreHandle_t lock = s_pool_lock;
+    portEXIT_CRITICAL(&s_pool_init_lock);
+    return lock;
+}
+
+static bool pool_init(void)
+{
+    if (pool_lock()) {
+        return true;
+    }
+    SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+    QueueHandle_t jobs = xQueueCreate(JPG_MAX_WORKERS, sizeof(strip_job_t *));
+    bool mine = false;
+    if (lock && jobs) {
+        portENTER_CRITICAL(&s_pool_init_lock);
+        mine = !s_pool_lock;
+        if (mine) {
+            s_pool_jobs = jobs;
+            s_pool_lock = lock;
+        }
+        portEXIT_CRITICAL(&s_pool_init_lock);
+    }
+    if (!mine) {
+        if (lock) {
+            vSemaphoreDelete(lock);
+        }
+        if (jobs) {
+            vQueueDelete(jobs);
         }
     }
+    return pool_lock() != NULL;
+}
+
+// Makes sure `workers` strip workers exist; call with s_pool_lock held.
+static int pool_grow(int workers)
+{
+    while (s_pool_size < workers) {
+        if (xTaskCreate(strip_worker_task, "jpg_strip", JPG_WORKER_STACK, NULL, uxTaskPriorityGet(NULL), NULL) != pdPASS) {
+            ESP_LOGW(TAG, "JPG strip worker %d not started", s_pool_size);
+            break;
+        }
+        s_pool_size++;
+    }
+    return s_pool_size;
+}
+
+/* Splits the image into MCU-row strips: the caller encodes the first straight
+ * into dst_stream while the workers encode the rest into buffers, which are
+ * written out in order as the caller gets to them. Every row ends in a restart
+ * marker, so the strips join into one baseline JPEG and the output is the
+ * same whatever the number of strips. */
+static __attribute__((noinline)) bool convert_image_strips(uint8_t *src, uint16_t width, uint16_t height, pixformat_t format,
+                                                           int num_channels, jpge::params comp_params, int strips,
+                                                           jpge::output_stream *dst_stream)
+{
+    if (!pool_init()) {
+        ESP_LOGE(TAG, "JPG strip pool alloc failed");
+        return false;
+    }
+    xSemaphoreTake(s_pool_lock, portMAX_DELAY);
+
+    comp_params.m_row_restarts = true;
+    const int mcu_h = jpge::mcu_height(comp_params.m_subsampling);
+    const int mcu_rows = (height + mcu_h - 1) / mcu_h;
+    int workers = pool_grow(strips - 1);
+    if (workers < strips - 1) {
+        strips = workers + 1;
+    }
+
+    strip_job_t jobs[JPG_MAX_WORKERS];
+    strip_stream outs[JPG_MAX_WORKERS];
+    QueueHandle_t done = xQueueCreate(JPG_MAX_WORKERS, sizeof(int));
+    if (!done) {
+        xSemaphoreGive(s_pool_lock);
+        ESP_LOGE(TAG, "JPG strip queue alloc failed");
+        return false;
+    }
+    for (int i = 0; i < strips; i++) {
+        strip_job_t *job = &jobs[i];
+        job->src = src;
+        job->width = width;
+        job->height = height;
+        job->format = format;
+        job->num_channels = num_channels;
+        job->params = comp_params;
+        job->first_row = mcu_rows * i / strips;
+        job->rows = mcu_rows * (i + 1) / strips - job->first_row;
+        job->index = i;
+        job->ok = false;
+        job->out = &outs[i];
+        job->done = done;
+    }
+
+    // Initialising the first strip before posting the rest builds this
+    // quality's tables once; the workers then find them cached.
+    jpge::jpeg_encoder enc;
+    bool ok = enc.init_strip(dst_stream, width, height, num_channels, comp_params, jobs[0].first_row, jobs[0].rows);
+    int posted = 0;
+    if (ok) {
+        for (int i = 1; i < strips; i++) {
+            // about a fifth of the raw strip is plenty for typical quality settings
+            outs[i].reserve((size_t)jobs[i].rows * mcu_h * width * num_channels / 5);
+            strip_job_t *job = &jobs[i];
+            xQueueSend(s_pool_jobs, &job, portMAX_DELAY);
+            posted++;
+        }
+        int end_line = jobs[0].rows * mcu_h < height ? jobs[0].rows * mcu_h : height;
+        ok = encode_lines(&enc, src, width, format, num_channels, 0, end_line);
+    } else {
+        ESP_LOGE(TAG, "JPG encoder init failed");
+    }
+
+    // Collect every posted job, even after a failure: they point into this frame.
+    bool finished[JPG_MAX_WORKERS] = { false };
+    for (int next = 1; next <= posted; next++) {
+        while (!finished[next]) {
+            int index;
+            xQueueReceive(done, &index, portMAX_DELAY);
+            finished[index] = true;
+        }
+        if (ok && !jobs[next].ok) {
+            ESP_LOGE(TAG, "JPG strip %d failed", next);
+            ok = false;
+        }
+        if (ok) {
+            ok = dst_stream->put_buf(outs[next].data(), outs[next].get_size());
+        }
+    }
+    vQueueDelete(done);
+    xSemaphoreGive(s_pool_lock);
+
+    if (ok && strips > 1) {
+        // the last strip's end-of-image call went to its buffer
+        dst_stream->put_buf(NULL, 0);
+    }
+    return ok;
+}
+
+// noinline, like convert_image_strips(): one encoder on the caller's stack, not two.
+static __attribute__((noinline)) bool convert_image_serial(uint8_t *src, uint16_t width, uint16_t height, pixformat_t format,
+                                                           int num_channels, const jpge::params &comp_params,
+                                                           jpge::output_stream *dst_stream)
+{
+    jpge::jpeg_encoder dst_image;
+
+    if (!dst_image.init(dst_stream, width, height, num_channels, comp_params)) {
+        ESP_LOGE(TAG, "JPG encoder init failed");
+        return false;
+    }
+    return encode_lines(&dst_image, src, width, format, num_channels, 0, height);
 }
 
 bool convert_image(uint8_t *src, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, jpge::output_stream *dst_stream)
@@ -106,6 +356,8 @@ bool convert_image(uint8_t *src, uint16_t width, uint16_t height, pixformat_t fo
     if(format == PIXFORMAT_GRAYSCALE) {
         num_channels = 1;
         subsampling = jpge::Y_ONLY;
+    } else if(format == PIXFORMAT_YUV422) {
+        num_channels = 2;
     }
 
     if(!quality) {
@@ -118,35 +370,12 @@ bool convert_image(uint8_t *src, uint16_t width, uint16_t height, pixformat_t fo
     comp_params.m_subsampling = subsampling;
     comp_params.m_quality = quality;
 
-    jpge::jpeg_encoder dst_image;
-
-    if (!dst_image.init(dst_stream, width, height, num_channels, comp_params)) {
-        ESP_LOGE(TAG, "JPG encoder init failed");
-        return false;
-    }
-
-    uint8_t* line = (uint8_t*)_malloc(width * num_channels);
-    if(!line) {
-        ESP_LOGE(TAG, "Scan line malloc failed");
-        return false;
-    }
-
-    for (int i = 0; i < height; i++) {
-        convert_line_format(src, format, line, width, num_channels, i);
-        if (!dst_image.process_scanline(line)) {
-            ESP_LOGE(TAG, "JPG process line %u failed", i);
-            free(line);
-            return false;
-        }
-    }
-    free(line);
-
-    if (!dst_image.process_scanline(NULL)) {
-        ESP_LOGE(TAG, "JPG image finish failed");
-        return false;
+    int mcu_rows = (height + jpge::mcu_height(subsampling) - 1) / jpge::mcu_height(subsampling);
+    int strips = encode_workers < mcu_rows ? encode_workers : mcu_rows;
+    if (strips > 1) {
+        return convert_image_strips(src, width, height, format, num_channels, comp_params, strips, dst_stream);
     }
-    dst_image.deinit();
-    return true;
+    return convert_image_serial(src, width, height, format, num_channels, comp_params, dst_stream);
 }
 
 class callback_stream : public jpge::output_stream {
@@ -253,3 +482,13 @@ void jpgSetRgb565BE(bool enable)
 {
     rgb565_big_endian = enable;
 }
+
+void jpgSetWorkers(uint8_t workers)
+{
+    if (workers < 1) {
+        workers = 1;
+    } else if (workers > JPG_MAX_WORKERS) {
+        workers = JPG_MAX_WORKERS;
+    }
+    encode_workers = workers;
+}
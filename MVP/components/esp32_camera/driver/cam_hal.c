@@ -20,6 +20,7 @@
 #include "freertos/task.h"
 #include "ll_cam.h"
 #include "cam_hal.h"
+#include "jpeg_marker.h"
 
 #if (ESP_IDF_VERSION_MAJOR == 3) && (ESP_IDF_VERSION_MINOR == 3)
 #include "rom/ets_sys.h"
@@ -63,6 +64,38 @@ static cam_obj_t *cam_obj = NULL;
 
 static volatile bool g_psram_dma_mode = CAMERA_PSRAM_DMA_ENABLED;
 static portMUX_TYPE g_psram_dma_lock = portMUX_INITIALIZER_UNLOCKED;
+#if defined(CONFIG_CAMERA_PSRAM_DMA_AUTO)
+static volatile camera_psram_policy_t g_psram_policy = CAMERA_PSRAM_POLICY_AUTO;
+#else
+static volatile camera_psram_policy_t g_psram_policy = CAMERA_PSRAM_POLICY_MANUAL;
+#endif
+
+#if CONFIG_CAMERA_PATH_STATS
+/* Cost of each path per pixel format and frame size, kept across
+ * reconfigures so CAMERA_PSRAM_POLICY_AUTO can compare them. cam_task pays
+ * for frames it completes (copies, SOI probe sync), cam_take() for frames it
+ * hands out (EOI probe and frame sync, grayscale pass). Indexed by
+ * psram_mode. */
+typedef struct {
+    bool used;
+    pixformat_t format;
+    framesize_t frame_size;
+    uint32_t task_frames[2];
+    uint64_t task_us[2];
+    uint32_t take_frames[2];
+    uint64_t take_us[2];
+} cam_path_cost_t;
+
+#define CAM_PATH_COST_SLOTS      8
+/* Frames each path needs before its measurement overrides the default */
+#define CAM_PATH_COST_MIN_FRAMES 4
+
+static camera_path_stats_t s_path_stats;
+static int64_t s_path_stats_start;
+static cam_path_cost_t s_path_cost[CAM_PATH_COST_SLOTS];
+static cam_path_cost_t *s_path_cost_cur;
+static portMUX_TYPE s_path_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
 
 /* At top of cam_hal.c – one switch for noisy ISR prints */
 #ifndef CAM_LOG_SPAM_EVERY_FRAME
@@ -132,13 +165,18 @@ static inline void cam_drop_psram_cache(void *addr, size_t len)
 /* JPEG markers (byte-order independent). */
 static const uint8_t JPEG_SOI_MARKER[] = {0xFF, 0xD8, 0xFF}; /* SOI = FF D8 FF */
 #define JPEG_SOI_MARKER_LEN (3)
-static const uint8_t JPEG_EOI_BYTES[] = {0xFF, 0xD9};        /* EOI = FF D9 */
+#define JPEG_EOI_CODE 0xD9                                      /* EOI = FF D9 */
 #define JPEG_EOI_MARKER_LEN (2)
 
-/* Compute the scan window for JPEG EOI detection in PSRAM. */
+/* Compute the scan window for JPEG EOI detection: the last two DMA halves
+ * plus the byte before them. At VSYNC the driver takes one more half, which
+ * holds the end of the frame followed by data from an older frame, or only
+ * older data when the frame ended exactly on a half boundary. Everything
+ * before the real EOI was written by this frame, so the first EOI in the
+ * window is the real one and stale markers after it are ignored. */
 static inline size_t eoi_probe_window(size_t half, size_t frame_len)
 {
-    size_t w = half + (JPEG_EOI_MARKER_LEN - 1);
+    size_t w = 2 * half + (JPEG_EOI_MARKER_LEN - 1);
     return w > frame_len ? frame_len : w;
 }
 
@@ -151,11 +189,18 @@ static int cam_verify_jpeg_soi(const uint8_t *inbuf, uint32_t length)
         return -1;
     }
 
-    for (uint32_t i = 0; i <= length - JPEG_SOI_MARKER_LEN; i++) {
-        if (memcmp(&inbuf[i], JPEG_SOI_MARKER, JPEG_SOI_MARKER_LEN) == 0) {
+    uint32_t i = 0;
+    while (i <= length - JPEG_SOI_MARKER_LEN) {
+        int off = jpeg_marker_find(inbuf + i, length - 1 - i, JPEG_SOI_MARKER[1]);
+        if (off < 0) {
+            break;
+        }
+        i += off;
+        if (inbuf[i + 2] == JPEG_SOI_MARKER[2]) {
             //ESP_LOGW(TAG, "SOI: %d", (int) i);
             return i;
         }
+        i++;
     }
 
     CAM_WARN_THROTTLE(warn_soi_miss_cnt,
@@ -163,58 +208,134 @@ static int cam_verify_jpeg_soi(const uint8_t *inbuf, uint32_t length)
     return -1;
 }
 
-static int cam_verify_jpeg_eoi(const uint8_t *inbuf, uint32_t length, bool search_forward)
+/* Offset of the first EOI in the buffer, or -1. */
+static int cam_verify_jpeg_eoi(const uint8_t *inbuf, uint32_t length)
 {
-    if (length < JPEG_EOI_MARKER_LEN) {
-        return -1;
-    }
+    return jpeg_marker_find(inbuf, length, JPEG_EOI_CODE);
+}
 
-    if (search_forward) {
-        /* Scan forward to honor the earliest marker in the buffer. This avoids
-         * returning an EOI that belongs to a larger previous frame when the tail
-         * of that frame still resides in PSRAM. JPEG data is pseudo random, so
-         * the first marker byte appears rarely; test four positions per load to
-         * reduce memory traffic. */
-        const uint8_t *pat = JPEG_EOI_BYTES;
-        const uint32_t A = pat[0] * 0x01010101u;
-        const uint32_t ONE = 0x01010101u;
-        const uint32_t HIGH = 0x80808080u;
-        uint32_t i = 0;
-        while (i + 4 <= length) {
-            uint32_t w;
-            memcpy(&w, inbuf + i, 4); /* unaligned load is allowed */
-            uint32_t x = w ^ A; /* identify bytes equal to first marker byte */
-            uint32_t m = (~x & (x - ONE)) & HIGH; /* mask has high bit set for candidate bytes */
-            while (m) { /* handle only candidates to avoid unnecessary memcmp calls */
-                unsigned off = __builtin_ctz(m) >> 3;
-                uint32_t pos = i + off;
-                if (pos + JPEG_EOI_MARKER_LEN <= length &&
-                    memcmp(inbuf + pos, pat, JPEG_EOI_MARKER_LEN) == 0) {
-                    return pos;
-                }
-                m &= m - 1; /* clear processed candidate */
-            }
-            i += 4;
-        }
-        for (; i + JPEG_EOI_MARKER_LEN <= length; i++) {
-            if (memcmp(inbuf + i, pat, JPEG_EOI_MARKER_LEN) == 0) {
-                return i;
-            }
+/* Timestamp for the path counters, 0 when they are compiled out. */
+static inline int64_t cam_path_time(void)
+{
+#if CONFIG_CAMERA_PATH_STATS
+    return esp_timer_get_time();
+#else
+    return 0;
+#endif
+}
+
+/* Add one frame's copy and cache sync time to the counters of the current
+ * path. `taken` is false from cam_task, true from cam_take(). */
+static void cam_path_commit(bool taken, uint32_t copy_us, size_t copy_bytes, uint32_t sync_us)
+{
+#if CONFIG_CAMERA_PATH_STATS
+    int path = cam_obj->psram_mode;
+    portENTER_CRITICAL(&s_path_stats_lock);
+    if (taken) {
+        s_path_stats.frames_taken++;
+    } else {
+        s_path_stats.frames++;
+    }
+    s_path_stats.copy_bytes += copy_bytes;
+    s_path_stats.copy_us += copy_us;
+    if (copy_us > s_path_stats.copy_us_max) {
+        s_path_stats.copy_us_max = copy_us;
+    }
+    s_path_stats.cache_sync_us += sync_us;
+    if (sync_us > s_path_stats.cache_sync_us_max) {
+        s_path_stats.cache_sync_us_max = sync_us;
+    }
+    cam_path_cost_t *cost = s_path_cost_cur;
+    if (cost) {
+        if (taken) {
+            cost->take_frames[path]++;
+            cost->take_us[path] += copy_us + sync_us;
+        } else {
+            cost->task_frames[path]++;
+            cost->task_us[path] += copy_us + sync_us;
         }
-        return -1;
     }
+    portEXIT_CRITICAL(&s_path_stats_lock);
+#else
+    (void)taken;
+    (void)copy_us;
+    (void)copy_bytes;
+    (void)sync_us;
+#endif
+}
 
-    const uint8_t *dptr = inbuf + length - JPEG_EOI_MARKER_LEN;
-    while (dptr >= inbuf) {
-        if (memcmp(dptr, JPEG_EOI_BYTES, JPEG_EOI_MARKER_LEN) == 0) {
-            return dptr - inbuf;
-        }
-        if (dptr == inbuf) {
+#if CONFIG_CAMERA_PATH_STATS
+/* Point the cost accounting at the slot for this format and size, reusing
+ * the oldest slot when all are taken. */
+static void cam_path_cost_select(pixformat_t format, framesize_t frame_size)
+{
+    static int next_slot;
+    cam_path_cost_t *cost = NULL;
+    for (int i = 0; i < CAM_PATH_COST_SLOTS; i++) {
+        if (s_path_cost[i].used && s_path_cost[i].format == format &&
+            s_path_cost[i].frame_size == frame_size) {
+            cost = &s_path_cost[i];
             break;
         }
-        dptr--;
     }
-    return -1;
+    portENTER_CRITICAL(&s_path_stats_lock);
+    if (!cost) {
+        cost = &s_path_cost[next_slot];
+        next_slot = (next_slot + 1) % CAM_PATH_COST_SLOTS;
+        memset(cost, 0, sizeof(*cost));
+        cost->used = true;
+        cost->format = format;
+        cost->frame_size = frame_size;
+    }
+    s_path_cost_cur = cost;
+    portEXIT_CRITICAL(&s_path_stats_lock);
+}
+
+/* Mean copy plus cache sync time per frame on one path, if measured. */
+static bool cam_path_cost_mean(const cam_path_cost_t *cost, int path, uint32_t *us)
+{
+    if (!cost || cost->task_frames[path] < CAM_PATH_COST_MIN_FRAMES ||
+        cost->take_frames[path] < CAM_PATH_COST_MIN_FRAMES) {
+        return false;
+    }
+    *us = cost->task_us[path] / cost->task_frames[path] + cost->take_us[path] / cost->take_frames[path];
+    return true;
+}
+#endif
+
+/* PSRAM DMA mode for a new configuration, see esp_camera_set_psram_policy().
+ * Needs in/fb_bytes_per_pixel from ll_cam_set_sample_mode(). */
+static bool cam_choose_psram_mode(const camera_config_t *config)
+{
+#if CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3
+    if (g_psram_policy == CAMERA_PSRAM_POLICY_MANUAL) {
+        return g_psram_dma_mode;
+    }
+    bool psram = false;
+    if (config->fb_location == CAMERA_FB_IN_PSRAM) {
+        /* Unmeasured: DMA into PSRAM saves the copy when frames are stored
+         * as captured. A conversion costs a pass over the frame either way,
+         * and doing it on the copy out of internal RAM avoids reading the
+         * frame back from PSRAM. */
+        psram = cam_obj->in_bytes_per_pixel == cam_obj->fb_bytes_per_pixel;
+#if CONFIG_CAMERA_PATH_STATS
+        uint32_t internal_us, psram_us;
+        if (cam_path_cost_mean(s_path_cost_cur, 0, &internal_us) &&
+            cam_path_cost_mean(s_path_cost_cur, 1, &psram_us)) {
+            psram = psram_us < internal_us;
+            ESP_LOGI(TAG, "Measured %u us/frame internal, %u us/frame PSRAM DMA",
+                     (unsigned) internal_us, (unsigned) psram_us);
+        }
+#endif
+    }
+    portENTER_CRITICAL(&g_psram_dma_lock);
+    g_psram_dma_mode = psram;
+    portEXIT_CRITICAL(&g_psram_dma_lock);
+    return psram;
+#else
+    (void)config;
+    return false;
+#endif
 }
 
 static bool cam_get_next_frame(int * frame_pos)
@@ -267,6 +388,10 @@ static void cam_task(void *arg)
 {
     int cnt = 0;
     int frame_pos = 0;
+    /* path counters for the frame being read */
+    uint32_t copy_us = 0;
+    size_t copy_bytes = 0;
+    uint32_t sync_us = 0;
     cam_obj->state = CAM_STATE_IDLE;
     cam_event_t cam_event = 0;
 
@@ -274,6 +399,13 @@ static void cam_task(void *arg)
 
     while (1) {
         xQueueReceive(cam_obj->event_queue, (void *)&cam_event, portMAX_DELAY);
+        if (cam_event == CAM_RESET_EVENT) {
+            /* the frame being read (if any) is abandoned; cam_restart() frees it */
+            cam_obj->state = CAM_STATE_IDLE;
+            cnt = 0;
+            cam_obj->reset_pending = false;
+            continue;
+        }
         DBG_PIN_SET(1);
         switch (cam_obj->state) {
 
@@ -285,6 +417,9 @@ static void cam_task(void *arg)
                         cam_obj->state = CAM_STATE_READ_BUF;
                     }
                     cnt = 0;
+                    copy_us = 0;
+                    copy_bytes = 0;
+                    sync_us = 0;
                 }
             }
             break;
@@ -300,10 +435,14 @@ static void cam_task(void *arg)
                             ll_cam_stop(cam_obj);
                             continue;
                         }
-                        frame_buffer_event->len += ll_cam_memcpy(cam_obj,
+                        int64_t t0 = cam_path_time();
+                        size_t n = ll_cam_memcpy(cam_obj,
                             &frame_buffer_event->buf[frame_buffer_event->len],
                             &cam_obj->dma_buffer[(cnt % cam_obj->dma_half_buffer_cnt) * cam_obj->dma_half_buffer_size],
                             cam_obj->dma_half_buffer_size);
+                        copy_us += cam_path_time() - t0;
+                        copy_bytes += n;
+                        frame_buffer_event->len += n;
                     } else {
                         // stop if the next DMA copy would exceed the framebuffer slot
                         // size, since we're called only after the copy occurs
@@ -328,7 +467,9 @@ static void cam_task(void *arg)
                                 probe_len = CAM_SOI_PROBE_BYTES;
                             }
                             /* Invalidate cache lines for the DMA buffer before probing */
+                            int64_t t0 = cam_path_time();
                             cam_drop_psram_cache(frame_buffer_event->buf, probe_len);
+                            sync_us += cam_path_time() - t0;
 
                             uint8_t soi_probe[CAM_SOI_PROBE_BYTES];
                             memcpy(soi_probe, frame_buffer_event->buf, probe_len);
@@ -377,10 +518,14 @@ static void cam_task(void *arg)
                                     ESP_CAMERA_ETS_PRINTF(DRAM_STR("cam_hal: FB-OVF\r\n"));
                                     cnt--;
                                 } else {
-                                    frame_buffer_event->len += ll_cam_memcpy(cam_obj,
+                                    int64_t t0 = cam_path_time();
+                                    size_t n = ll_cam_memcpy(cam_obj,
                                         &frame_buffer_event->buf[frame_buffer_event->len],
                                         &cam_obj->dma_buffer[(cnt % cam_obj->dma_half_buffer_cnt) * cam_obj->dma_half_buffer_size],
                                         cam_obj->dma_half_buffer_size);
+                                    copy_us += cam_path_time() - t0;
+                                    copy_bytes += n;
+                                    frame_buffer_event->len += n;
                                 }
                             }
                             cnt++;
@@ -400,6 +545,18 @@ static void cam_task(void *arg)
                                 ESP_CAMERA_ETS_PRINTF(DRAM_STR("cam_hal: FB-SIZE: %u != %u\r\n"), frame_buffer_event->len, (unsigned) cam_obj->fb_size);
                             }
                         }
+                        /* before the frame is queued and cam_take() can add its share */
+                        if (!cam_obj->frames[frame_pos].en) {
+                            cam_path_commit(false, copy_us, copy_bytes, sync_us);
+                        }
+                        //in GRAB_LATEST mode keep one buffer free for the sensor
+                        if (!cam_obj->frames[frame_pos].en && cam_obj->grab_latest && cam_obj->frame_cnt > 1 &&
+                            uxQueueMessagesWaiting(cam_obj->frame_buffer_queue) >= cam_obj->frame_cnt - 1) {
+                            camera_fb_t * stale = NULL;
+                            if (xQueueReceive(cam_obj->frame_buffer_queue, &stale, 0) == pdTRUE) {
+                                cam_give(stale);
+                            }
+                        }
                         //send frame
                         if(!cam_obj->frames[frame_pos].en && xQueueSend(cam_obj->frame_buffer_queue, (void *)&frame_buffer_event, 0) != pdTRUE) {
                             //pop frame buffer from the queue
@@ -426,6 +583,9 @@ static void cam_task(void *arg)
                         cam_obj->frames[frame_pos].fb.len = 0;
                     }
                     cnt = 0;
+                    copy_us = 0;
+                    copy_bytes = 0;
+                    sync_us = 0;
                 }
             }
             break;
@@ -573,12 +733,13 @@ esp_err_t cam_config(const camera_config_t *config, framesize_t frame_size, uint
     CAM_CHECK_GOTO(ret == ESP_OK, "ll_cam_set_sample_mode failed", err);
     
     cam_obj->jpeg_mode = config->pixel_format == PIXFORMAT_JPEG;
-#if CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3
-    cam_obj->psram_mode = g_psram_dma_mode;
-#else
-    cam_obj->psram_mode = false;
+#if CONFIG_CAMERA_PATH_STATS
+    cam_path_cost_select((pixformat_t)config->pixel_format, frame_size);
 #endif
-    ESP_LOGI(TAG, "PSRAM DMA mode %s", cam_obj->psram_mode ? "enabled" : "disabled");
+    cam_obj->psram_mode = cam_choose_psram_mode(config);
+    ESP_LOGI(TAG, "PSRAM DMA mode %s%s", cam_obj->psram_mode ? "enabled" : "disabled",
+             g_psram_policy == CAMERA_PSRAM_POLICY_AUTO ? " (auto)" : "");
+    cam_reset_path_stats();
     cam_obj->frame_cnt = config->fb_count;
     cam_obj->width = resolution[frame_size].width;
     cam_obj->height = resolution[frame_size].height;
@@ -605,11 +766,10 @@ esp_err_t cam_config(const camera_config_t *config, framesize_t frame_size, uint
     cam_obj->event_queue = xQueueCreate(queue_size, sizeof(cam_event_t));
     CAM_CHECK_GOTO(cam_obj->event_queue != NULL, "event_queue create failed", err);
 
-    size_t frame_buffer_queue_len = cam_obj->frame_cnt;
-    if (config->grab_mode == CAMERA_GRAB_LATEST && cam_obj->frame_cnt > 1) {
-        frame_buffer_queue_len = cam_obj->frame_cnt - 1;
-    }
-    cam_obj->frame_buffer_queue = xQueueCreate(frame_buffer_queue_len, sizeof(camera_fb_t*));
+    /* Sized for CAMERA_GRAB_WHEN_EMPTY; CAMERA_GRAB_LATEST is enforced when
+     * frames are queued so the mode can change at runtime. */
+    cam_obj->grab_latest = config->grab_mode == CAMERA_GRAB_LATEST;
+    cam_obj->frame_buffer_queue = xQueueCreate(cam_obj->frame_cnt, sizeof(camera_fb_t*));
     CAM_CHECK_GOTO(cam_obj->frame_buffer_queue != NULL, "frame_buffer_queue create failed", err);
 
     ret = ll_cam_init_isr(cam_obj);
@@ -683,6 +843,41 @@ void cam_start(void)
     ll_cam_vsync_intr_enable(cam_obj, true);
 }
 
+esp_err_t cam_restart(void)
+{
+    if (!cam_obj) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    cam_stop();
+#if CONFIG_IDF_TARGET_ESP32S3
+    ll_cam_dma_reset(cam_obj);
+#endif
+    /* cam_task may be mid-frame on the other core: let it reset its own state */
+    xQueueReset(cam_obj->event_queue);
+    cam_obj->reset_pending = true;
+    cam_event_t ev = CAM_RESET_EVENT;
+    if (xQueueSend(cam_obj->event_queue, &ev, pdMS_TO_TICKS(10)) != pdTRUE) {
+        cam_obj->reset_pending = false;
+        cam_start();
+        return ESP_ERR_TIMEOUT;
+    }
+    for (int i = 0; i < 10 && cam_obj->reset_pending; i++) {
+        vTaskDelay(1);
+    }
+    if (cam_obj->reset_pending) {
+        cam_start();
+        return ESP_ERR_TIMEOUT;
+    }
+
+    /* queued frames are likely the corrupt ones that led here */
+    camera_fb_t *fb = NULL;
+    while (xQueueReceive(cam_obj->frame_buffer_queue, &fb, 0) == pdTRUE) {
+    }
+    cam_give_all();
+    cam_start();
+    return ESP_OK;
+}
+
 camera_fb_t *cam_take(TickType_t timeout)
 {
     camera_fb_t *dma_buffer = NULL;
@@ -736,31 +931,36 @@ camera_fb_t *cam_take(TickType_t timeout)
         if (cam_obj->jpeg_mode) {
             /* find the end marker for JPEG. Data after that can be discarded */
             int offset_e = -1;
+            /* Search forward through the last two DMA halves only: the frame
+             * data before them cannot hold the EOI, and the earliest EOI in
+             * the window is this frame's, not a stale one from a larger
+             * prior frame (see eoi_probe_window()). */
+            size_t probe_len = eoi_probe_window(cam_obj->dma_half_buffer_size,
+                                               dma_buffer->len);
+            if (probe_len < JPEG_EOI_MARKER_LEN) {
+                goto skip_eoi_check;
+            }
+            uint8_t *probe_start = dma_buffer->buf + dma_buffer->len - probe_len;
+            uint32_t sync_us = 0;
             if (cam_obj->psram_mode) {
-                /* Search forward from (JPEG_EOI_MARKER_LEN - 1) bytes before the final
-                 * DMA block. We prefer forward search to pick the earliest EOI in the
-                 * last DMA node, avoiding stale markers from a larger prior frame. */
-                size_t probe_len = eoi_probe_window(cam_obj->dma_node_buffer_size,
-                                                   dma_buffer->len);
-                if (probe_len < JPEG_EOI_MARKER_LEN) {
-                    goto skip_eoi_check;
-                }
-                uint8_t *probe_start = dma_buffer->buf + dma_buffer->len - probe_len;
+                int64_t t0 = cam_path_time();
                 cam_drop_psram_cache(probe_start, probe_len);
-                int off = cam_verify_jpeg_eoi(probe_start, probe_len, true);
-                if (off >= 0) {
-                    offset_e = dma_buffer->len - probe_len + off;
-                }
-            } else {
-                offset_e = cam_verify_jpeg_eoi(dma_buffer->buf, dma_buffer->len, false);
+                sync_us = cam_path_time() - t0;
+            }
+            int off = cam_verify_jpeg_eoi(probe_start, probe_len);
+            if (off >= 0) {
+                offset_e = dma_buffer->len - probe_len + off;
             }
 
             if (offset_e >= 0) {
                 dma_buffer->len = offset_e + JPEG_EOI_MARKER_LEN;
                 if (cam_obj->psram_mode) {
                     /* DMA may bypass cache, ensure full frame is visible */
+                    int64_t t0 = cam_path_time();
                     cam_drop_psram_cache(dma_buffer->buf, dma_buffer->len);
+                    sync_us += cam_path_time() - t0;
                 }
+                cam_path_commit(true, 0, 0, sync_us);
                 return dma_buffer;
             }
 
@@ -770,16 +970,25 @@ skip_eoi_check:
                               "NO-EOI - JPEG end marker missing");
             cam_give(dma_buffer);
             continue; /* wait for another frame */
-        } else if (cam_obj->psram_mode &&
-                   cam_obj->in_bytes_per_pixel != cam_obj->fb_bytes_per_pixel) {
-            /* currently used only for YUV to GRAYSCALE */
-            dma_buffer->len = ll_cam_memcpy(cam_obj, dma_buffer->buf, dma_buffer->buf, dma_buffer->len);
         }
 
+        uint32_t copy_us = 0;
+        size_t copy_bytes = 0;
+        uint32_t sync_us = 0;
         if (cam_obj->psram_mode) {
             /* DMA may bypass cache, ensure full frame is visible to the app */
+            int64_t t0 = cam_path_time();
             cam_drop_psram_cache(dma_buffer->buf, dma_buffer->len);
+            int64_t t1 = cam_path_time();
+            sync_us = t1 - t0;
+            if (cam_obj->in_bytes_per_pixel != cam_obj->fb_bytes_per_pixel) {
+                /* currently used only for YUV to GRAYSCALE */
+                dma_buffer->len = ll_cam_memcpy(cam_obj, dma_buffer->buf, dma_buffer->buf, dma_buffer->len);
+                copy_us = cam_path_time() - t1;
+                copy_bytes = dma_buffer->len;
+            }
         }
+        cam_path_commit(true, copy_us, copy_bytes, sync_us);
 
         return dma_buffer;
     }
@@ -806,10 +1015,18 @@ bool cam_get_available_frames(void)
     return 0 < uxQueueMessagesWaiting(cam_obj->frame_buffer_queue);
 }
 
+void cam_set_grab_mode(camera_grab_mode_t mode)
+{
+    if (cam_obj) {
+        cam_obj->grab_latest = mode == CAMERA_GRAB_LATEST;
+    }
+}
+
 void cam_set_psram_mode(bool enable)
 {
     portENTER_CRITICAL(&g_psram_dma_lock);
     g_psram_dma_mode = enable;
+    g_psram_policy = CAMERA_PSRAM_POLICY_MANUAL;
     portEXIT_CRITICAL(&g_psram_dma_lock);
 }
 
@@ -817,3 +1034,40 @@ bool cam_get_psram_mode(void)
 {
     return g_psram_dma_mode;
 }
+
+void cam_set_psram_policy(camera_psram_policy_t policy)
+{
+    g_psram_policy = policy;
+}
+
+camera_psram_policy_t cam_get_psram_policy(void)
+{
+    return g_psram_policy;
+}
+
+esp_err_t cam_get_path_stats(camera_path_stats_t *stats)
+{
+#if CONFIG_CAMERA_PATH_STATS
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_path_stats_lock);
+    *stats = s_path_stats;
+    stats->elapsed_us = now - s_path_stats_start;
+    portEXIT_CRITICAL(&s_path_stats_lock);
+    return ESP_OK;
+#else
+    (void)stats;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void cam_reset_path_stats(void)
+{
+#if CONFIG_CAMERA_PATH_STATS
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&s_path_stats_lock);
+    memset(&s_path_stats, 0, sizeof(s_path_stats));
+    s_path_stats.psram_mode = cam_obj ? cam_obj->psram_mode : g_psram_dma_mode;
+    s_path_stats_start = now;
+    portEXIT_CRITICAL(&s_path_stats_lock);
+#endif
+}
@@ -520,6 +520,55 @@ bool esp_camera_available_frames(void)
     return cam_get_available_frames();
 }
 
+esp_err_t esp_camera_set_grab_mode(camera_grab_mode_t mode)
+{
+    if (s_state == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    cam_set_grab_mode(mode);
+    s_saved_config.grab_mode = mode;
+    return ESP_OK;
+}
+
+esp_err_t esp_camera_recover(camera_recover_level_t level)
+{
+    if (s_state == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (level == CAMERA_RECOVER_SENSOR) {
+        sensor_t *s = &s_state->sensor;
+        camera_status_t st = s->status;
+        pixformat_t pf = s->pixformat;
+        cam_stop();
+        if (s->reset(s) != 0) {
+            cam_start();
+            return ESP_ERR_CAMERA_NOT_SUPPORTED;
+        }
+        /* reset() loads the power-on tables; put back what init and the
+         * application had set */
+        s->set_pixformat(s, pf);
+        if (s->set_framesize(s, st.framesize) != 0) {
+            cam_start();
+            return ESP_ERR_CAMERA_FAILED_TO_SET_FRAME_SIZE;
+        }
+        if (pf == PIXFORMAT_JPEG) {
+            s->set_quality(s, st.quality);
+        }
+        s->set_gainceiling(s, st.gainceiling);
+        s->set_bpc(s, st.bpc);
+        s->set_wpc(s, st.wpc);
+        s->set_lenc(s, st.lenc);
+        s->set_brightness(s, st.brightness);
+        s->set_contrast(s, st.contrast);
+        s->set_saturation(s, st.saturation);
+        s->set_hmirror(s, st.hmirror);
+        s->set_vflip(s, st.vflip);
+    } else if (level != CAMERA_RECOVER_DMA) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return cam_restart();
+}
+
 esp_err_t esp_camera_reconfigure(const camera_config_t *config)
 {
     if (!config) {
@@ -548,3 +597,65 @@ bool esp_camera_get_psram_mode(void)
 {
     return cam_get_psram_mode();
 }
+
+esp_err_t esp_camera_set_psram_policy(camera_psram_policy_t policy)
+{
+    cam_set_psram_policy(policy);
+    if (!s_state) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    return esp_camera_reconfigure(&s_saved_config);
+}
+
+camera_psram_policy_t esp_camera_get_psram_policy(void)
+{
+    return cam_get_psram_policy();
+}
+
+esp_err_t esp_camera_get_path_stats(camera_path_stats_t *stats)
+{
+    if (!stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return cam_get_path_stats(stats);
+}
+
+void esp_camera_reset_path_stats(void)
+{
+    cam_reset_path_stats();
+}
+
+esp_err_t esp_camera_calibrate_psram_mode(int frames)
+{
+#if CONFIG_CAMERA_PATH_STATS && (CONFIG_IDF_TARGET_ESP32S2 || CONFIG_IDF_TARGET_ESP32S3)
+    if (!s_state) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_saved_config.fb_location != CAMERA_FB_IN_PSRAM) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (frames < 4) {
+        frames = 4;
+    }
+    for (int psram = 0; psram < 2; psram++) {
+        cam_set_psram_mode(psram);
+        esp_err_t err = esp_camera_reconfigure(&s_saved_config);
+        if (err != ESP_OK) {
+            return err;
+        }
+        for (int i = 0; i < frames; i++) {
+            camera_fb_t *fb = esp_camera_fb_get();
+            if (!fb) {
+                ESP_LOGE(TAG, "No frame with PSRAM DMA %s", psram ? "on" : "off");
+                return ESP_ERR_TIMEOUT;
+            }
+            esp_camera_fb_return(fb);
+        }
+    }
+    cam_set_psram_policy(CAMERA_PSRAM_POLICY_AUTO);
+    return esp_camera_reconfigure(&s_saved_config);
+#else
+    (void)frames;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
@@ -245,6 +245,45 @@ void esp_camera_return_all(void);
  */
 bool esp_camera_available_frames(void);
 
+/**
+ * @brief Switch between CAMERA_GRAB_WHEN_EMPTY and CAMERA_GRAB_LATEST at runtime.
+ *
+ * Unlike esp_camera_reconfigure() this does not restart the sensor. Frames
+ * already queued stay queued; in CAMERA_GRAB_LATEST the oldest is dropped
+ * as each new frame completes.
+ *
+ * @param mode  New grab mode
+ * @return
+ * - ESP_OK on success
+ * - ESP_ERR_INVALID_STATE if the camera is not initialized
+ */
+esp_err_t esp_camera_set_grab_mode(camera_grab_mode_t mode);
+
+/**
+ * @brief Recovery steps short of esp_camera_deinit()/esp_camera_init().
+ */
+typedef enum {
+    CAMERA_RECOVER_DMA,     /*!< Restart capture: DMA channel reset, frame queue flushed */
+    CAMERA_RECOVER_SENSOR,  /*!< Sensor soft reset and settings restored, then CAMERA_RECOVER_DMA */
+} camera_recover_level_t;
+
+/**
+ * @brief Restart a capture pipeline that stopped producing valid frames,
+ *        keeping the frame buffers and the driver task.
+ *
+ * Both levels are much cheaper than a deinit/init cycle, which reallocates
+ * the frame buffers and reprobes the sensor. All frame buffers must have
+ * been returned; queued frames are dropped.
+ *
+ * @param level  How much to reset
+ * @return
+ * - ESP_OK on success
+ * - ESP_ERR_INVALID_STATE if the camera is not initialized
+ * - ESP_ERR_TIMEOUT if the capture task did not acknowledge the restart
+ * - ESP_ERR_CAMERA_NOT_SUPPORTED if the sensor soft reset failed
+ */
+esp_err_t esp_camera_recover(camera_recover_level_t level);
+
 /**
  * @brief Enable or disable PSRAM DMA mode at runtime.
  *
@@ -274,6 +313,101 @@ esp_err_t esp_camera_reconfigure(const camera_config_t *config);
  */
 bool esp_camera_get_psram_mode(void);
 
+/**
+ * @brief How the PSRAM DMA mode is chosen when the camera is configured.
+ */
+typedef enum {
+    CAMERA_PSRAM_POLICY_MANUAL, /*!< Use the mode set by esp_camera_set_psram_mode() */
+    CAMERA_PSRAM_POLICY_AUTO,   /*!< Pick the cheaper path for the pixel format and frame size at each init */
+} camera_psram_policy_t;
+
+/**
+ * @brief Select how the PSRAM DMA mode is chosen and reconfigure.
+ *
+ * In CAMERA_PSRAM_POLICY_AUTO the camera uses PSRAM DMA only with
+ * CAMERA_FB_IN_PSRAM. If both paths have been measured this boot for the
+ * same pixel format and frame size (CONFIG_CAMERA_PATH_STATS, see
+ * esp_camera_calibrate_psram_mode()), the one with the lower copy plus cache
+ * sync time per frame wins. Otherwise PSRAM DMA is used when frames are
+ * stored as captured (JPEG, RGB565, YUV422) and the internal copy path when
+ * they are converted on the way (grayscale from YUV). The chosen mode is
+ * reported by esp_camera_get_psram_mode().
+ *
+ * esp_camera_set_psram_mode() returns to CAMERA_PSRAM_POLICY_MANUAL.
+ *
+ * @param policy  New policy
+ * @return
+ * - ESP_OK on success
+ * - ESP_ERR_INVALID_STATE if the camera is not initialized (the policy
+ *   still applies to the next esp_camera_init())
+ * - Propagated error from reinitialization on failure
+ */
+esp_err_t esp_camera_set_psram_policy(camera_psram_policy_t policy);
+
+/**
+ * @brief Get the current PSRAM DMA policy.
+ */
+camera_psram_policy_t esp_camera_get_psram_policy(void);
+
+/**
+ * @brief Capture path cost counters, see esp_camera_get_path_stats().
+ *
+ * Copy time is CPU time spent moving pixels: copying the internal DMA
+ * buffers into the frame buffer, or the in-place YUV to grayscale pass in
+ * PSRAM DMA mode. Cache sync time is spent invalidating the data cache over
+ * frame data DMA wrote to PSRAM, so it is zero on the internal path.
+ */
+typedef struct {
+    bool psram_mode;            /*!< Path the counters were taken on */
+    uint32_t frames;            /*!< Frames completed by the capture task */
+    uint32_t frames_taken;      /*!< Frames handed out by esp_camera_fb_get() */
+    uint64_t copy_bytes;        /*!< Bytes written by copies */
+    uint64_t copy_us;           /*!< Total copy time */
+    uint32_t copy_us_max;       /*!< Longest copy time for one frame */
+    uint64_t cache_sync_us;     /*!< Total cache sync time */
+    uint32_t cache_sync_us_max; /*!< Longest cache sync time for one frame */
+    int64_t elapsed_us;         /*!< Time since the last reset; frames * 1e6 / elapsed_us is the frame rate */
+} camera_path_stats_t;
+
+/**
+ * @brief Read the capture path counters.
+ *
+ * The counters restart whenever the camera is (re)configured and on
+ * esp_camera_reset_path_stats().
+ *
+ * @param stats  Filled with the counters
+ * @return
+ * - ESP_OK on success
+ * - ESP_ERR_INVALID_ARG if stats is NULL
+ * - ESP_ERR_NOT_SUPPORTED if CONFIG_CAMERA_PATH_STATS is disabled
+ */
+esp_err_t esp_camera_get_path_stats(camera_path_stats_t *stats);
+
+/**
+ * @brief Restart the capture path counters.
+ */
+void esp_camera_reset_path_stats(void);
+
+/**
+ * @brief Measure both capture paths and keep the cheaper one.
+ *
+ * Reconfigures with PSRAM DMA off and on, takes `frames` frames on each
+ * (at least 4), then reconfigures once more in CAMERA_PSRAM_POLICY_AUTO so
+ * the measured costs decide. Later inits with the same pixel format and
+ * frame size reuse the measurement until reboot. No frame buffer may be held
+ * by the caller.
+ *
+ * @param frames  Frames to take on each path
+ * @return
+ * - ESP_OK on success
+ * - ESP_ERR_INVALID_STATE if the camera is not initialized
+ * - ESP_ERR_NOT_SUPPORTED without CONFIG_CAMERA_PATH_STATS, on targets
+ *   without PSRAM DMA, or with frame buffers outside PSRAM
+ * - ESP_ERR_TIMEOUT if a path produced no frame
+ * - Propagated error from reinitialization on failure
+ */
+esp_err_t esp_camera_calibrate_psram_mode(int frames);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,59 @@
+#include "jpeg_marker.h"
+
+#include <string.h>
+
+/*
+ * SWAR scan: a word is loaded and tested for 0xFF bytes with the classic
+ * "has zero byte" trick on its complement. The test can flag a byte above a
+ * real hit by borrow, never miss one, so every flagged byte is re-checked.
+ * 32-bit words on the ESP32 targets, 64-bit on 64-bit hosts.
+ */
+#if UINTPTR_MAX > 0xFFFFFFFFu
+typedef uint64_t marker_word_t;
+#define MARKER_CTZ(x) __builtin_ctzll(x)
+#else
+typedef uint32_t marker_word_t;
+#define MARKER_CTZ(x) __builtin_ctz(x)
+#endif
+
+#define MARKER_WORD  sizeof(marker_word_t)
+#define MARKER_ONES  ((marker_word_t)-1 / 0xFF)
+#define MARKER_HIGHS (MARKER_ONES * 0x80)
+
+int jpeg_marker_find(const uint8_t *buf, size_t len, uint8_t code)
+{
+    if (len < 2) {
+        return -1;
+    }
+    /* a marker must start before the last byte */
+    const size_t last = len - 1;
+    size_t i = 0;
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    /* head: up to the first aligned word */
+    for (; i < last && ((uintptr_t)(buf + i) & (MARKER_WORD - 1)); i++) {
+        if (buf[i] == 0xFF && buf[i + 1] == code) {
+            return i;
+        }
+    }
+    /* whole words, leaving at least one byte after each for the code */
+    for (; i + MARKER_WORD <= last; i += MARKER_WORD) {
+        marker_word_t w;
+        memcpy(&w, __builtin_assume_aligned(buf + i, MARKER_WORD), MARKER_WORD);
+        marker_word_t m = (~w - MARKER_ONES) & w & MARKER_HIGHS;
+        while (m) {
+            size_t k = i + (MARKER_CTZ(m) >> 3);
+            if (buf[k] == 0xFF && buf[k + 1] == code) {
+                return k;
+            }
+            m &= m - 1;
+        }
+    }
+#endif
+    for (; i < last; i++) {
+        if (buf[i] == 0xFF && buf[i + 1] == code) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -51,6 +51,15 @@ void cam_stop(void);
 
 void cam_start(void);
 
+/**
+ * @brief Restart capture without touching buffers or the sensor.
+ *
+ * Stops the capture, resets the DMA channel (ESP32-S3), returns cam_task to
+ * idle and drops every queued frame, then restarts on the next VSYNC. The
+ * caller must not hold any frame buffer.
+ */
+esp_err_t cam_restart(void);
+
 camera_fb_t *cam_take(TickType_t timeout);
 
 void cam_give(camera_fb_t *dma_buffer);
@@ -59,9 +68,18 @@ void cam_give_all(void);
 
 bool cam_get_available_frames(void);
 
+void cam_set_grab_mode(camera_grab_mode_t mode);
+
+/* Setting the mode also selects CAMERA_PSRAM_POLICY_MANUAL. */
 void cam_set_psram_mode(bool enable);
 bool cam_get_psram_mode(void);
 
+void cam_set_psram_policy(camera_psram_policy_t policy);
+camera_psram_policy_t cam_get_psram_policy(void);
+
+esp_err_t cam_get_path_stats(camera_path_stats_t *stats);
+void cam_reset_path_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Find the first JPEG marker FF <code> in a buffer.
+ *
+ * Scans a machine word at a time and only looks at the byte after an 0xFF,
+ * which in entropy-coded data is rare (every data 0xFF is followed by a
+ * stuffed 0x00). Used by the SOI and EOI probes in cam_hal.c.
+ *
+ * @param buf   Data to scan
+ * @param len   Bytes in buf
+ * @param code  Second marker byte, e.g. 0xD8 (SOI) or 0xD9 (EOI)
+ *
+ * @return Offset of the 0xFF, or -1 if there is no complete marker
+ */
+int jpeg_marker_find(const uint8_t *buf, size_t len, uint8_t code);
+
+#ifdef __cplusplus
+}
+#endif
@@ -77,7 +77,8 @@
 
 typedef enum {
     CAM_IN_SUC_EOF_EVENT = 0,
-    CAM_VSYNC_EVENT
+    CAM_VSYNC_EVENT,
+    CAM_RESET_EVENT, // posted by cam_restart(), never by the ISR
 } cam_event_t;
 
 typedef enum {
@@ -126,6 +127,8 @@ typedef struct {
     uint32_t recv_size;
     bool swap_data;
     bool psram_mode;
+    volatile bool grab_latest;
+    volatile bool reset_pending;
 
     //for RGB/YUV modes
     uint16_t width;
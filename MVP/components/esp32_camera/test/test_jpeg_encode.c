@@ -0,0 +1,159 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+
+#include "img_converters.h"
+
+#define ENC_WIDTH  320
+#define ENC_HEIGHT 240
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} enc_out_t;
+
+static size_t enc_out_cb(void *arg, size_t index, const void *data, size_t len)
+{
+    enc_out_t *out = (enc_out_t *)arg;
+    if (!data) {
+        return 0;
+    }
+    if (out->len + len > out->cap) {
+        return 0;
+    }
+    memcpy(out->data + out->len, data, len);
+    out->len += len;
+    return len;
+}
+
+/* Big-endian RGB565 with gradients and edges in every MCU row. */
+static uint8_t *make_rgb565(void)
+{
+    uint8_t *buf = malloc(ENC_WIDTH * ENC_HEIGHT * 2);
+    TEST_ASSERT_NOT_NULL(buf);
+    uint8_t *p = buf;
+    for (int y = 0; y < ENC_HEIGHT; y++) {
+        for (int x = 0; x < ENC_WIDTH; x++) {
+            uint16_t r = (x * 31) / ENC_WIDTH;
+            uint16_t g = ((x ^ y) & 0x20) ? 63 : (y * 63) / ENC_HEIGHT;
+            uint16_t b = ((x + y) * 31) / (ENC_WIDTH + ENC_HEIGHT);
+            uint16_t v = r << 11 | g << 5 | b;
+            *p++ = v >> 8;
+            *p++ = v & 0xFF;
+        }
+    }
+    return buf;
+}
+
+static void encode(uint8_t *src, uint8_t workers, enc_out_t *out)
+{
+    out->len = 0;
+    jpgSetWorkers(workers);
+    TEST_ASSERT_TRUE(fmt2jpg_cb(src, ENC_WIDTH * ENC_HEIGHT * 2, ENC_WIDTH, ENC_HEIGHT, PIXFORMAT_RGB565, 80, enc_out_cb, out));
+    jpgSetWorkers(1);
+}
+
+static int count_marker(const enc_out_t *out, uint8_t code, uint8_t mask)
+{
+    int n = 0;
+    for (size_t i = 0; i + 1 < out->len; i++) {
+        if (out->data[i] == 0xFF && (out->data[i + 1] & mask) == code) {
+            n++;
+        }
+    }
+    return n;
+}
+
+TEST_CASE("JPEG encode split into strips joins with restart markers", "[camera]")
+{
+    uint8_t *src = make_rgb565();
+    enc_out_t outs[3];
+    for (int i = 0; i < 3; i++) {
+        outs[i].cap = 64 * 1024;
+        outs[i].data = malloc(outs[i].cap);
+        TEST_ASSERT_NOT_NULL(outs[i].data);
+    }
+
+    encode(src, 1, &outs[0]);
+    encode(src, 2, &outs[1]);
+    encode(src, 3, &outs[2]);
+
+    int rows = ENC_HEIGHT / 16;
+    TEST_ASSERT_EQUAL_INT(0, count_marker(&outs[0], 0xDD, 0xFF));
+    TEST_ASSERT_EQUAL_INT(0, count_marker(&outs[0], 0xD0, 0xF8));
+    TEST_ASSERT_EQUAL_INT(1, count_marker(&outs[1], 0xDD, 0xFF));
+    TEST_ASSERT_EQUAL_INT(rows - 1, count_marker(&outs[1], 0xD0, 0xF8));
+    TEST_ASSERT_EQUAL_INT(1, count_marker(&outs[1], 0xD9, 0xFF));
+    /* the strip count changes who encodes a row, not the bytes */
+    TEST_ASSERT_EQUAL_UINT32(outs[1].len, outs[2].len);
+    TEST_ASSERT_EQUAL_MEMORY(outs[1].data, outs[2].data, outs[1].len);
+
+    /* restarts change the entropy coding only: same pixels once decoded */
+    uint8_t *serial = malloc(ENC_WIDTH * ENC_HEIGHT * 2);
+    uint8_t *split = malloc(ENC_WIDTH * ENC_HEIGHT * 2);
+    TEST_ASSERT_NOT_NULL(serial);
+    TEST_ASSERT_NOT_NULL(split);
+    TEST_ASSERT_TRUE(jpg2rgb565(outs[0].data, outs[0].len, serial, JPG_SCALE_NONE));
+    TEST_ASSERT_TRUE(jpg2rgb565(outs[1].data, outs[1].len, split, JPG_SCALE_NONE));
+    TEST_ASSERT_EQUAL_MEMORY(serial, split, ENC_WIDTH * ENC_HEIGHT * 2);
+
+    free(serial);
+    free(split);
+    for (int i = 0; i < 3; i++) {
+        free(outs[i].data);
+    }
+    free(src);
+}
+
+/* BT.601 video-range YUYV of a single colour */
+static void fill_yuyv(uint8_t *buf, int pixels, uint8_t y, uint8_t u, uint8_t v)
+{
+    for (int i = 0; i < pixels; i += 2, buf += 4) {
+        buf[0] = y;
+        buf[1] = u;
+        buf[2] = y;
+        buf[3] = v;
+    }
+}
+
+TEST_CASE("JPEG encode takes YUV422 as YCbCr in every chroma mode", "[camera]")
+{
+    static const struct {
+        uint8_t y, u, v;
+        uint8_t r, g, b;
+    } colours[] = {
+        { 126, 128, 128, 128, 128, 128 },   /* grey */
+        { 81, 90, 240, 255, 0, 0 },         /* red */
+        { 41, 240, 110, 0, 0, 255 },        /* blue */
+    };
+    static const chroma_t modes[] = { CHROMA_444, CHROMA_422, CHROMA_420 };
+    const int width = 64, height = 32;
+    uint8_t *src = malloc(width * height * 2);
+    uint8_t *rgb = malloc(width * height * 2);
+    enc_out_t out = { .data = malloc(16 * 1024), .len = 0, .cap = 16 * 1024 };
+    TEST_ASSERT_NOT_NULL(src);
+    TEST_ASSERT_NOT_NULL(rgb);
+    TEST_ASSERT_NOT_NULL(out.data);
+
+    for (int m = 0; m < 3; m++) {
+        jpgSetChroma(modes[m]);
+        for (int c = 0; c < 3; c++) {
+            fill_yuyv(src, width * height, colours[c].y, colours[c].u, colours[c].v);
+            out.len = 0;
+            TEST_ASSERT_TRUE(fmt2jpg_cb(src, width * height * 2, width, height, PIXFORMAT_YUV422, 90, enc_out_cb, &out));
+            TEST_ASSERT_TRUE(jpg2rgb565(out.data, out.len, rgb, JPG_SCALE_NONE));
+            /* centre pixel, RGB565 as the decoder writes it */
+            const uint8_t *px = rgb + (height / 2 * width + width / 2) * 2;
+            uint16_t v = px[0] << 8 | px[1];
+            TEST_ASSERT_INT_WITHIN(12, colours[c].r, (v >> 11) << 3);
+            TEST_ASSERT_INT_WITHIN(12, colours[c].g, ((v >> 5) & 0x3F) << 2);
+            TEST_ASSERT_INT_WITHIN(12, colours[c].b, (v & 0x1F) << 3);
+        }
+    }
+    jpgSetChroma(CHROMA_420);
+    free(out.data);
+    free(rgb);
+    free(src);
+}
@@ -0,0 +1,106 @@
+#include <stdint.h>
+#include <string.h>
+#include "unity.h"
+
+#include "jpeg_marker.h"
+
+static uint32_t s_seed;
+
+static uint8_t next_byte(void)
+{
+    s_seed = s_seed * 1664525u + 1013904223u;
+    return s_seed >> 24;
+}
+
+/* Entropy-coded-looking data: every 0xFF is followed by a stuffed 0x00. */
+static void fill_entropy(uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = next_byte();
+        if (buf[i] == 0xFF && i + 1 < len) {
+            buf[++i] = 0x00;
+        }
+    }
+}
+
+static int naive_find(const uint8_t *buf, size_t len, uint8_t code)
+{
+    for (size_t i = 0; i + 1 < len; i++) {
+        if (buf[i] == 0xFF && buf[i + 1] == code) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+TEST_CASE("JPEG marker scan finds a marker at every offset and alignment", "[camera]")
+{
+    static uint8_t buf[80];
+    for (size_t start = 0; start < 8; start++) {
+        for (size_t pos = start; pos + 2 <= sizeof(buf); pos++) {
+            memset(buf, 0x00, sizeof(buf));
+            buf[pos] = 0xFF;
+            buf[pos + 1] = 0xD9;
+            TEST_ASSERT_EQUAL_INT(pos - start, jpeg_marker_find(buf + start, sizeof(buf) - start, 0xD9));
+            /* cut off after the 0xFF: no complete marker */
+            TEST_ASSERT_EQUAL_INT(-1, jpeg_marker_find(buf + start, pos + 1 - start, 0xD9));
+        }
+    }
+}
+
+TEST_CASE("JPEG marker scan skips stuffed and fill bytes", "[camera]")
+{
+    static const uint8_t stuffed[] = {0x12, 0xFF, 0x00, 0xFF, 0xD0, 0xFF, 0xFF, 0xFF, 0xD9, 0x34};
+    TEST_ASSERT_EQUAL_INT(7, jpeg_marker_find(stuffed, sizeof(stuffed), 0xD9));
+    TEST_ASSERT_EQUAL_INT(3, jpeg_marker_find(stuffed, sizeof(stuffed), 0xD0));
+    TEST_ASSERT_EQUAL_INT(-1, jpeg_marker_find(stuffed, sizeof(stuffed), 0xD8));
+
+    static uint8_t all_ff[64];
+    memset(all_ff, 0xFF, sizeof(all_ff));
+    TEST_ASSERT_EQUAL_INT(-1, jpeg_marker_find(all_ff, sizeof(all_ff), 0xD9));
+    all_ff[sizeof(all_ff) - 1] = 0xD9;
+    TEST_ASSERT_EQUAL_INT(sizeof(all_ff) - 2, jpeg_marker_find(all_ff, sizeof(all_ff), 0xD9));
+
+    TEST_ASSERT_EQUAL_INT(-1, jpeg_marker_find(all_ff, 0, 0xD9));
+    TEST_ASSERT_EQUAL_INT(-1, jpeg_marker_find(all_ff, 1, 0xD9));
+}
+
+TEST_CASE("JPEG marker scan matches a byte-wise search", "[camera]")
+{
+    static uint8_t buf[3000];
+    s_seed = 1;
+    for (int round = 0; round < 200; round++) {
+        fill_entropy(buf, sizeof(buf));
+        int markers = next_byte() % 4;
+        for (int m = 0; m < markers; m++) {
+            size_t pos = (next_byte() << 8 | next_byte()) % (sizeof(buf) - 1);
+            buf[pos] = 0xFF;
+            buf[pos + 1] = (m & 1) ? 0xD8 : 0xD9;
+        }
+        size_t start = next_byte() % 8;
+        size_t len = sizeof(buf) - start - next_byte() % 8;
+        TEST_ASSERT_EQUAL_INT(naive_find(buf + start, len, 0xD9), jpeg_marker_find(buf + start, len, 0xD9));
+        TEST_ASSERT_EQUAL_INT(naive_find(buf + start, len, 0xD8), jpeg_marker_find(buf + start, len, 0xD8));
+    }
+}
+
+/* cam_take() scans the last two DMA halves of a frame forward. Whatever
+ * follows this frame's EOI there is left over from an older, longer frame
+ * and may hold that frame's EOI; the first marker must win. */
+TEST_CASE("JPEG marker scan returns this frame's EOI before stale ones", "[camera]")
+{
+    enum { HALF = 1024 };
+    static uint8_t window[2 * HALF + 1];
+    s_seed = 7;
+    for (size_t end = 2; end <= sizeof(window); end += 37) {
+        fill_entropy(window, sizeof(window));
+        window[end - 2] = 0xFF;
+        window[end - 1] = 0xD9;
+        /* stale EOIs at every alignment after it */
+        for (size_t stale = end + 1; stale + 2 <= sizeof(window); stale += 97) {
+            window[stale] = 0xFF;
+            window[stale + 1] = 0xD9;
+        }
+        TEST_ASSERT_EQUAL_INT(end - 2, jpeg_marker_find(window, sizeof(window), 0xD9));
+    }
+}
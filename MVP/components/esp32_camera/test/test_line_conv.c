@@ -0,0 +1,126 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "unity.h"
+#include "esp_cpu.h"
+
+#include "line_conv.h"
+#include "yuv.h"
+
+#define BENCH_WIDTH 640
+
+TEST_CASE("Line RGB565 conversion matches the per-pixel code", "[camera]")
+{
+    static uint8_t src[256 * 2], got[256 * 3];
+    for (int hi = 0; hi < 256; hi++) {
+        for (int lo = 0; lo < 256; lo++) {
+            src[2 * lo] = hi;
+            src[2 * lo + 1] = lo;
+        }
+        line_rgb565_to_rgb888(got, src, 256, true, false);
+        for (int lo = 0; lo < 256; lo++) {
+            TEST_ASSERT_EQUAL_UINT8(hi & 0xF8, got[3 * lo]);
+            TEST_ASSERT_EQUAL_UINT8((hi & 0x07) << 5 | (lo & 0xE0) >> 3, got[3 * lo + 1]);
+            TEST_ASSERT_EQUAL_UINT8((lo & 0x1F) << 3, got[3 * lo + 2]);
+        }
+        /* little-endian input, BGR output */
+        line_rgb565_to_rgb888(got, src, 256, false, true);
+        for (int lo = 0; lo < 256; lo++) {
+            TEST_ASSERT_EQUAL_UINT8(lo & 0xF8, got[3 * lo + 2]);
+            TEST_ASSERT_EQUAL_UINT8((lo & 0x07) << 5 | (hi & 0xE0) >> 3, got[3 * lo + 1]);
+            TEST_ASSERT_EQUAL_UINT8((hi & 0x1F) << 3, got[3 * lo]);
+        }
+    }
+}
+
+TEST_CASE("Line YUV422 conversion matches yuv2rgb", "[camera]")
+{
+    static uint8_t src[512 * 2], got[512 * 3];
+    uint8_t r, g, b;
+    for (int u = 0; u < 256; u++) {
+        /* every U against a spread of V, every Y on both sides of a pair */
+        for (int v = u % 5; v < 256; v += 5) {
+            for (int i = 0; i < 256; i++) {
+                src[4 * i] = i;
+                src[4 * i + 1] = u;
+                src[4 * i + 2] = 255 - i;
+                src[4 * i + 3] = v;
+            }
+            line_yuv422_to_rgb888(got, src, 512, false);
+            for (int i = 0; i < 512; i++) {
+                yuv2rgb(src[2 * i], u, v, &r, &g, &b);
+                TEST_ASSERT_EQUAL_UINT8(r, got[3 * i]);
+                TEST_ASSERT_EQUAL_UINT8(g, got[3 * i + 1]);
+                TEST_ASSERT_EQUAL_UINT8(b, got[3 * i + 2]);
+            }
+        }
+    }
+}
+
+TEST_CASE("Line YUV422 to JFIF stretches video range to full range", "[camera]")
+{
+    const uint8_t src[8] = { 16, 16, 235, 240, 126, 128, 127, 127 };
+    uint8_t got[8];
+    line_yuv422_to_jfif(got, src, 4);
+    const uint8_t want[8] = { 0, 0, 255, 255, 128, 128, 129, 127 };
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(want, got, sizeof(want));
+}
+
+static uint32_t cycles_per_100px(void (*fn)(uint8_t *, const uint8_t *), uint8_t *dst, const uint8_t *src)
+{
+    uint32_t best = UINT32_MAX;
+    for (int rep = 0; rep < 8; rep++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        fn(dst, src);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        if (cycles < best) {
+            best = cycles;
+        }
+    }
+    return best * 100 / BENCH_WIDTH;
+}
+
+static void scalar_yuv(uint8_t *dst, const uint8_t *src)
+{
+    for (int i = 0; i < BENCH_WIDTH * 2; i += 4, dst += 6) {
+        yuv2rgb(src[i], src[i + 1], src[i + 3], &dst[0], &dst[1], &dst[2]);
+        yuv2rgb(src[i + 2], src[i + 1], src[i + 3], &dst[3], &dst[4], &dst[5]);
+    }
+}
+
+static void line_yuv(uint8_t *dst, const uint8_t *src)
+{
+    line_yuv422_to_rgb888(dst, src, BENCH_WIDTH, false);
+}
+
+static void line_jfif(uint8_t *dst, const uint8_t *src)
+{
+    line_yuv422_to_jfif(dst, src, BENCH_WIDTH);
+}
+
+static void line_rgb565(uint8_t *dst, const uint8_t *src)
+{
+    line_rgb565_to_rgb888(dst, src, BENCH_WIDTH, true, false);
+}
+
+TEST_CASE("Line conversion cycles per pixel", "[camera]")
+{
+    uint8_t *src = malloc(BENCH_WIDTH * 2);
+    uint8_t *dst = malloc(BENCH_WIDTH * 3);
+    TEST_ASSERT_NOT_NULL(src);
+    TEST_ASSERT_NOT_NULL(dst);
+    for (int i = 0; i < BENCH_WIDTH * 2; i++) {
+        src[i] = i * 37;
+    }
+    uint32_t scalar = cycles_per_100px(scalar_yuv, dst, src);
+    uint32_t line = cycles_per_100px(line_yuv, dst, src);
+    printf("yuv422 -> rgb888: yuv2rgb %lu.%02lu, line %lu.%02lu cycles/px\n",
+           scalar / 100, scalar % 100, line / 100, line % 100);
+    uint32_t jfif = cycles_per_100px(line_jfif, dst, src);
+    uint32_t rgb = cycles_per_100px(line_rgb565, dst, src);
+    printf("yuv422 -> jfif %lu.%02lu, rgb565 -> rgb888 %lu.%02lu cycles/px\n",
+           jfif / 100, jfif % 100, rgb / 100, rgb % 100);
+    free(src);
+    free(dst);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+// Binary framing for bulk transfers over the USB console. A transfer (one
+// JPEG, one audio clip, one telemetry record) is sent as consecutive frames:
+//
+//   0   magic      0xA5 0x5A
+//   2   ver_type   version << 4 | usb_frame_type_t
+//   3   flags      USB_FRAME_FLAG_*
+//   4   seq        transfer number, u16 LE (same for all frames of a transfer)
+//   6   len        payload bytes in this frame, u16 LE
+//   8   offset     payload position within the transfer, u32 LE
+//   12  total      transfer size, u32 LE
+//   16  payload
+//   ..  crc32      zlib CRC-32 of header and payload, u32 LE
+//
+// Log text may appear between frames; receivers pass through anything that
+// is not a frame with a valid CRC. tools/usb_frame.py is the host decoder.
+// Pure C with no IDF dependencies beyond esp_err_t.
+
+#define USB_FRAME_MAGIC0        0xA5U
+#define USB_FRAME_MAGIC1        0x5AU
+#define USB_FRAME_VERSION       1U
+#define USB_FRAME_HEADER_BYTES  16U
+#define USB_FRAME_TRAILER_BYTES 4U
+#define USB_FRAME_MAX_PAYLOAD   16384U
+
+#define USB_FRAME_FLAG_FIRST 0x01U
+#define USB_FRAME_FLAG_LAST  0x02U
+
+typedef enum {
+  USB_FRAME_IMAGE = 1,      // JPEG
+  USB_FRAME_AUDIO = 2,      // WAV or FLAC file
+  USB_FRAME_TELEMETRY = 3,  // UTF-8 text, one record per transfer
+} usb_frame_type_t;
+
+typedef struct {
+  uint8_t type;
+  uint8_t flags;
+  uint16_t seq;
+  uint16_t len;
+  uint32_t offset;
+  uint32_t total;
+} usb_frame_header_t;
+
+// zlib-compatible CRC-32; pass 0 to start and the previous result to continue.
+uint32_t usb_frame_crc32(uint32_t crc, const void *data, size_t len);
+
+void usb_frame_pack_header(const usb_frame_header_t *h, uint8_t out[USB_FRAME_HEADER_BYTES]);
+// Checks magic, version and length fields (not the CRC).
+bool usb_frame_parse_header(const uint8_t in[USB_FRAME_HEADER_BYTES], usb_frame_header_t *h);
+
+typedef esp_err_t (*usb_frame_write_fn)(void *ctx, const void *data, size_t len);
+
+// Sender state. write receives the header, the payload straight from the
+// caller's buffer, and the CRC as three calls per frame; frame_begin and
+// frame_end (optional) bracket them, e.g. to hold a stream lock.
+typedef struct {
+  usb_frame_write_fn write;
+  void (*frame_begin)(void *ctx);
+  esp_err_t (*frame_end)(void *ctx);
+  void *ctx;
+  uint16_t chunk_bytes;  // payload per frame, 0 = USB_FRAME_MAX_PAYLOAD
+  uint16_t next_seq;
+} usb_frame_sender_t;
+
+// Streams data as one transfer without copying it. A zero-length transfer
+// is a single empty frame. Returns the first write error.
+esp_err_t usb_frame_send(usb_frame_sender_t *s, usb_frame_type_t type, const void *data, size_t len);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "usb_frame.h"
+
+// usb_frame transfers over the console (USB-Serial-JTAG CDC or UART). Frames
+// share the stream with ESP_LOG output: each frame is written under the
+// stdout lock so log lines can only land between frames.
+
+typedef struct {
+  uint32_t transfers;
+  uint32_t failures;
+  uint64_t payload_bytes;
+  uint64_t wire_bytes;
+  uint32_t last_us;        // duration of the last transfer
+  uint32_t last_kb_per_s;  // payload kB/s of the last transfer
+} usb_link_stats_t;
+
+// Switches console TX to raw LF line endings (binary payloads must not get
+// CR inserted) and, on USB-Serial-JTAG, installs the blocking driver so
+// frames are not dropped while the host is slow to read. Idempotent.
+esp_err_t usb_link_init(void);
+// Streams data as one transfer; blocks until the last frame is written.
+esp_err_t usb_link_send(usb_frame_type_t type, const void *data, size_t len);
+void usb_link_get_stats(usb_link_stats_t *out);
@@ -0,0 +1,163 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "usb_frame.h"
+
+typedef struct {
+  uint8_t *out;
+  size_t cap;
+  size_t len;
+  int begins;
+  int ends;
+  size_t fail_after;  // bytes accepted before writes fail, 0 = never
+} buffer_sink_t;
+
+static esp_err_t buffer_write(void *ctx, const void *data, size_t len) {
+  buffer_sink_t *sink = (buffer_sink_t *)ctx;
+  if ((sink->fail_after && sink->len + len > sink->fail_after) || sink->len + len > sink->cap) {
+    return ESP_FAIL;
+  }
+  memcpy(sink->out + sink->len, data, len);
+  sink->len += len;
+  return ESP_OK;
+}
+
+static void buffer_begin(void *ctx) {
+  ((buffer_sink_t *)ctx)->begins++;
+}
+
+static esp_err_t buffer_end(void *ctx) {
+  ((buffer_sink_t *)ctx)->ends++;
+  return ESP_OK;
+}
+
+// Walks the frames in buf, checks each CRC and reassembles one transfer.
+// Returns the number of frames, or -1 on any inconsistency.
+static int reassemble(const uint8_t *buf, size_t len, uint8_t *out, size_t *out_len, usb_frame_header_t *first) {
+  size_t pos = 0;
+  size_t got = 0;
+  int frames = 0;
+  while (pos < len) {
+    usb_frame_header_t h;
+    if (len - pos < USB_FRAME_HEADER_BYTES + USB_FRAME_TRAILER_BYTES || !usb_frame_parse_header(buf + pos, &h) ||
+        len - pos < USB_FRAME_HEADER_BYTES + h.len + USB_FRAME_TRAILER_BYTES) {
+      return -1;
+    }
+    const uint8_t *t = buf + pos + USB_FRAME_HEADER_BYTES + h.len;
+    uint32_t crc = (uint32_t)t[0] | ((uint32_t)t[1] << 8) | ((uint32_t)t[2] << 16) | ((uint32_t)t[3] << 24);
+    if (crc != usb_frame_crc32(0, buf + pos, USB_FRAME_HEADER_BYTES + h.len) || h.offset != got) {
+      return -1;
+    }
+    if (frames == 0) {
+      *first = h;
+      if (!(h.flags & USB_FRAME_FLAG_FIRST)) {
+        return -1;
+      }
+    } else if (h.seq != first->seq || h.type != first->type || (h.flags & USB_FRAME_FLAG_FIRST)) {
+      return -1;
+    }
+    memcpy(out + got, buf + pos + USB_FRAME_HEADER_BYTES, h.len);
+    got += h.len;
+    pos += USB_FRAME_HEADER_BYTES + h.len + USB_FRAME_TRAILER_BYTES;
+    frames++;
+    if (h.flags & USB_FRAME_FLAG_LAST) {
+      break;
+    }
+  }
+  *out_len = got;
+  return pos == len ? frames : -1;
+}
+
+TEST_CASE("USB frame CRC-32 matches zlib", "[usb_frame]")
+{
+  TEST_ASSERT_EQUAL_HEX32(0xCBF43926U, usb_frame_crc32(0, "123456789", 9));
+  // Incremental use gives the same result.
+  uint32_t crc = usb_frame_crc32(0, "1234", 4);
+  TEST_ASSERT_EQUAL_HEX32(0xCBF43926U, usb_frame_crc32(crc, "56789", 5));
+  TEST_ASSERT_EQUAL_HEX32(0, usb_frame_crc32(0, NULL, 0));
+}
+
+TEST_CASE("USB frame header round trip and validation", "[usb_frame]")
+{
+  usb_frame_header_t h = {.type = USB_FRAME_AUDIO, .flags = USB_FRAME_FLAG_LAST, .seq = 0xBEEF, .len = 100,
+                          .offset = 70000, .total = 70100};
+  uint8_t raw[USB_FRAME_HEADER_BYTES];
+  usb_frame_pack_header(&h, raw);
+  TEST_ASSERT_EQUAL_HEX8(USB_FRAME_MAGIC0, raw[0]);
+  TEST_ASSERT_EQUAL_HEX8(USB_FRAME_MAGIC1, raw[1]);
+
+  usb_frame_header_t back;
+  TEST_ASSERT_TRUE(usb_frame_parse_header(raw, &back));
+  TEST_ASSERT_EQUAL_MEMORY(&h, &back, sizeof(h));
+
+  // Payload past the end of the transfer, oversized payload, wrong version.
+  h.total = 70050;
+  usb_frame_pack_header(&h, raw);
+  TEST_ASSERT_FALSE(usb_frame_parse_header(raw, &back));
+  h.total = 1000000;
+  h.len = USB_FRAME_MAX_PAYLOAD + 1;
+  usb_frame_pack_header(&h, raw);
+  TEST_ASSERT_FALSE(usb_frame_parse_header(raw, &back));
+  h.len = 10;
+  usb_frame_pack_header(&h, raw);
+  raw[2] ^= 0x30;
+  TEST_ASSERT_FALSE(usb_frame_parse_header(raw, &back));
+}
+
+TEST_CASE("USB frame sender streams chunks that reassemble exactly", "[usb_frame]")
+{
+  const size_t len = 10000;
+  uint8_t *data = malloc(len);
+  uint8_t *back = malloc(len);
+  buffer_sink_t sink = {.cap = len + 64 * (USB_FRAME_HEADER_BYTES + USB_FRAME_TRAILER_BYTES)};
+  sink.out = malloc(sink.cap);
+  TEST_ASSERT_NOT_NULL(data);
+  TEST_ASSERT_NOT_NULL(back);
+  TEST_ASSERT_NOT_NULL(sink.out);
+  for (size_t i = 0; i < len; i++) {
+    data[i] = (uint8_t)(i * 7 + (i >> 8));
+  }
+
+  usb_frame_sender_t s = {.write = buffer_write, .frame_begin = buffer_begin, .frame_end = buffer_end,
+                          .ctx = &sink, .chunk_bytes = 1000, .next_seq = 41};
+  TEST_ESP_OK(usb_frame_send(&s, USB_FRAME_IMAGE, data, len));
+  TEST_ASSERT_EQUAL(len + 10 * (USB_FRAME_HEADER_BYTES + USB_FRAME_TRAILER_BYTES), sink.len);
+  TEST_ASSERT_EQUAL(10, sink.begins);
+  TEST_ASSERT_EQUAL(10, sink.ends);
+
+  usb_frame_header_t first;
+  size_t back_len = 0;
+  TEST_ASSERT_EQUAL(10, reassemble(sink.out, sink.len, back, &back_len, &first));
+  TEST_ASSERT_EQUAL(len, back_len);
+  TEST_ASSERT_EQUAL_MEMORY(data, back, len);
+  TEST_ASSERT_EQUAL(41, first.seq);
+  TEST_ASSERT_EQUAL(USB_FRAME_IMAGE, first.type);
+  TEST_ASSERT_EQUAL(len, first.total);
+
+  // A flipped payload bit fails the CRC.
+  sink.out[USB_FRAME_HEADER_BYTES + 500] ^= 0x04;
+  TEST_ASSERT_EQUAL(-1, reassemble(sink.out, sink.len, back, &back_len, &first));
+
+  // Empty transfers are one empty frame; the sequence number advances.
+  sink.len = 0;
+  TEST_ESP_OK(usb_frame_send(&s, USB_FRAME_TELEMETRY, NULL, 0));
+  TEST_ASSERT_EQUAL(1, reassemble(sink.out, sink.len, back, &back_len, &first));
+  TEST_ASSERT_EQUAL(0, back_len);
+  TEST_ASSERT_EQUAL(42, first.seq);
+  TEST_ASSERT_EQUAL(USB_FRAME_FLAG_FIRST | USB_FRAME_FLAG_LAST, first.flags);
+
+  // Write errors stop the transfer and still close the open frame.
+  sink.len = 0;
+  sink.begins = sink.ends = 0;
+  sink.fail_after = 2500;
+  TEST_ASSERT_EQUAL(ESP_FAIL, usb_frame_send(&s, USB_FRAME_IMAGE, data, len));
+  TEST_ASSERT_EQUAL(sink.begins, sink.ends);
+  TEST_ASSERT_EQUAL(3, sink.ends);
+
+  free(data);
+  free(back);
+  free(sink.out);
+}
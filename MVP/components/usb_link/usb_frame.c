@@ -0,0 +1,117 @@
+#include "usb_frame.h"
+
+// Nibble-wise CRC-32 (reflected 0xEDB88320): a 64-byte table, no init, and
+// still far faster than the USB link.
+static const uint32_t s_crc_nibble[16] = {
+    0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU,
+    0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+    0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU,
+    0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU,
+};
+
+uint32_t usb_frame_crc32(uint32_t crc, const void *data, size_t len) {
+  const uint8_t *p = (const uint8_t *)data;
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= p[i];
+    crc = s_crc_nibble[crc & 0x0FU] ^ (crc >> 4);
+    crc = s_crc_nibble[crc & 0x0FU] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+static void put_le16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_le32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_le32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void usb_frame_pack_header(const usb_frame_header_t *h, uint8_t out[USB_FRAME_HEADER_BYTES]) {
+  out[0] = USB_FRAME_MAGIC0;
+  out[1] = USB_FRAME_MAGIC1;
+  out[2] = (uint8_t)((USB_FRAME_VERSION << 4) | (h->type & 0x0FU));
+  out[3] = h->flags;
+  put_le16(out + 4, h->seq);
+  put_le16(out + 6, h->len);
+  put_le32(out + 8, h->offset);
+  put_le32(out + 12, h->total);
+}
+
+bool usb_frame_parse_header(const uint8_t in[USB_FRAME_HEADER_BYTES], usb_frame_header_t *h) {
+  if (in[0] != USB_FRAME_MAGIC0 || in[1] != USB_FRAME_MAGIC1 || (in[2] >> 4) != USB_FRAME_VERSION) {
+    return false;
+  }
+  h->type = in[2] & 0x0FU;
+  h->flags = in[3];
+  h->seq = get_le16(in + 4);
+  h->len = get_le16(in + 6);
+  h->offset = get_le32(in + 8);
+  h->total = get_le32(in + 12);
+  return h->len <= USB_FRAME_MAX_PAYLOAD && h->offset <= h->total && h->total - h->offset >= h->len;
+}
+
+esp_err_t usb_frame_send(usb_frame_sender_t *s, usb_frame_type_t type, const void *data, size_t len) {
+  if (!s || !s->write || (!data && len > 0) || len > UINT32_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  size_t chunk = s->chunk_bytes ? s->chunk_bytes : USB_FRAME_MAX_PAYLOAD;
+  if (chunk > USB_FRAME_MAX_PAYLOAD) {
+    chunk = USB_FRAME_MAX_PAYLOAD;
+  }
+  const uint8_t *src = (const uint8_t *)data;
+  uint16_t seq = s->next_seq++;
+  size_t off = 0;
+
+  do {
+    size_t n = len - off < chunk ? len - off : chunk;
+    usb_frame_header_t h = {
+        .type = (uint8_t)type,
+        .flags = (uint8_t)((off == 0 ? USB_FRAME_FLAG_FIRST : 0U) | (off + n == len ? USB_FRAME_FLAG_LAST : 0U)),
+        .seq = seq,
+        .len = (uint16_t)n,
+        .offset = (uint32_t)off,
+        .total = (uint32_t)len,
+    };
+    uint8_t header[USB_FRAME_HEADER_BYTES];
+    uint8_t trailer[USB_FRAME_TRAILER_BYTES];
+    usb_frame_pack_header(&h, header);
+    uint32_t crc = usb_frame_crc32(0, header, sizeof(header));
+    crc = usb_frame_crc32(crc, src + off, n);
+    put_le32(trailer, crc);
+
+    if (s->frame_begin) {
+      s->frame_begin(s->ctx);
+    }
+    esp_err_t err = s->write(s->ctx, header, sizeof(header));
+    if (err == ESP_OK && n > 0) {
+      err = s->write(s->ctx, src + off, n);
+    }
+    if (err == ESP_OK) {
+      err = s->write(s->ctx, trailer, sizeof(trailer));
+    }
+    if (s->frame_end) {
+      esp_err_t end_err = s->frame_end(s->ctx);
+      err = err == ESP_OK ? end_err : err;
+    }
+    if (err != ESP_OK) {
+      return err;
+    }
+    off += n;
+  } while (off < len);
+  return ESP_OK;
+}
@@ -0,0 +1,109 @@
+#include "usb_link.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "driver/uart_vfs.h"
+#include "driver/usb_serial_jtag.h"
+#include "driver/usb_serial_jtag_vfs.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "USB_LINK";
+
+// Driver TX ring; frames are written through it in pieces, so it does not
+// need to hold a whole frame.
+#define USB_LINK_TX_BUFFER_BYTES 4096
+
+static SemaphoreHandle_t s_lock = NULL;
+static usb_frame_sender_t s_sender;
+static usb_link_stats_t s_stats;
+static uint64_t s_frame_bytes;
+
+static void stdout_frame_begin(void *ctx) {
+  (void)ctx;
+  flockfile(stdout);
+}
+
+static esp_err_t stdout_write(void *ctx, const void *data, size_t len) {
+  (void)ctx;
+  s_frame_bytes += len;
+  return fwrite(data, 1, len, stdout) == len ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t stdout_frame_end(void *ctx) {
+  (void)ctx;
+  int rc = fflush(stdout);
+  funlockfile(stdout);
+  return rc == 0 ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t usb_link_init(void) {
+  if (s_lock) {
+    return ESP_OK;
+  }
+
+#if CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG || CONFIG_ESP_CONSOLE_SECONDARY_USB_SERIAL_JTAG
+  if (!usb_serial_jtag_is_driver_installed()) {
+    usb_serial_jtag_driver_config_t jtag_cfg = USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT();
+    jtag_cfg.tx_buffer_size = USB_LINK_TX_BUFFER_BYTES;
+    esp_err_t err = usb_serial_jtag_driver_install(&jtag_cfg);
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "usb_serial_jtag_driver_install failed: %s", esp_err_to_name(err));
+      return err;
+    }
+    usb_serial_jtag_vfs_use_driver();
+  }
+  usb_serial_jtag_vfs_set_tx_line_endings(ESP_LINE_ENDINGS_LF);
+#endif
+#if CONFIG_ESP_CONSOLE_UART
+  uart_vfs_dev_port_set_tx_line_endings(CONFIG_ESP_CONSOLE_UART_NUM, ESP_LINE_ENDINGS_LF);
+#endif
+
+  s_lock = xSemaphoreCreateMutex();
+  if (!s_lock) {
+    return ESP_ERR_NO_MEM;
+  }
+  s_sender = (usb_frame_sender_t){
+      .write = stdout_write,
+      .frame_begin = stdout_frame_begin,
+      .frame_end = stdout_frame_end,
+      .chunk_bytes = USB_FRAME_MAX_PAYLOAD,
+  };
+  return ESP_OK;
+}
+
+esp_err_t usb_link_send(usb_frame_type_t type, const void *data, size_t len) {
+  if (!s_lock) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  // One transfer at a time keeps sequence numbers and frames in order;
+  // log lines from other tasks still fit between frames.
+  xSemaphoreTake(s_lock, portMAX_DELAY);
+  int64_t t0 = esp_timer_get_time();
+  s_frame_bytes = 0;
+  esp_err_t err = usb_frame_send(&s_sender, type, data, len);
+  uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+
+  if (err == ESP_OK) {
+    s_stats.transfers++;
+    s_stats.payload_bytes += len;
+    s_stats.last_us = us;
+    s_stats.last_kb_per_s = us ? (uint32_t)((uint64_t)len * 1000U / us) : 0;
+  } else {
+    s_stats.failures++;
+  }
+  s_stats.wire_bytes += s_frame_bytes;
+  xSemaphoreGive(s_lock);
+  return err;
+}
+
+void usb_link_get_stats(usb_link_stats_t *out) {
+  if (out) {
+    *out = s_stats;
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Pre-trigger ring of variable-size JPEG frames.
+//
+// Frames are copied into one caller-provided arena (PSRAM on the device) and
+// kept contiguous: a frame that does not fit before the end of the arena
+// starts again at offset 0, and the oldest frames are evicted until the new
+// one has room. Per-frame bookkeeping lives in a fixed slot array, so pushing
+// a frame never allocates. Pure C with no IDF dependencies, so it builds on
+// the host (tools/jpeg_ring_bench.c). Not thread safe: the task that pushes
+// frames also reads and resets the ring.
+
+#define JPEG_RING_ALIGN 4U
+
+typedef struct {
+  uint32_t offset;
+  uint32_t len;
+  int64_t timestamp_us;
+  uint32_t seq;
+} jpeg_ring_slot_t;
+
+typedef struct {
+  const uint8_t *data;  // valid until the frame is evicted or the ring reset
+  size_t len;
+  int64_t timestamp_us;
+  uint32_t seq;
+} jpeg_ring_frame_t;
+
+typedef struct {
+  uint32_t pushed;
+  uint32_t evicted;
+  uint32_t rejected;  // larger than the arena
+} jpeg_ring_stats_t;
+
+typedef struct {
+  uint8_t *arena;
+  size_t arena_bytes;
+  jpeg_ring_slot_t *slots;
+  size_t max_frames;
+  size_t first;      // slot index of the oldest frame
+  size_t count;      // frames held
+  size_t write_pos;  // arena offset just past the newest frame
+  size_t reserved;   // bytes handed out by jpeg_ring_reserve(), 0 if none
+  uint32_t next_seq;
+  jpeg_ring_stats_t stats;
+} jpeg_ring_t;
+
+// arena must be JPEG_RING_ALIGN aligned; slots holds max_frames entries.
+// Both stay owned by the caller. Returns false on bad arguments.
+bool jpeg_ring_init(jpeg_ring_t *ring, void *arena, size_t arena_bytes, jpeg_ring_slot_t *slots,
+                    size_t max_frames);
+void jpeg_ring_reset(jpeg_ring_t *ring);
+
+// Zero-copy insert: reserve len bytes (evicting as needed), fill them, then
+// jpeg_ring_commit(). Returns NULL if len is 0 or larger than the arena.
+void *jpeg_ring_reserve(jpeg_ring_t *ring, size_t len);
+void jpeg_ring_commit(jpeg_ring_t *ring, int64_t timestamp_us);
+// Copying insert; false if the frame can never fit.
+bool jpeg_ring_push(jpeg_ring_t *ring, const void *data, size_t len, int64_t timestamp_us);
+
+size_t jpeg_ring_count(const jpeg_ring_t *ring);
+// index 0 is the oldest frame held.
+bool jpeg_ring_get(const jpeg_ring_t *ring, size_t index, jpeg_ring_frame_t *out);
+// Index of the first frame with timestamp_us >= since_us (count if none).
+size_t jpeg_ring_find(const jpeg_ring_t *ring, int64_t since_us);
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Block-wise frame differencing against a running background, used to
+// confirm PIR triggers before a capture is stored.
+//
+// Works on small grayscale frames (the JPEG decoded at 1/8 scale: 40x30 for
+// QVGA). Each block's mean absolute difference from the background decides
+// whether it changed; the frame shows motion when the changed blocks cover
+// at least area_permille of the image. The background follows the scene at
+// 1/2^bg_shift per frame where nothing changed and four times slower where
+// something did, so a moved branch is absorbed but a passing animal is not.
+//
+// Pure C with no IDF dependencies; tools/motion_bench.c runs it on the host.
+
+#define MOTION_MAX_WIDTH 256U
+
+typedef struct {
+  uint16_t width;
+  uint16_t height;
+  uint8_t block;             // block edge in pixels
+  uint8_t pixel_threshold;   // block mean |diff| that marks it changed
+  uint16_t area_permille;    // changed area needed to report motion
+  uint8_t bg_shift;          // background learning rate, 1/2^bg_shift
+  bool compensate_brightness;  // remove the global mean shift (clouds, AEC)
+} motion_config_t;
+
+typedef struct {
+  motion_config_t cfg;
+  uint8_t *background;  // width * height, owned by the caller
+  bool primed;
+} motion_detect_t;
+
+typedef struct {
+  uint16_t changed_blocks;
+  uint16_t total_blocks;
+  uint16_t changed_permille;
+  uint8_t max_block_mad;  // largest block mean |diff|
+  int8_t brightness_offset;  // mean(frame) - mean(background) removed
+  bool motion;
+} motion_result_t;
+
+void motion_default_config(motion_config_t *cfg, uint16_t width, uint16_t height);
+// background must hold width * height bytes. Returns false if the config is
+// unusable (zero or too wide frame, zero block).
+bool motion_init(motion_detect_t *md, const motion_config_t *cfg, uint8_t *background);
+// Forgets the background; the next frame becomes the new one.
+void motion_reset(motion_detect_t *md);
+
+// Compares gray (width * height) with the background and, when learn is set,
+// updates the background from it. The first frame after init/reset only
+// primes the background and reports no motion.
+void motion_process(motion_detect_t *md, const uint8_t *gray, bool learn, motion_result_t *out);
+
+// Luma from native-endian RGB565 (jpg2rgb565 output), count pixels.
+void motion_gray_from_rgb565(const uint16_t *src, uint8_t *dst, size_t count);
+
+// Inner kernel, exposed for benchmarking: acc[i] += |a[i] - b[i] - offset|.
+// Branch-free over non-aliasing arrays so compilers vectorise it at -O3.
+void motion_accumulate_absdiff(const uint8_t *restrict a, const uint8_t *restrict b, int offset,
+                               uint16_t *restrict acc, size_t n);
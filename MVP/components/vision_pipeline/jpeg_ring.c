@@ -0,0 +1,147 @@
+#include "jpeg_ring.h"
+
+#include <string.h>
+
+static inline size_t align_up(size_t len) {
+  return (len + JPEG_RING_ALIGN - 1U) & ~(size_t)(JPEG_RING_ALIGN - 1U);
+}
+
+static inline jpeg_ring_slot_t *slot_at(const jpeg_ring_t *ring, size_t index) {
+  size_t pos = ring->first + index;
+  if (pos >= ring->max_frames) {
+    pos -= ring->max_frames;
+  }
+  return &ring->slots[pos];
+}
+
+static void evict_oldest(jpeg_ring_t *ring) {
+  ring->first = ring->first + 1 == ring->max_frames ? 0 : ring->first + 1;
+  ring->count--;
+  ring->stats.evicted++;
+}
+
+// Offset where a frame of size bytes can go, evicting the oldest frames
+// until it fits. The live frames occupy [oldest, write_pos) circularly; the
+// free space is either [write_pos, end) plus [0, oldest) when the live run
+// does not wrap, or [write_pos, oldest) when it does.
+static size_t make_room(jpeg_ring_t *ring, size_t size) {
+  while (true) {
+    if (ring->count == 0) {
+      ring->write_pos = 0;
+      return 0;
+    }
+    if (ring->count < ring->max_frames) {
+      size_t oldest = slot_at(ring, 0)->offset;
+      if (oldest < ring->write_pos) {
+        if (ring->write_pos + size <= ring->arena_bytes) {
+          return ring->write_pos;
+        }
+        if (size <= oldest) {
+          return 0;
+        }
+      } else if (ring->write_pos + size <= oldest) {
+        return ring->write_pos;
+      }
+    }
+    evict_oldest(ring);
+  }
+}
+
+bool jpeg_ring_init(jpeg_ring_t *ring, void *arena, size_t arena_bytes, jpeg_ring_slot_t *slots,
+                    size_t max_frames) {
+  if (!ring || !arena || !slots || max_frames == 0 || ((uintptr_t)arena % JPEG_RING_ALIGN) != 0) {
+    return false;
+  }
+  arena_bytes &= ~(size_t)(JPEG_RING_ALIGN - 1U);
+  if (arena_bytes == 0 || arena_bytes > UINT32_MAX) {
+    return false;
+  }
+  memset(ring, 0, sizeof(*ring));
+  ring->arena = (uint8_t *)arena;
+  ring->arena_bytes = arena_bytes;
+  ring->slots = slots;
+  ring->max_frames = max_frames;
+  return true;
+}
+
+void jpeg_ring_reset(jpeg_ring_t *ring) {
+  ring->first = 0;
+  ring->count = 0;
+  ring->write_pos = 0;
+  ring->reserved = 0;
+}
+
+void *jpeg_ring_reserve(jpeg_ring_t *ring, size_t len) {
+  if (!ring || !ring->arena || len == 0 || align_up(len) > ring->arena_bytes) {
+    if (ring) {
+      ring->stats.rejected++;
+    }
+    return NULL;
+  }
+  size_t offset = make_room(ring, align_up(len));
+  jpeg_ring_slot_t *slot = slot_at(ring, ring->count);
+  slot->offset = (uint32_t)offset;
+  slot->len = (uint32_t)len;
+  ring->reserved = len;
+  return ring->arena + offset;
+}
+
+void jpeg_ring_commit(jpeg_ring_t *ring, int64_t timestamp_us) {
+  if (!ring || ring->reserved == 0) {
+    return;
+  }
+  jpeg_ring_slot_t *slot = slot_at(ring, ring->count);
+  slot->timestamp_us = timestamp_us;
+  slot->seq = ring->next_seq++;
+  ring->write_pos = slot->offset + align_up(slot->len);
+  ring->count++;
+  ring->reserved = 0;
+  ring->stats.pushed++;
+}
+
+bool jpeg_ring_push(jpeg_ring_t *ring, const void *data, size_t len, int64_t timestamp_us) {
+  if (!data) {
+    return false;
+  }
+  void *dst = jpeg_ring_reserve(ring, len);
+  if (!dst) {
+    return false;
+  }
+  memcpy(dst, data, len);
+  jpeg_ring_commit(ring, timestamp_us);
+  return true;
+}
+
+size_t jpeg_ring_count(const jpeg_ring_t *ring) {
+  return ring ? ring->count : 0;
+}
+
+bool jpeg_ring_get(const jpeg_ring_t *ring, size_t index, jpeg_ring_frame_t *out) {
+  if (!ring || !out || index >= ring->count) {
+    return false;
+  }
+  const jpeg_ring_slot_t *slot = slot_at(ring, index);
+  out->data = ring->arena + slot->offset;
+  out->len = slot->len;
+  out->timestamp_us = slot->timestamp_us;
+  out->seq = slot->seq;
+  return true;
+}
+
+size_t jpeg_ring_find(const jpeg_ring_t *ring, int64_t since_us) {
+  if (!ring) {
+    return 0;
+  }
+  // Timestamps are pushed in order, so binary search the slot run.
+  size_t lo = 0;
+  size_t hi = ring->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (slot_at(ring, mid)->timestamp_us < since_us) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
@@ -0,0 +1,133 @@
+#include "motion_detect.h"
+
+#include <string.h>
+
+void motion_default_config(motion_config_t *cfg, uint16_t width, uint16_t height) {
+  cfg->width = width;
+  cfg->height = height;
+  cfg->block = 4;
+  cfg->pixel_threshold = 18;
+  cfg->area_permille = 20;  // 2%: two of the 70 4x4 blocks of a 40x30 frame
+  cfg->bg_shift = 3;
+  cfg->compensate_brightness = true;
+}
+
+bool motion_init(motion_detect_t *md, const motion_config_t *cfg, uint8_t *background) {
+  if (!md || !cfg || !background || cfg->width == 0 || cfg->height == 0 || cfg->width > MOTION_MAX_WIDTH ||
+      cfg->block == 0 || cfg->block > cfg->width || cfg->block > cfg->height || cfg->bg_shift > 6) {
+    return false;
+  }
+  md->cfg = *cfg;
+  md->background = background;
+  md->primed = false;
+  return true;
+}
+
+void motion_reset(motion_detect_t *md) {
+  md->primed = false;
+}
+
+void motion_gray_from_rgb565(const uint16_t *src, uint8_t *dst, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    uint32_t p = src[i];
+    uint32_t r = (p >> 11) & 0x1FU;
+    uint32_t g = (p >> 5) & 0x3FU;
+    uint32_t b = p & 0x1FU;
+    // BT.601 weights with the 5/6-bit channels widened to 8 bits:
+    // (77*R8 + 150*G8 + 29*B8) >> 8 with R8 = r*255/31 etc., folded.
+    dst[i] = (uint8_t)((r * 633U + g * 607U + b * 239U) >> 8);
+  }
+}
+
+void motion_accumulate_absdiff(const uint8_t *restrict a, const uint8_t *restrict b, int offset,
+                               uint16_t *restrict acc, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    int d = (int)a[i] - (int)b[i] - offset;
+    acc[i] = (uint16_t)(acc[i] + (uint16_t)(d < 0 ? -d : d));
+  }
+}
+
+static uint32_t sum_u8(const uint8_t *p, size_t n) {
+  uint32_t s = 0;
+  for (size_t i = 0; i < n; i++) {
+    s += p[i];
+  }
+  return s;
+}
+
+// Moves the background toward the frame for one block; rounding away from
+// zero so it always converges on a still scene.
+static void learn_block(uint8_t *bg, const uint8_t *cur, size_t stride, uint8_t bw, uint8_t bh, uint8_t shift) {
+  int round = (1 << shift) - 1;
+  for (uint8_t y = 0; y < bh; y++) {
+    for (uint8_t x = 0; x < bw; x++) {
+      int d = (int)cur[x] - (int)bg[x];
+      bg[x] = (uint8_t)((int)bg[x] + (d >= 0 ? (d + round) >> shift : -((-d + round) >> shift)));
+    }
+    bg += stride;
+    cur += stride;
+  }
+}
+
+void motion_process(motion_detect_t *md, const uint8_t *gray, bool learn, motion_result_t *out) {
+  const motion_config_t *c = &md->cfg;
+  const size_t w = c->width;
+  const size_t pixels = w * c->height;
+  const uint8_t blk = c->block;
+  const size_t bx_count = w / blk;
+  const size_t by_count = c->height / blk;
+
+  memset(out, 0, sizeof(*out));
+  out->total_blocks = (uint16_t)(bx_count * by_count);
+  if (!md->primed) {
+    memcpy(md->background, gray, pixels);
+    md->primed = true;
+    return;
+  }
+
+  int offset = 0;
+  if (c->compensate_brightness) {
+    int64_t delta = (int64_t)sum_u8(gray, pixels) - (int64_t)sum_u8(md->background, pixels);
+    offset = (int)(delta / (int64_t)pixels);
+    offset = offset > 127 ? 127 : (offset < -128 ? -128 : offset);
+    out->brightness_offset = (int8_t)offset;
+  }
+
+  // One band of block rows at a time: the kernel sums |diff| per column,
+  // then the columns are folded into blocks. Pixels right of or below the
+  // last whole block are ignored.
+  uint16_t acc[MOTION_MAX_WIDTH];
+  const uint32_t limit = (uint32_t)c->pixel_threshold * blk * blk;
+  const uint8_t learn_shift = c->bg_shift;
+  for (size_t by = 0; by < by_count; by++) {
+    const size_t row0 = by * blk * w;
+    memset(acc, 0, bx_count * blk * sizeof(acc[0]));
+    for (size_t y = 0; y < blk; y++) {
+      motion_accumulate_absdiff(gray + row0 + y * w, md->background + row0 + y * w, offset, acc, bx_count * blk);
+    }
+    for (size_t bx = 0; bx < bx_count; bx++) {
+      uint32_t sad = 0;
+      for (size_t x = 0; x < blk; x++) {
+        sad += acc[bx * blk + x];
+      }
+      uint32_t mad = sad / ((uint32_t)blk * blk);
+      if (mad > out->max_block_mad) {
+        out->max_block_mad = (uint8_t)(mad > 255U ? 255U : mad);
+      }
+      bool changed = sad > limit;
+      if (changed) {
+        out->changed_blocks++;
+      }
+      if (learn) {
+        size_t off = row0 + bx * blk;
+        learn_block(md->background + off, gray + off, w, blk, blk,
+                    (uint8_t)(changed ? learn_shift + 2U : learn_shift));
+      }
+    }
+  }
+
+  if (out->total_blocks > 0) {
+    out->changed_permille = (uint16_t)((uint32_t)out->changed_blocks * 1000U / out->total_blocks);
+  }
+  out->motion = out->changed_blocks > 0 && out->changed_permille >= c->area_permille;
+}
@@ -0,0 +1,142 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "jpeg_ring.h"
+
+typedef struct {
+  jpeg_ring_t ring;
+  uint32_t *arena;
+  jpeg_ring_slot_t *slots;
+} test_ring_t;
+
+static jpeg_ring_t *ring_open(test_ring_t *t, size_t arena_bytes, size_t max_frames) {
+  t->arena = malloc(arena_bytes);
+  t->slots = calloc(max_frames, sizeof(jpeg_ring_slot_t));
+  TEST_ASSERT_NOT_NULL(t->arena);
+  TEST_ASSERT_NOT_NULL(t->slots);
+  TEST_ASSERT_TRUE(jpeg_ring_init(&t->ring, t->arena, arena_bytes, t->slots, max_frames));
+  return &t->ring;
+}
+
+static void ring_close(test_ring_t *t) {
+  free(t->arena);
+  free(t->slots);
+}
+
+// Every byte of frame seq is derived from seq, so a frame that was partly
+// overwritten by a later one is detected.
+static void fill_frame(uint8_t *buf, size_t len, uint32_t seq) {
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = (uint8_t)(seq * 31U + i);
+  }
+}
+
+static void check_ring(const jpeg_ring_t *ring) {
+  uint32_t prev_seq = 0;
+  for (size_t i = 0; i < jpeg_ring_count(ring); i++) {
+    jpeg_ring_frame_t f;
+    TEST_ASSERT_TRUE(jpeg_ring_get(ring, i, &f));
+    TEST_ASSERT_TRUE(f.data >= ring->arena && f.data + f.len <= ring->arena + ring->arena_bytes);
+    TEST_ASSERT_EQUAL_UINT32(0, (uintptr_t)(f.data - ring->arena) % JPEG_RING_ALIGN);
+    if (i > 0) {
+      TEST_ASSERT_EQUAL_UINT32(prev_seq + 1, f.seq);
+    }
+    prev_seq = f.seq;
+    for (size_t b = 0; b < f.len; b++) {
+      if (f.data[b] != (uint8_t)(f.seq * 31U + b)) {
+        TEST_FAIL_MESSAGE("frame payload corrupted");
+      }
+    }
+  }
+}
+
+TEST_CASE("JPEG ring keeps the newest frames intact across wrap", "[jpeg_ring]")
+{
+  test_ring_t t;
+  jpeg_ring_t *ring = ring_open(&t, 64 * 1024, 32);
+  uint8_t *buf = malloc(20000);
+  TEST_ASSERT_NOT_NULL(buf);
+
+  srand(7);
+  size_t total = 0;
+  for (uint32_t seq = 0; seq < 500; seq++) {
+    size_t len = 1000 + (size_t)(rand() % 19000);
+    fill_frame(buf, len, seq);
+    TEST_ASSERT_TRUE(jpeg_ring_push(ring, buf, len, (int64_t)seq * 100000));
+    check_ring(ring);
+
+    // The newest frame is always held, and held frames never exceed the arena.
+    jpeg_ring_frame_t last;
+    TEST_ASSERT_TRUE(jpeg_ring_get(ring, jpeg_ring_count(ring) - 1, &last));
+    TEST_ASSERT_EQUAL_UINT32(seq, last.seq);
+    total = 0;
+    for (size_t i = 0; i < jpeg_ring_count(ring); i++) {
+      jpeg_ring_frame_t f;
+      jpeg_ring_get(ring, i, &f);
+      total += f.len;
+    }
+    TEST_ASSERT_TRUE(total <= ring->arena_bytes);
+  }
+  TEST_ASSERT_EQUAL_UINT32(500, ring->stats.pushed);
+  TEST_ASSERT_EQUAL_UINT32(500 - jpeg_ring_count(ring), ring->stats.evicted);
+  // Mixed 1-20 kB frames in 64 kB: at least a few frames must survive.
+  TEST_ASSERT_TRUE(jpeg_ring_count(ring) >= 3);
+
+  free(buf);
+  ring_close(&t);
+}
+
+TEST_CASE("JPEG ring evicts by frame count and finds by time", "[jpeg_ring]")
+{
+  test_ring_t t;
+  jpeg_ring_t *ring = ring_open(&t, 16 * 1024, 4);
+  uint8_t frame[100];
+  for (uint32_t seq = 0; seq < 10; seq++) {
+    fill_frame(frame, sizeof(frame), seq);
+    TEST_ASSERT_TRUE(jpeg_ring_push(ring, frame, sizeof(frame), 1000000LL + (int64_t)seq * 500000));
+  }
+  TEST_ASSERT_EQUAL(4, jpeg_ring_count(ring));
+  check_ring(ring);
+
+  jpeg_ring_frame_t f;
+  TEST_ASSERT_TRUE(jpeg_ring_get(ring, 0, &f));
+  TEST_ASSERT_EQUAL_UINT32(6, f.seq);
+  // Frames 6..9 are at 4.0, 4.5, 5.0, 5.5 s.
+  TEST_ASSERT_EQUAL(0, jpeg_ring_find(ring, 0));
+  TEST_ASSERT_EQUAL(2, jpeg_ring_find(ring, 4800000));
+  TEST_ASSERT_EQUAL(2, jpeg_ring_find(ring, 5000000));
+  TEST_ASSERT_EQUAL(4, jpeg_ring_find(ring, 6000000));
+  TEST_ASSERT_FALSE(jpeg_ring_get(ring, 4, &f));
+
+  jpeg_ring_reset(ring);
+  TEST_ASSERT_EQUAL(0, jpeg_ring_count(ring));
+  ring_close(&t);
+}
+
+TEST_CASE("JPEG ring reserve/commit and oversize frames", "[jpeg_ring]")
+{
+  test_ring_t t;
+  jpeg_ring_t *ring = ring_open(&t, 4096, 8);
+
+  uint8_t *dst = jpeg_ring_reserve(ring, 3000);
+  TEST_ASSERT_NOT_NULL(dst);
+  fill_frame(dst, 3000, 0);
+  jpeg_ring_commit(ring, 1);
+  TEST_ASSERT_EQUAL(1, jpeg_ring_count(ring));
+
+  // 2000 bytes fit neither after the first frame nor before it: it goes.
+  uint8_t frame[2000];
+  fill_frame(frame, sizeof(frame), 1);
+  TEST_ASSERT_TRUE(jpeg_ring_push(ring, frame, sizeof(frame), 2));
+  TEST_ASSERT_EQUAL(1, jpeg_ring_count(ring));
+  check_ring(ring);
+
+  TEST_ASSERT_NULL(jpeg_ring_reserve(ring, 0));
+  TEST_ASSERT_FALSE(jpeg_ring_push(ring, frame, 4097, 3));
+  TEST_ASSERT_EQUAL_UINT32(2, ring->stats.rejected);
+  TEST_ASSERT_EQUAL(1, jpeg_ring_count(ring));
+  ring_close(&t);
+}
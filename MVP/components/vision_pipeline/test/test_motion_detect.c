@@ -0,0 +1,143 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "motion_detect.h"
+
+#define W 40
+#define H 30
+
+// Deterministic textured scene so that block differences are not trivially
+// zero; noise adds +-amp per pixel on top of it.
+static void render_scene(uint8_t *img, uint32_t noise_seed, int amp, int brightness) {
+  uint32_t s = noise_seed;
+  for (int y = 0; y < H; y++) {
+    for (int x = 0; x < W; x++) {
+      int v = 60 + (x * 3 + y * 2) % 90 + brightness;
+      if (amp > 0) {
+        s = s * 1664525U + 1013904223U;
+        v += (int)((s >> 24) % (uint32_t)(2 * amp + 1)) - amp;
+      }
+      img[y * W + x] = (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+    }
+  }
+}
+
+static void draw_square(uint8_t *img, int x0, int y0, int size, uint8_t value) {
+  for (int y = y0; y < y0 + size && y < H; y++) {
+    for (int x = x0; x < x0 + size && x < W; x++) {
+      img[y * W + x] = value;
+    }
+  }
+}
+
+static motion_detect_t *open_detector(motion_detect_t *md, uint8_t *bg) {
+  motion_config_t cfg;
+  motion_default_config(&cfg, W, H);
+  TEST_ASSERT_TRUE(motion_init(md, &cfg, bg));
+  return md;
+}
+
+TEST_CASE("Motion detect ignores sensor noise and confirms a moving object", "[motion_detect]")
+{
+  static uint8_t bg[W * H];
+  static uint8_t frame[W * H];
+  motion_detect_t md;
+  motion_result_t r;
+  open_detector(&md, bg);
+
+  render_scene(frame, 1, 0, 0);
+  motion_process(&md, frame, true, &r);
+  TEST_ASSERT_FALSE(r.motion);
+  TEST_ASSERT_EQUAL(70, r.total_blocks);  // 10x7, the last two rows are unused
+
+  for (uint32_t i = 0; i < 20; i++) {
+    render_scene(frame, 100 + i, 6, 0);
+    motion_process(&md, frame, true, &r);
+    TEST_ASSERT_FALSE(r.motion);
+    TEST_ASSERT_EQUAL(0, r.changed_blocks);
+  }
+
+  // An 8x8 object covers four of 70 blocks, over the default 2% threshold.
+  render_scene(frame, 200, 6, 0);
+  draw_square(frame, 16, 12, 8, 250);
+  motion_process(&md, frame, true, &r);
+  TEST_ASSERT_TRUE(r.motion);
+  TEST_ASSERT_TRUE(r.changed_blocks >= 4);
+  TEST_ASSERT_TRUE(r.max_block_mad > 50);
+
+  // A single changed 4x4 block (1.4%) is below it.
+  render_scene(frame, 201, 6, 0);
+  draw_square(frame, 0, 0, 4, 250);
+  motion_process(&md, frame, false, &r);
+  TEST_ASSERT_EQUAL(1, r.changed_blocks);
+  TEST_ASSERT_FALSE(r.motion);
+}
+
+TEST_CASE("Motion detect compensates global brightness and adapts the background", "[motion_detect]")
+{
+  static uint8_t bg[W * H];
+  static uint8_t frame[W * H];
+  motion_detect_t md;
+  motion_result_t r;
+  open_detector(&md, bg);
+
+  render_scene(frame, 1, 0, 0);
+  motion_process(&md, frame, true, &r);
+
+  // A cloud or an exposure step shifts every pixel alike.
+  render_scene(frame, 2, 4, 30);
+  motion_process(&md, frame, false, &r);
+  TEST_ASSERT_FALSE(r.motion);
+  TEST_ASSERT_INT_WITHIN(2, 30, r.brightness_offset);
+
+  // Without compensation the same frame lights up everything.
+  md.cfg.compensate_brightness = false;
+  motion_process(&md, frame, false, &r);
+  TEST_ASSERT_TRUE(r.motion);
+  TEST_ASSERT_EQUAL(r.total_blocks, r.changed_blocks);
+  md.cfg.compensate_brightness = true;
+
+  // Something that stays put (a moved branch) is absorbed after a while.
+  render_scene(frame, 3, 0, 0);
+  draw_square(frame, 8, 8, 8, 240);
+  motion_process(&md, frame, true, &r);
+  TEST_ASSERT_TRUE(r.motion);
+  int frames = 1;
+  while (r.motion && frames < 200) {
+    motion_process(&md, frame, true, &r);
+    frames++;
+  }
+  TEST_ASSERT_FALSE(r.motion);
+  TEST_ASSERT_TRUE(frames > 5);
+
+  motion_reset(&md);
+  draw_square(frame, 24, 16, 8, 0);
+  motion_process(&md, frame, true, &r);
+  TEST_ASSERT_FALSE(r.motion);
+  TEST_ASSERT_EQUAL_MEMORY(frame, bg, sizeof(bg));
+}
+
+TEST_CASE("Motion detect gray conversion and config limits", "[motion_detect]")
+{
+  const uint16_t px[4] = {0x0000, 0xFFFF, 0xF800, 0x07E0};
+  uint8_t gray[4];
+  motion_gray_from_rgb565(px, gray, 4);
+  TEST_ASSERT_EQUAL_UINT8(0, gray[0]);
+  TEST_ASSERT_TRUE(gray[1] >= 253);
+  TEST_ASSERT_INT_WITHIN(2, 76, gray[2]);
+  TEST_ASSERT_INT_WITHIN(2, 150, gray[3]);
+
+  uint8_t bg[16];
+  motion_detect_t md;
+  motion_config_t cfg;
+  motion_default_config(&cfg, MOTION_MAX_WIDTH + 1, 2);
+  TEST_ASSERT_FALSE(motion_init(&md, &cfg, bg));
+  motion_default_config(&cfg, 4, 4);
+  cfg.block = 0;
+  TEST_ASSERT_FALSE(motion_init(&md, &cfg, bg));
+  cfg.block = 4;
+  TEST_ASSERT_FALSE(motion_init(&md, &cfg, NULL));
+  TEST_ASSERT_TRUE(motion_init(&md, &cfg, bg));
+}
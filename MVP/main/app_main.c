@@ -7,6 +7,7 @@
 #include "bsp_env.h"
 #include "bsp_gps.h"
 #include "bsp_storage.h"
+#include "usb_link.h"
 
 void sys_vision_task(void *pvParameters);
 void sys_audio_task(void *pvParameters);
@@ -18,6 +19,7 @@ static const char *TAG = "APP_MAIN";
 void app_main(void) {
   ESP_LOGI(TAG, "Field Node MVP starting");
 
+  (void)usb_link_init();
   (void)bsp_storage_init();
   (void)bsp_env_init();
   (void)bsp_gps_init();
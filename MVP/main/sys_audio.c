@@ -1,5 +1,12 @@
+#include "audio_codec.h"
+#include "audio_detect.h"
+#include "audio_pcm.h"
+#include "audio_spectral.h"
+#include "audio_ring.h"
+#include "audio_writer.h"
 #include "bsp_audio.h"
 #include "bsp_storage.h"
+#include "wav_writer.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -7,270 +14,358 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "esp_heap_caps.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 static const char *TAG = "SYS_AUDIO";
 
-// Keep Sean's lifecycle safety: init/deinit audio per monitoring cycle.
+typedef enum {
+  AUDIO_POLICY_TRIGGERED = 0,  // periodic monitor windows, pre-roll clips on events
+  AUDIO_POLICY_CONTINUOUS,     // I2S stays open, rolling fixed-length segments
+} audio_policy_t;
+
+static const audio_policy_t AUDIO_POLICY = AUDIO_POLICY_TRIGGERED;
+
+// Triggered policy keeps the I2S channel allocated and only suspends it
+// between monitoring cycles (clock off, mic asleep). Sean's lifecycle
+// safety is kept as the fallback: a failed resume tears the channel down
+// and the next cycle re-creates it.
 static const int64_t AUDIO_MONITOR_INTERVAL_MS = 2LL * 60LL * 60LL * 1000LL;
 static const int64_t AUDIO_MONITOR_WINDOW_MS = 60LL * 1000LL;
 static const int64_t AUDIO_TRIGGER_COOLDOWN_MS = 2000;
 
-// Rachel-inspired event capture settings.
-#define AUDIO_PRE_TRIGGER_SECONDS  5U
+// Rachel-inspired event capture settings. The ring stores PCM16 (converted
+// once at ingest), so 10 s of pre-trigger fits where 5 s of raw I2S words did.
+#define AUDIO_RING_FORMAT          AUDIO_SAMPLE_PCM16
+#define AUDIO_PRE_TRIGGER_SECONDS  10U
 #define AUDIO_POST_TRIGGER_SECONDS 3U
-#define AUDIO_READ_CHUNK_SAMPLES   512U
-#define AUDIO_EVENT_THRESHOLD      2500
-#define AUDIO_EVENT_HIT_COUNT      10U
+#define AUDIO_READ_CHUNK_SAMPLES   512U  // I2S words per read (all channels)
+
+// Capture profile (rate, slot width, channels, DMA geometry, gain). Defaults
+// to BSP_AUDIO_CONFIG_DEFAULT(); a deployment can override any field with
+// "key=value" lines (rate, slot_bits, channels, dma_desc, dma_frames, shift)
+// in this file on the card, without rebuilding.
+#define AUDIO_PROFILE_PATH         "/sdcard/config/audio.txt"
+
+// Optional band-limited trigger (default band 2-8 kHz, birdsong), off by
+// default so any loud event starts a clip. When set to 1, events need energy
+// above the band's own floor instead: wind and handling noise stop
+// triggering, and so does anything loud outside the band. Broadband SNR is
+// still computed and logged either way.
+#define AUDIO_SPECTRAL_TRIGGER     0
+
+// Clip and segment encoding. FLAC is lossless at roughly 1.3-2:1 on field
+// audio; AUDIO_CODEC_IMA_ADPCM gives a fixed 4:1 when card space matters more
+// than fidelity; AUDIO_CODEC_PCM keeps plain WAV.
+#define AUDIO_CLIP_CODEC           AUDIO_CODEC_FLAC
+
+// Continuous policy: segment length and the per-segment index (path, first
+// sample number, start time in us since boot, rate, samples, dropped).
+#define AUDIO_SEGMENT_SECONDS      300U
+#define AUDIO_SEGMENT_INDEX_PATH   "/sdcard/audio/segments.csv"
+
+// Writer pool sized in time rather than blocks: ~2 s of SD stall the capture
+// loop can absorb before it starts dropping audio, at any sample rate.
+#define AUDIO_WRITER_BUFFER_MS     2000U
+#define AUDIO_WRITER_PRIORITY      4
+#define AUDIO_WRITER_STACK         4096
 
 typedef struct {
-  int32_t *samples;
-  size_t size_samples;
-  size_t write_idx;
-  bool full;
-} audio_ring_buffer_t;
-
-static audio_ring_buffer_t s_ring = {0};
-
-static inline int16_t pcm32_to_pcm16(int32_t sample) {
-  int32_t shifted = sample >> BSP_AUDIO_PCM_SHIFT;
-  if (shifted > INT16_MAX) {
-    shifted = INT16_MAX;
-  } else if (shifted < INT16_MIN) {
-    shifted = INT16_MIN;
-  }
-  return (int16_t)shifted;
+  char path[128];
+  uint16_t bits_per_sample;
+  audio_codec_t codec;
+  bool segment;
+  uint64_t start_sample;
+  int64_t start_us;
+  uint32_t dropped_samples;
+  wav_writer_t wav;
+} clip_sink_ctx_t;
+
+static bsp_audio_config_t s_audio_cfg = BSP_AUDIO_CONFIG_DEFAULT();
+static size_t s_writer_blocks;
+// Bytes per stored sample (AUDIO_RING_FORMAT), in the ring and writer blocks.
+static size_t s_sample_bytes;
+// Pre-trigger window; only the triggered policy allocates it.
+static audio_ring_t s_ring = {0};
+static audio_detect_t s_detect;
+static int16_t s_detect_pcm[AUDIO_READ_CHUNK_SAMPLES];
+static audio_spectral_t s_spectral;
+static bool s_spectral_ready;
+// Detector CPU accounting for the current monitor cycle.
+static int64_t s_detect_cpu_us;
+static uint64_t s_detect_samples;
+static audio_writer_t s_writer;
+static clip_sink_ctx_t s_clip_ctx;
+// Segment N+1 opens while the writer may still be draining segment N, so the
+// continuous policy alternates between two contexts.
+static clip_sink_ctx_t s_segment_ctx[2];
+
+// The encoders take mono PCM16 only; a raw 32-bit ring or a stereo profile
+// falls back to plain WAV.
+static audio_codec_t clip_codec(void) {
+  return s_sample_bytes == sizeof(int16_t) && s_audio_cfg.channels == 1 ? AUDIO_CLIP_CODEC : AUDIO_CODEC_PCM;
 }
 
-static esp_err_t ring_buffer_init(audio_ring_buffer_t *rb, size_t size_samples) {
-  rb->samples = (int32_t *)heap_caps_malloc(size_samples * sizeof(int32_t), MALLOC_CAP_SPIRAM);
-  if (!rb->samples) {
-    rb->samples = (int32_t *)malloc(size_samples * sizeof(int32_t));
-  }
-  if (!rb->samples) {
-    ESP_LOGE(TAG, "Ring buffer allocation failed for %zu samples", size_samples);
-    return ESP_ERR_NO_MEM;
+static esp_err_t clip_sink_open(void *ctx) {
+  clip_sink_ctx_t *clip = (clip_sink_ctx_t *)ctx;
+  if (clip->codec != AUDIO_CODEC_PCM) {
+    return wav_writer_open_codec(&clip->wav, clip->path, s_audio_cfg.sample_rate_hz, clip->codec,
+                                 BSP_STORAGE_ALLOCATION_UNIT);
   }
-
-  rb->size_samples = size_samples;
-  rb->write_idx = 0;
-  rb->full = false;
-  memset(rb->samples, 0, size_samples * sizeof(int32_t));
-  return ESP_OK;
+  return wav_writer_open(&clip->wav, clip->path, s_audio_cfg.sample_rate_hz, s_audio_cfg.channels,
+                         clip->bits_per_sample, BSP_STORAGE_ALLOCATION_UNIT);
 }
 
-static void ring_buffer_reset(audio_ring_buffer_t *rb) {
-  rb->write_idx = 0;
-  rb->full = false;
-  if (rb->samples && rb->size_samples > 0) {
-    memset(rb->samples, 0, rb->size_samples * sizeof(int32_t));
-  }
+static esp_err_t clip_sink_write(void *ctx, const void *data, size_t len) {
+  clip_sink_ctx_t *clip = (clip_sink_ctx_t *)ctx;
+  return wav_writer_append(&clip->wav, data, len);
 }
 
-static void ring_buffer_write(audio_ring_buffer_t *rb, const int32_t *samples, size_t count) {
-  if (!rb->samples || rb->size_samples == 0 || !samples || count == 0) {
-    return;
+static esp_err_t clip_sink_close(void *ctx) {
+  clip_sink_ctx_t *clip = (clip_sink_ctx_t *)ctx;
+  // Read the totals after finalize: it encodes the last partial block.
+  esp_err_t err = wav_writer_finalize(&clip->wav);
+  uint32_t data_size = clip->wav.data_bytes;
+  uint32_t samples = clip->wav.samples;
+  if (err == ESP_OK) {
+    ESP_LOGI(TAG, "Saved %s (%s, %u bytes, %.2fs, %.2f:1)", clip->path, audio_codec_name(clip->codec),
+             (unsigned)data_size, (float)samples / (float)s_audio_cfg.sample_rate_hz,
+             data_size ? (float)samples * (float)(s_audio_cfg.channels * clip->bits_per_sample / 8U) / (float)data_size
+                       : 0.0f);
+  } else {
+    ESP_LOGW(TAG, "Failed to finalize %s", clip->path);
   }
 
-  for (size_t i = 0; i < count; i++) {
-    rb->samples[rb->write_idx] = samples[i];
-    rb->write_idx++;
-    if (rb->write_idx >= rb->size_samples) {
-      rb->write_idx = 0;
-      rb->full = true;
+  if (clip->segment) {
+    char line[192];
+    snprintf(line, sizeof(line), "%s,%llu,%lld,%u,%u,%u\n", clip->path, (unsigned long long)clip->start_sample,
+             (long long)clip->start_us, (unsigned)s_audio_cfg.sample_rate_hz,
+             (unsigned)samples, (unsigned)clip->dropped_samples);
+    if (bsp_storage_append_line(AUDIO_SEGMENT_INDEX_PATH, line) != ESP_OK) {
+      ESP_LOGW(TAG, "Failed to update segment index");
     }
   }
+  return err;
 }
 
-static size_t ring_buffer_copy_chronological(const audio_ring_buffer_t *rb, int32_t *dest, size_t max_samples) {
-  if (!rb->samples || !dest || max_samples == 0) {
-    return 0;
-  }
-
-  size_t available = rb->full ? rb->size_samples : rb->write_idx;
-  if (available > max_samples) {
-    available = max_samples;
+// Hands the clip to the writer task: it streams the pre-trigger ring first,
+// then every block submitted until end_clip().
+static esp_err_t start_triggered_clip(void) {
+  if (!bsp_storage_is_ready()) {
+    return ESP_ERR_INVALID_STATE;
   }
-
-  size_t read_idx = rb->full ? rb->write_idx : 0;
-  for (size_t i = 0; i < available; i++) {
-    dest[i] = rb->samples[read_idx];
-    read_idx++;
-    if (read_idx >= rb->size_samples) {
-      read_idx = 0;
-    }
+  s_clip_ctx.bits_per_sample = (uint16_t)(s_sample_bytes * 8U);
+  s_clip_ctx.codec = clip_codec();
+  if (bsp_storage_make_path(s_clip_ctx.path, sizeof(s_clip_ctx.path), "audio", "audio",
+                            audio_codec_extension(s_clip_ctx.codec)) != ESP_OK) {
+    return ESP_ERR_INVALID_SIZE;
   }
-  return available;
+  s_clip_ctx.segment = false;
+
+  audio_writer_sink_t sink = {
+      .open = clip_sink_open,
+      .write = clip_sink_write,
+      .close = clip_sink_close,
+      .ctx = &s_clip_ctx,
+  };
+  return audio_writer_begin(&s_writer, &sink, &s_ring);
 }
 
-static void write_wav_header(FILE *f, uint32_t sample_rate, uint16_t channels, uint16_t bits_per_sample,
-                             uint32_t data_size) {
-  uint32_t byte_rate = sample_rate * channels * bits_per_sample / 8U;
-  uint16_t block_align = (uint16_t)(channels * bits_per_sample / 8U);
-  uint32_t riff_chunk_size = 36U + data_size;
-  uint32_t fmt_chunk_size = 16U;
-  uint16_t audio_format = 1U;
-
-  fwrite("RIFF", 1, 4, f);
-  fwrite(&riff_chunk_size, sizeof(riff_chunk_size), 1, f);
-  fwrite("WAVE", 1, 4, f);
-  fwrite("fmt ", 1, 4, f);
-  fwrite(&fmt_chunk_size, sizeof(fmt_chunk_size), 1, f);
-  fwrite(&audio_format, sizeof(audio_format), 1, f);
-  fwrite(&channels, sizeof(channels), 1, f);
-  fwrite(&sample_rate, sizeof(sample_rate), 1, f);
-  fwrite(&byte_rate, sizeof(byte_rate), 1, f);
-  fwrite(&block_align, sizeof(block_align), 1, f);
-  fwrite(&bits_per_sample, sizeof(bits_per_sample), 1, f);
-  fwrite("data", 1, 4, f);
-  fwrite(&data_size, sizeof(data_size), 1, f);
-}
-
-static esp_err_t save_clip_to_wav(const int32_t *samples, size_t sample_count) {
+// Opens a continuous-mode segment whose first sample is stream sample
+// start_sample. The start time is derived from the sample count, not read
+// from the clock, so consecutive segments tile the timeline exactly.
+static esp_err_t start_segment(clip_sink_ctx_t *seg, uint64_t start_sample, int64_t stream_start_us) {
   if (!bsp_storage_is_ready()) {
     return ESP_ERR_INVALID_STATE;
   }
 
-  char path[128] = {0};
-  if (bsp_storage_make_path(path, sizeof(path), "audio", "audio", "wav") != ESP_OK) {
+  seg->segment = true;
+  seg->start_sample = start_sample;
+  seg->start_us = stream_start_us + (int64_t)(start_sample * 1000000ULL / s_audio_cfg.sample_rate_hz);
+  seg->dropped_samples = 0;
+  seg->bits_per_sample = (uint16_t)(s_sample_bytes * 8U);
+  seg->codec = clip_codec();
+  if (bsp_storage_make_path_at(seg->path, sizeof(seg->path), "audio", "seg", seg->start_us / 1000,
+                               audio_codec_extension(seg->codec)) != ESP_OK) {
     return ESP_ERR_INVALID_SIZE;
   }
 
-  FILE *f = fopen(path, "wb+");
-  if (!f) {
-    ESP_LOGW(TAG, "Failed to open %s", path);
-    return ESP_FAIL;
-  }
-
-  uint32_t data_size = (uint32_t)(sample_count * sizeof(int16_t));
-  write_wav_header(f, BSP_AUDIO_RATE_HZ, 1, 16, data_size);
-
-  int16_t pcm16_chunk[256];
-  size_t offset = 0;
-  while (offset < sample_count) {
-    size_t chunk_count = sample_count - offset;
-    if (chunk_count > 256) {
-      chunk_count = 256;
-    }
+  audio_writer_sink_t sink = {
+      .open = clip_sink_open,
+      .write = clip_sink_write,
+      .close = clip_sink_close,
+      .ctx = seg,
+  };
+  return audio_writer_begin(&s_writer, &sink, NULL);
+}
 
-    for (size_t i = 0; i < chunk_count; i++) {
-      pcm16_chunk[i] = pcm32_to_pcm16(samples[offset + i]);
-    }
+static void end_clip(void) {
+  audio_writer_end(&s_writer);
 
-    size_t written = fwrite(pcm16_chunk, sizeof(int16_t), chunk_count, f);
-    if (written != chunk_count) {
-      fclose(f);
-      ESP_LOGE(TAG, "Partial WAV write to %s", path);
-      return ESP_FAIL;
-    }
-    offset += chunk_count;
-  }
-
-  fclose(f);
-  ESP_LOGI(TAG, "Saved %s (%u bytes)", path, data_size);
-  return ESP_OK;
+  audio_writer_stats_t stats;
+  audio_writer_get_stats(&s_writer, &stats);
+  ESP_LOGI(TAG, "Writer: %u blocks, %u overruns, queue high-water %u/%u, write max %u us",
+           (unsigned)stats.blocks_written, (unsigned)stats.overruns, (unsigned)stats.queue_high_water,
+           (unsigned)s_writer_blocks, (unsigned)stats.max_write_us);
 }
 
-static bool detect_audio_event(const int32_t *samples, size_t sample_count) {
-  size_t hits = 0;
-
-  for (size_t i = 0; i < sample_count; i++) {
-    int32_t shifted = samples[i] >> BSP_AUDIO_PCM_SHIFT;
-    int32_t magnitude = shifted < 0 ? -shifted : shifted;
-    if (magnitude >= AUDIO_EVENT_THRESHOLD) {
-      hits++;
-      if (hits >= AUDIO_EVENT_HIT_COUNT) {
-        return true;
-      }
+// Converts count I2S words (whole frames) into a pool block and queues it.
+// If ring is set the chunk also goes into it, copied from the block while
+// this task still owns it. Returns false if the clip lost the chunk.
+static bool submit_clip_chunk(const int32_t *chunk, size_t count, audio_ring_t *ring) {
+  audio_writer_block_t *blk = audio_writer_acquire(&s_writer);
+  if (!blk) {
+    if (ring) {
+      audio_pcm_ring_ingest(ring, AUDIO_RING_FORMAT, chunk, count, s_audio_cfg.pcm_shift, true);
     }
+    return false;
   }
-  return false;
+  audio_pcm_from_i2s(AUDIO_RING_FORMAT, chunk, blk->data, count, s_audio_cfg.pcm_shift);
+  if (ring) {
+    audio_ring_write_overwrite(ring, blk->data, count);
+  }
+  blk->len = count * s_sample_bytes;
+  return audio_writer_submit(&s_writer, blk) == ESP_OK;
 }
 
-static esp_err_t capture_post_trigger(int32_t *dest, size_t requested_samples, size_t *captured_samples) {
-  size_t total = 0;
+// Continuous policy: the microphone is opened once and never closed. Every
+// chunk is split at segment boundaries, so sample k of the stream lands in
+// exactly one segment and segment start times are stream_start + k / rate.
+static void run_continuous(void) {
   int32_t chunk[AUDIO_READ_CHUNK_SAMPLES] = {0};
-  int empty_loops = 0;
+  const size_t ch = s_audio_cfg.channels;
+  const uint32_t rate = s_audio_cfg.sample_rate_hz;
+  const uint64_t segment_samples = (uint64_t)rate * AUDIO_SEGMENT_SECONDS;
+  uint64_t stream_samples = 0;
+  uint64_t segment_end = 0;
+  int64_t stream_start_us = 0;
+  clip_sink_ctx_t *seg = NULL;
+  int next_ctx = 0;
+  bool start_failed = false;
+
+  while (bsp_audio_init(&s_audio_cfg) != ESP_OK) {
+    ESP_LOGW(TAG, "Audio init failed, retrying");
+    vTaskDelay(pdMS_TO_TICKS(1000));
+  }
+  ESP_LOGI(TAG, "Continuous recording started (%u Hz, %u s segments, %u writer blocks)", (unsigned)rate,
+           (unsigned)AUDIO_SEGMENT_SECONDS, (unsigned)s_writer_blocks);
 
-  while (total < requested_samples) {
+  while (1) {
     size_t bytes_read = 0;
-    esp_err_t err = bsp_audio_read(chunk, sizeof(chunk), &bytes_read, 200);
+    esp_err_t err = bsp_audio_read(chunk, sizeof(chunk), &bytes_read, 100);
     if (err != ESP_OK) {
-      if (err == ESP_ERR_TIMEOUT) {
-        if (++empty_loops > 20) {
-          break;
-        }
-        continue;
+      if (err != ESP_ERR_TIMEOUT) {
+        ESP_LOGW(TAG, "Audio read failed: %s", esp_err_to_name(err));
       }
-      return err;
+      continue;
     }
 
-    size_t read_samples = bytes_read / sizeof(int32_t);
+    // Stream positions count frames (one sample per channel).
+    size_t read_samples = bytes_read / sizeof(int32_t) / ch;
     if (read_samples == 0) {
-      if (++empty_loops > 20) {
-        break;
-      }
       continue;
     }
-    empty_loops = 0;
+    if (stream_samples == 0) {
+      // Anchor the stream at its first sample: the chunk just completed, so
+      // it started read_samples sample periods ago.
+      stream_start_us = esp_timer_get_time() - (int64_t)(read_samples * 1000000ULL / rate);
+    }
 
-    ring_buffer_write(&s_ring, chunk, read_samples);
+    size_t off = 0;
+    while (off < read_samples) {
+      uint64_t pos = stream_samples + off;
+      if (!seg) {
+        err = start_segment(&s_segment_ctx[next_ctx], pos, stream_start_us);
+        if (err != ESP_OK) {
+          if (!start_failed) {
+            ESP_LOGW(TAG, "Segment start failed: %s", esp_err_to_name(err));
+            start_failed = true;
+          }
+          break;
+        }
+        start_failed = false;
+        seg = &s_segment_ctx[next_ctx];
+        next_ctx ^= 1;
+        segment_end = pos + segment_samples;
+      }
 
-    size_t remaining = requested_samples - total;
-    size_t to_copy = read_samples < remaining ? read_samples : remaining;
-    memcpy(dest + total, chunk, to_copy * sizeof(int32_t));
-    total += to_copy;
-  }
+      size_t n = read_samples - off;
+      if ((uint64_t)n > segment_end - pos) {
+        n = (size_t)(segment_end - pos);
+      }
+      if (!submit_clip_chunk(chunk + off * ch, n * ch, NULL)) {
+        seg->dropped_samples += (uint32_t)n;
+      }
+      off += n;
+      if (pos + n == segment_end) {
+        end_clip();
+        seg = NULL;
+      }
+    }
 
-  if (captured_samples) {
-    *captured_samples = total;
+    stream_samples += read_samples;
   }
-  return total > 0 ? ESP_OK : ESP_ERR_TIMEOUT;
 }
 
-static esp_err_t record_triggered_clip(void) {
-  size_t pre_trigger_samples = s_ring.size_samples;
-  size_t post_trigger_samples = BSP_AUDIO_RATE_HZ * AUDIO_POST_TRIGGER_SECONDS;
-  size_t max_total_samples = pre_trigger_samples + post_trigger_samples;
-
-  int32_t *clip = (int32_t *)heap_caps_malloc(max_total_samples * sizeof(int32_t), MALLOC_CAP_SPIRAM);
-  if (!clip) {
-    clip = (int32_t *)malloc(max_total_samples * sizeof(int32_t));
-  }
-  if (!clip) {
-    ESP_LOGE(TAG, "Clip allocation failed (%zu samples)", max_total_samples);
-    return ESP_ERR_NO_MEM;
-  }
-
-  size_t copied_pre = ring_buffer_copy_chronological(&s_ring, clip, pre_trigger_samples);
-  size_t captured_post = 0;
-  esp_err_t err = capture_post_trigger(clip + copied_pre, post_trigger_samples, &captured_post);
-  if (err != ESP_OK) {
-    heap_caps_free(clip);
-    ESP_LOGW(TAG, "Post-trigger capture failed: %s", esp_err_to_name(err));
-    return err;
+// Runs the detectors on one chunk of sample_count frames (first channel only).
+// They see every chunk, including those during a clip or cooldown, so the
+// noise floors keep tracking.
+static bool detect_audio_event(const int32_t *samples, size_t sample_count) {
+  int64_t t0 = esp_timer_get_time();
+  audio_detect_frame_t info;
+  audio_pcm16_from_i2s_strided(samples, s_audio_cfg.channels, s_detect_pcm, sample_count, s_audio_cfg.pcm_shift);
+  bool onset = audio_detect_process(&s_detect, s_detect_pcm, sample_count, &info);
+
+  if (s_spectral_ready) {
+    audio_spectral_frame_t band;
+    bool band_onset = audio_spectral_process(&s_spectral, s_detect_pcm, sample_count, &band);
+    if (band_onset) {
+      ESP_LOGI(TAG, "Band event: snr_q8=%u", (unsigned)band.snr_q8[0]);
+    }
+    // The band stage replaces the broadband onset rather than gating it:
+    // a call can stand out in its band without raising the overall level.
+    onset = band_onset;
   }
-
-  size_t total_samples = copied_pre + captured_post;
-  err = save_clip_to_wav(clip, total_samples);
-  heap_caps_free(clip);
-
-  if (err == ESP_OK) {
-    ESP_LOGI(TAG, "Audio clip saved (%.2fs)", (float)total_samples / (float)BSP_AUDIO_RATE_HZ);
+  s_detect_cpu_us += esp_timer_get_time() - t0;
+  s_detect_samples += sample_count;
+
+  ESP_LOGD(TAG, "Frame rms=%u peak=%u floor=%u snr_q8=%u%s", (unsigned)info.rms, (unsigned)info.peak,
+           (unsigned)info.floor_rms, (unsigned)info.snr_q8, info.active ? " active" : "");
+  if (info.onset) {
+    // With the band stage deciding, a broadband onset alone is not an event
+    // (wind, rain, handling); keep it for debugging only.
+    ESP_LOG_LEVEL(s_spectral_ready ? ESP_LOG_DEBUG : ESP_LOG_INFO, TAG,
+                  "%s: rms=%u peak=%u floor=%u snr=%u.%02ux", s_spectral_ready ? "Broadband onset" : "Audio event",
+                  (unsigned)info.rms, (unsigned)info.peak, (unsigned)info.floor_rms,
+                  (unsigned)(info.snr_q8 / AUDIO_DETECT_Q8_ONE),
+                  (unsigned)((info.snr_q8 % AUDIO_DETECT_Q8_ONE) * 100U / AUDIO_DETECT_Q8_ONE));
   }
-  return err;
+  return onset;
 }
 
 static void run_monitor_cycle(void) {
+  const size_t ch = s_audio_cfg.channels;
   int64_t start_ms = bsp_storage_now_ms();
   int32_t chunk[AUDIO_READ_CHUNK_SAMPLES] = {0};
+  size_t post_remaining = 0;
+  bool ring_stale = false;
+  int64_t last_clip_end_ms = start_ms - AUDIO_TRIGGER_COOLDOWN_MS;
 
-  ring_buffer_reset(&s_ring);
+  // A clip from the previous cycle may still be copying the ring.
+  while (audio_writer_ring_busy(&s_writer)) {
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+  audio_ring_reset(&s_ring);
+  audio_detect_reset(&s_detect);
+  audio_spectral_reset(&s_spectral);
+  s_detect_cpu_us = 0;
+  s_detect_samples = 0;
   ESP_LOGI(TAG, "Audio monitor cycle started (%lld ms window)", (long long)AUDIO_MONITOR_WINDOW_MS);
 
+  // The capture loop never touches storage and never sleeps while the
+  // microphone is running; all SD I/O happens on the writer task.
   while ((bsp_storage_now_ms() - start_ms) < AUDIO_MONITOR_WINDOW_MS) {
     size_t bytes_read = 0;
     esp_err_t err = bsp_audio_read(chunk, sizeof(chunk), &bytes_read, 100);
@@ -282,35 +377,184 @@ static void run_monitor_cycle(void) {
       continue;
     }
 
-    size_t read_samples = bytes_read / sizeof(int32_t);
+    size_t read_samples = bytes_read / sizeof(int32_t) / ch;
     if (read_samples == 0) {
       vTaskDelay(pdMS_TO_TICKS(5));
       continue;
     }
 
-    ring_buffer_write(&s_ring, chunk, read_samples);
+    // Keep the pre-trigger ring rolling unless the writer is still reading
+    // it; if we had to skip audio, restart it so it stays gapless.
+    audio_ring_t *ring = NULL;
+    if (audio_writer_ring_busy(&s_writer)) {
+      ring_stale = true;
+    } else {
+      if (ring_stale) {
+        audio_ring_reset(&s_ring);
+        ring_stale = false;
+      }
+      ring = &s_ring;
+    }
 
-    if (detect_audio_event(chunk, read_samples)) {
-      ESP_LOGI(TAG, "Audio event detected");
-      if (record_triggered_clip() != ESP_OK) {
-        ESP_LOGW(TAG, "Triggered clip capture failed");
+    if (post_remaining > 0) {
+      size_t n = read_samples < post_remaining ? read_samples : post_remaining;
+      // A whole chunk feeds the ring from its block instead of converting twice.
+      submit_clip_chunk(chunk, n * ch, n == read_samples ? ring : NULL);
+      if (n == read_samples) {
+        ring = NULL;
+      }
+      post_remaining -= n;
+      if (post_remaining == 0) {
+        end_clip();
+        last_clip_end_ms = bsp_storage_now_ms();
+      }
+    }
+    if (ring) {
+      audio_pcm_ring_ingest(ring, AUDIO_RING_FORMAT, chunk, read_samples * ch, s_audio_cfg.pcm_shift, true);
+    }
+
+    bool event = detect_audio_event(chunk, read_samples);
+
+    if (event && post_remaining == 0 && !audio_writer_clip_active(&s_writer) &&
+        (bsp_storage_now_ms() - last_clip_end_ms) >= AUDIO_TRIGGER_COOLDOWN_MS) {
+      err = start_triggered_clip();
+      if (err == ESP_OK) {
+        post_remaining = s_audio_cfg.sample_rate_hz * AUDIO_POST_TRIGGER_SECONDS;
+      } else {
+        ESP_LOGW(TAG, "Triggered clip start failed: %s", esp_err_to_name(err));
       }
-      vTaskDelay(pdMS_TO_TICKS(AUDIO_TRIGGER_COOLDOWN_MS));
     }
   }
+
+  if (post_remaining > 0) {
+    end_clip();
+  }
+
+  if (s_detect_samples > 0) {
+    ESP_LOGI(TAG, "Detector CPU: %.2f ms per audio second",
+             (double)s_detect_cpu_us * s_audio_cfg.sample_rate_hz / 1000.0 / (double)s_detect_samples);
+  }
+}
+
+// Resumes the warm channel (or creates it on the first cycle / after a
+// failure) and logs how long the microphone took to deliver valid audio.
+static esp_err_t start_listening(void) {
+  bool warm = bsp_audio_is_suspended();
+  esp_err_t err = warm ? bsp_audio_resume() : bsp_audio_init(&s_audio_cfg);
+  if (err != ESP_OK && warm) {
+    bsp_audio_deinit();
+    err = bsp_audio_init(&s_audio_cfg);
+    warm = false;
+  }
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  bsp_audio_stats_t stats;
+  bsp_audio_get_stats(&stats);
+  if (warm) {
+    ESP_LOGI(TAG, "Audio resumed in %u us (max %u us over %u resumes, cold start %u us)",
+             (unsigned)stats.last_resume_us, (unsigned)stats.max_resume_us, (unsigned)stats.resumes,
+             (unsigned)stats.cold_start_us);
+  }
+  return ESP_OK;
+}
+
+// Applies AUDIO_PROFILE_PATH over the default profile. Unknown keys are
+// ignored; an invalid result falls back to the default.
+static void load_audio_profile(void) {
+  bsp_audio_config_t cfg = BSP_AUDIO_CONFIG_DEFAULT();
+  char text[256];
+  if (bsp_storage_read_text(AUDIO_PROFILE_PATH, text, sizeof(text)) == ESP_OK) {
+    char *save = NULL;
+    for (char *line = strtok_r(text, "\r\n", &save); line; line = strtok_r(NULL, "\r\n", &save)) {
+      char key[16];
+      unsigned long value = 0;
+      if (sscanf(line, " %15[a-z_] = %lu", key, &value) != 2) {
+        continue;
+      }
+      if (!strcmp(key, "rate")) {
+        cfg.sample_rate_hz = (uint32_t)value;
+      } else if (!strcmp(key, "slot_bits")) {
+        cfg.slot_bits = (uint8_t)value;
+      } else if (!strcmp(key, "channels")) {
+        cfg.channels = (uint8_t)value;
+      } else if (!strcmp(key, "dma_desc")) {
+        cfg.dma_desc_num = (uint8_t)value;
+      } else if (!strcmp(key, "dma_frames")) {
+        cfg.dma_frame_num = (uint16_t)value;
+      } else if (!strcmp(key, "shift")) {
+        cfg.pcm_shift = (uint8_t)value;
+      }
+    }
+    if (bsp_audio_config_validate(&cfg) != ESP_OK) {
+      ESP_LOGW(TAG, "Invalid profile in %s; using defaults", AUDIO_PROFILE_PATH);
+      cfg = (bsp_audio_config_t)BSP_AUDIO_CONFIG_DEFAULT();
+    }
+  }
+  s_audio_cfg = cfg;
 }
 
 void sys_audio_task(void *pvParameters) {
   (void)pvParameters;
   ESP_LOGI(TAG, "Task started on Core %d", xPortGetCoreID());
 
-  size_t pre_trigger_samples = BSP_AUDIO_RATE_HZ * AUDIO_PRE_TRIGGER_SECONDS;
-  if (ring_buffer_init(&s_ring, pre_trigger_samples) != ESP_OK) {
+  load_audio_profile();
+  const uint32_t rate = s_audio_cfg.sample_rate_hz;
+  const size_t ch = s_audio_cfg.channels;
+  // Ring and writer blocks hold interleaved samples; sizes stay whole frames.
+  const size_t chunk_words = AUDIO_READ_CHUNK_SAMPLES / ch * ch;
+  // Continuous segments start at the stream's first sample; no pre-roll.
+  size_t pre_trigger_samples =
+      AUDIO_POLICY == AUDIO_POLICY_CONTINUOUS ? 0 : (size_t)rate * AUDIO_PRE_TRIGGER_SECONDS * ch;
+  s_sample_bytes = audio_pcm_bytes_per_sample(AUDIO_RING_FORMAT);
+  s_writer_blocks = ((size_t)rate * ch * AUDIO_WRITER_BUFFER_MS / 1000U + chunk_words - 1U) / chunk_words;
+  if (pre_trigger_samples > 0 && audio_ring_init(&s_ring, pre_trigger_samples, s_sample_bytes) != ESP_OK) {
     ESP_LOGE(TAG, "Audio ring buffer init failed; task exiting");
     vTaskDelete(NULL);
     return;
   }
 
+  audio_detect_init(&s_detect, NULL);
+  if (AUDIO_SPECTRAL_TRIGGER) {
+    audio_spectral_config_t spectral_cfg;
+    audio_spectral_default_config(&spectral_cfg, rate);
+    spectral_cfg.fft_size = AUDIO_READ_CHUNK_SAMPLES / ch;
+    s_spectral_ready = audio_spectral_init(&s_spectral, &spectral_cfg);
+    if (!s_spectral_ready) {
+      ESP_LOGW(TAG, "Spectral trigger init failed; using broadband detector");
+    }
+  }
+
+  audio_writer_config_t writer_cfg = {
+      .block_count = s_writer_blocks,
+      .block_bytes = chunk_words * s_sample_bytes,
+      .task_priority = AUDIO_WRITER_PRIORITY,
+      .task_core = 0,
+      .task_stack = AUDIO_WRITER_STACK,
+  };
+  if (audio_writer_init(&s_writer, &writer_cfg) != ESP_OK) {
+    ESP_LOGE(TAG, "Audio writer init failed; task exiting");
+    audio_ring_free(&s_ring);
+    vTaskDelete(NULL);
+    return;
+  }
+
+  bsp_audio_profile_info_t info;
+  if (bsp_audio_profile_info(&s_audio_cfg, &info) == ESP_OK) {
+    ESP_LOGI(TAG, "Audio profile: %u Hz, %u-bit slots, %u ch, DMA %ux%u (%u B, %u us/read, %u us to overrun)",
+             (unsigned)rate, (unsigned)s_audio_cfg.slot_bits, (unsigned)ch, (unsigned)s_audio_cfg.dma_desc_num,
+             (unsigned)s_audio_cfg.dma_frame_num, (unsigned)info.dma_bytes, (unsigned)info.dma_buffer_us,
+             (unsigned)info.overrun_us);
+    ESP_LOGI(TAG, "Audio buffers: ring %u B (%u s pre-trigger), writer %u x %u B",
+             (unsigned)(pre_trigger_samples * s_sample_bytes), (unsigned)(pre_trigger_samples / ch / rate),
+             (unsigned)s_writer_blocks, (unsigned)writer_cfg.block_bytes);
+  }
+
+  if (AUDIO_POLICY == AUDIO_POLICY_CONTINUOUS) {
+    run_continuous();
+  }
+
   // Start first monitoring cycle right after boot for easier field verification.
   int64_t last_cycle_ms = bsp_storage_now_ms() - AUDIO_MONITOR_INTERVAL_MS;
 
@@ -321,11 +565,13 @@ void sys_audio_task(void *pvParameters) {
 
       if (!bsp_storage_is_ready()) {
         ESP_LOGW(TAG, "Storage not ready, skipping audio cycle");
-      } else if (bsp_audio_init() != ESP_OK) {
-        ESP_LOGW(TAG, "Audio init failed, skipping audio cycle");
+      } else if (start_listening() != ESP_OK) {
+        ESP_LOGW(TAG, "Audio start failed, skipping audio cycle");
       } else {
         run_monitor_cycle();
-        bsp_audio_deinit();
+        if (bsp_audio_suspend() != ESP_OK) {
+          bsp_audio_deinit();
+        }
       }
     }
 
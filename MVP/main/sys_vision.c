@@ -1,51 +1,142 @@
 #include "bsp_camera.h"
 #include "bsp_env.h"
 #include "bsp_storage.h"
+#include "pir_trigger.h"
+#include "img_converters.h"
+#include "jpeg_ring.h"
+#include "motion_detect.h"
+#include "usb_link.h"
 
 #include <stdbool.h>
 #include <stdio.h>
-#include <stdlib.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "mbedtls/base64.h"
 
 static const char *TAG = "SYS_VISION";
 static const int64_t TIMELAPSE_INTERVAL_MS = 5LL * 60LL * 1000LL;
 static const int64_t PIR_COOLDOWN_MS = 5000;
 
-static bool send_image_over_usb_base64(const uint8_t *buf, size_t len) {
-  size_t b64_cap = 4 * ((len + 2) / 3) + 1;
-  unsigned char *b64 = malloc(b64_cap);
-  if (!b64) {
-    return false;
-  }
+// Capture profiles (bsp_camera): PIR captures at SVGA, timelapse at QVGA,
+// each with its own byte budget. The camera idles in the PIR profile, so a
+// trigger only pays a frame-size switch if the PIR one was deferred;
+// timelapse switches there and back and may take longer.
+#define PIR_SWITCH_BUDGET_MS       150U
+#define TIMELAPSE_SWITCH_BUDGET_MS 1000U
+
+// Frames per PIR trigger, taken back to back at the sensor's frame rate
+// (1 = single shot). Each burst is indexed in PIR_BURST_INDEX_PATH as
+// burst id, frame, path, frame time (ms since boot), bytes; pre-roll frames
+// have negative frame numbers.
+#define PIR_BURST_FRAMES       8U
+#define PIR_BURST_MAX_FRAMES   32U
+#define PIR_BURST_INDEX_PATH   "/sdcard/pir/bursts.csv"
+// Set to 1 to log sustained burst fps for QVGA..UXGA once at startup.
+#define VISION_BURST_BENCHMARK 0
+#define VISION_BENCH_FRAMES    16U
+
+// Optional pre-trigger ring: while idle the camera streams
+// VISION_PREROLL_FPS frames per second into a PSRAM arena, and a PIR burst
+// is followed by the frames from the VISION_PREROLL_SECONDS before the edge.
+// 0 seconds disables it. The arena holds ~10 s of QVGA at 2 fps many times
+// over; size it for the frame size in use.
+#define VISION_PREROLL_SECONDS     0U
+#define VISION_PREROLL_FPS         2U
+#define VISION_PREROLL_ARENA_BYTES (512U * 1024U)
+#define VISION_PREROLL_MAX_FRAMES  (VISION_PREROLL_SECONDS * VISION_PREROLL_FPS + 4U)
+
+static jpeg_ring_t s_preroll;
+static bool s_preroll_ready = false;
+
+// PIR confirmation: a trigger is only captured if the camera agrees. The
+// newest frame is decoded at 1/8 scale (40x30 for QVGA), converted to gray
+// and diffed block-wise against a running background; up to
+// VISION_MOTION_CONFIRM_FRAMES frames are checked before the trigger is
+// dropped. The background is refreshed every VISION_MOTION_BG_INTERVAL_MS
+// while idle (from every pre-roll frame when the ring is on) and from the
+// frames of rejected triggers. 0 captures on every PIR edge as before.
+#define VISION_MOTION_CONFIRM        1
+#define VISION_MOTION_CONFIRM_FRAMES 2U
+#define VISION_MOTION_BG_INTERVAL_MS 10000
 
-  size_t out_len = 0;
-  int rc = mbedtls_base64_encode(b64, b64_cap, &out_len, buf, len);
-  if (rc != 0) {
-    free(b64);
+typedef struct {
+  motion_detect_t md;
+  uint16_t *rgb;  // 1/8-scale RGB565 decode
+  uint8_t *gray;
+  uint8_t *background;
+  uint16_t width;
+  uint16_t height;
+  uint32_t confirmed;
+  uint32_t rejected;
+} motion_gate_t;
+
+// Per-stage cost of one confirmation frame.
+typedef struct {
+  uint32_t capture_us;
+  uint32_t decode_us;
+  uint32_t diff_us;
+} motion_timing_t;
+
+static motion_gate_t s_motion;
+
+typedef struct {
+  uint32_t frames;
+  int64_t first_us;  // sensor timestamps of the first and last frame
+  int64_t last_us;
+  size_t bytes;
+} burst_result_t;
+
+// Streams the frame buffer straight to the host as binary frames: no copy,
+// no encode buffer, and ~0.1% framing overhead instead of base64's 33%.
+static bool send_image_over_usb(const camera_fb_t *fb) {
+  if (usb_link_send(USB_FRAME_IMAGE, fb->buf, fb->len) != ESP_OK) {
     return false;
   }
+  usb_link_stats_t stats;
+  usb_link_get_stats(&stats);
+  ESP_LOGI(TAG, "PIR image sent over USB (%u bytes, %u ms, %u kB/s)", (unsigned)fb->len,
+           (unsigned)(stats.last_us / 1000U), (unsigned)stats.last_kb_per_s);
+  return true;
+}
+
+// Records edge-to-frame latency once the first frame for a trigger is in hand.
+static void log_trigger_latency(const pir_trigger_event_t *trigger) {
+  uint32_t latency_us = pir_trigger_mark_captured(trigger);
+  pir_trigger_stats_t st;
+  pir_trigger_get_stats(&st);
+  ESP_LOGI(TAG, "PIR edge to frame: %u ms (max %u ms, %u edges, %u dropped)", (unsigned)(latency_us / 1000U),
+           (unsigned)(st.max_latency_us / 1000U), (unsigned)st.edges, (unsigned)st.dropped);
+}
 
-  printf("[USB_IMAGE_BEGIN] bytes=%u b64=%u\n", (unsigned)len, (unsigned)out_len);
-  fwrite(b64, 1, out_len, stdout);
-  printf("\n[USB_IMAGE_END]\n");
-  fflush(stdout);
+static int64_t fb_time_us(const camera_fb_t *fb) {
+  return (int64_t)fb->timestamp.tv_sec * 1000000LL + (int64_t)fb->timestamp.tv_usec;
+}
 
-  free(b64);
-  return true;
+// Sustained rate over the burst, in tenths of a frame per second.
+static uint32_t burst_fps_x10(const burst_result_t *r) {
+  if (r->frames < 2 || r->last_us <= r->first_us) {
+    return 0;
+  }
+  return (uint32_t)(((int64_t)(r->frames - 1) * 10000000LL) / (r->last_us - r->first_us));
 }
 
-static bool capture_and_store(const char *subdir, const char *prefix, bool send_over_usb) {
+// trigger, when set, is the PIR edge that caused this capture.
+static bool capture_and_store(const char *subdir, const char *prefix, bool send_over_usb,
+                              const pir_trigger_event_t *trigger) {
   camera_fb_t *fb = bsp_camera_capture();
   if (!fb) {
     ESP_LOGW(TAG, "Camera capture failed");
     return false;
   }
+  if (trigger) {
+    log_trigger_latency(trigger);
+  }
 
   bool ok = false;
   if (bsp_storage_is_ready()) {
@@ -58,8 +149,7 @@ static bool capture_and_store(const char *subdir, const char *prefix, bool send_
   }
 
   if (send_over_usb) {
-    if (send_image_over_usb_base64(fb->buf, fb->len)) {
-      ESP_LOGI(TAG, "PIR image sent over USB serial");
+    if (send_image_over_usb(fb)) {
       ok = true;
     } else {
       ESP_LOGW(TAG, "USB image transfer failed");
@@ -70,28 +160,455 @@ static bool capture_and_store(const char *subdir, const char *prefix, bool send_
   return ok;
 }
 
+// burst_<id>_<NN>_<ms>.jpg for frame NN, burst_<id>_p<NN>_<ms>.jpg for the
+// pre-roll frame NN positions before the trigger.
+static esp_err_t make_burst_path(char *path, size_t path_len, const char *subdir, int64_t burst_id, int index,
+                                 int64_t frame_ms) {
+  char prefix[48];
+  if (index >= 0) {
+    snprintf(prefix, sizeof(prefix), "burst_%lld_%02d", (long long)burst_id, index);
+  } else {
+    snprintf(prefix, sizeof(prefix), "burst_%lld_p%02d", (long long)burst_id, -index);
+  }
+  return bsp_storage_make_path_at(path, path_len, subdir, prefix, frame_ms, "jpg");
+}
+
+static esp_err_t append_burst_index(const char *index_path, int64_t burst_id, int index, const char *path,
+                                    int64_t frame_ms, size_t bytes) {
+  char line[192];
+  snprintf(line, sizeof(line), "%lld,%d,%s,%lld,%u\n", (long long)burst_id, index, path, (long long)frame_ms,
+           (unsigned)bytes);
+  return bsp_storage_append_line(index_path, line);
+}
+
+// Captures up to frames JPEGs as /sdcard/<subdir>/burst_<id>_<NN>_<ms>.jpg.
+// Frame i is written to SD while the driver fills the other frame buffer
+// with frame i+1; the index is appended once at the end so the burst itself
+// only costs one file write per frame. With store false nothing is written
+// (sensor-limited rate). index_path (optional) gets one line per frame; the
+// last frame captured optionally goes out over USB, also when the burst stops
+// early. That frame is held until the next one arrives, which still leaves
+// the driver a buffer to fill.
+static esp_err_t capture_burst(const char *subdir, int64_t burst_id, uint32_t frames, bool store,
+                               const char *index_path, bool send_last_over_usb,
+                               const pir_trigger_event_t *trigger, burst_result_t *out) {
+  static int64_t frame_ms[PIR_BURST_MAX_FRAMES];
+  static uint32_t frame_bytes[PIR_BURST_MAX_FRAMES];
+
+  memset(out, 0, sizeof(*out));
+  if (frames > PIR_BURST_MAX_FRAMES) {
+    frames = PIR_BURST_MAX_FRAMES;
+  }
+  store = store && bsp_storage_is_ready();
+  esp_err_t err = bsp_camera_burst_begin();
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  char path[128];
+  camera_fb_t *held = NULL;
+  for (uint32_t i = 0; i < frames; i++) {
+    camera_fb_t *fb = bsp_camera_burst_next();
+    if (!fb) {
+      ESP_LOGW(TAG, "Burst stopped after %u frames", (unsigned)i);
+      break;
+    }
+    if (held) {
+      esp_camera_fb_return(held);
+      held = NULL;
+    }
+    if (i == 0 && trigger) {
+      log_trigger_latency(trigger);
+    }
+
+    int64_t t_us = fb_time_us(fb);
+    if (out->frames == 0) {
+      out->first_us = t_us;
+    }
+    out->last_us = t_us;
+    out->bytes += fb->len;
+    frame_ms[out->frames] = t_us / 1000;
+    frame_bytes[out->frames] = (uint32_t)fb->len;
+    out->frames++;
+
+    if (store) {
+      if (make_burst_path(path, sizeof(path), subdir, burst_id, (int)i, t_us / 1000) != ESP_OK ||
+          bsp_storage_write_blob(path, fb->buf, fb->len) != ESP_OK) {
+        ESP_LOGW(TAG, "Burst frame %u not saved", (unsigned)i);
+      }
+    }
+    if (send_last_over_usb) {
+      held = fb;
+    } else {
+      esp_camera_fb_return(fb);
+    }
+  }
+  if (held) {
+    if (!send_image_over_usb(held)) {
+      ESP_LOGW(TAG, "USB image transfer failed");
+    }
+    esp_camera_fb_return(held);
+  }
+  bsp_camera_burst_end();
+
+  if (store && index_path) {
+    for (uint32_t i = 0; i < out->frames; i++) {
+      if (make_burst_path(path, sizeof(path), subdir, burst_id, (int)i, frame_ms[i]) != ESP_OK) {
+        continue;
+      }
+      if (append_burst_index(index_path, burst_id, (int)i, path, frame_ms[i], frame_bytes[i]) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to update burst index");
+        break;
+      }
+    }
+  }
+  return out->frames > 0 ? ESP_OK : ESP_FAIL;
+}
+
+// (Re)sizes the gate for a frame; a new frame size restarts the background.
+static bool motion_gate_prepare(const camera_fb_t *fb) {
+  uint16_t w = (uint16_t)(fb->width / 8U);
+  uint16_t h = (uint16_t)(fb->height / 8U);
+  if (s_motion.rgb && w == s_motion.width && h == s_motion.height) {
+    return true;
+  }
+  heap_caps_free(s_motion.rgb);
+  heap_caps_free(s_motion.gray);
+  heap_caps_free(s_motion.background);
+  memset(&s_motion.md, 0, sizeof(s_motion.md));
+  s_motion.width = w;
+  s_motion.height = h;
+  // At most 200x150 (UXGA): 60 kB of RGB565, so PSRAM when present.
+  size_t pixels = (size_t)w * h;
+  s_motion.rgb = heap_caps_malloc(pixels * sizeof(uint16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!s_motion.rgb) {
+    s_motion.rgb = heap_caps_malloc(pixels * sizeof(uint16_t), MALLOC_CAP_8BIT);
+  }
+  s_motion.gray = heap_caps_malloc(pixels, MALLOC_CAP_8BIT);
+  s_motion.background = heap_caps_malloc(pixels, MALLOC_CAP_8BIT);
+  motion_config_t cfg;
+  motion_default_config(&cfg, w, h);
+  if (!s_motion.rgb || !s_motion.gray || !s_motion.background ||
+      !motion_init(&s_motion.md, &cfg, s_motion.background)) {
+    ESP_LOGW(TAG, "Motion gate unavailable for %ux%u", (unsigned)w, (unsigned)h);
+    heap_caps_free(s_motion.rgb);
+    heap_caps_free(s_motion.gray);
+    heap_caps_free(s_motion.background);
+    s_motion.rgb = NULL;
+    s_motion.gray = NULL;
+    s_motion.background = NULL;
+    return false;
+  }
+  return true;
+}
+
+// Decodes fb at 1/8 scale and runs it through the detector, which learns from
+// it. false if the frame could not be used (and the result is not valid).
+static bool motion_gate_frame(const camera_fb_t *fb, motion_result_t *res, motion_timing_t *t) {
+  if (fb->format != PIXFORMAT_JPEG || !motion_gate_prepare(fb)) {
+    return false;
+  }
+  int64_t t0 = esp_timer_get_time();
+  if (!jpg2rgb565(fb->buf, fb->len, (uint8_t *)s_motion.rgb, JPG_SCALE_8X)) {
+    return false;
+  }
+  motion_gray_from_rgb565(s_motion.rgb, s_motion.gray, (size_t)s_motion.width * s_motion.height);
+  int64_t t1 = esp_timer_get_time();
+  motion_process(&s_motion.md, s_motion.gray, true, res);
+  int64_t t2 = esp_timer_get_time();
+  if (t) {
+    t->decode_us = (uint32_t)(t1 - t0);
+    t->diff_us = (uint32_t)(t2 - t1);
+  }
+  return true;
+}
+
+// Idle background refresh from a fresh frame (the driver's buffers may be
+// minutes old outside a burst).
+static void motion_background_tick(void) {
+  if (bsp_camera_burst_begin() != ESP_OK) {
+    return;
+  }
+  camera_fb_t *fb = bsp_camera_burst_next();
+  if (fb) {
+    motion_result_t res;
+    (void)motion_gate_frame(fb, &res, NULL);
+    esp_camera_fb_return(fb);
+  }
+  bsp_camera_burst_end();
+}
+
+// true if the camera sees enough change to back the PIR edge. Fails open:
+// without a usable frame or background the trigger is captured as before.
+// *latency_logged tells whether a frame arrived and the edge latency was
+// recorded, which a fail-open leaves to the capture that follows.
+static bool motion_confirm(const pir_trigger_event_t *ev, bool *latency_logged) {
+  *latency_logged = false;
+  if (bsp_camera_burst_begin() != ESP_OK) {
+    return true;
+  }
+  bool confirmed = true;
+  for (uint32_t i = 0; i < VISION_MOTION_CONFIRM_FRAMES; i++) {
+    int64_t t0 = esp_timer_get_time();
+    camera_fb_t *fb = bsp_camera_burst_next();
+    if (!fb) {
+      break;
+    }
+    motion_timing_t t = {.capture_us = (uint32_t)(esp_timer_get_time() - t0)};
+    if (i == 0) {
+      log_trigger_latency(ev);
+      *latency_logged = true;
+    }
+    bool primed = s_motion.md.primed && s_motion.width == fb->width / 8U && s_motion.height == fb->height / 8U;
+    motion_result_t res;
+    bool ok = motion_gate_frame(fb, &res, &t);
+    esp_camera_fb_return(fb);
+    if (!ok || !primed) {
+      break;
+    }
+    ESP_LOGI(TAG, "PIR check %u: capture %u us, decode %u us, diff %u us; %u/%u blocks (%u permille), offset %d",
+             (unsigned)i, (unsigned)t.capture_us, (unsigned)t.decode_us, (unsigned)t.diff_us,
+             (unsigned)res.changed_blocks, (unsigned)res.total_blocks, (unsigned)res.changed_permille,
+             (int)res.brightness_offset);
+    confirmed = res.motion;
+    if (confirmed) {
+      break;
+    }
+  }
+  bsp_camera_burst_end();
+
+  if (confirmed) {
+    s_motion.confirmed++;
+  } else {
+    s_motion.rejected++;
+    ESP_LOGI(TAG, "PIR trigger not confirmed by camera (%u rejected, %u confirmed)", (unsigned)s_motion.rejected,
+             (unsigned)s_motion.confirmed);
+  }
+  return confirmed;
+}
+
+static void preroll_init(void) {
+  if (VISION_PREROLL_SECONDS == 0) {
+    return;
+  }
+  // PSRAM only: the arena is far larger than spare internal RAM.
+  void *arena = heap_caps_malloc(VISION_PREROLL_ARENA_BYTES, MALLOC_CAP_SPIRAM);
+  jpeg_ring_slot_t *slots = calloc(VISION_PREROLL_MAX_FRAMES, sizeof(jpeg_ring_slot_t));
+  if (!arena || !slots ||
+      !jpeg_ring_init(&s_preroll, arena, VISION_PREROLL_ARENA_BYTES, slots, VISION_PREROLL_MAX_FRAMES) ||
+      bsp_camera_set_streaming(true) != ESP_OK) {
+    ESP_LOGW(TAG, "Pre-roll disabled (no PSRAM arena or camera)");
+    heap_caps_free(arena);
+    free(slots);
+    return;
+  }
+  s_preroll_ready = true;
+  ESP_LOGI(TAG, "Pre-roll: %u s at %u fps, %u kB arena", (unsigned)VISION_PREROLL_SECONDS,
+           (unsigned)VISION_PREROLL_FPS, (unsigned)(VISION_PREROLL_ARENA_BYTES / 1024U));
+}
+
+// Copies the newest frame into the ring; the camera buffer goes straight back.
+static void preroll_capture(void) {
+  camera_fb_t *fb = bsp_camera_capture();
+  if (!fb) {
+    return;
+  }
+  void *dst = jpeg_ring_reserve(&s_preroll, fb->len);
+  if (dst) {
+    memcpy(dst, fb->buf, fb->len);
+    jpeg_ring_commit(&s_preroll, fb_time_us(fb));
+  }
+  if (VISION_MOTION_CONFIRM) {
+    motion_result_t res;
+    (void)motion_gate_frame(fb, &res, NULL);
+  }
+  esp_camera_fb_return(fb);
+}
+
+// Saves the ring frames from the pre-roll window before edge_us, straight
+// from PSRAM, and empties the ring.
+static void preroll_flush(const char *subdir, int64_t burst_id, int64_t edge_us) {
+  size_t first = jpeg_ring_find(&s_preroll, edge_us - (int64_t)VISION_PREROLL_SECONDS * 1000000LL);
+  size_t last = jpeg_ring_find(&s_preroll, edge_us);
+  size_t saved = 0;
+  char path[128];
+  for (size_t i = first; i < last && bsp_storage_is_ready(); i++) {
+    jpeg_ring_frame_t f;
+    if (!jpeg_ring_get(&s_preroll, i, &f)) {
+      break;
+    }
+    int index = -(int)(last - i);
+    int64_t frame_ms = f.timestamp_us / 1000;
+    if (make_burst_path(path, sizeof(path), subdir, burst_id, index, frame_ms) != ESP_OK ||
+        bsp_storage_write_blob(path, f.data, f.len) != ESP_OK) {
+      ESP_LOGW(TAG, "Pre-roll frame %d not saved", index);
+      continue;
+    }
+    (void)append_burst_index(PIR_BURST_INDEX_PATH, burst_id, index, path, frame_ms, f.len);
+    saved++;
+  }
+  jpeg_ring_reset(&s_preroll);
+  ESP_LOGI(TAG, "Pre-roll: saved %u frames (%u evicted so far)", (unsigned)saved,
+           (unsigned)s_preroll.stats.evicted);
+}
+
+// Timelapse frames use their own profile; the camera goes back to the PIR
+// profile straight after so the next trigger does not wait for the switch.
+static void capture_timelapse(void) {
+  if (bsp_camera_use_profile(BSP_CAMERA_PROFILE_TIMELAPSE, TIMELAPSE_SWITCH_BUDGET_MS) != ESP_OK) {
+    ESP_LOGW(TAG, "Timelapse profile not applied");
+  }
+  (void)capture_and_store("timelapse", "timelapse", false, NULL);
+  (void)bsp_camera_use_profile(BSP_CAMERA_PROFILE_PIR, TIMELAPSE_SWITCH_BUDGET_MS);
+
+  bsp_camera_profile_stats_t st;
+  bsp_camera_get_profile_stats(&st);
+  jpeg_quality_ctl_t q;
+  bsp_camera_get_profile_quality(BSP_CAMERA_PROFILE_TIMELAPSE, &q);
+  ESP_LOGI(TAG, "Timelapse: %u bytes at quality %u; switch %u ms (max %u, %u drained, %u deferred)",
+           (unsigned)q.last_len, (unsigned)q.quality, (unsigned)(st.last_switch_us / 1000U),
+           (unsigned)(st.max_switch_us / 1000U), (unsigned)st.drained_frames, (unsigned)st.deferred);
+}
+
+// The post-trigger burst goes first so the pre-roll flush never delays it;
+// nothing is pushed into the ring while the burst runs.
+static void run_pir_capture(const pir_trigger_event_t *ev) {
+  const pir_trigger_event_t *trigger = ev;
+  if (bsp_camera_use_profile(BSP_CAMERA_PROFILE_PIR, PIR_SWITCH_BUDGET_MS) != ESP_OK) {
+    ESP_LOGW(TAG, "PIR profile not applied, capturing at the current size");
+  }
+  if (VISION_MOTION_CONFIRM) {
+    bool latency_logged;
+    if (!motion_confirm(ev, &latency_logged)) {
+      return;  // the pre-roll ring keeps running for the next trigger
+    }
+    if (latency_logged) {
+      trigger = NULL;  // already logged on the first confirmation frame
+    }
+  }
+
+  int64_t burst_id = bsp_storage_now_ms();
+  if (PIR_BURST_FRAMES <= 1) {
+    (void)capture_and_store("pir", "pir", true, trigger);
+  } else {
+    burst_result_t r;
+    if (capture_burst("pir", burst_id, PIR_BURST_FRAMES, true, PIR_BURST_INDEX_PATH, true, trigger, &r) ==
+        ESP_OK) {
+      uint32_t fps_x10 = burst_fps_x10(&r);
+      jpeg_quality_ctl_t q;
+      bsp_camera_get_profile_quality(BSP_CAMERA_PROFILE_PIR, &q);
+      ESP_LOGI(TAG, "PIR burst: %u frames, %u bytes, %u ms, %u.%u fps, quality now %u (%u over budget)",
+               (unsigned)r.frames, (unsigned)r.bytes, (unsigned)((r.last_us - r.first_us) / 1000),
+               (unsigned)(fps_x10 / 10U), (unsigned)(fps_x10 % 10U), (unsigned)q.quality,
+               (unsigned)q.over_budget);
+    } else {
+      ESP_LOGW(TAG, "PIR burst failed");
+    }
+  }
+  if (s_preroll_ready) {
+    preroll_flush("pir", burst_id, ev->edge_us);
+  }
+}
+
+#if VISION_BURST_BENCHMARK
+// Sustained fps per frame size, sensor-limited (no SD) and with every frame
+// written to /sdcard/bench. Leaves the camera at the PIR profile size.
+static void run_burst_benchmark(void) {
+  static const struct {
+    framesize_t size;
+    const char *name;
+  } sizes[] = {
+      {FRAMESIZE_QVGA, "QVGA"}, {FRAMESIZE_VGA, "VGA"},   {FRAMESIZE_SVGA, "SVGA"},
+      {FRAMESIZE_XGA, "XGA"},   {FRAMESIZE_SXGA, "SXGA"}, {FRAMESIZE_UXGA, "UXGA"},
+  };
+  for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+    if (bsp_camera_reinit(sizes[i].size) != ESP_OK) {
+      ESP_LOGW(TAG, "Bench %s: camera reinit failed", sizes[i].name);
+      continue;
+    }
+    vTaskDelay(pdMS_TO_TICKS(500));  // let AEC settle
+    burst_result_t raw;
+    burst_result_t sd;
+    if (capture_burst("bench", bsp_storage_now_ms(), VISION_BENCH_FRAMES, false, NULL, false, NULL, &raw) != ESP_OK ||
+        capture_burst("bench", bsp_storage_now_ms(), VISION_BENCH_FRAMES, true, NULL, false, NULL, &sd) != ESP_OK) {
+      ESP_LOGW(TAG, "Bench %s: burst failed", sizes[i].name);
+      continue;
+    }
+    uint32_t raw_x10 = burst_fps_x10(&raw);
+    uint32_t sd_x10 = burst_fps_x10(&sd);
+    ESP_LOGI(TAG, "Bench %-4s: %u.%u fps sensor, %u.%u fps to SD, %u bytes/frame", sizes[i].name,
+             (unsigned)(raw_x10 / 10U), (unsigned)(raw_x10 % 10U), (unsigned)(sd_x10 / 10U),
+             (unsigned)(sd_x10 % 10U), (unsigned)(sd.frames ? sd.bytes / sd.frames : 0));
+  }
+  (void)bsp_camera_reinit(FRAMESIZE_SVGA);
+}
+#endif
+
 void sys_vision_task(void *pvParameters) {
   (void)pvParameters;
   ESP_LOGI(TAG, "Task started on Core %d", xPortGetCoreID());
 
-  int64_t last_timelapse_ms = esp_timer_get_time() / 1000 - TIMELAPSE_INTERVAL_MS;
+  // Normally created by bsp_env_init(); without it (no sensor board) the task
+  // still sleeps until the next timelapse instead of spinning.
+  if (pir_trigger_init() != ESP_OK) {
+    ESP_LOGE(TAG, "PIR trigger queue unavailable");
+  }
+
+#if VISION_BURST_BENCHMARK
+  run_burst_benchmark();
+#endif
+  preroll_init();
+
+  int64_t next_timelapse_ms = esp_timer_get_time() / 1000;
+  int64_t next_preroll_ms = next_timelapse_ms;
+  int64_t next_background_ms = next_timelapse_ms;
   int64_t last_pir_ms = 0;
 
   while (1) {
     int64_t now_ms = esp_timer_get_time() / 1000;
 
-    if ((now_ms - last_timelapse_ms) >= TIMELAPSE_INTERVAL_MS) {
-      last_timelapse_ms = now_ms;
+    if (now_ms >= next_timelapse_ms) {
+      next_timelapse_ms = now_ms + TIMELAPSE_INTERVAL_MS;
       ESP_LOGI(TAG, "Timelapse trigger");
-      (void)capture_and_store("timelapse", "timelapse", false);
+      capture_timelapse();
+      continue;
     }
 
-    if (bsp_pir_check() && (now_ms - last_pir_ms) >= PIR_COOLDOWN_MS) {
-      last_pir_ms = now_ms;
-      ESP_LOGI(TAG, "PIR trigger");
-      (void)capture_and_store("pir", "pir", true);
+    int64_t wake_ms = next_timelapse_ms;
+    if (s_preroll_ready) {
+      if (now_ms >= next_preroll_ms) {
+        preroll_capture();
+        next_preroll_ms += 1000 / VISION_PREROLL_FPS;
+        if (next_preroll_ms <= now_ms) {
+          next_preroll_ms = now_ms + 1000 / VISION_PREROLL_FPS;
+        }
+      }
+      if (next_preroll_ms < wake_ms) {
+        wake_ms = next_preroll_ms;
+      }
+    } else if (VISION_MOTION_CONFIRM) {
+      if (now_ms >= next_background_ms) {
+        motion_background_tick();
+        next_background_ms = now_ms + VISION_MOTION_BG_INTERVAL_MS;
+      }
+      if (next_background_ms < wake_ms) {
+        wake_ms = next_background_ms;
+      }
     }
 
-    vTaskDelay(pdMS_TO_TICKS(20));
+    // Block until motion or the next deadline, whichever comes first.
+    pir_trigger_event_t ev;
+    now_ms = esp_timer_get_time() / 1000;
+    if (!pir_trigger_wait(wake_ms > now_ms ? (uint32_t)(wake_ms - now_ms) : 0U, &ev)) {
+      continue;
+    }
+    // Edges queued during a capture or the cooldown are dropped here.
+    int64_t edge_ms = ev.edge_us / 1000;
+    if ((edge_ms - last_pir_ms) < PIR_COOLDOWN_MS) {
+      continue;
+    }
+    last_pir_ms = edge_ms;
+    ESP_LOGI(TAG, "PIR trigger");
+    run_pir_capture(&ev);
   }
 }
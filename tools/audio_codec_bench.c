@@ -0,0 +1,218 @@
+// Measures the firmware's clip encoders on Linux: compression ratio,
+// encode throughput, and a bit-exact FLAC decode check.
+//
+// Build from the repository root:
+//   cc -O2 -o audio_codec_bench tools/audio_codec_bench.c
+//      MVP/components/audio_pipeline/audio_codec.c
+//      -IMVP/components/audio_pipeline/include -lm
+//
+// Usage:
+//   audio_codec_bench [--write DIR] file.wav...
+//
+// The corpus from make_audio_corpus.py is a reasonable input. Throughput is
+// single-threaded (one core); scale by the host/ESP32-S3 clock ratio with
+// care, the on-target numbers come from the [audio_codec] unit test. With
+// --write, each input is also saved as DIR/<name>.flac and DIR/<name>.ima.wav
+// for listening or for checking with stock tools (flac -t, sox, ffprobe).
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_codec.h"
+#include "wav_load.h"
+
+typedef struct {
+  size_t samples;
+  size_t bytes;
+  double seconds;
+} codec_stats_t;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static const char *base_name(const char *path) {
+  const char *slash = strrchr(path, '/');
+  return slash ? slash + 1 : path;
+}
+
+static FILE *open_output(const char *dir, const char *path, const char *suffix, size_t header_bytes) {
+  if (!dir) {
+    return NULL;
+  }
+  char name[512];
+  snprintf(name, sizeof(name), "%s/%s", dir, base_name(path));
+  char *dot = strrchr(name, '.');
+  if (dot && dot > strrchr(name, '/')) {
+    *dot = '\0';
+  }
+  strncat(name, suffix, sizeof(name) - strlen(name) - 1);
+  FILE *f = fopen(name, "wb");
+  if (!f) {
+    fprintf(stderr, "%s: cannot create\n", name);
+    return NULL;
+  }
+  // Header is written last, once the totals are known.
+  uint8_t zero[IMA_ADPCM_HEADER_BYTES] = {0};
+  fwrite(zero, 1, header_bytes, f);
+  return f;
+}
+
+static void close_output(FILE *f, const uint8_t *header, size_t header_bytes) {
+  if (!f) {
+    return;
+  }
+  fseek(f, 0, SEEK_SET);
+  fwrite(header, 1, header_bytes, f);
+  fclose(f);
+}
+
+// Returns 0 when every frame decodes back to the input.
+static int run_flac(const wav_data_t *wav, const char *path, const char *out_dir, codec_stats_t *st) {
+  uint8_t *frame = malloc(FLAC_MAX_FRAME_BYTES(FLAC_BLOCK_SAMPLES));
+  uint32_t *scratch = malloc(FLAC_BLOCK_SAMPLES * sizeof(uint32_t));
+  int16_t *decoded = malloc(FLAC_BLOCK_SAMPLES * sizeof(int16_t));
+  if (!frame || !scratch || !decoded) {
+    free(frame);
+    free(scratch);
+    free(decoded);
+    return -1;
+  }
+
+  FILE *out = open_output(out_dir, path, ".flac", FLAC_HEADER_BYTES);
+  uint32_t min_frame = UINT32_MAX;
+  uint32_t max_frame = 0;
+  size_t bytes = 0;
+  double encode_s = 0.0;
+  int mismatch = 0;
+  uint32_t frame_number = 0;
+
+  for (size_t off = 0; off < wav->samples; off += FLAC_BLOCK_SAMPLES, frame_number++) {
+    size_t count = wav->samples - off < FLAC_BLOCK_SAMPLES ? wav->samples - off : FLAC_BLOCK_SAMPLES;
+    double t0 = now_s();
+    size_t n = flac_encode_frame(wav->pcm + off, count, frame_number, wav->rate, scratch, frame);
+    encode_s += now_s() - t0;
+    bytes += n;
+    min_frame = n < min_frame ? (uint32_t)n : min_frame;
+    max_frame = n > max_frame ? (uint32_t)n : max_frame;
+    if (out) {
+      fwrite(frame, 1, n, out);
+    }
+
+    size_t got = 0;
+    if (flac_decode_frame(frame, n, decoded, FLAC_BLOCK_SAMPLES, &got) != n || got != count ||
+        memcmp(decoded, wav->pcm + off, count * sizeof(int16_t)) != 0) {
+      fprintf(stderr, "%s: FLAC frame %u does not decode bit-exact\n", path, (unsigned)frame_number);
+      mismatch = 1;
+    }
+  }
+
+  uint8_t header[FLAC_HEADER_BYTES];
+  audio_codec_build_header(AUDIO_CODEC_FLAC, header, wav->rate, (uint32_t)wav->samples, (uint32_t)bytes,
+                           min_frame == UINT32_MAX ? 0 : min_frame, max_frame);
+  close_output(out, header, sizeof(header));
+
+  st->samples += wav->samples;
+  st->bytes += bytes + FLAC_HEADER_BYTES;
+  st->seconds += encode_s;
+  free(frame);
+  free(scratch);
+  free(decoded);
+  return mismatch ? -1 : 0;
+}
+
+// Returns the SNR of the decoded signal in dB.
+static double run_ima(const wav_data_t *wav, const char *path, const char *out_dir, codec_stats_t *st) {
+  uint8_t block[IMA_ADPCM_BLOCK_BYTES];
+  int16_t *recon = malloc(IMA_ADPCM_BLOCK_SAMPLES * sizeof(int16_t));
+  if (!recon) {
+    return 0.0;
+  }
+
+  FILE *out = open_output(out_dir, path, ".ima.wav", IMA_ADPCM_HEADER_BYTES);
+  uint8_t index = 0;
+  size_t bytes = 0;
+  double encode_s = 0.0;
+  double err2 = 0.0;
+  double sig2 = 0.0;
+
+  for (size_t off = 0; off < wav->samples; off += IMA_ADPCM_BLOCK_SAMPLES) {
+    size_t count = wav->samples - off < IMA_ADPCM_BLOCK_SAMPLES ? wav->samples - off : IMA_ADPCM_BLOCK_SAMPLES;
+    double t0 = now_s();
+    bytes += ima_adpcm_encode_block(&index, wav->pcm + off, count, block, recon);
+    encode_s += now_s() - t0;
+    if (out) {
+      fwrite(block, 1, sizeof(block), out);
+    }
+    for (size_t i = 0; i < count; i++) {
+      double e = (double)wav->pcm[off + i] - recon[i];
+      err2 += e * e;
+      sig2 += (double)wav->pcm[off + i] * wav->pcm[off + i];
+    }
+  }
+
+  uint8_t header[IMA_ADPCM_HEADER_BYTES];
+  audio_codec_build_header(AUDIO_CODEC_IMA_ADPCM, header, wav->rate, (uint32_t)wav->samples, (uint32_t)bytes, 0, 0);
+  close_output(out, header, sizeof(header));
+
+  st->samples += wav->samples;
+  st->bytes += bytes + IMA_ADPCM_HEADER_BYTES;
+  st->seconds += encode_s;
+  free(recon);
+  return err2 > 0.0 ? 10.0 * log10(sig2 / err2) : INFINITY;
+}
+
+static void print_stats(const char *name, const codec_stats_t *st) {
+  printf("%-10s ratio %5.2f:1  %7.2f Msamples/s/core  %7.0fx real time at 16 kHz\n", name,
+         st->bytes ? (double)(st->samples * 2) / (double)st->bytes : 0.0,
+         st->seconds > 0.0 ? (double)st->samples / st->seconds / 1e6 : 0.0,
+         st->seconds > 0.0 ? (double)st->samples / st->seconds / 16000.0 : 0.0);
+}
+
+int main(int argc, char **argv) {
+  const char *out_dir = NULL;
+  codec_stats_t flac = {0};
+  codec_stats_t ima = {0};
+  int files = 0;
+  int failures = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--write") && i + 1 < argc) {
+      out_dir = argv[++i];
+      continue;
+    }
+    if (argv[i][0] == '-') {
+      fprintf(stderr, "usage: %s [--write DIR] file.wav...\n", argv[0]);
+      return 2;
+    }
+
+    wav_data_t wav = {0};
+    if (load_wav(argv[i], &wav) != 0) {
+      failures++;
+      continue;
+    }
+    size_t flac_before = flac.bytes;
+    int exact = run_flac(&wav, argv[i], out_dir, &flac);
+    double snr = run_ima(&wav, argv[i], out_dir, &ima);
+    printf("%s: %zu samples, flac %.2f:1%s, ima %.1f dB SNR\n", argv[i], wav.samples,
+           (double)(wav.samples * 2) / (double)(flac.bytes - flac_before), exact == 0 ? "" : " MISMATCH", snr);
+    failures += exact != 0;
+    files++;
+    free(wav.pcm);
+  }
+
+  if (files == 0) {
+    fprintf(stderr, "usage: %s [--write DIR] file.wav...\n", argv[0]);
+    return 2;
+  }
+  printf("\n%d files\n", files);
+  print_stats("flac", &flac);
+  print_stats("ima_adpcm", &ima);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+// Replays WAV files through the firmware's audio event detectors on Linux.
+//
+// Build from the repository root:
+//   cc -O2 -o audio_detect_replay tools/audio_detect_replay.c
+//      MVP/components/audio_pipeline/audio_detect.c
+//      MVP/components/audio_pipeline/audio_spectral.c
+//      -IMVP/components/audio_pipeline/include -lm
+//
+// Usage:
+//   audio_detect_replay [--frame N] [--trigger-db X] [--release-db X]
+//                       [--hold N] [--bands LO-HI[,LO-HI...]]
+//                       [--manifest corpus/manifest.csv] [-v] file.wav...
+//
+// --bands switches the trigger to the spectral stage (e.g. 2000-8000), as
+// AUDIO_SPECTRAL_TRIGGER does on the device; the SNR options then apply to
+// the bands.
+//
+// Prints onsets per file, triggers per hour, detector throughput and CPU
+// time per second of audio. With a
+// manifest (lines of "file.wav,expected_events"), files listed on the command
+// line may be omitted and false/missed triggers are totalled so detector
+// changes can be compared against the same corpus.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_detect.h"
+#include "audio_spectral.h"
+#include "wav_load.h"
+
+#define MAX_FILES 256
+
+static uint32_t db_to_q8(double db) {
+  return (uint32_t)lround(AUDIO_DETECT_Q8_ONE * pow(10.0, db / 10.0));
+}
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+  audio_detect_config_t cfg;
+  audio_detect_default_config(&cfg);
+  audio_spectral_config_t scfg;
+  audio_spectral_default_config(&scfg, 16000);
+  scfg.band_count = 0;
+  uint32_t trigger_q8 = 0;
+  uint32_t release_q8 = 0;
+  size_t frame = 512;
+  int verbose = 0;
+  const char *manifest = NULL;
+  const char *files[MAX_FILES];
+  int expected[MAX_FILES];
+  int nfiles = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--frame") && i + 1 < argc) {
+      frame = (size_t)atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--trigger-db") && i + 1 < argc) {
+      trigger_q8 = db_to_q8(atof(argv[++i]));
+    } else if (!strcmp(argv[i], "--release-db") && i + 1 < argc) {
+      release_q8 = db_to_q8(atof(argv[++i]));
+    } else if (!strcmp(argv[i], "--hold") && i + 1 < argc) {
+      cfg.hold_frames = (uint16_t)atoi(argv[++i]);
+      scfg.hold_frames = cfg.hold_frames;
+    } else if (!strcmp(argv[i], "--bands") && i + 1 < argc) {
+      char *spec = argv[++i];
+      while (*spec && scfg.band_count < AUDIO_SPECTRAL_MAX_BANDS) {
+        char *end = NULL;
+        scfg.bands[scfg.band_count].lo_hz = (uint16_t)strtoul(spec, &end, 10);
+        if (*end != '-') {
+          fprintf(stderr, "bad band spec %s\n", spec);
+          return 2;
+        }
+        scfg.bands[scfg.band_count].hi_hz = (uint16_t)strtoul(end + 1, &end, 10);
+        scfg.band_count++;
+        spec = (*end == ',') ? end + 1 : end;
+      }
+    } else if (!strcmp(argv[i], "--manifest") && i + 1 < argc) {
+      manifest = argv[++i];
+    } else if (!strcmp(argv[i], "-v")) {
+      verbose = 1;
+    } else if (argv[i][0] == '-') {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 2;
+    } else if (nfiles < MAX_FILES) {
+      expected[nfiles] = -1;
+      files[nfiles++] = argv[i];
+    }
+  }
+
+  static char names[MAX_FILES][1024];
+  if (manifest) {
+    FILE *mf = fopen(manifest, "r");
+    if (!mf) {
+      fprintf(stderr, "%s: cannot open\n", manifest);
+      return 2;
+    }
+    // Manifest entries are relative to the manifest's directory.
+    char dir[400] = ".";
+    const char *slash = strrchr(manifest, '/');
+    if (slash) {
+      snprintf(dir, sizeof(dir), "%.*s", (int)(slash - manifest), manifest);
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), mf) && nfiles < MAX_FILES) {
+      char *comma = strchr(line, ',');
+      if (!comma || line[0] == '#') {
+        continue;
+      }
+      *comma = '\0';
+      snprintf(names[nfiles], sizeof(names[nfiles]), "%s/%s", dir, line);
+      files[nfiles] = names[nfiles];
+      expected[nfiles++] = atoi(comma + 1);
+    }
+    fclose(mf);
+  }
+
+  if (trigger_q8) {
+    cfg.trigger_snr_q8 = scfg.trigger_snr_q8 = trigger_q8;
+  }
+  if (release_q8) {
+    cfg.release_snr_q8 = scfg.release_snr_q8 = release_q8;
+  }
+
+  if (nfiles == 0 || frame == 0) {
+    fprintf(stderr, "usage: %s [options] [--manifest m.csv] file.wav...\n", argv[0]);
+    return 2;
+  }
+
+  double total_audio_s = 0.0;
+  double total_cpu_s = 0.0;
+  uint64_t total_samples = 0;
+  int total_onsets = 0;
+  int false_triggers = 0;
+  int missed = 0;
+
+  printf("%-40s %8s %7s %8s %9s\n", "file", "seconds", "onsets", "expected", "per_hour");
+  for (int i = 0; i < nfiles; i++) {
+    wav_data_t wav = {0};
+    if (load_wav(files[i], &wav) != 0) {
+      continue;
+    }
+
+    audio_detect_t det;
+    audio_detect_init(&det, &cfg);
+    audio_detect_frame_t info;
+    audio_spectral_t sp;
+    audio_spectral_frame_t band;
+    bool spectral = scfg.band_count > 0;
+    if (spectral) {
+      scfg.sample_rate = wav.rate;
+      scfg.fft_size = 1;
+      while (scfg.fft_size < frame && scfg.fft_size < AUDIO_SPECTRAL_MAX_FFT) {
+        scfg.fft_size <<= 1;
+      }
+      if (!audio_spectral_init(&sp, &scfg)) {
+        fprintf(stderr, "bad spectral config\n");
+        return 2;
+      }
+    }
+    int onsets = 0;
+
+    double t0 = now_s();
+    for (size_t off = 0; off + frame <= wav.samples; off += frame) {
+      bool onset = audio_detect_process(&det, wav.pcm + off, frame, &info);
+      if (spectral) {
+        onset = audio_spectral_process(&sp, wav.pcm + off, frame, &band);
+      }
+      if (onset) {
+        onsets++;
+        if (verbose && spectral) {
+          printf("  onset at %.3f s band0 snr=%.1f dB\n", (double)off / wav.rate,
+                 10.0 * log10((double)band.snr_q8[0] / AUDIO_DETECT_Q8_ONE));
+        } else if (verbose) {
+          printf("  onset at %.3f s rms=%u peak=%u floor=%u snr=%.1f dB\n", (double)off / wav.rate,
+                 (unsigned)info.rms, (unsigned)info.peak, (unsigned)info.floor_rms,
+                 10.0 * log10((double)info.snr_q8 / AUDIO_DETECT_Q8_ONE));
+        }
+      }
+    }
+    total_cpu_s += now_s() - t0;
+    if (spectral) {
+      audio_spectral_free(&sp);
+    }
+
+    double seconds = (double)wav.samples / wav.rate;
+    total_audio_s += seconds;
+    total_samples += wav.samples;
+    total_onsets += onsets;
+    if (expected[i] >= 0) {
+      if (onsets > expected[i]) {
+        false_triggers += onsets - expected[i];
+      } else {
+        missed += expected[i] - onsets;
+      }
+      printf("%-40s %8.1f %7d %8d %9.1f\n", files[i], seconds, onsets, expected[i], onsets * 3600.0 / seconds);
+    } else {
+      printf("%-40s %8.1f %7d %8s %9.1f\n", files[i], seconds, onsets, "-", onsets * 3600.0 / seconds);
+    }
+    free(wav.pcm);
+  }
+
+  printf("\ntotal: %.1f s audio, %d onsets (%.1f/h)", total_audio_s, total_onsets,
+         total_audio_s > 0 ? total_onsets * 3600.0 / total_audio_s : 0.0);
+  if (manifest) {
+    printf(", %d false, %d missed", false_triggers, missed);
+  }
+  printf("\nthroughput: %.1f Msamples/s, %.3f ms CPU per audio second\n",
+         total_cpu_s > 0 ? total_samples / total_cpu_s / 1e6 : 0.0,
+         total_audio_s > 0 ? total_cpu_s * 1000.0 / total_audio_s : 0.0);
+  return (manifest && (false_triggers || missed)) ? 1 : 0;
+}
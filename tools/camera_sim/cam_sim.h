@@ -0,0 +1,94 @@
+#pragma once
+
+// Host simulator for the camera capture path.
+//
+// ll_cam_sim.c replaces the ESP32-S3 LCD_CAM/GDMA target (target/esp32s3/
+// ll_cam.c) and sccb_sim.c answers SCCB as an OV2640, so the unmodified
+// cam_hal.c, esp_camera.c, ov2640.c and bsp_camera.c run on Linux. A source
+// thread plays the sensor and the DMA engine: it writes each frame into the
+// same DMA nodes the hardware would (the ping-pong ring in internal RAM, or the
+// frame buffer itself in PSRAM DMA mode), raises IN_SUC_EOF after every
+// dma_half_buffer_size bytes and VSYNC between frames, through the driver's own
+// ll_cam_send_event(). cam_task and cam_take() see the same event sequence as
+// on the board, including queue overflows when they fall behind.
+//
+// Frames come from files or memory. JPEG frames whose SOF size matches the
+// sensor's current framesize are preferred, so framesize switches behave as on
+// the device; RGB565/YUV422 frames must match the framesize exactly and are
+// replaced by a moving test pattern when none does.
+//
+// Faults are injected per frame or held until the reset that clears them on
+// hardware, which lets the bsp_camera recovery tiers run end to end.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_camera.h"
+#include "esp_err.h"
+
+// Defaults: 25 fps, 10 MB/s within a frame (OV2640 JPEG at 20 MHz XCLK),
+// 2 ms vertical blanking, lossy.
+typedef struct {
+  uint32_t fps;                // frame starts per second, 0 = back to back
+  uint32_t pclk_bytes_per_s;   // bus rate within a frame, 0 = as fast as possible
+  uint32_t vblank_us;          // wait after VSYNC for cam_task to restart DMA
+  bool lossless;               // hold the bus until cam_task has caught up
+} cam_sim_config_t;
+
+typedef enum {
+  // Per-frame faults, applied to the next `frames` frames.
+  CAM_SIM_FAULT_TRUNCATE = 0,  // stop the frame after `param` bytes (0: half of it)
+  CAM_SIM_FAULT_NO_EOI,        // zero the final FF D9
+  CAM_SIM_FAULT_NO_SOI,        // zero the leading FF D8
+  CAM_SIM_FAULT_DROP_EOF,      // data lands but no IN_SUC_EOF is raised
+  CAM_SIM_FAULT_DROP_VSYNC,    // no VSYNC after the frame: it runs into the next
+  // Held faults, active until the matching reset.
+  CAM_SIM_FAULT_DMA_STALL,     // no data or EOF; cleared by ll_cam_dma_reset()
+  CAM_SIM_FAULT_SENSOR_HANG,   // no VSYNC either; cleared by an OV2640 soft reset
+  CAM_SIM_FAULT_WEDGED,        // like SENSOR_HANG; cleared only by ll_cam_deinit()
+  CAM_SIM_FAULT_MAX,
+} cam_sim_fault_t;
+
+typedef enum {
+  CAM_SIM_EVENT_EOF = 0,
+  CAM_SIM_EVENT_VSYNC,
+} cam_sim_event_t;
+
+typedef struct {
+  uint32_t frames;          // frames the sensor started
+  uint32_t frames_missed;   // started while DMA was not armed (no free buffer)
+  uint32_t vsync_events;
+  uint32_t eof_events;
+  uint32_t events_dropped;  // event queue full: ll_cam_send_event stopped DMA
+  uint64_t bytes;           // bytes written by the simulated DMA
+  uint32_t dma_resets;
+  uint32_t sensor_resets;
+  uint32_t faults[CAM_SIM_FAULT_MAX];  // frames (or holds) each fault affected
+} cam_sim_stats_t;
+
+void cam_sim_default_config(cam_sim_config_t *cfg);
+// Takes effect from the next frame.
+void cam_sim_set_config(const cam_sim_config_t *cfg);
+
+// Adds a frame to the source list; the data is copied. For JPEG, width and
+// height may be 0 and are then read from the SOF marker.
+esp_err_t cam_sim_add_frame(pixformat_t format, uint16_t width, uint16_t height, const uint8_t *data,
+                            size_t len);
+// .jpg/.jpeg files, or raw frames named *_<W>x<H>.rgb565 / *_<W>x<H>.yuv422.
+esp_err_t cam_sim_add_file(const char *path);
+void cam_sim_clear_frames(void);
+size_t cam_sim_frame_count(void);
+
+void cam_sim_inject(cam_sim_fault_t fault, uint32_t frames, uint32_t param);
+void cam_sim_clear_faults(void);
+// Raises one event as the interrupt handler would, outside the frame timing.
+esp_err_t cam_sim_post_event(cam_sim_event_t event);
+
+void cam_sim_get_stats(cam_sim_stats_t *out);
+void cam_sim_reset_stats(void);
+
+const char *cam_sim_fault_name(cam_sim_fault_t fault);
+
+// Called by sccb_sim.c on an OV2640 COM7 soft reset.
+void cam_sim_sensor_reset(void);
@@ -0,0 +1,318 @@
+// Host benchmark of the JPEG capture path on the camera simulator.
+//
+// markers: cost of the SOI/EOI probes in cam_hal.c per frame size. "old"
+//   is the byte-by-byte search the driver used before jpeg_marker_find():
+//   backward over the whole copied frame in internal-RAM mode (hit: through
+//   the stale tail after EOI; miss: the whole frame). "new" is the forward
+//   word-at-a-time search over the eoi_probe_window() both modes use now.
+//   The scan columns are the raw search over a whole frame with no marker.
+//   The probes are static, so this file includes cam_hal.c instead of
+//   linking it.
+// take: esp_camera_fb_get() throughput with the simulator running back to
+//   back (no frame pacing, no bus pacing, lossless), i.e. how fast cam_task
+//   and cam_take() can move frames through the real state machine, with
+//   the copy and cache sync time per frame from esp_camera_get_path_stats().
+//
+// Host numbers rank alternatives and show scaling with frame size; they are
+// not ESP32-S3 timings. Built and run by tools/test_camera_sim.py --bench:
+//   camera_sim_bench [--only markers|take] [--quick]
+
+#include "cam_hal.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "cam_sim.h"
+#include "idf_host.h"
+
+typedef struct {
+  const char *name;
+  framesize_t size;
+} bench_size_t;
+
+static const bench_size_t k_sizes[] = {
+    {"QVGA", FRAMESIZE_QVGA}, {"VGA", FRAMESIZE_VGA},   {"SVGA", FRAMESIZE_SVGA},
+    {"XGA", FRAMESIZE_XGA},   {"SXGA", FRAMESIZE_SXGA}, {"UXGA", FRAMESIZE_UXGA},
+};
+#define SIZE_COUNT (sizeof(k_sizes) / sizeof(k_sizes[0]))
+
+// Same 1 KiB DMA half and node as ll_cam_dma_sizes() on the S3 in JPEG mode.
+#define JPEG_DMA_HALF 1024U
+
+static double s_min_ms = 200.0;
+static volatile int s_sink;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static uint32_t s_rng = 0x12345678U;
+
+static uint32_t next_rand(void) {
+  s_rng ^= s_rng << 13;
+  s_rng ^= s_rng >> 17;
+  s_rng ^= s_rng << 5;
+  return s_rng;
+}
+
+// Entropy-coded-looking bytes: uniform, with every FF stuffed by 00 so no
+// marker appears inside.
+static void fill_entropy(uint8_t *buf, size_t len) {
+  for (size_t i = 0; i < len; i++) {
+    buf[i] = (uint8_t)next_rand();
+    if (buf[i] == 0xFF && i + 1 < len) {
+      buf[++i] = 0x00;
+    }
+  }
+}
+
+// A frame as cam_take() sees it in internal-RAM mode: the JPEG followed by
+// the rest of the last DMA half, holding older data. Returns the buffer
+// length; *jpeg_len is where EOI ends.
+static size_t make_frame(uint8_t *buf, size_t jpeg_len, size_t *out_jpeg_len) {
+  size_t len = (jpeg_len + JPEG_DMA_HALF - 1) / JPEG_DMA_HALF * JPEG_DMA_HALF;
+  fill_entropy(buf, len);
+  buf[0] = 0xFF;
+  buf[1] = 0xD8;
+  buf[2] = 0xFF;
+  buf[jpeg_len - 2] = 0xFF;
+  buf[jpeg_len - 1] = 0xD9;
+  if (buf[jpeg_len - 3] == 0xFF) {
+    buf[jpeg_len - 3] = 0x00;
+  }
+  *out_jpeg_len = jpeg_len;
+  return len;
+}
+
+// The probes as they were before jpeg_marker_find(), for comparison.
+static int old_eoi_backward(const uint8_t *inbuf, uint32_t length) {
+  static const uint8_t eoi[] = {0xFF, 0xD9};
+  if (length < 2) {
+    return -1;
+  }
+  const uint8_t *dptr = inbuf + length - 2;
+  while (dptr >= inbuf) {
+    if (memcmp(dptr, eoi, 2) == 0) {
+      return dptr - inbuf;
+    }
+    if (dptr == inbuf) {
+      break;
+    }
+    dptr--;
+  }
+  return -1;
+}
+
+static int old_soi(const uint8_t *inbuf, uint32_t length) {
+  for (uint32_t i = 0; i + JPEG_SOI_MARKER_LEN <= length; i++) {
+    if (memcmp(&inbuf[i], JPEG_SOI_MARKER, JPEG_SOI_MARKER_LEN) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static int old_scan_forward(const uint8_t *inbuf, uint32_t length) {
+  for (uint32_t i = 0; i + 1 < length; i++) {
+    if (inbuf[i] == 0xFF && inbuf[i + 1] == 0xD9) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+typedef int (*probe_fn_t)(const uint8_t *buf, size_t len);
+
+static int probe_eoi_old(const uint8_t *buf, size_t len) {
+  return old_eoi_backward(buf, len);
+}
+
+static int probe_eoi_new(const uint8_t *buf, size_t len) {
+  size_t w = eoi_probe_window(JPEG_DMA_HALF, len);
+  int off = cam_verify_jpeg_eoi(buf + len - w, w);
+  return off < 0 ? -1 : (int)(len - w) + off;
+}
+
+static int probe_scan_old(const uint8_t *buf, size_t len) {
+  return old_scan_forward(buf, len);
+}
+
+static int probe_scan_new(const uint8_t *buf, size_t len) {
+  return jpeg_marker_find(buf, len, 0xD9);
+}
+
+static int probe_soi_old(const uint8_t *buf, size_t len) {
+  return old_soi(buf, len < JPEG_DMA_HALF ? len : JPEG_DMA_HALF);
+}
+
+static int probe_soi_new(const uint8_t *buf, size_t len) {
+  return cam_verify_jpeg_soi(buf, len < JPEG_DMA_HALF ? len : JPEG_DMA_HALF);
+}
+
+// Nanoseconds per call, repeated for at least s_min_ms.
+static double time_probe(probe_fn_t fn, const uint8_t *buf, size_t len, int expect) {
+  int got = fn(buf, len);
+  if (got != expect) {
+    fprintf(stderr, "probe returned %d, expected %d\n", got, expect);
+    exit(1);
+  }
+  unsigned reps = 1;
+  for (;;) {
+    double t0 = now_s();
+    int acc = 0;
+    for (unsigned r = 0; r < reps; r++) {
+      acc += fn(buf, len);
+    }
+    double dt = now_s() - t0;
+    s_sink += acc;
+    if (dt * 1000.0 >= s_min_ms) {
+      return dt * 1e9 / reps;
+    }
+    reps = dt > 0 ? (unsigned)(reps * (s_min_ms / 1000.0 / dt) * 1.2) + 1 : reps * 10;
+  }
+}
+
+static void bench_markers(void) {
+  printf("\nmarker probes (ns per frame; ~w*h/10 bytes of entropy data, 512 B stale tail)\n");
+  printf("%-5s %8s %10s %10s %10s %10s %10s %10s\n", "size", "bytes", "eoi-old", "eoi-new", "miss-old",
+         "miss-new", "scan-old", "scan-new");
+  for (size_t s = 0; s < SIZE_COUNT; s++) {
+    size_t pixels = (size_t)resolution[k_sizes[s].size].width * resolution[k_sizes[s].size].height;
+    size_t jpeg = pixels / 10U / JPEG_DMA_HALF * JPEG_DMA_HALF + JPEG_DMA_HALF / 2U;
+    uint8_t *buf = malloc(jpeg + JPEG_DMA_HALF);
+    size_t end;
+    size_t len = make_frame(buf, jpeg, &end);
+    int eoi = (int)end - 2;
+    double hit_old = time_probe(probe_eoi_old, buf, len, eoi);
+    double hit_new = time_probe(probe_eoi_new, buf, len, eoi);
+    buf[end - 1] = 0x00;
+    double miss_old = time_probe(probe_eoi_old, buf, len, -1);
+    double miss_new = time_probe(probe_eoi_new, buf, len, -1);
+    double scan_old = time_probe(probe_scan_old, buf, len, -1);
+    double scan_new = time_probe(probe_scan_new, buf, len, -1);
+    printf("%-5s %8zu %10.0f %10.0f %10.0f %10.0f %10.0f %10.0f\n", k_sizes[s].name, end, hit_old, hit_new,
+           miss_old, miss_new, scan_old, scan_new);
+    free(buf);
+  }
+
+  // The SOI probe covers the first DMA half; only a frame without SOI is
+  // scanned to the end.
+  uint8_t half[JPEG_DMA_HALF];
+  fill_entropy(half, sizeof(half));
+  double soi_old = time_probe(probe_soi_old, half, sizeof(half), -1);
+  double soi_new = time_probe(probe_soi_new, half, sizeof(half), -1);
+  printf("SOI miss over one DMA half: old %.0f ns, new %.0f ns\n", soi_old, soi_new);
+}
+
+static bool bench_take_one(framesize_t size, bool psram, double secs, double *fps, double *mbps,
+                           cam_sim_stats_t *st, camera_path_stats_t *path) {
+  camera_config_t cfg = {
+      .pin_pwdn = -1,
+      .pin_reset = -1,
+      .pin_xclk = -1,
+      .pin_sccb_sda = 40,
+      .pin_sccb_scl = 39,
+      .pin_vsync = 38,
+      .xclk_freq_hz = 20000000,
+      .pixel_format = PIXFORMAT_JPEG,
+      .frame_size = size,
+      .jpeg_quality = 12,
+      .fb_count = 2,
+      .fb_location = CAMERA_FB_IN_PSRAM,
+      .grab_mode = CAMERA_GRAB_WHEN_EMPTY,
+  };
+  esp_camera_set_psram_mode(psram);
+  if (esp_camera_init(&cfg) != ESP_OK) {
+    return false;
+  }
+  // Let the first frames through before timing.
+  for (int i = 0; i < 3; i++) {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (fb) {
+      esp_camera_fb_return(fb);
+    }
+  }
+  cam_sim_reset_stats();
+  esp_camera_reset_path_stats();
+  uint32_t frames = 0;
+  uint64_t bytes = 0;
+  double t0 = now_s();
+  double dt = 0;
+  do {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb) {
+      break;
+    }
+    frames++;
+    bytes += fb->len;
+    esp_camera_fb_return(fb);
+    dt = now_s() - t0;
+  } while (dt < secs);
+  cam_sim_get_stats(st);
+  esp_camera_get_path_stats(path);
+  esp_camera_deinit();
+  esp_camera_set_psram_mode(false);
+  *fps = frames / dt;
+  *mbps = (double)bytes / dt / 1e6;
+  return frames > 0;
+}
+
+static void bench_take(double secs) {
+  cam_sim_config_t sim;
+  cam_sim_default_config(&sim);
+  sim.fps = 0;
+  sim.pclk_bytes_per_s = 0;
+  sim.lossless = true;
+  cam_sim_set_config(&sim);
+  cam_sim_clear_frames();  // synthetic JPEGs at the sensor's framesize
+
+  printf("\ncam_take throughput (synthetic JPEG, q12, back to back)\n");
+  printf("%-5s %-8s %9s %9s %8s %8s %8s %8s\n", "size", "dma", "fps", "MB/s", "started", "missed", "copy-us",
+         "sync-us");
+  for (size_t s = 0; s < SIZE_COUNT; s++) {
+    for (int psram = 0; psram < 2; psram++) {
+      double fps = 0;
+      double mbps = 0;
+      cam_sim_stats_t st;
+      camera_path_stats_t path;
+      if (!bench_take_one(k_sizes[s].size, psram, secs, &fps, &mbps, &st, &path)) {
+        printf("%-5s %-8s failed\n", k_sizes[s].name, psram ? "psram" : "internal");
+        continue;
+      }
+      // per frame handed out, from the driver's own path counters
+      uint32_t taken = path.frames_taken ? path.frames_taken : 1;
+      printf("%-5s %-8s %9.0f %9.1f %8u %8u %8.1f %8.1f\n", k_sizes[s].name, psram ? "psram" : "internal", fps, mbps,
+             (unsigned)st.frames, (unsigned)st.frames_missed, (double)path.copy_us / taken,
+             (double)path.cache_sync_us / taken);
+      fflush(stdout);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  const char *only = NULL;
+  double take_secs = 1.0;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--only") && i + 1 < argc) {
+      only = argv[++i];
+    } else if (!strcmp(argv[i], "--quick")) {
+      s_min_ms = 20.0;
+      take_secs = 0.2;
+    } else {
+      fprintf(stderr, "usage: %s [--only markers|take] [--quick]\n", argv[0]);
+      return 2;
+    }
+  }
+  esp_log_level_set("*", ESP_LOG_NONE);
+  host_set_time_scale(1);
+  if (!only || !strcmp(only, "markers")) {
+    bench_markers();
+  }
+  if (!only || !strcmp(only, "take")) {
+    bench_take(take_secs);
+  }
+  return 0;
+}
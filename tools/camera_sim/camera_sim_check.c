@@ -0,0 +1,500 @@
+// Runs the firmware's capture path (bsp_camera -> esp_camera -> cam_hal) on
+// the camera simulator and checks it against injected faults: every frame
+// handed to the caller must be byte-identical to a source image, bad frames
+// must be dropped, and the recovery tiers must each clear the fault they are
+// meant for.
+//
+// Built and run by tools/test_camera_sim.py. By hand, from the repository
+// root, with the source list printed by `test_camera_sim.py --print-build`:
+//   camera_sim_check [--pictures DIR] [--only NAME] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp_camera.h"
+#include "cam_sim.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "idf_host.h"
+
+// Simulated time runs this much faster than the wall clock, so the driver's
+// 4 s frame timeout (hit five times before recovery starts) costs 0.1 s.
+#define CHECK_TIME_SCALE 40
+
+typedef struct {
+  uint8_t *data;
+  size_t len;
+} image_t;
+
+static const char *const k_pictures[] = {"test_inside.jpeg", "test_outside.jpeg", "testimg.jpeg"};
+#define PICTURE_COUNT (sizeof(k_pictures) / sizeof(k_pictures[0]))
+static image_t s_images[PICTURE_COUNT];
+static int s_failures;
+
+#define CHECK(cond, ...)                                 \
+  do {                                                   \
+    if (!(cond)) {                                       \
+      printf("    %s:%d: ", __func__, __LINE__);         \
+      printf(__VA_ARGS__);                               \
+      printf("\n");                                      \
+      ok = false;                                        \
+      goto out;                                          \
+    }                                                    \
+  } while (0)
+
+static bool load_image(const char *dir, const char *name, image_t *out) {
+  char path[512];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  out->len = (size_t)ftell(f);
+  fseek(f, 0, SEEK_SET);
+  out->data = malloc(out->len);
+  bool ok = out->data && fread(out->data, 1, out->len, f) == out->len;
+  fclose(f);
+  return ok && cam_sim_add_file(path) == ESP_OK;
+}
+
+// Index of the source image fb matches byte for byte, or -1.
+static int match_image(const camera_fb_t *fb) {
+  for (size_t i = 0; i < PICTURE_COUNT; i++) {
+    if (fb->len == s_images[i].len && !memcmp(fb->buf, s_images[i].data, fb->len)) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+static bool capture_exact(int count, const char *what) {
+  bool ok = true;
+  for (int i = 0; i < count; i++) {
+    camera_fb_t *fb = bsp_camera_capture();
+    CHECK(fb != NULL, "%s: capture %d returned no frame", what, i);
+    int idx = match_image(fb);
+    size_t len = fb->len;
+    esp_camera_fb_return(fb);
+    CHECK(idx >= 0, "%s: capture %d (%zu bytes) matches no source image", what, i, len);
+  }
+out:
+  return ok;
+}
+
+static void reset_sim(void) {
+  cam_sim_config_t cfg;
+  cam_sim_default_config(&cfg);
+  cam_sim_set_config(&cfg);
+  cam_sim_clear_faults();
+  cam_sim_reset_stats();
+}
+
+// ---- scenarios ----
+
+static bool check_capture(bool psram) {
+  bool ok = true;
+  esp_camera_set_psram_mode(psram);
+  CHECK(bsp_camera_init() == ESP_OK, "init failed");
+  ok = capture_exact(12, psram ? "psram dma" : "internal dma");
+  cam_sim_stats_t st;
+  cam_sim_get_stats(&st);
+  CHECK(st.eof_events > 0 && st.vsync_events > 0, "no DMA events raised");
+out:
+  bsp_camera_deinit();
+  esp_camera_set_psram_mode(false);
+  return ok;
+}
+
+static bool check_capture_internal(void) {
+  return check_capture(false);
+}
+
+static bool check_capture_psram(void) {
+  return check_capture(true);
+}
+
+// A frame cut short is still accepted if an FF D9 follows the cut: an EOI
+// inside the source itself (the end of an EXIF thumbnail), or one left in
+// the buffer by an earlier, longer frame. Such frames are made of source
+// bytes at their own offsets and shorter than the image they end in; report
+// them rather than fail, the driver cannot tell them from a good frame.
+static bool is_spliced(const camera_fb_t *fb) {
+  for (size_t off = 0; off < fb->len; off++) {
+    bool found = false;
+    for (size_t i = 0; i < PICTURE_COUNT && !found; i++) {
+      found = off < s_images[i].len && fb->buf[off] == s_images[i].data[off];
+    }
+    if (!found) {
+      return false;
+    }
+  }
+  return fb->len >= 2 && fb->buf[fb->len - 2] == 0xFF && fb->buf[fb->len - 1] == 0xD9;
+}
+
+// A damaged frame must never reach the caller, and the next one must.
+static bool check_frame_fault(cam_sim_fault_t fault, bool psram) {
+  bool ok = true;
+  cam_sim_reset_stats();
+  esp_camera_set_psram_mode(psram);
+  CHECK(bsp_camera_init() == ESP_OK, "init failed");
+  CHECK(capture_exact(2, "before fault"), "capture before the fault failed");
+  cam_sim_inject(fault, 3, 0);
+  for (int i = 0; i < 8; i++) {
+    camera_fb_t *fb = bsp_camera_capture();
+    CHECK(fb != NULL, "%s: capture %d returned no frame", cam_sim_fault_name(fault), i);
+    bool exact = match_image(fb) >= 0;
+    bool spliced = !exact && is_spliced(fb);
+    size_t len = fb->len;
+    esp_camera_fb_return(fb);
+    if (spliced) {
+      printf("    note: %s frame ended on a stale or embedded EOI, %zu bytes passed\n", cam_sim_fault_name(fault),
+             len);
+      continue;
+    }
+    CHECK(exact, "%s: capture %d (%zu bytes) matches no source image", cam_sim_fault_name(fault), i, len);
+  }
+  cam_sim_stats_t st;
+  cam_sim_get_stats(&st);
+  CHECK(st.faults[fault] == 3, "%s applied to %u frames, expected 3", cam_sim_fault_name(fault),
+        (unsigned)st.faults[fault]);
+out:
+  bsp_camera_deinit();
+  esp_camera_set_psram_mode(false);
+  return ok;
+}
+
+static bool check_truncate(void) {
+  return check_frame_fault(CAM_SIM_FAULT_TRUNCATE, false) && check_frame_fault(CAM_SIM_FAULT_TRUNCATE, true);
+}
+
+static bool check_no_eoi(void) {
+  return check_frame_fault(CAM_SIM_FAULT_NO_EOI, false) && check_frame_fault(CAM_SIM_FAULT_NO_EOI, true);
+}
+
+static bool check_no_soi(void) {
+  return check_frame_fault(CAM_SIM_FAULT_NO_SOI, false) && check_frame_fault(CAM_SIM_FAULT_NO_SOI, true);
+}
+
+static bool check_drop_eof(void) {
+  return check_frame_fault(CAM_SIM_FAULT_DROP_EOF, false) && check_frame_fault(CAM_SIM_FAULT_DROP_EOF, true);
+}
+
+// A lost VSYNC joins two frames in one buffer. Both carry SOI at the start
+// and EOI at the end, so the driver cannot tell; report what reaches the
+// caller and check that capture is clean again afterwards.
+static bool check_drop_vsync(void) {
+  bool ok = true;
+  CHECK(bsp_camera_init() == ESP_OK, "init failed");
+  CHECK(capture_exact(2, "before fault"), "capture before the fault failed");
+  cam_sim_inject(CAM_SIM_FAULT_DROP_VSYNC, 1, 0);
+  int merged = 0;
+  for (int i = 0; i < 6; i++) {
+    camera_fb_t *fb = bsp_camera_capture();
+    CHECK(fb != NULL, "capture %d returned no frame", i);
+    if (match_image(fb) < 0) {
+      merged++;
+      printf("    note: joined frame of %zu bytes passed as a valid JPEG\n", fb->len);
+    }
+    esp_camera_fb_return(fb);
+  }
+  CHECK(merged <= 1, "%d bad frames after one lost VSYNC", merged);
+  CHECK(capture_exact(4, "after lost vsync"), "capture did not recover");
+out:
+  bsp_camera_deinit();
+  return ok;
+}
+
+// Each held fault must be cleared by exactly the tier meant for it.
+static bool check_recovery_tier(cam_sim_fault_t fault, camera_recovery_tier_t expected) {
+  bool ok = true;
+  CHECK(bsp_camera_init() == ESP_OK, "init failed");
+  CHECK(capture_exact(1, "before fault"), "capture before the fault failed");
+  camera_recovery_stats_t before;
+  bsp_camera_get_recovery_stats(&before);
+  cam_sim_inject(fault, 1, 0);
+  int64_t t0 = esp_timer_get_time();
+  CHECK(capture_exact(1, cam_sim_fault_name(fault)), "no frame after %s", cam_sim_fault_name(fault));
+  camera_recovery_stats_t after;
+  bsp_camera_get_recovery_stats(&after);
+  for (int t = 0; t < CAMERA_RECOVERY_TIERS; t++) {
+    uint32_t fixes = after.tier[t].fixes - before.tier[t].fixes;
+    CHECK(fixes == (t == (int)expected ? 1U : 0U), "%s: tier %s fixed %u times",
+          cam_sim_fault_name(fault), camera_recovery_tier_name((camera_recovery_tier_t)t), (unsigned)fixes);
+  }
+  printf("    %s cleared by %s reset, %lld ms simulated\n", cam_sim_fault_name(fault),
+         camera_recovery_tier_name(expected), (long long)((esp_timer_get_time() - t0) / 1000));
+  CHECK(capture_exact(3, "after recovery"), "capture after recovery failed");
+out:
+  bsp_camera_deinit();
+  return ok;
+}
+
+static bool check_recovery(void) {
+  return check_recovery_tier(CAM_SIM_FAULT_DMA_STALL, CAMERA_RECOVERY_DMA) &&
+         check_recovery_tier(CAM_SIM_FAULT_SENSOR_HANG, CAMERA_RECOVERY_SENSOR) &&
+         check_recovery_tier(CAM_SIM_FAULT_WEDGED, CAMERA_RECOVERY_REINIT);
+}
+
+// Synthetic JPEGs carry the sensor's framesize in SOF and shrink with the
+// quality setting, so the profile switch drain and the byte-budget
+// controller run as on the device.
+static bool check_profiles(void) {
+  bool ok = true;
+  cam_sim_clear_frames();
+  CHECK(bsp_camera_init() == ESP_OK, "init failed");
+  CHECK(bsp_camera_use_profile(BSP_CAMERA_PROFILE_TIMELAPSE, 0) == ESP_OK, "switch to timelapse failed");
+  camera_fb_t *fb = bsp_camera_capture();
+  CHECK(fb && fb->width == 320 && fb->height == 240, "timelapse frame is not QVGA");
+  esp_camera_fb_return(fb);
+  CHECK(bsp_camera_use_profile(BSP_CAMERA_PROFILE_PIR, 0) == ESP_OK, "switch back to PIR failed");
+
+  for (int i = 0; i < 30; i++) {
+    fb = bsp_camera_capture();
+    CHECK(fb != NULL, "PIR capture %d failed", i);
+    esp_camera_fb_return(fb);
+  }
+  jpeg_quality_ctl_t q;
+  bsp_camera_get_profile_quality(BSP_CAMERA_PROFILE_PIR, &q);
+  bsp_camera_profile_stats_t ps;
+  bsp_camera_get_profile_stats(&ps);
+  printf("    PIR settled at q%u, last frame %u bytes (target %u); %u switches, %u frames drained\n",
+         (unsigned)q.quality, (unsigned)q.last_len, (unsigned)q.target_bytes, (unsigned)ps.switches,
+         (unsigned)ps.drained_frames);
+  CHECK(q.last_len <= q.target_bytes + q.target_bytes * q.tolerance_pct / 100U, "PIR frames stay over budget");
+  CHECK(ps.switches == 2, "expected 2 profile switches, saw %u", (unsigned)ps.switches);
+out:
+  bsp_camera_deinit();
+  for (size_t i = 0; i < PICTURE_COUNT; i++) {
+    cam_sim_add_frame(PIXFORMAT_JPEG, 0, 0, s_images[i].data, s_images[i].len);
+  }
+  return ok;
+}
+
+// JPEG-shaped frame of exactly len bytes: SOI, APP0, stuffed entropy, EOI.
+static void make_jpeg(uint8_t *buf, size_t len, uint32_t seed) {
+  static const uint8_t head[] = {0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x02};
+  memcpy(buf, head, sizeof(head));
+  for (size_t i = sizeof(head); i < len - 2; i++) {
+    seed = seed * 1664525U + 1013904223U;
+    buf[i] = (uint8_t)(seed >> 24);
+    if (buf[i] == 0xFF) {
+      buf[i] = 0x00;
+    }
+  }
+  buf[len - 2] = 0xFF;
+  buf[len - 1] = 0xD9;
+}
+
+// A frame that ends exactly on a DMA half boundary is followed in the buffer
+// by one more half of older data. Alternate it with a longer frame whose EOI
+// lands in that half, so the stale marker is there to be picked up.
+static bool check_stale_eoi_mode(bool psram) {
+  bool ok = true;
+  enum { SHORT_LEN = 5 * 1024, LONG_LEN = 5 * 1024 + 600 };
+  static uint8_t short_frame[SHORT_LEN];
+  static uint8_t long_frame[LONG_LEN];
+  make_jpeg(short_frame, sizeof(short_frame), 1);
+  make_jpeg(long_frame, sizeof(long_frame), 2);
+  cam_sim_clear_frames();
+  // No SOF in these, so give them the SVGA size bsp_camera runs at.
+  CHECK(cam_sim_add_frame(PIXFORMAT_JPEG, 800, 600, long_frame, sizeof(long_frame)) == ESP_OK &&
+            cam_sim_add_frame(PIXFORMAT_JPEG, 800, 600, short_frame, sizeof(short_frame)) == ESP_OK &&
+            cam_sim_add_frame(PIXFORMAT_JPEG, 800, 600, short_frame, sizeof(short_frame)) == ESP_OK,
+        "cannot add frames");
+  esp_camera_set_psram_mode(psram);
+  CHECK(bsp_camera_init() == ESP_OK, "init failed");
+  int shorts = 0;
+  for (int i = 0; i < 24; i++) {
+    camera_fb_t *fb = bsp_camera_capture();
+    CHECK(fb != NULL, "capture %d returned no frame", i);
+    bool is_short = fb->len == SHORT_LEN && !memcmp(fb->buf, short_frame, SHORT_LEN);
+    bool is_long = fb->len == LONG_LEN && !memcmp(fb->buf, long_frame, LONG_LEN);
+    size_t len = fb->len;
+    esp_camera_fb_return(fb);
+    CHECK(is_short || is_long, "%s: capture %d is %zu bytes, not one of the sources", psram ? "psram" : "internal",
+          i, len);
+    shorts += is_short;
+  }
+  CHECK(shorts > 0, "no boundary-length frame captured");
+out:
+  bsp_camera_deinit();
+  esp_camera_set_psram_mode(false);
+  cam_sim_clear_frames();
+  for (size_t i = 0; i < PICTURE_COUNT; i++) {
+    cam_sim_add_frame(PIXFORMAT_JPEG, 0, 0, s_images[i].data, s_images[i].len);
+  }
+  return ok;
+}
+
+static bool check_stale_eoi(void) {
+  return check_stale_eoi_mode(false) && check_stale_eoi_mode(true);
+}
+
+// Raw formats straight through esp_camera: exact frame size, and YUV422 to
+// grayscale through ll_cam_memcpy.
+// Ten EOFs per QVGA frame: at the accelerated clock cam_task would fall
+// behind, so hold the bus instead of overflowing the event queue.
+static camera_config_t raw_config(pixformat_t format) {
+  cam_sim_config_t sim;
+  cam_sim_default_config(&sim);
+  sim.lossless = true;
+  cam_sim_set_config(&sim);
+  camera_config_t cfg = {
+      .pin_pwdn = -1,
+      .pin_reset = -1,
+      .pin_xclk = -1,
+      .pin_sccb_sda = 40,
+      .pin_sccb_scl = 39,
+      .pin_vsync = 38,
+      .xclk_freq_hz = 20000000,
+      .pixel_format = format,
+      .frame_size = FRAMESIZE_QVGA,
+      .fb_count = 2,
+      .fb_location = CAMERA_FB_IN_PSRAM,
+      .grab_mode = CAMERA_GRAB_LATEST,
+  };
+  return cfg;
+}
+
+static bool check_raw_format(pixformat_t format, size_t bytes_per_pixel) {
+  bool ok = true;
+  camera_config_t cfg = raw_config(format);
+  CHECK(esp_camera_init(&cfg) == ESP_OK, "esp_camera_init failed");
+  for (int i = 0; i < 5; i++) {
+    camera_fb_t *fb = esp_camera_fb_get();
+    if (!fb) {
+      cam_sim_stats_t st;
+      cam_sim_get_stats(&st);
+      CHECK(false, "frame %d missing: %u started, %u missed, %u vsync, %u eof, %u dropped", i, (unsigned)st.frames,
+            (unsigned)st.frames_missed, (unsigned)st.vsync_events, (unsigned)st.eof_events,
+            (unsigned)st.events_dropped);
+    }
+    size_t len = fb->len;
+    esp_camera_fb_return(fb);
+    CHECK(len == 320U * 240U * bytes_per_pixel, "frame %d is %zu bytes", i, len);
+  }
+out:
+  esp_camera_deinit();
+  return ok;
+}
+
+static bool check_raw(void) {
+  return check_raw_format(PIXFORMAT_RGB565, 2) && check_raw_format(PIXFORMAT_YUV422, 2) &&
+         check_raw_format(PIXFORMAT_GRAYSCALE, 1);
+}
+
+// The path counters follow the path in use; the auto policy picks PSRAM DMA
+// for frames stored as captured and the copy path for converted ones until
+// esp_camera_calibrate_psram_mode() has measured both.
+static bool check_path_stats(void) {
+  bool ok = true;
+  camera_path_stats_t st;
+  CHECK(esp_camera_set_psram_policy(CAMERA_PSRAM_POLICY_AUTO) == ESP_ERR_INVALID_STATE,
+        "policy change before init should only be recorded");
+  CHECK(bsp_camera_init() == ESP_OK, "init failed");
+  CHECK(esp_camera_get_psram_mode(), "auto policy chose the copy path for JPEG");
+  CHECK(capture_exact(6, "auto"), "auto: bad frames");
+  CHECK(esp_camera_get_path_stats(&st) == ESP_OK, "no path stats");
+  CHECK(st.psram_mode && st.frames_taken >= 6 && st.frames >= st.frames_taken, "psram: %u frames, %u taken",
+        (unsigned)st.frames, (unsigned)st.frames_taken);
+  CHECK(st.copy_bytes == 0, "psram: %llu bytes copied", (unsigned long long)st.copy_bytes);
+  CHECK(st.elapsed_us > 0, "psram: no elapsed time");
+
+  CHECK(esp_camera_set_psram_mode(false) == ESP_OK, "switch to the copy path failed");
+  CHECK(esp_camera_get_psram_policy() == CAMERA_PSRAM_POLICY_MANUAL, "set_psram_mode kept the auto policy");
+  CHECK(capture_exact(6, "internal"), "internal: bad frames");
+  CHECK(esp_camera_get_path_stats(&st) == ESP_OK, "no path stats");
+  CHECK(!st.psram_mode && st.frames_taken >= 6, "internal: %u taken", (unsigned)st.frames_taken);
+  CHECK(st.copy_bytes >= (uint64_t)st.frames * 1024, "internal: %llu bytes copied for %u frames",
+        (unsigned long long)st.copy_bytes, (unsigned)st.frames);
+  CHECK(st.cache_sync_us == 0, "internal: cache sync counted");
+
+  esp_camera_reset_path_stats();
+  CHECK(esp_camera_get_path_stats(&st) == ESP_OK && st.frames == 0 && st.copy_bytes == 0, "reset kept counters");
+
+  CHECK(esp_camera_calibrate_psram_mode(6) == ESP_OK, "calibration failed");
+  CHECK(esp_camera_get_psram_policy() == CAMERA_PSRAM_POLICY_AUTO, "calibration left the manual policy");
+  CHECK(esp_camera_get_path_stats(&st) == ESP_OK && st.psram_mode == esp_camera_get_psram_mode(),
+        "stats and mode disagree");
+  CHECK(capture_exact(3, "calibrated"), "calibrated: bad frames");
+  bsp_camera_deinit();
+
+  camera_config_t cfg = raw_config(PIXFORMAT_GRAYSCALE);
+  CHECK(esp_camera_init(&cfg) == ESP_OK, "grayscale init failed");
+  CHECK(!esp_camera_get_psram_mode(), "auto policy chose PSRAM DMA for grayscale");
+  camera_fb_t *fb = esp_camera_fb_get();
+  CHECK(fb != NULL, "grayscale: no frame");
+  esp_camera_fb_return(fb);
+  CHECK(esp_camera_get_path_stats(&st) == ESP_OK && st.copy_bytes >= 320U * 240U, "grayscale: %llu bytes copied",
+        (unsigned long long)st.copy_bytes);
+out:
+  esp_camera_deinit();
+  bsp_camera_deinit();
+  esp_camera_set_psram_mode(false);
+  return ok;
+}
+
+typedef struct {
+  const char *name;
+  bool (*fn)(void);
+} scenario_t;
+
+static const scenario_t k_scenarios[] = {
+    {"capture_internal", check_capture_internal},
+    {"capture_psram", check_capture_psram},
+    {"truncate", check_truncate},
+    {"no_eoi", check_no_eoi},
+    {"no_soi", check_no_soi},
+    {"drop_eof", check_drop_eof},
+    {"drop_vsync", check_drop_vsync},
+    {"stale_eoi", check_stale_eoi},
+    {"recovery", check_recovery},
+    {"profiles", check_profiles},
+    {"raw", check_raw},
+    {"path_stats", check_path_stats},
+};
+
+int main(int argc, char **argv) {
+  const char *pictures = "MVP/components/esp32_camera/test/pictures";
+  const char *only = NULL;
+  esp_log_level_t level = ESP_LOG_NONE;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--pictures") && i + 1 < argc) {
+      pictures = argv[++i];
+    } else if (!strcmp(argv[i], "--only") && i + 1 < argc) {
+      only = argv[++i];
+    } else if (!strcmp(argv[i], "-v")) {
+      level = ESP_LOG_INFO;
+    } else {
+      fprintf(stderr, "usage: %s [--pictures DIR] [--only NAME] [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+  esp_log_level_set("*", level);
+  host_set_time_scale(CHECK_TIME_SCALE);
+  for (size_t i = 0; i < PICTURE_COUNT; i++) {
+    if (!load_image(pictures, k_pictures[i], &s_images[i])) {
+      fprintf(stderr, "cannot load %s/%s\n", pictures, k_pictures[i]);
+      return 2;
+    }
+  }
+
+  int run = 0;
+  for (size_t i = 0; i < sizeof(k_scenarios) / sizeof(k_scenarios[0]); i++) {
+    if (only && strcmp(only, k_scenarios[i].name)) {
+      continue;
+    }
+    reset_sim();
+    bool ok = k_scenarios[i].fn();
+    printf("%s %s\n", ok ? "PASS" : "FAIL", k_scenarios[i].name);
+    fflush(stdout);
+    s_failures += !ok;
+    run++;
+  }
+  printf("%d scenarios, %d failed\n", run, s_failures);
+  return s_failures ? 1 : 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+
+// Routed through the log level so the cam_hal ISR warnings can be silenced.
+int ets_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void ets_delay_us(uint32_t us);
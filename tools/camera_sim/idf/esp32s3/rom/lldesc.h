@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+
+// Same layout as the ROM descriptor. The simulated GDMA follows buf/size of
+// each node but ignores the hardware link (empty is only 32 bits wide).
+typedef struct lldesc_s {
+  volatile uint32_t size : 12, length : 12, offset : 5, sosf : 1, eof : 1, owner : 1;
+  volatile uint8_t *buf;
+  union {
+    volatile uint32_t empty;
+    struct lldesc_s *qe;
+  };
+} lldesc_t;
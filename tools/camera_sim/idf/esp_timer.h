@@ -0,0 +1,14 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Microseconds since the process started, CLOCK_MONOTONIC.
+int64_t esp_timer_get_time(void);
+
+#ifdef __cplusplus
+}
+#endif
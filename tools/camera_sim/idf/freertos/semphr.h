@@ -0,0 +1,28 @@
+#pragma once
+
+#include "freertos/queue.h"
+
+// Semaphores are queues in FreeRTOS too: a mutex is a one-slot queue that
+// holds a token while it is free. No priority inheritance.
+typedef QueueHandle_t SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+  QueueHandle_t q = xQueueCreate(1, 1);
+  const uint8_t token = 0;
+  if (q) {
+    xQueueSend(q, &token, 0);
+  }
+  return q;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait) {
+  uint8_t token;
+  return xQueueReceive(sem, &token, wait);
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  const uint8_t token = 0;
+  return xQueueSend(sem, &token, 0);
+}
+
+#define vSemaphoreDelete vQueueDelete
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "hal/cache_ll.h"
+
+// ESP32-S3 data cache line.
+static inline uint32_t cache_hal_get_cache_line_size(uint32_t level, cache_type_t type) {
+  (void)level;
+  (void)type;
+  return 32;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#define CACHE_LL_LEVEL_INT_MEM 0
+#define CACHE_LL_LEVEL_EXT_MEM 1
+
+typedef enum {
+  CACHE_TYPE_DATA,
+  CACHE_TYPE_INSTRUCTION,
+  CACHE_TYPE_ALL,
+} cache_type_t;
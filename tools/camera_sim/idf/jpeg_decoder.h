@@ -0,0 +1,10 @@
+#pragma once
+
+// Only the scale enum img_converters.h needs; the esp_jpeg decoder itself is
+// not part of the host build.
+typedef enum {
+  JPEG_IMAGE_SCALE_0 = 0,
+  JPEG_IMAGE_SCALE_1_2,
+  JPEG_IMAGE_SCALE_1_4,
+  JPEG_IMAGE_SCALE_1_8,
+} esp_jpeg_image_scale_t;
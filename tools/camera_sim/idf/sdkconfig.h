@@ -0,0 +1,17 @@
+#pragma once
+
+// Camera-relevant subset of the firmware's sdkconfig for the host build. The
+// simulator stands in for the ESP32-S3 LCD_CAM/GDMA, so the driver takes its
+// S3 code paths.
+
+#define CONFIG_IDF_TARGET "esp32s3"
+#define CONFIG_IDF_TARGET_ESP32S3 1
+#define CONFIG_FREERTOS_HZ 1000
+#define CONFIG_LOG_DEFAULT_LEVEL 3
+
+#define CONFIG_OV2640_SUPPORT 1
+#define CONFIG_SCCB_CLK_FREQ 100000
+#define CONFIG_CAMERA_TASK_STACK_SIZE 4096
+#define CONFIG_CAMERA_DMA_BUFFER_SIZE_MAX 32768
+#define CONFIG_CAMERA_JPEG_MODE_FRAME_SIZE_AUTO 1
+#define CONFIG_CAMERA_PATH_STATS 1
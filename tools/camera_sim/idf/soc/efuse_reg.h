@@ -0,0 +1,3 @@
+#pragma once
+
+// Included by conversions/to_jpg.cpp, which uses nothing from it.
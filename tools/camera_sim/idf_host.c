@@ -0,0 +1,508 @@
+// Host runtime behind the IDF shim headers in idf/: FreeRTOS tasks and queues
+// on POSIX threads, logging, esp_timer, heap_caps and the no-op GPIO/NVS/cache
+// calls the camera driver makes.
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "driver/gpio.h"
+#include "esp32s3/rom/ets_sys.h"
+#include "esp_cache.h"
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "idf_host.h"
+#include "nvs.h"
+
+static struct timespec s_epoch;
+static pthread_once_t s_epoch_once = PTHREAD_ONCE_INIT;
+static uint32_t s_time_scale = 1;
+
+static void init_epoch(void) {
+  clock_gettime(CLOCK_MONOTONIC, &s_epoch);
+}
+
+void host_set_time_scale(uint32_t scale) {
+  s_time_scale = scale ? scale : 1;
+}
+
+uint32_t host_get_time_scale(void) {
+  return s_time_scale;
+}
+
+int64_t esp_timer_get_time(void) {
+  pthread_once(&s_epoch_once, init_epoch);
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  int64_t ns = (int64_t)(now.tv_sec - s_epoch.tv_sec) * 1000000000 + (now.tv_nsec - s_epoch.tv_nsec);
+  return ns * s_time_scale / 1000;
+}
+
+void host_sleep_us(int64_t us) {
+  if (us <= 0) {
+    return;
+  }
+  int64_t ns = us * 1000 / s_time_scale;
+  struct timespec ts = {.tv_sec = (time_t)(ns / 1000000000), .tv_nsec = (long)(ns % 1000000000)};
+  while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+  }
+}
+
+void host_deadline_us(struct timespec *deadline, int64_t us) {
+  clock_gettime(CLOCK_MONOTONIC, deadline);
+  int64_t ns = us * 1000 / s_time_scale;
+  deadline->tv_sec += (time_t)(ns / 1000000000);
+  deadline->tv_nsec += (long)(ns % 1000000000);
+  if (deadline->tv_nsec >= 1000000000L) {
+    deadline->tv_sec++;
+    deadline->tv_nsec -= 1000000000L;
+  }
+}
+
+// ---- logging ----
+
+static esp_log_level_t s_log_level = (esp_log_level_t)CONFIG_LOG_DEFAULT_LEVEL;
+static pthread_mutex_t s_log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+  (void)tag;
+  s_log_level = level;
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...) {
+  static const char k_letters[] = "NEWIDV";
+  if (level > s_log_level) {
+    return;
+  }
+  va_list ap;
+  va_start(ap, format);
+  pthread_mutex_lock(&s_log_lock);
+  fprintf(stderr, "%c (%lld) %s: ", k_letters[level], (long long)(esp_timer_get_time() / 1000), tag);
+  vfprintf(stderr, format, ap);
+  fputc('\n', stderr);
+  pthread_mutex_unlock(&s_log_lock);
+  va_end(ap);
+}
+
+int ets_printf(const char *fmt, ...) {
+  if (s_log_level < ESP_LOG_WARN) {
+    return 0;
+  }
+  va_list ap;
+  va_start(ap, fmt);
+  pthread_mutex_lock(&s_log_lock);
+  int n = vfprintf(stderr, fmt, ap);
+  pthread_mutex_unlock(&s_log_lock);
+  va_end(ap);
+  return n;
+}
+
+void ets_delay_us(uint32_t us) {
+  host_sleep_us(us);
+}
+
+const char *esp_err_to_name(esp_err_t code) {
+  switch (code) {
+    case ESP_OK:
+      return "ESP_OK";
+    case ESP_FAIL:
+      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+      return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+      return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+      return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+      return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+      return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+      return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+      return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND:
+      return "ESP_ERR_NVS_NOT_FOUND";
+    default:
+      return "UNKNOWN ERROR";
+  }
+}
+
+void esp_restart(void) {
+  fprintf(stderr, "esp_restart() called\n");
+  abort();
+}
+
+// ---- heap ----
+
+void *heap_caps_malloc(size_t size, uint32_t caps) {
+  (void)caps;
+  return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps) {
+  (void)caps;
+  return calloc(n, size);
+}
+
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps) {
+  (void)caps;
+  void *p = NULL;
+  if (alignment < sizeof(void *)) {
+    alignment = sizeof(void *);
+  }
+  return posix_memalign(&p, alignment, size) == 0 ? p : NULL;
+}
+
+void *heap_caps_aligned_calloc(size_t alignment, size_t n, size_t size, uint32_t caps) {
+  void *p = heap_caps_aligned_alloc(alignment, n * size, caps);
+  if (p) {
+    memset(p, 0, n * size);
+  }
+  return p;
+}
+
+void heap_caps_free(void *ptr) {
+  free(ptr);
+}
+
+// 8 MB, the XIAO ESP32-S3 Sense PSRAM.
+size_t heap_caps_get_free_size(uint32_t caps) {
+  (void)caps;
+  return 8U * 1024U * 1024U;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps) {
+  return heap_caps_get_free_size(caps);
+}
+
+esp_err_t esp_cache_msync(void *addr, size_t size, int flags) {
+  (void)flags;
+  return addr && size ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+// ---- GPIO / NVS ----
+
+esp_err_t gpio_config(const gpio_config_t *cfg) {
+  return cfg ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level) {
+  (void)gpio;
+  (void)level;
+  return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out) {
+  (void)name;
+  (void)mode;
+  (void)out;
+  return ESP_ERR_NVS_NOT_FOUND;
+}
+
+void nvs_close(nvs_handle_t handle) {
+  (void)handle;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t len) {
+  (void)handle;
+  (void)key;
+  (void)value;
+  (void)len;
+  return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *len) {
+  (void)handle;
+  (void)key;
+  (void)out;
+  (void)len;
+  return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value) {
+  (void)handle;
+  (void)key;
+  (void)value;
+  return ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out) {
+  (void)handle;
+  (void)key;
+  (void)out;
+  return ESP_ERR_NVS_NOT_FOUND;
+}
+
+// ---- critical sections ----
+
+static pthread_mutex_t s_critical;
+static pthread_once_t s_critical_once = PTHREAD_ONCE_INIT;
+
+static void init_critical(void) {
+  pthread_mutexattr_t attr;
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&s_critical, &attr);
+  pthread_mutexattr_destroy(&attr);
+}
+
+void vPortEnterCritical(void) {
+  pthread_once(&s_critical_once, init_critical);
+  pthread_mutex_lock(&s_critical);
+}
+
+void vPortExitCritical(void) {
+  pthread_mutex_unlock(&s_critical);
+}
+
+BaseType_t xPortGetCoreID(void) {
+  return 0;
+}
+
+// ---- ticks and tasks ----
+
+TickType_t xTaskGetTickCount(void) {
+  return (TickType_t)(esp_timer_get_time() * configTICK_RATE_HZ / 1000000);
+}
+
+void vTaskDelay(TickType_t ticks) {
+  host_sleep_us((int64_t)ticks * 1000000 / configTICK_RATE_HZ);
+}
+
+struct host_task {
+  pthread_t thread;
+  TaskFunction_t fn;
+  void *arg;
+};
+
+static void *task_entry(void *p) {
+  struct host_task *t = p;
+  pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
+  t->fn(t->arg);
+  return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *out, BaseType_t core) {
+  (void)name;
+  (void)stack;
+  (void)prio;
+  (void)core;
+  struct host_task *t = calloc(1, sizeof(*t));
+  if (!t) {
+    return pdFAIL;
+  }
+  t->fn = fn;
+  t->arg = arg;
+  if (pthread_create(&t->thread, NULL, task_entry, t) != 0) {
+    free(t);
+    return pdFAIL;
+  }
+  if (out) {
+    *out = t;
+  }
+  return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t prio,
+                       TaskHandle_t *out) {
+  return xTaskCreatePinnedToCore(fn, name, stack, arg, prio, out, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+  if (!task) {
+    pthread_exit(NULL);
+  }
+  if (pthread_equal(task->thread, pthread_self())) {
+    pthread_detach(task->thread);
+    free(task);
+    pthread_exit(NULL);
+  }
+  pthread_cancel(task->thread);
+  pthread_join(task->thread, NULL);
+  free(task);
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task) {
+  (void)task;
+  return 1;
+}
+
+// ---- queues ----
+
+struct host_queue {
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  size_t item_size;
+  size_t length;
+  size_t head;
+  size_t count;
+  int receivers;  // tasks blocked in xQueueReceive
+  uint8_t *items;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+  struct host_queue *q = calloc(1, sizeof(*q));
+  if (!q) {
+    return NULL;
+  }
+  q->items = malloc((size_t)length * item_size);
+  if (!q->items) {
+    free(q);
+    return NULL;
+  }
+  pthread_mutex_init(&q->lock, NULL);
+  pthread_condattr_t attr;
+  pthread_condattr_init(&attr);
+  pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+  pthread_cond_init(&q->changed, &attr);
+  pthread_condattr_destroy(&attr);
+  q->item_size = item_size;
+  q->length = length;
+  return q;
+}
+
+void vQueueDelete(QueueHandle_t q) {
+  if (!q) {
+    return;
+  }
+  pthread_cond_destroy(&q->changed);
+  pthread_mutex_destroy(&q->lock);
+  free(q->items);
+  free(q);
+}
+
+static void unlock_on_cancel(void *m) {
+  pthread_mutex_unlock(m);
+}
+
+// Waits with q->lock held until ready(q) or the timeout. Returns false on
+// timeout. A cancelled waiter releases the lock on the way out.
+static bool wait_until(struct host_queue *q, bool (*ready)(const struct host_queue *), TickType_t wait) {
+  if (ready(q)) {
+    return true;
+  }
+  if (wait == 0) {
+    return false;
+  }
+  struct timespec deadline;
+  host_deadline_us(&deadline, (int64_t)wait * 1000000 / configTICK_RATE_HZ);
+  bool ok = true;
+  pthread_cleanup_push(unlock_on_cancel, &q->lock);
+  while (!ready(q)) {
+    if (wait == portMAX_DELAY) {
+      pthread_cond_wait(&q->changed, &q->lock);
+    } else if (pthread_cond_timedwait(&q->changed, &q->lock, &deadline) == ETIMEDOUT) {
+      ok = ready(q);
+      break;
+    }
+  }
+  pthread_cleanup_pop(0);
+  return ok;
+}
+
+static bool has_space(const struct host_queue *q) {
+  return q->count < q->length;
+}
+
+static bool has_item(const struct host_queue *q) {
+  return q->count > 0;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait) {
+  pthread_mutex_lock(&q->lock);
+  if (!wait_until(q, has_space, wait)) {
+    pthread_mutex_unlock(&q->lock);
+    return pdFALSE;
+  }
+  memcpy(q->items + ((q->head + q->count) % q->length) * q->item_size, item, q->item_size);
+  q->count++;
+  pthread_cond_broadcast(&q->changed);
+  pthread_mutex_unlock(&q->lock);
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait) {
+  pthread_mutex_lock(&q->lock);
+  q->receivers++;
+  pthread_cond_broadcast(&q->changed);
+  bool ok = wait_until(q, has_item, wait);
+  q->receivers--;
+  if (!ok) {
+    pthread_mutex_unlock(&q->lock);
+    return pdFALSE;
+  }
+  memcpy(item, q->items + q->head * q->item_size, q->item_size);
+  q->head = (q->head + 1) % q->length;
+  q->count--;
+  pthread_cond_broadcast(&q->changed);
+  pthread_mutex_unlock(&q->lock);
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken) {
+  if (woken) {
+    *woken = pdFALSE;
+  }
+  return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t q, const void *item) {
+  pthread_mutex_lock(&q->lock);
+  if (q->count == q->length) {
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+  }
+  memcpy(q->items + ((q->head + q->count) % q->length) * q->item_size, item, q->item_size);
+  q->count++;
+  pthread_cond_broadcast(&q->changed);
+  pthread_mutex_unlock(&q->lock);
+  return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t q) {
+  pthread_mutex_lock(&q->lock);
+  q->head = 0;
+  q->count = 0;
+  pthread_cond_broadcast(&q->changed);
+  pthread_mutex_unlock(&q->lock);
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+  pthread_mutex_lock(&q->lock);
+  UBaseType_t n = (UBaseType_t)q->count;
+  pthread_mutex_unlock(&q->lock);
+  return n;
+}
+
+bool host_queue_wait_drained(QueueHandle_t q, int64_t timeout_us) {
+  struct timespec deadline;
+  host_deadline_us(&deadline, timeout_us);
+  pthread_mutex_lock(&q->lock);
+  while (q->count > 0 || q->receivers == 0) {
+    if (pthread_cond_timedwait(&q->changed, &q->lock, &deadline) == ETIMEDOUT) {
+      break;
+    }
+  }
+  bool drained = q->count == 0 && q->receivers > 0;
+  pthread_mutex_unlock(&q->lock);
+  return drained;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t q) {
+  pthread_mutex_lock(&q->lock);
+  UBaseType_t n = (UBaseType_t)(q->length - q->count);
+  pthread_mutex_unlock(&q->lock);
+  return n;
+}
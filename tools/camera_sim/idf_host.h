@@ -0,0 +1,26 @@
+#pragma once
+
+// Clock control for the host runtime in idf_host.c.
+//
+// Simulated time can run faster than the wall clock: with scale N,
+// esp_timer_get_time(), tick counts, vTaskDelay(), queue timeouts and the
+// simulator's frame and bus pacing all advance N times faster, so the
+// driver's 4 s frame timeout takes 4/N s. CPU work is not scaled, so use 1
+// when timing the driver. Set it before the camera is initialised.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+void host_set_time_scale(uint32_t scale);
+uint32_t host_get_time_scale(void);
+// Sleeps for us of simulated time.
+void host_sleep_us(int64_t us);
+// CLOCK_MONOTONIC deadline us of simulated time from now.
+void host_deadline_us(struct timespec *deadline, int64_t us);
+// Waits until q is empty and a task is blocked receiving from it, i.e. the
+// consumer has finished with every item sent so far. False on timeout.
+bool host_queue_wait_drained(QueueHandle_t q, int64_t timeout_us);
@@ -0,0 +1,394 @@
+// Host benchmark and check of the JPEG encoder in conversions/ (to_jpg.cpp,
+// jpge.cpp): fmt2jpg_cb() time per frame with 1, 2 and N strip workers
+// (jpgSetWorkers()) for RGB565 and YUV422 input from QVGA to UXGA.
+//
+// The source picture is test_outside.jpeg decoded with libjpeg and scaled to
+// each size. Every output is decoded with libjpeg again: split encodes must
+// decode to exactly the pixels of the serial encode (restart markers change
+// the coding, not the coefficients), and must be byte-identical to each
+// other whatever the number of strips. A mismatch fails the run.
+//
+// Workers are FreeRTOS tasks on the host shims, i.e. POSIX threads; the
+// speedup is bounded by the host's cores, not the ESP32-S3's two. Built and
+// run by tools/test_jpeg_encode.py:
+//   jpeg_encode_bench [--pictures DIR] [--workers N] [--quick]
+
+#include <math.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <jpeglib.h>
+
+#include "img_converters.h"
+#include "yuv.h"
+
+typedef struct {
+  const char *name;
+  int width, height;
+} bench_size_t;
+
+static const bench_size_t k_sizes[] = {
+    {"QVGA", 320, 240}, {"VGA", 640, 480}, {"SVGA", 800, 600}, {"XGA", 1024, 768}, {"SXGA", 1280, 1024}, {"UXGA", 1600, 1200},
+};
+#define SIZE_COUNT (sizeof(k_sizes) / sizeof(k_sizes[0]))
+
+#define QUALITY 80
+
+typedef struct {
+  uint8_t *data;
+  size_t len, cap;
+} out_buf_t;
+
+typedef struct {
+  uint8_t *rgb;
+  int width, height;
+} picture_t;
+
+static double s_min_ms = 300.0;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static size_t out_cb(void *arg, size_t index, const void *data, size_t len) {
+  out_buf_t *out = arg;
+  (void)index;
+  if (!data) {
+    return 0;
+  }
+  if (out->len + len > out->cap) {
+    out->cap = (out->len + len) * 2;
+    out->data = realloc(out->data, out->cap);
+  }
+  memcpy(out->data + out->len, data, len);
+  out->len += len;
+  return len;
+}
+
+typedef struct {
+  struct jpeg_error_mgr mgr;
+  jmp_buf fail;
+} decode_error_t;
+
+static void decode_error_exit(j_common_ptr cinfo) {
+  decode_error_t *err = (decode_error_t *)cinfo->err;
+  (*cinfo->err->output_message)(cinfo);
+  longjmp(err->fail, 1);
+}
+
+// RGB888 from a JPEG file or buffer; NULL if libjpeg fails or warns.
+static uint8_t *decode(FILE *f, const uint8_t *buf, size_t len, int *width, int *height) {
+  struct jpeg_decompress_struct cinfo;
+  decode_error_t jerr;
+  uint8_t *volatile rgb = NULL;
+  cinfo.err = jpeg_std_error(&jerr.mgr);
+  jerr.mgr.error_exit = decode_error_exit;
+  if (setjmp(jerr.fail)) {
+    jpeg_destroy_decompress(&cinfo);
+    free(rgb);
+    return NULL;
+  }
+  jpeg_create_decompress(&cinfo);
+  if (f) {
+    jpeg_stdio_src(&cinfo, f);
+  } else {
+    jpeg_mem_src(&cinfo, buf, len);
+  }
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = JCS_RGB;
+  jpeg_start_decompress(&cinfo);
+  *width = cinfo.output_width;
+  *height = cinfo.output_height;
+  size_t stride = (size_t)cinfo.output_width * 3;
+  rgb = malloc(stride * cinfo.output_height);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = rgb + stride * cinfo.output_scanline;
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  bool warned = jerr.mgr.num_warnings != 0;
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  if (warned) {
+    free(rgb);
+    return NULL;
+  }
+  return rgb;
+}
+
+// Nearest-neighbour scale of the picture to RGB888.
+static uint8_t *scale_rgb(const picture_t *pic, int width, int height) {
+  uint8_t *out = malloc((size_t)width * height * 3);
+  uint8_t *o = out;
+  for (int y = 0; y < height; y++) {
+    const uint8_t *row = pic->rgb + (size_t)(y * pic->height / height) * pic->width * 3;
+    for (int x = 0; x < width; x++, o += 3) {
+      memcpy(o, row + (x * pic->width / width) * 3, 3);
+    }
+  }
+  return out;
+}
+
+static uint8_t round_u8(double v) {
+  return v < 0 ? 0 : (v > 255 ? 255 : (uint8_t)(v + 0.5));
+}
+
+// RGB888 to big-endian RGB565, or to YUYV in BT.601 video range as the
+// sensors deliver it (chroma averaged over each pair).
+static uint8_t *make_source(const uint8_t *rgb, int width, int height, pixformat_t format) {
+  uint8_t *out = malloc((size_t)width * height * 2);
+  uint8_t *o = out;
+  for (size_t i = 0; i < (size_t)width * height; i += 2, rgb += 6) {
+    const uint8_t *p[2] = {rgb, rgb + 3};
+    if (format == PIXFORMAT_RGB565) {
+      for (int k = 0; k < 2; k++) {
+        uint16_t v = (p[k][0] & 0xF8) << 8 | (p[k][1] & 0xFC) << 3 | p[k][2] >> 3;
+        *o++ = v >> 8;
+        *o++ = v & 0xFF;
+      }
+    } else {
+      double yy[2], u = 0, v = 0;
+      for (int k = 0; k < 2; k++) {
+        double r = p[k][0], g = p[k][1], b = p[k][2];
+        yy[k] = 16 + (65.481 * r + 128.553 * g + 24.966 * b) / 255;
+        u += 128 + (-37.797 * r - 74.203 * g + 112.0 * b) / 255;
+        v += 128 + (112.0 * r - 93.786 * g - 18.214 * b) / 255;
+      }
+      *o++ = round_u8(yy[0]);
+      *o++ = round_u8(u / 2);
+      *o++ = round_u8(yy[1]);
+      *o++ = round_u8(v / 2);
+    }
+  }
+  return out;
+}
+
+static double psnr(const uint8_t *a, const uint8_t *b, size_t len) {
+  double se = 0;
+  for (size_t i = 0; i < len; i++) {
+    double d = (double)a[i] - b[i];
+    se += d * d;
+  }
+  return se == 0 ? 99.0 : 10 * log10(255.0 * 255.0 * len / se);
+}
+
+static int count_restarts(const out_buf_t *jpg) {
+  int n = 0;
+  for (size_t i = 0; i + 1 < jpg->len; i++) {
+    if (jpg->data[i] == 0xFF && (jpg->data[i + 1] & 0xF8) == 0xD0) {
+      n++;
+    }
+  }
+  return n;
+}
+
+// Encodes until s_min_ms has passed; returns ms per frame, or -1 on failure.
+// With via_rgb, times what the encoder did with YUYV before it took YCbCr
+// directly: yuv2rgb() on every pixel, then an RGB888 encode.
+static double time_encode(uint8_t *src, const bench_size_t *sz, pixformat_t format, int workers, out_buf_t *out,
+                          uint8_t *via_rgb) {
+  jpgSetWorkers(workers);
+  int frames = 0;
+  double t0 = now_s();
+  double dt = 0;
+  size_t pixels = (size_t)sz->width * sz->height;
+  do {
+    out->len = 0;
+    if (via_rgb) {
+      for (size_t i = 0; i < pixels; i += 2) {
+        const uint8_t *s = src + 2 * i;
+        uint8_t *d = via_rgb + 3 * i;
+        // RGB888 frames are BGR in memory
+        yuv2rgb(s[0], s[1], s[3], &d[2], &d[1], &d[0]);
+        yuv2rgb(s[2], s[1], s[3], &d[5], &d[4], &d[3]);
+      }
+      if (!fmt2jpg_cb(via_rgb, pixels * 3, sz->width, sz->height, PIXFORMAT_RGB888, QUALITY, out_cb, out)) {
+        return -1;
+      }
+    } else if (!fmt2jpg_cb(src, pixels * 2, sz->width, sz->height, format, QUALITY, out_cb, out)) {
+      return -1;
+    }
+    frames++;
+    dt = now_s() - t0;
+  } while (dt * 1000.0 < s_min_ms);
+  return dt * 1000.0 / frames;
+}
+
+static bool bench_one(const picture_t *pic, const bench_size_t *sz, pixformat_t format, int max_workers) {
+  int counts[3] = {1, 2, max_workers};
+  int runs = max_workers > 2 ? 3 : 2;
+  uint8_t *rgb = scale_rgb(pic, sz->width, sz->height);
+  uint8_t *src = make_source(rgb, sz->width, sz->height, format);
+  free(rgb);
+  out_buf_t outs[3] = {{0}};
+  uint8_t *decoded[3] = {NULL};
+  double ms[3];
+  bool ok = true;
+
+  for (int r = 0; r < runs; r++) {
+    ms[r] = time_encode(src, sz, format, counts[r], &outs[r], NULL);
+    int w = 0, h = 0;
+    decoded[r] = ms[r] < 0 ? NULL : decode(NULL, outs[r].data, outs[r].len, &w, &h);
+    if (!decoded[r] || w != sz->width || h != sz->height) {
+      printf("%-5s %-6s %2d workers: encode or decode failed\n", sz->name, format == PIXFORMAT_RGB565 ? "RGB565" : "YUV422",
+             counts[r]);
+      ok = false;
+      goto out;
+    }
+  }
+  size_t pixels = (size_t)sz->width * sz->height * 3;
+  for (int r = 1; r < runs; r++) {
+    if (memcmp(decoded[r], decoded[0], pixels)) {
+      printf("%-5s %d workers: decoded pixels differ from the serial encode\n", sz->name, counts[r]);
+      ok = false;
+    }
+    if (outs[r].len != outs[1].len || memcmp(outs[r].data, outs[1].data, outs[1].len)) {
+      printf("%-5s %d workers: output differs from the 2-worker encode\n", sz->name, counts[r]);
+      ok = false;
+    }
+  }
+  int rows = (sz->height + 15) / 16;
+  if (count_restarts(&outs[0]) != 0 || count_restarts(&outs[1]) != rows - 1) {
+    printf("%-5s restart markers: %d serial, %d split, expected 0 and %d\n", sz->name, count_restarts(&outs[0]),
+           count_restarts(&outs[1]), rows - 1);
+    ok = false;
+  }
+
+  printf("%-5s %-6s %8.2f %8.2f", sz->name, format == PIXFORMAT_RGB565 ? "RGB565" : "YUV422", ms[0], ms[1]);
+  if (runs > 2) {
+    printf(" %8.2f", ms[2]);
+  } else {
+    printf(" %8s", "-");
+  }
+  printf(" %7.2fx %8zu %+6zd\n", ms[0] / ms[runs - 1], outs[0].len, (ssize_t)(outs[1].len - outs[0].len));
+  fflush(stdout);
+out:
+  for (int r = 0; r < 3; r++) {
+    free(outs[r].data);
+    free(decoded[r]);
+  }
+  free(src);
+  return ok;
+}
+
+// YUV422 straight into jpge as YCbCr against the old route through RGB888,
+// one worker. Both are scored against the RGB picture the YUYV came from.
+static bool bench_yuv_path(const picture_t *pic, const bench_size_t *sz) {
+  size_t pixels = (size_t)sz->width * sz->height;
+  uint8_t *rgb = scale_rgb(pic, sz->width, sz->height);
+  uint8_t *src = make_source(rgb, sz->width, sz->height, PIXFORMAT_YUV422);
+  uint8_t *via_rgb = malloc(pixels * 3);
+  out_buf_t outs[2] = {{0}};
+  double ms[2], db[2];
+  bool ok = true;
+  for (int r = 0; r < 2; r++) {
+    ms[r] = time_encode(src, sz, PIXFORMAT_YUV422, 1, &outs[r], r == 0 ? via_rgb : NULL);
+    int w = 0, h = 0;
+    uint8_t *decoded = ms[r] < 0 ? NULL : decode(NULL, outs[r].data, outs[r].len, &w, &h);
+    if (!decoded || w != sz->width || h != sz->height) {
+      printf("%-5s YUV422 %s: encode or decode failed\n", sz->name, r == 0 ? "via RGB" : "direct");
+      free(decoded);
+      ok = false;
+      goto out;
+    }
+    db[r] = psnr(decoded, rgb, pixels * 3);
+    free(decoded);
+  }
+  // parity: the direct path must not lose quality against the old one
+  ok = db[1] >= db[0] - 0.1;
+  printf("%-5s %8.2f %8.2f %7.2fx %8.2f %8.2f %9zu %9zu%s\n", sz->name, ms[0], ms[1], ms[0] / ms[1], db[0], db[1],
+         outs[0].len, outs[1].len, ok ? "" : "  PSNR DROP");
+  fflush(stdout);
+out:
+  for (int r = 0; r < 2; r++) {
+    free(outs[r].data);
+  }
+  free(via_rgb);
+  free(src);
+  free(rgb);
+  return ok;
+}
+
+// The same parity for every chroma mode and a size that is not a whole
+// number of MCUs, encoded once each.
+static bool check_yuv_modes(const picture_t *pic) {
+  static const bench_size_t k_odd = {"226x150", 226, 150};
+  static const struct {
+    chroma_t chroma;
+    const char *name;
+  } k_modes[] = {{CHROMA_444, "4:4:4"}, {CHROMA_422, "4:2:2"}, {CHROMA_420, "4:2:0"}};
+  const double saved_ms = s_min_ms;
+  bool ok = true;
+  s_min_ms = 0;
+  for (size_t m = 0; m < sizeof(k_modes) / sizeof(k_modes[0]); m++) {
+    jpgSetChroma(k_modes[m].chroma);
+    printf("%s ", k_modes[m].name);
+    ok &= bench_yuv_path(pic, &k_odd);
+  }
+  jpgSetChroma(CHROMA_420);
+  s_min_ms = saved_ms;
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  const char *dir = "MVP/components/esp32_camera/test/pictures";
+  int workers = 4;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--pictures") && i + 1 < argc) {
+      dir = argv[++i];
+    } else if (!strcmp(argv[i], "--workers") && i + 1 < argc) {
+      workers = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--quick")) {
+      s_min_ms = 40.0;
+    } else {
+      fprintf(stderr, "usage: %s [--pictures DIR] [--workers N] [--quick]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (workers < 2) {
+    workers = 2;
+  } else if (workers > 8) {
+    workers = 8;
+  }
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/test_outside.jpeg", dir);
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "cannot open %s\n", path);
+    return 2;
+  }
+  picture_t pic;
+  pic.rgb = decode(f, NULL, 0, &pic.width, &pic.height);
+  fclose(f);
+  if (!pic.rgb) {
+    fprintf(stderr, "cannot decode %s\n", path);
+    return 2;
+  }
+
+  printf("fmt2jpg_cb, quality %d, 4:2:0, ms per frame (restart overhead in bytes)\n", QUALITY);
+  char label[8];
+  snprintf(label, sizeof(label), "%d", workers);
+  printf("%-5s %-6s %8s %8s %8s %8s %8s %6s\n", "size", "input", "1", "2", label, "speedup", "bytes", "rst");
+  bool ok = true;
+  for (size_t s = 0; s < SIZE_COUNT; s++) {
+    ok &= bench_one(&pic, &k_sizes[s], PIXFORMAT_RGB565, workers);
+    ok &= bench_one(&pic, &k_sizes[s], PIXFORMAT_YUV422, workers);
+  }
+
+  printf("\nYUV422 via RGB888 (yuv2rgb + RGB encode) vs direct YCbCr, 1 worker: ms per frame, PSNR in dB\n");
+  printf("%-5s %8s %8s %8s %8s %8s %9s %9s\n", "size", "via RGB", "direct", "speedup", "dB RGB", "dB dir", "bytes RGB",
+         "bytes dir");
+  for (size_t s = 0; s < SIZE_COUNT; s++) {
+    ok &= bench_yuv_path(&pic, &k_sizes[s]);
+  }
+  ok &= check_yuv_modes(&pic);
+  free(pic.rgb);
+  jpgSetWorkers(1);
+  printf("%s\n", ok ? "all outputs decode and match" : "MISMATCH");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,353 @@
+// Host benchmark and regression check of jpge's encoder core (DCT,
+// quantisation, Huffman coding) on the test picture corpus.
+//
+// Every picture in --pictures is decoded with libjpeg and encoded with
+// fmt2jpg_cb() as RGB888 and as greyscale, in each chroma mode and at a few
+// qualities, one worker. Throughput is source megabytes per second.
+//
+// jpge has no bit-exact reference since its DCT is its own, so the check is
+// PSNR parity: libjpeg encodes the same picture with the quantisation tables
+// and sampling read back from jpge's output (its accurate integer DCT), both
+// are decoded, and jpge must score within PSNR_SLACK dB of libjpeg against
+// the source. Built and run by tools/test_jpeg_encode.py:
+//   jpge_corpus_bench [--pictures DIR] [--quick]
+
+#include <dirent.h>
+#include <math.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <jpeglib.h>
+
+#include "img_converters.h"
+
+#define MAX_PICTURES 16
+#define PSNR_SLACK 0.1
+
+typedef struct {
+  uint8_t *data;
+  size_t len, cap;
+} out_buf_t;
+
+typedef struct {
+  char name[64];
+  uint8_t *rgb;
+  int width, height;
+} picture_t;
+
+typedef struct {
+  const char *name;
+  pixformat_t format;
+  chroma_t chroma;
+} bench_mode_t;
+
+static const bench_mode_t k_modes[] = {
+    {"grey", PIXFORMAT_GRAYSCALE, CHROMA_420},
+    {"4:4:4", PIXFORMAT_RGB888, CHROMA_444},
+    {"4:2:2", PIXFORMAT_RGB888, CHROMA_422},
+    {"4:2:0", PIXFORMAT_RGB888, CHROMA_420},
+};
+#define MODE_COUNT (sizeof(k_modes) / sizeof(k_modes[0]))
+
+static const int k_qualities[] = {50, 80, 95};
+#define QUALITY_COUNT (sizeof(k_qualities) / sizeof(k_qualities[0]))
+
+static double s_min_ms = 200.0;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static size_t out_cb(void *arg, size_t index, const void *data, size_t len) {
+  out_buf_t *out = arg;
+  (void)index;
+  if (!data) {
+    return 0;
+  }
+  if (out->len + len > out->cap) {
+    out->cap = (out->len + len) * 2;
+    out->data = realloc(out->data, out->cap);
+  }
+  memcpy(out->data + out->len, data, len);
+  out->len += len;
+  return len;
+}
+
+typedef struct {
+  struct jpeg_error_mgr mgr;
+  jmp_buf fail;
+} jpeg_fail_t;
+
+static void jpeg_fail_exit(j_common_ptr cinfo) {
+  jpeg_fail_t *err = (jpeg_fail_t *)cinfo->err;
+  (*cinfo->err->output_message)(cinfo);
+  longjmp(err->fail, 1);
+}
+
+// Pixels of a JPEG file or buffer with `components` bytes each (1 grey,
+// 3 RGB); NULL if libjpeg fails or warns.
+static uint8_t *decode(FILE *f, const uint8_t *buf, size_t len, int components, int *width, int *height) {
+  struct jpeg_decompress_struct cinfo;
+  jpeg_fail_t jerr;
+  uint8_t *volatile px = NULL;
+  cinfo.err = jpeg_std_error(&jerr.mgr);
+  jerr.mgr.error_exit = jpeg_fail_exit;
+  if (setjmp(jerr.fail)) {
+    jpeg_destroy_decompress(&cinfo);
+    free(px);
+    return NULL;
+  }
+  jpeg_create_decompress(&cinfo);
+  if (f) {
+    jpeg_stdio_src(&cinfo, f);
+  } else {
+    jpeg_mem_src(&cinfo, buf, len);
+  }
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+  jpeg_start_decompress(&cinfo);
+  *width = cinfo.output_width;
+  *height = cinfo.output_height;
+  size_t stride = (size_t)cinfo.output_width * components;
+  px = malloc(stride * cinfo.output_height);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = px + stride * cinfo.output_scanline;
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  bool warned = jerr.mgr.num_warnings != 0;
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  if (warned) {
+    free(px);
+    return NULL;
+  }
+  return px;
+}
+
+// libjpeg encode of src with the quantisation tables and sampling factors of
+// the JPEG in like; false on failure.
+static bool encode_like(const uint8_t *src, int width, int height, int components, const out_buf_t *like,
+                        out_buf_t *out) {
+  struct jpeg_decompress_struct d;
+  struct jpeg_compress_struct c;
+  jpeg_fail_t jerr;
+  unsigned char *volatile mem = NULL;
+  unsigned long mem_len = 0;
+  d.err = jpeg_std_error(&jerr.mgr);
+  c.err = d.err;
+  jerr.mgr.error_exit = jpeg_fail_exit;
+  jpeg_create_decompress(&d);
+  jpeg_create_compress(&c);
+  if (setjmp(jerr.fail)) {
+    jpeg_destroy_decompress(&d);
+    jpeg_destroy_compress(&c);
+    free(mem);
+    return false;
+  }
+  jpeg_mem_src(&d, like->data, like->len);
+  jpeg_read_header(&d, TRUE);
+  if (d.num_components != components) {
+    longjmp(jerr.fail, 1);
+  }
+
+  jpeg_mem_dest(&c, (unsigned char **)&mem, &mem_len);
+  c.image_width = width;
+  c.image_height = height;
+  c.input_components = components;
+  c.in_color_space = components == 1 ? JCS_GRAYSCALE : JCS_RGB;
+  jpeg_set_defaults(&c);
+  c.dct_method = JDCT_ISLOW;
+  for (int t = 0; t < 2; t++) {
+    if (d.quant_tbl_ptrs[t]) {
+      unsigned int table[DCTSIZE2];
+      for (int i = 0; i < DCTSIZE2; i++) {
+        table[i] = d.quant_tbl_ptrs[t]->quantval[i];
+      }
+      jpeg_add_quant_table(&c, t, table, 100, TRUE);
+    }
+  }
+  for (int i = 0; i < components; i++) {
+    c.comp_info[i].h_samp_factor = d.comp_info[i].h_samp_factor;
+    c.comp_info[i].v_samp_factor = d.comp_info[i].v_samp_factor;
+    c.comp_info[i].quant_tbl_no = d.comp_info[i].quant_tbl_no;
+  }
+  jpeg_start_compress(&c, TRUE);
+  while (c.next_scanline < c.image_height) {
+    JSAMPROW row = (JSAMPROW)src + (size_t)c.next_scanline * width * components;
+    jpeg_write_scanlines(&c, &row, 1);
+  }
+  jpeg_finish_compress(&c);
+  jpeg_destroy_compress(&c);
+  jpeg_destroy_decompress(&d);
+  out->len = 0;
+  out_cb(out, 0, mem, mem_len);
+  free(mem);
+  return true;
+}
+
+static double psnr(const uint8_t *a, const uint8_t *b, size_t len) {
+  double se = 0;
+  for (size_t i = 0; i < len; i++) {
+    double d = (double)a[i] - b[i];
+    se += d * d;
+  }
+  return se == 0 ? 99.0 : 10 * log10(255.0 * 255.0 * len / se);
+}
+
+// PSNR of a JPEG against the source it was encoded from; -1 if it does not
+// decode to the source's size.
+static double score(const out_buf_t *jpg, const uint8_t *src, int width, int height, int components) {
+  int w = 0, h = 0;
+  uint8_t *px = decode(NULL, jpg->data, jpg->len, components, &w, &h);
+  double db = (px && w == width && h == height) ? psnr(px, src, (size_t)width * height * components) : -1;
+  free(px);
+  return db;
+}
+
+// Encodes one picture in one mode; adds to the totals, false on a failure or
+// a PSNR short of libjpeg's.
+static bool bench_one(const picture_t *pic, const bench_mode_t *mode, int quality, double *bytes, double *seconds) {
+  const bool grey = mode->format == PIXFORMAT_GRAYSCALE;
+  const int components = grey ? 1 : 3;
+  const size_t pixels = (size_t)pic->width * pic->height;
+  uint8_t *src = malloc(pixels * components);
+  uint8_t *frame = malloc(pixels * components);
+  for (size_t i = 0; i < pixels; i++) {
+    const uint8_t *p = pic->rgb + 3 * i;
+    if (grey) {
+      src[i] = frame[i] = (p[0] * 77 + p[1] * 150 + p[2] * 29 + 128) >> 8;
+    } else {
+      // RGB888 frames are BGR in memory
+      memcpy(src + 3 * i, p, 3);
+      frame[3 * i] = p[2];
+      frame[3 * i + 1] = p[1];
+      frame[3 * i + 2] = p[0];
+    }
+  }
+
+  out_buf_t jpg = {0}, ref = {0};
+  jpgSetChroma(mode->chroma);
+  int frames = 0;
+  double t0 = now_s(), dt = 0;
+  bool ok = true;
+  do {
+    jpg.len = 0;
+    if (!fmt2jpg_cb(frame, pixels * components, pic->width, pic->height, mode->format, quality, out_cb, &jpg)) {
+      ok = false;
+      break;
+    }
+    frames++;
+    dt = now_s() - t0;
+  } while (dt * 1000.0 < s_min_ms);
+
+  double db = ok ? score(&jpg, src, pic->width, pic->height, components) : -1;
+  double ref_db = -1;
+  if (db >= 0 && encode_like(src, pic->width, pic->height, components, &jpg, &ref)) {
+    ref_db = score(&ref, src, pic->width, pic->height, components);
+  }
+  if (db < 0 || ref_db < 0) {
+    printf("%-16s %-5s q%-3d encode or decode failed\n", pic->name, mode->name, quality);
+    ok = false;
+  } else {
+    const double mb_s = (double)pixels * components * frames / dt / 1e6;
+    ok = db >= ref_db - PSNR_SLACK;
+    printf("%-16s %-5s %3d %8.2f %8zu %8zu %8.2f %8.2f%s\n", pic->name, mode->name, quality, mb_s, jpg.len, ref.len, db,
+           ref_db, ok ? "" : "  PSNR DROP");
+    *bytes += (double)pixels * components * frames;
+    *seconds += dt;
+  }
+  fflush(stdout);
+  free(jpg.data);
+  free(ref.data);
+  free(frame);
+  free(src);
+  return ok;
+}
+
+static int load_corpus(const char *dir, picture_t *pics) {
+  DIR *d = opendir(dir);
+  if (!d) {
+    return 0;
+  }
+  int n = 0;
+  struct dirent *e;
+  while ((e = readdir(d)) && n < MAX_PICTURES) {
+    size_t len = strlen(e->d_name);
+    if (len < 6 || strcmp(e->d_name + len - 5, ".jpeg")) {
+      continue;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+      continue;
+    }
+    picture_t *pic = &pics[n];
+    pic->rgb = decode(f, NULL, 0, 3, &pic->width, &pic->height);
+    fclose(f);
+    if (!pic->rgb) {
+      fprintf(stderr, "cannot decode %s\n", path);
+      continue;
+    }
+    snprintf(pic->name, sizeof(pic->name), "%.*s", (int)(len - 5), e->d_name);
+    n++;
+  }
+  closedir(d);
+  return n;
+}
+
+static int by_name(const void *a, const void *b) {
+  return strcmp(((const picture_t *)a)->name, ((const picture_t *)b)->name);
+}
+
+int main(int argc, char **argv) {
+  const char *dir = "MVP/components/esp32_camera/test/pictures";
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--pictures") && i + 1 < argc) {
+      dir = argv[++i];
+    } else if (!strcmp(argv[i], "--quick")) {
+      s_min_ms = 30.0;
+    } else {
+      fprintf(stderr, "usage: %s [--pictures DIR] [--quick]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  picture_t pics[MAX_PICTURES];
+  int count = load_corpus(dir, pics);
+  if (!count) {
+    fprintf(stderr, "no pictures in %s\n", dir);
+    return 2;
+  }
+  qsort(pics, count, sizeof(pics[0]), by_name);
+
+  jpgSetWorkers(1);
+  printf("jpge on the picture corpus, 1 worker: source MB/s, bytes and PSNR (dB) against libjpeg with the same tables\n");
+  printf("%-16s %-5s %3s %8s %8s %8s %8s %8s\n", "picture", "mode", "q", "MB/s", "bytes", "libjpeg", "dB", "libjpeg");
+  bool ok = true;
+  double mode_bytes[MODE_COUNT] = {0}, mode_seconds[MODE_COUNT] = {0};
+  for (int p = 0; p < count; p++) {
+    printf("%s: %dx%d\n", pics[p].name, pics[p].width, pics[p].height);
+    for (size_t m = 0; m < MODE_COUNT; m++) {
+      for (size_t q = 0; q < QUALITY_COUNT; q++) {
+        ok &= bench_one(&pics[p], &k_modes[m], k_qualities[q], &mode_bytes[m], &mode_seconds[m]);
+      }
+    }
+  }
+  printf("corpus MB/s:");
+  for (size_t m = 0; m < MODE_COUNT; m++) {
+    printf("  %s %.2f", k_modes[m].name, mode_seconds[m] > 0 ? mode_bytes[m] / mode_seconds[m] / 1e6 : 0.0);
+  }
+  printf("\n");
+  jpgSetChroma(CHROMA_420);
+  for (int p = 0; p < count; p++) {
+    free(pics[p].rgb);
+  }
+  printf("%s\n", ok ? "PSNR on par with libjpeg throughout" : "PSNR REGRESSION");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,284 @@
+// Host stress test of jpge's reentrancy: several threads call fmt2jpg_cb()
+// at once, over a mix of input formats, frame sizes and more qualities than
+// jpge caches tables for, and every output must be byte-identical to the
+// same encode run alone.
+//
+// The threaded pass runs first, so the threads also race to build and
+// publish the per-quality tables. Then every job is encoded again on one
+// thread, and each thread's outputs are compared with those. Repeated for
+// each chroma mode, and once with strip workers on. Built with
+// ThreadSanitizer where the compiler has it, and run by
+// tools/test_jpeg_encode.py:
+//   jpge_stress [--pictures DIR] [--threads N] [--rounds N]
+
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <jpeglib.h>
+
+#include "img_converters.h"
+
+typedef struct {
+  uint8_t *data;
+  size_t len, cap;
+} out_buf_t;
+
+typedef struct {
+  pixformat_t format;
+  int width, height, quality;
+  uint8_t *src;
+  size_t src_len;
+  out_buf_t want;
+} job_t;
+
+static const pixformat_t k_formats[] = {PIXFORMAT_RGB565, PIXFORMAT_YUV422, PIXFORMAT_GRAYSCALE, PIXFORMAT_RGB888};
+// More than jpge's table cache holds, so some encoders build private tables.
+static const int k_qualities[] = {5, 12, 25, 37, 50, 63, 75, 80, 88, 95, 100};
+static const int k_sizes[][2] = {{160, 120}, {226, 150}};
+
+#define FORMAT_COUNT (sizeof(k_formats) / sizeof(k_formats[0]))
+#define QUALITY_COUNT (sizeof(k_qualities) / sizeof(k_qualities[0]))
+#define SIZE_COUNT (sizeof(k_sizes) / sizeof(k_sizes[0]))
+#define JOB_COUNT (FORMAT_COUNT * QUALITY_COUNT * SIZE_COUNT)
+#define MAX_THREADS 16
+
+typedef struct {
+  job_t *jobs;
+  int index, rounds;
+  out_buf_t outs[JOB_COUNT];  // the thread's latest output per job
+  int mismatches, failures;
+} thread_arg_t;
+
+static size_t out_cb(void *arg, size_t index, const void *data, size_t len) {
+  out_buf_t *out = arg;
+  (void)index;
+  if (!data) {
+    return 0;
+  }
+  if (out->len + len > out->cap) {
+    out->cap = (out->len + len) * 2;
+    out->data = realloc(out->data, out->cap);
+  }
+  memcpy(out->data + out->len, data, len);
+  out->len += len;
+  return len;
+}
+
+typedef struct {
+  struct jpeg_error_mgr mgr;
+  jmp_buf fail;
+} decode_error_t;
+
+static void decode_error_exit(j_common_ptr cinfo) {
+  decode_error_t *err = (decode_error_t *)cinfo->err;
+  (*cinfo->err->output_message)(cinfo);
+  longjmp(err->fail, 1);
+}
+
+static uint8_t *decode_file(const char *path, int *width, int *height) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    return NULL;
+  }
+  struct jpeg_decompress_struct cinfo;
+  decode_error_t jerr;
+  uint8_t *volatile rgb = NULL;
+  cinfo.err = jpeg_std_error(&jerr.mgr);
+  jerr.mgr.error_exit = decode_error_exit;
+  if (setjmp(jerr.fail)) {
+    jpeg_destroy_decompress(&cinfo);
+    fclose(f);
+    free(rgb);
+    return NULL;
+  }
+  jpeg_create_decompress(&cinfo);
+  jpeg_stdio_src(&cinfo, f);
+  jpeg_read_header(&cinfo, TRUE);
+  cinfo.out_color_space = JCS_RGB;
+  jpeg_start_decompress(&cinfo);
+  *width = cinfo.output_width;
+  *height = cinfo.output_height;
+  size_t stride = (size_t)cinfo.output_width * 3;
+  rgb = malloc(stride * cinfo.output_height);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = rgb + stride * cinfo.output_scanline;
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  fclose(f);
+  return rgb;
+}
+
+// A frame in `format` from the picture, nearest-neighbour scaled. The bytes
+// only need to be deterministic, not colour-accurate.
+static uint8_t *make_frame(const uint8_t *rgb, int pic_w, int pic_h, int width, int height, pixformat_t format,
+                           size_t *len) {
+  const int bpp = format == PIXFORMAT_GRAYSCALE ? 1 : (format == PIXFORMAT_RGB888 ? 3 : 2);
+  *len = (size_t)width * height * bpp;
+  uint8_t *out = malloc(*len), *o = out;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const uint8_t *p = rgb + ((size_t)(y * pic_h / height) * pic_w + x * pic_w / width) * 3;
+      if (format == PIXFORMAT_GRAYSCALE) {
+        *o++ = p[1];
+      } else if (format == PIXFORMAT_RGB888) {
+        *o++ = p[2];
+        *o++ = p[1];
+        *o++ = p[0];
+      } else if (format == PIXFORMAT_RGB565) {
+        uint16_t v = (p[0] & 0xF8) << 8 | (p[1] & 0xFC) << 3 | p[2] >> 3;
+        *o++ = v >> 8;
+        *o++ = v & 0xFF;
+      } else {
+        // YUYV: luma from green, alternate chroma bytes from red and blue
+        *o++ = p[1];
+        *o++ = (x & 1) ? p[0] : p[2];
+      }
+    }
+  }
+  return out;
+}
+
+static bool encode(const job_t *job, out_buf_t *out) {
+  out->len = 0;
+  return fmt2jpg_cb(job->src, job->src_len, job->width, job->height, job->format, job->quality, out_cb, out);
+}
+
+// Each thread walks the jobs from its own offset and in its own direction,
+// so different qualities and formats overlap. A thread's encodes of one job
+// must agree with each other too.
+static void *stress_thread(void *p) {
+  thread_arg_t *arg = p;
+  out_buf_t out = {0};
+  for (int r = 0; r < arg->rounds; r++) {
+    for (size_t k = 0; k < JOB_COUNT; k++) {
+      size_t step = (arg->index + r) & 1 ? JOB_COUNT - k - 1 : k;
+      size_t j = (step + (size_t)arg->index * 7) % JOB_COUNT;
+      if (!encode(&arg->jobs[j], &out)) {
+        arg->failures++;
+        continue;
+      }
+      out_buf_t *last = &arg->outs[j];
+      if (last->len && (out.len != last->len || memcmp(out.data, last->data, out.len))) {
+        arg->mismatches++;
+      }
+      last->len = 0;
+      out_cb(last, 0, out.data, out.len);
+    }
+  }
+  free(out.data);
+  return NULL;
+}
+
+static bool run_phase(const char *name, job_t *jobs, int threads, int rounds) {
+  pthread_t tids[MAX_THREADS];
+  thread_arg_t *args = calloc(threads, sizeof(thread_arg_t));
+  for (int t = 0; t < threads; t++) {
+    args[t].jobs = jobs;
+    args[t].index = t;
+    args[t].rounds = rounds;
+    pthread_create(&tids[t], NULL, stress_thread, &args[t]);
+  }
+  int mismatches = 0, failures = 0;
+  for (int t = 0; t < threads; t++) {
+    pthread_join(tids[t], NULL);
+  }
+
+  // then every job alone, as the reference
+  for (size_t j = 0; j < JOB_COUNT; j++) {
+    if (!encode(&jobs[j], &jobs[j].want)) {
+      failures++;
+    }
+  }
+  for (int t = 0; t < threads; t++) {
+    mismatches += args[t].mismatches;
+    failures += args[t].failures;
+    for (size_t j = 0; j < JOB_COUNT; j++) {
+      const out_buf_t *got = &args[t].outs[j], *want = &jobs[j].want;
+      if (got->len != want->len || memcmp(got->data, want->data, want->len)) {
+        mismatches++;
+      }
+      free(got->data);
+    }
+  }
+  free(args);
+  printf("%-14s %6d encodes on %d threads: %d differ from one thread, %d failed\n", name, threads * rounds * (int)JOB_COUNT,
+         threads, mismatches, failures);
+  fflush(stdout);
+  return !mismatches && !failures;
+}
+
+int main(int argc, char **argv) {
+  const char *dir = "MVP/components/esp32_camera/test/pictures";
+  int threads = 4, rounds = 2;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--pictures") && i + 1 < argc) {
+      dir = argv[++i];
+    } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--rounds") && i + 1 < argc) {
+      rounds = atoi(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--pictures DIR] [--threads N] [--rounds N]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (threads < 2) {
+    threads = 2;
+  } else if (threads > MAX_THREADS) {
+    threads = MAX_THREADS;
+  }
+  if (rounds < 1) {
+    rounds = 1;
+  }
+
+  char path[512];
+  snprintf(path, sizeof(path), "%s/test_outside.jpeg", dir);
+  int pic_w, pic_h;
+  uint8_t *rgb = decode_file(path, &pic_w, &pic_h);
+  if (!rgb) {
+    fprintf(stderr, "cannot decode %s\n", path);
+    return 2;
+  }
+
+  job_t *jobs = calloc(JOB_COUNT, sizeof(job_t));
+  size_t n = 0;
+  for (size_t s = 0; s < SIZE_COUNT; s++) {
+    for (size_t f = 0; f < FORMAT_COUNT; f++) {
+      for (size_t q = 0; q < QUALITY_COUNT; q++, n++) {
+        job_t *job = &jobs[n];
+        job->format = k_formats[f];
+        job->width = k_sizes[s][0];
+        job->height = k_sizes[s][1];
+        job->quality = k_qualities[q];
+        job->src = make_frame(rgb, pic_w, pic_h, job->width, job->height, job->format, &job->src_len);
+      }
+    }
+  }
+  free(rgb);
+
+  printf("jpge reentrancy: concurrent fmt2jpg_cb() against single-threaded encodes\n");
+  bool ok = true;
+  jpgSetWorkers(1);
+  jpgSetChroma(CHROMA_444);
+  ok &= run_phase("4:4:4", jobs, threads, rounds);
+  jpgSetChroma(CHROMA_422);
+  ok &= run_phase("4:2:2", jobs, threads, rounds);
+  jpgSetChroma(CHROMA_420);
+  ok &= run_phase("4:2:0", jobs, threads, rounds);
+  jpgSetWorkers(2);
+  ok &= run_phase("4:2:0 strips", jobs, threads, 1);
+  jpgSetWorkers(1);
+
+  for (size_t j = 0; j < JOB_COUNT; j++) {
+    free(jobs[j].src);
+    free(jobs[j].want.data);
+  }
+  free(jobs);
+  printf("%s\n", ok ? "all concurrent encodes match" : "MISMATCH");
+  return ok ? 0 : 1;
+}
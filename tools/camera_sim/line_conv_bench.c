@@ -0,0 +1,246 @@
+// Host check and benchmark of the line colour conversion kernels in
+// conversions/line_conv.c against the per-pixel code they replaced.
+//
+// Checks, exhaustively: RGB565 in both byte orders and both output orders,
+// every YUYV (y, u, v) against yuv2rgb(), BGR swap, and the video to full
+// range kernel against its formula in double precision. Then times each
+// kernel and its scalar counterpart (for the range stretch: yuv2rgb() and
+// jpge's RGB_to_YCC(), the encoder's old YUYV path) on 640-pixel lines and
+// prints cycles per pixel (TSC on x86, otherwise nanoseconds). Built and run by
+// tools/test_jpeg_encode.py:
+//   line_conv_bench [--quick]
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "line_conv.h"
+#include "yuv.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cyc/px"
+static double ticks(void) { return (double)__rdtsc(); }
+#else
+#define BENCH_UNIT "ns/px"
+static double ticks(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+#endif
+
+#define LINE 640
+
+static int s_failures;
+
+static void fail(const char *what, size_t at) {
+  if (s_failures++ < 10) {
+    printf("FAIL %s at pixel %zu\n", what, at);
+  }
+}
+
+// The loops convert_line_format() and to_bmp.c used before the kernels.
+static void ref_rgb565(uint8_t *dst, const uint8_t *src, size_t width, bool big_endian) {
+  size_t o = 0;
+  for (size_t i = 0; i < width * 2; i += 2) {
+    if (big_endian) {
+      dst[o++] = src[i] & 0xF8;
+      dst[o++] = (src[i] & 0x07) << 5 | (src[i + 1] & 0xE0) >> 3;
+      dst[o++] = (src[i + 1] & 0x1F) << 3;
+    } else {
+      dst[o++] = src[i + 1] & 0xF8;
+      dst[o++] = (src[i + 1] & 0x07) << 5 | (src[i] & 0xE0) >> 3;
+      dst[o++] = (src[i] & 0x1F) << 3;
+    }
+  }
+}
+
+static void ref_swap(uint8_t *dst, const uint8_t *src, size_t width) {
+  size_t o = 0;
+  for (size_t i = 0; i < width * 3; i += 3) {
+    dst[o++] = src[i + 2];
+    dst[o++] = src[i + 1];
+    dst[o++] = src[i];
+  }
+}
+
+static void ref_yuv422(uint8_t *dst, const uint8_t *src, size_t width) {
+  size_t o = 0;
+  uint8_t r, g, b;
+  for (size_t i = 0; i < width * 2; i += 4) {
+    yuv2rgb(src[i], src[i + 1], src[i + 3], &r, &g, &b);
+    dst[o++] = r;
+    dst[o++] = g;
+    dst[o++] = b;
+    yuv2rgb(src[i + 2], src[i + 1], src[i + 3], &r, &g, &b);
+    dst[o++] = r;
+    dst[o++] = g;
+    dst[o++] = b;
+  }
+}
+
+// What the JPEG encoder did with YUYV before: yuv2rgb() per pixel, then
+// jpge's RGB_to_YCC() (its constants, 16-bit fixed point).
+static void ref_yuv422_ycc(uint8_t *dst, const uint8_t *src, size_t width) {
+  ref_yuv422(dst, src, width);
+  for (size_t i = 0; i < width; i++, dst += 3) {
+    const int r = dst[0], g = dst[1], b = dst[2];
+    const int cb = 128 + ((r * -11059 + g * -21709 + b * 32768 + 32768) >> 16);
+    const int cr = 128 + ((r * 32768 + g * -27439 + b * -5329 + 32768) >> 16);
+    dst[0] = (r * 19595 + g * 38470 + b * 7471 + 32768) >> 16;
+    dst[1] = cb < 0 ? 0 : (cb > 255 ? 255 : cb);
+    dst[2] = cr < 0 ? 0 : (cr > 255 ? 255 : cr);
+  }
+}
+
+// Video range sample x (zero at 16 for Y, 128 for chroma) stretched to full range.
+static uint8_t ref_full_range(int x, int zero, double scale) {
+  double v = round((x - zero) * scale) + (zero == 16 ? 0 : 128);
+  return v < 0 ? 0 : (v > 255 ? 255 : (uint8_t)v);
+}
+
+static void check_rgb565(void) {
+  uint8_t *src = malloc(65536 * 3), *want = malloc(65536 * 3), *got = malloc(65536 * 3);
+  for (int v = 0; v < 65536; v++) {
+    src[2 * v] = v >> 8;
+    src[2 * v + 1] = v & 0xFF;
+  }
+  for (int be = 0; be < 2; be++) {
+    ref_rgb565(want, src, 65536, be);
+    line_rgb565_to_rgb888(got, src, 65536, be, false);
+    for (size_t i = 0; i < 65536; i++) {
+      if (memcmp(got + 3 * i, want + 3 * i, 3)) {
+        fail(be ? "rgb565 big-endian" : "rgb565 little-endian", i);
+        break;
+      }
+    }
+    line_rgb565_to_rgb888(got, src, 65536, be, true);
+    for (size_t i = 0; i < 65536; i++) {
+      if (got[3 * i] != want[3 * i + 2] || got[3 * i + 1] != want[3 * i + 1] || got[3 * i + 2] != want[3 * i]) {
+        fail("rgb565 bgr", i);
+        break;
+      }
+    }
+  }
+  // got holds every RGB565 colour as BGR888 now
+  ref_swap(want, got, 65536);
+  line_swap_rb888(src, got, 65536);
+  if (memcmp(src, want, 65536 * 3)) {
+    fail("bgr swap", 0);
+  }
+  free(src);
+  free(want);
+  free(got);
+}
+
+static void check_yuv(void) {
+  // For each (u, v): a line with every Y at both positions of a pair.
+  uint8_t src[512 * 2], want[512 * 3], got[512 * 3];
+  for (int u = 0; u < 256; u++) {
+    for (int v = 0; v < 256; v++) {
+      for (int i = 0; i < 256; i++) {
+        uint8_t *s = src + 4 * i;
+        s[0] = i;
+        s[1] = u;
+        s[2] = 255 - i;
+        s[3] = v;
+      }
+      ref_yuv422(want, src, 512);
+      line_yuv422_to_rgb888(got, src, 512, false);
+      if (memcmp(got, want, sizeof(want))) {
+        for (size_t i = 0; i < 512; i++) {
+          if (memcmp(got + 3 * i, want + 3 * i, 3)) {
+            fail("yuv422 to rgb888", i);
+            break;
+          }
+        }
+        return;
+      }
+      line_yuv422_to_rgb888(got, src, 512, true);
+      for (size_t i = 0; i < 512; i++) {
+        if (got[3 * i] != want[3 * i + 2] || got[3 * i + 2] != want[3 * i]) {
+          fail("yuv422 to bgr888", i);
+          return;
+        }
+      }
+      if (v == u) {
+        line_yuv422_to_jfif(got, src, 512);
+        for (size_t i = 0; i < 512 * 2; i++) {
+          uint8_t want = (i & 1) ? ref_full_range(src[i], 128, 255.0 / 224.0) : ref_full_range(src[i], 16, 255.0 / 219.0);
+          if (got[i] != want) {
+            fail("yuv422 to jfif", i / 2);
+            return;
+          }
+        }
+      }
+    }
+  }
+}
+
+typedef void (*kernel_fn)(uint8_t *dst, const uint8_t *src);
+
+static void k_rgb565(uint8_t *d, const uint8_t *s) { line_rgb565_to_rgb888(d, s, LINE, true, false); }
+static void r_rgb565(uint8_t *d, const uint8_t *s) { ref_rgb565(d, s, LINE, true); }
+static void k_swap(uint8_t *d, const uint8_t *s) { line_swap_rb888(d, s, LINE); }
+static void r_swap(uint8_t *d, const uint8_t *s) { ref_swap(d, s, LINE); }
+static void k_yuv(uint8_t *d, const uint8_t *s) { line_yuv422_to_rgb888(d, s, LINE, false); }
+static void r_yuv(uint8_t *d, const uint8_t *s) { ref_yuv422(d, s, LINE); }
+static void k_jfif(uint8_t *d, const uint8_t *s) { line_yuv422_to_jfif(d, s, LINE); }
+static void r_ycc(uint8_t *d, const uint8_t *s) { ref_yuv422_ycc(d, s, LINE); }
+
+static double per_pixel(kernel_fn fn, const uint8_t *src, uint8_t *dst, int lines) {
+  double best = 1e30;
+  for (int rep = 0; rep < 5; rep++) {
+    double t0 = ticks();
+    for (int l = 0; l < lines; l++) {
+      fn(dst, src + (l & 7) * LINE * 3);
+    }
+    double t = (ticks() - t0) / ((double)lines * LINE);
+    if (t < best) {
+      best = t;
+    }
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  int lines = 2000;
+  if (argc > 1 && !strcmp(argv[1], "--quick")) {
+    lines = 200;
+  } else if (argc > 1) {
+    fprintf(stderr, "usage: %s [--quick]\n", argv[0]);
+    return 2;
+  }
+
+  check_rgb565();
+  check_yuv();
+  printf("line kernels: %s\n", s_failures ? "MISMATCH" : "bit-exact with the scalar code");
+
+  uint8_t *src = malloc(8 * LINE * 3), *dst = malloc(LINE * 3);
+  srand(1);
+  for (int i = 0; i < 8 * LINE * 3; i++) {
+    src[i] = rand();
+  }
+  static const struct {
+    const char *name;
+    kernel_fn kernel, scalar;
+  } k_rows[] = {
+      {"rgb565 -> rgb888", k_rgb565, r_rgb565},
+      {"bgr888 -> rgb888", k_swap, r_swap},
+      {"yuv422 -> rgb888", k_yuv, r_yuv},
+      {"yuv422 -> jfif", k_jfif, r_ycc},
+  };
+  printf("%-18s %10s %10s %8s\n", "kernel", "scalar", "line", "speedup");
+  for (size_t r = 0; r < sizeof(k_rows) / sizeof(k_rows[0]); r++) {
+    double k = per_pixel(k_rows[r].kernel, src, dst, lines);
+    double s = per_pixel(k_rows[r].scalar, src, dst, lines);
+    printf("%-18s %10.2f %10.2f %7.1fx  %s\n", k_rows[r].name, s, k, s / k, BENCH_UNIT);
+  }
+  free(src);
+  free(dst);
+  return s_failures ? 1 : 0;
+}
@@ -0,0 +1,816 @@
+// Simulated LCD_CAM + GDMA for the host build; stands in for
+// target/esp32s3/ll_cam.c. See cam_sim.h.
+//
+// The DMA sizing and ll_cam_memcpy() follow the S3 target exactly, so cam_hal
+// allocates the same buffers and counts the same EOF events as on the board.
+// Registers become a few atomics: VSYNC interrupt enable, DMA running, EOF
+// interrupt enable, and a start counter bumped by every ll_cam_start().
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cam_sim.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "idf_host.h"
+#include "ll_cam.h"
+#include "cam_hal.h"
+
+static const char *TAG = "sim ll_cam";
+
+typedef struct {
+  uint8_t *data;
+  size_t len;
+  pixformat_t format;
+  uint16_t width;
+  uint16_t height;
+} sim_frame_t;
+
+static struct {
+  // Guards frames, config, faults and stats.
+  pthread_mutex_t lock;
+  sim_frame_t *frames;
+  size_t frame_count;
+  size_t frame_cap;
+  size_t next_frame;
+  cam_sim_config_t cfg;
+  uint32_t pending[CAM_SIM_FAULT_MAX];
+  uint32_t param[CAM_SIM_FAULT_MAX];
+  cam_sim_stats_t stats;
+
+  // Held by the source thread around each write/event; disabling VSYNC takes
+  // it too, so once ll_cam_vsync_intr_enable(false) returns the thread no
+  // longer touches the cam object or its queues.
+  pthread_mutex_t bus;
+  pthread_cond_t started;
+
+  cam_obj_t *cam;
+  pthread_t thread;
+  atomic_bool running;
+  atomic_bool vsync_enabled;
+  atomic_bool dma_running;
+  atomic_bool eof_enabled;
+  atomic_uint start_seq;
+  atomic_int frame_pos;
+
+  // Source thread only.
+  uint8_t *work;
+  size_t work_cap;
+  uint32_t rng;
+  uint32_t phase;
+} s_sim = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .bus = PTHREAD_MUTEX_INITIALIZER,
+    .started = PTHREAD_COND_INITIALIZER,
+    .cfg = {.fps = 25, .pclk_bytes_per_s = 10000000, .vblank_us = 2000, .lossless = false},
+    .rng = 0x12345678U,
+};
+
+static const char *const k_fault_names[CAM_SIM_FAULT_MAX] = {
+    "truncate", "no_eoi", "no_soi", "drop_eof", "drop_vsync", "dma_stall", "sensor_hang", "wedged",
+};
+
+const char *cam_sim_fault_name(cam_sim_fault_t fault) {
+  return fault < CAM_SIM_FAULT_MAX ? k_fault_names[fault] : "?";
+}
+
+static bool is_held(cam_sim_fault_t fault) {
+  return fault >= CAM_SIM_FAULT_DMA_STALL;
+}
+
+static void sleep_until_us(int64_t t_us) {
+  host_sleep_us(t_us - esp_timer_get_time());
+}
+
+static uint32_t next_rand(void) {
+  s_sim.rng ^= s_sim.rng << 13;
+  s_sim.rng ^= s_sim.rng >> 17;
+  s_sim.rng ^= s_sim.rng << 5;
+  return s_sim.rng;
+}
+
+// ---- public API ----
+
+void cam_sim_default_config(cam_sim_config_t *cfg) {
+  cfg->fps = 25;
+  cfg->pclk_bytes_per_s = 10000000;
+  cfg->vblank_us = 2000;
+  cfg->lossless = false;
+}
+
+void cam_sim_set_config(const cam_sim_config_t *cfg) {
+  pthread_mutex_lock(&s_sim.lock);
+  s_sim.cfg = *cfg;
+  pthread_mutex_unlock(&s_sim.lock);
+}
+
+static bool sof_dimensions(const uint8_t *buf, size_t len, uint16_t *width, uint16_t *height) {
+  size_t i = 2;
+  while (i + 9 <= len && buf[i] == 0xFF) {
+    uint8_t marker = buf[i + 1];
+    if (marker >= 0xC0 && marker <= 0xC2) {
+      *height = (uint16_t)((buf[i + 5] << 8) | buf[i + 6]);
+      *width = (uint16_t)((buf[i + 7] << 8) | buf[i + 8]);
+      return true;
+    }
+    if (marker == 0xDA) {
+      break;
+    }
+    i += 2 + (((size_t)buf[i + 2] << 8) | buf[i + 3]);
+  }
+  return false;
+}
+
+esp_err_t cam_sim_add_frame(pixformat_t format, uint16_t width, uint16_t height, const uint8_t *data,
+                            size_t len) {
+  if (!data || len == 0) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (format == PIXFORMAT_JPEG) {
+    if ((!width || !height) && !sof_dimensions(data, len, &width, &height)) {
+      return ESP_ERR_INVALID_ARG;
+    }
+  } else if (format == PIXFORMAT_RGB565 || format == PIXFORMAT_YUV422) {
+    if ((size_t)width * height * 2U != len) {
+      return ESP_ERR_INVALID_SIZE;
+    }
+  } else {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  uint8_t *copy = malloc(len);
+  if (!copy) {
+    return ESP_ERR_NO_MEM;
+  }
+  memcpy(copy, data, len);
+  pthread_mutex_lock(&s_sim.lock);
+  if (s_sim.frame_count == s_sim.frame_cap) {
+    size_t cap = s_sim.frame_cap ? s_sim.frame_cap * 2U : 8U;
+    sim_frame_t *grown = realloc(s_sim.frames, cap * sizeof(*grown));
+    if (!grown) {
+      pthread_mutex_unlock(&s_sim.lock);
+      free(copy);
+      return ESP_ERR_NO_MEM;
+    }
+    s_sim.frames = grown;
+    s_sim.frame_cap = cap;
+  }
+  s_sim.frames[s_sim.frame_count++] = (sim_frame_t){copy, len, format, width, height};
+  pthread_mutex_unlock(&s_sim.lock);
+  return ESP_OK;
+}
+
+esp_err_t cam_sim_add_file(const char *path) {
+  const char *dot = strrchr(path, '.');
+  if (!dot) {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  pixformat_t format;
+  unsigned w = 0;
+  unsigned h = 0;
+  if (!strcmp(dot, ".jpg") || !strcmp(dot, ".jpeg")) {
+    format = PIXFORMAT_JPEG;
+  } else if (!strcmp(dot, ".rgb565") || !strcmp(dot, ".yuv422")) {
+    format = dot[1] == 'r' ? PIXFORMAT_RGB565 : PIXFORMAT_YUV422;
+    const char *us = dot;
+    while (us > path && us[-1] != '_') {
+      us--;
+    }
+    if (us == path || sscanf(us, "%ux%u", &w, &h) != 2) {
+      ESP_LOGE(TAG, "%s: raw frames need _<W>x<H> before the extension", path);
+      return ESP_ERR_INVALID_ARG;
+    }
+  } else {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    ESP_LOGE(TAG, "%s: cannot open", path);
+    return ESP_ERR_NOT_FOUND;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  uint8_t *buf = size > 0 ? malloc((size_t)size) : NULL;
+  esp_err_t err = ESP_ERR_NO_MEM;
+  if (buf && fread(buf, 1, (size_t)size, f) == (size_t)size) {
+    err = cam_sim_add_frame(format, (uint16_t)w, (uint16_t)h, buf, (size_t)size);
+  }
+  free(buf);
+  fclose(f);
+  return err;
+}
+
+void cam_sim_clear_frames(void) {
+  pthread_mutex_lock(&s_sim.lock);
+  for (size_t i = 0; i < s_sim.frame_count; i++) {
+    free(s_sim.frames[i].data);
+  }
+  s_sim.frame_count = 0;
+  s_sim.next_frame = 0;
+  pthread_mutex_unlock(&s_sim.lock);
+}
+
+size_t cam_sim_frame_count(void) {
+  pthread_mutex_lock(&s_sim.lock);
+  size_t n = s_sim.frame_count;
+  pthread_mutex_unlock(&s_sim.lock);
+  return n;
+}
+
+void cam_sim_inject(cam_sim_fault_t fault, uint32_t frames, uint32_t param) {
+  if (fault >= CAM_SIM_FAULT_MAX) {
+    return;
+  }
+  pthread_mutex_lock(&s_sim.lock);
+  if (is_held(fault)) {
+    s_sim.pending[fault] = 1;
+    s_sim.stats.faults[fault]++;
+  } else {
+    s_sim.pending[fault] = frames;
+  }
+  s_sim.param[fault] = param;
+  pthread_mutex_unlock(&s_sim.lock);
+}
+
+void cam_sim_clear_faults(void) {
+  pthread_mutex_lock(&s_sim.lock);
+  memset(s_sim.pending, 0, sizeof(s_sim.pending));
+  pthread_mutex_unlock(&s_sim.lock);
+}
+
+void cam_sim_get_stats(cam_sim_stats_t *out) {
+  pthread_mutex_lock(&s_sim.lock);
+  *out = s_sim.stats;
+  pthread_mutex_unlock(&s_sim.lock);
+}
+
+void cam_sim_reset_stats(void) {
+  pthread_mutex_lock(&s_sim.lock);
+  memset(&s_sim.stats, 0, sizeof(s_sim.stats));
+  pthread_mutex_unlock(&s_sim.lock);
+}
+
+static void clear_held(cam_sim_fault_t fault) {
+  pthread_mutex_lock(&s_sim.lock);
+  s_sim.pending[fault] = 0;
+  pthread_mutex_unlock(&s_sim.lock);
+}
+
+void cam_sim_sensor_reset(void) {
+  pthread_mutex_lock(&s_sim.lock);
+  s_sim.stats.sensor_resets++;
+  s_sim.pending[CAM_SIM_FAULT_SENSOR_HANG] = 0;
+  pthread_mutex_unlock(&s_sim.lock);
+}
+
+// ---- event delivery ----
+
+static void count_stat(uint32_t *field) {
+  pthread_mutex_lock(&s_sim.lock);
+  (*field)++;
+  pthread_mutex_unlock(&s_sim.lock);
+}
+
+// Caller holds s_sim.bus with VSYNC enabled. In lossless mode waits until
+// cam_task has handled every earlier event, so it is never more than the
+// half being written behind and the ring slot it copies from is not
+// overwritten; otherwise an overflow takes the driver's own path (DMA stop,
+// state reset).
+static void raise_event(cam_event_t ev, bool lossless) {
+  cam_obj_t *cam = s_sim.cam;
+  if (lossless) {
+    while (atomic_load(&s_sim.vsync_enabled) && !host_queue_wait_drained(cam->event_queue, 0)) {
+      pthread_mutex_unlock(&s_sim.bus);
+      host_queue_wait_drained(cam->event_queue, 1000);
+      pthread_mutex_lock(&s_sim.bus);
+    }
+    if (!atomic_load(&s_sim.vsync_enabled)) {
+      return;
+    }
+  }
+  if (uxQueueSpacesAvailable(cam->event_queue) == 0) {
+    count_stat(&s_sim.stats.events_dropped);
+  }
+  count_stat(ev == CAM_VSYNC_EVENT ? &s_sim.stats.vsync_events : &s_sim.stats.eof_events);
+  BaseType_t woken = pdFALSE;
+  ll_cam_send_event(cam, ev, &woken);
+}
+
+esp_err_t cam_sim_post_event(cam_sim_event_t event) {
+  pthread_mutex_lock(&s_sim.bus);
+  if (!s_sim.cam || !atomic_load(&s_sim.vsync_enabled)) {
+    pthread_mutex_unlock(&s_sim.bus);
+    return ESP_ERR_INVALID_STATE;
+  }
+  raise_event(event == CAM_SIM_EVENT_VSYNC ? CAM_VSYNC_EVENT : CAM_IN_SUC_EOF_EVENT, false);
+  pthread_mutex_unlock(&s_sim.bus);
+  return ESP_OK;
+}
+
+// ---- frame source ----
+
+static bool reserve_work(size_t len) {
+  if (len <= s_sim.work_cap) {
+    return true;
+  }
+  uint8_t *grown = realloc(s_sim.work, len);
+  if (!grown) {
+    return false;
+  }
+  s_sim.work = grown;
+  s_sim.work_cap = len;
+  return true;
+}
+
+// A marker-correct JPEG of the right size for the sensor's quality setting:
+// SOI, SOF0 with the dimensions, an entropy segment of random non-FF bytes,
+// EOI. Not decodable, but cam_hal and bsp_camera only look at the markers.
+// Size is about 1.1/quality bytes per pixel (SVGA at q12: ~44 kB), +-8%.
+static size_t synth_jpeg(uint16_t w, uint16_t h, int quality) {
+  if (quality < 2) {
+    quality = 2;
+  }
+  size_t len = (size_t)((double)w * h * 1.1 / quality);
+  len = len - len * 8U / 100U + (next_rand() % (len * 16U / 100U + 1U));
+  if (len < 64) {
+    len = 64;
+  }
+  if (!reserve_work(len)) {
+    return 0;
+  }
+  static const uint8_t head[] = {0xFF, 0xD8, 0xFF, 0xC0, 0x00, 0x11, 0x08};
+  uint8_t *p = s_sim.work;
+  memcpy(p, head, sizeof(head));
+  p[7] = (uint8_t)(h >> 8);
+  p[8] = (uint8_t)h;
+  p[9] = (uint8_t)(w >> 8);
+  p[10] = (uint8_t)w;
+  p[11] = 3;
+  for (int c = 0; c < 3; c++) {
+    p[12 + c * 3] = (uint8_t)(c + 1);
+    p[13 + c * 3] = c ? 0x11 : 0x21;
+    p[14 + c * 3] = c ? 1 : 0;
+  }
+  p[21] = 0xFF;
+  p[22] = 0xDA;
+  for (size_t i = 23; i < len - 2; i += 4) {
+    uint32_t r = next_rand() & 0x7F7F7F7FU;
+    memcpy(p + i, &r, len - 2 - i < 4 ? len - 2 - i : 4);
+  }
+  p[len - 2] = 0xFF;
+  p[len - 1] = 0xD9;
+  return len;
+}
+
+// Diagonal bars that move one pixel per frame.
+static size_t synth_raw(pixformat_t format, uint16_t w, uint16_t h) {
+  size_t len = (size_t)w * h * 2U;
+  if (!reserve_work(len)) {
+    return 0;
+  }
+  uint8_t *p = s_sim.work;
+  for (uint16_t y = 0; y < h; y++) {
+    for (uint16_t x = 0; x < w; x++) {
+      uint8_t v = (uint8_t)(((x + y + s_sim.phase) & 0x3F) << 2);
+      if (format == PIXFORMAT_RGB565) {
+        uint16_t px = (uint16_t)(((v >> 3) << 11) | ((v >> 2) << 5) | (v >> 3));
+        *p++ = (uint8_t)(px >> 8);
+        *p++ = (uint8_t)px;
+      } else {
+        *p++ = v;
+        *p++ = 128;
+      }
+    }
+  }
+  s_sim.phase++;
+  return len;
+}
+
+// Copies the next frame for the sensor's format and size into s_sim.work.
+static size_t next_frame(void) {
+  sensor_t *sensor = esp_camera_sensor_get();
+  if (!sensor || sensor->status.framesize >= FRAMESIZE_INVALID) {
+    return 0;
+  }
+  pixformat_t format = sensor->pixformat == PIXFORMAT_GRAYSCALE ? PIXFORMAT_YUV422 : sensor->pixformat;
+  uint16_t w = resolution[sensor->status.framesize].width;
+  uint16_t h = resolution[sensor->status.framesize].height;
+
+  pthread_mutex_lock(&s_sim.lock);
+  const sim_frame_t *pick = NULL;
+  const sim_frame_t *any_jpeg = NULL;
+  for (size_t n = 0; n < s_sim.frame_count && !pick; n++) {
+    const sim_frame_t *f = &s_sim.frames[(s_sim.next_frame + n) % s_sim.frame_count];
+    if (f->format != format) {
+      continue;
+    }
+    if (f->width == w && f->height == h) {
+      pick = f;
+    } else if (format == PIXFORMAT_JPEG && !any_jpeg) {
+      any_jpeg = f;
+    }
+  }
+  if (!pick) {
+    pick = any_jpeg;
+  }
+  size_t len = 0;
+  if (pick) {
+    s_sim.next_frame = (size_t)(pick - s_sim.frames + 1) % s_sim.frame_count;
+    if (reserve_work(pick->len)) {
+      memcpy(s_sim.work, pick->data, pick->len);
+      len = pick->len;
+    }
+  }
+  pthread_mutex_unlock(&s_sim.lock);
+  if (pick) {
+    return len;
+  }
+  return format == PIXFORMAT_JPEG ? synth_jpeg(w, h, sensor->status.quality) : synth_raw(format, w, h);
+}
+
+typedef struct {
+  bool truncate;
+  bool drop_eof;
+  bool drop_vsync;
+} frame_faults_t;
+
+static bool take_fault(cam_sim_fault_t fault, uint32_t *param) {
+  if (!s_sim.pending[fault]) {
+    return false;
+  }
+  s_sim.pending[fault]--;
+  s_sim.stats.faults[fault]++;
+  if (param) {
+    *param = s_sim.param[fault];
+  }
+  return true;
+}
+
+static size_t apply_faults(size_t len, frame_faults_t *out) {
+  uint32_t keep = 0;
+  pthread_mutex_lock(&s_sim.lock);
+  memset(out, 0, sizeof(*out));
+  if (take_fault(CAM_SIM_FAULT_NO_SOI, NULL) && len >= 2) {
+    s_sim.work[0] = 0;
+    s_sim.work[1] = 0;
+  }
+  if (take_fault(CAM_SIM_FAULT_NO_EOI, NULL) && len >= 2) {
+    s_sim.work[len - 2] = 0;
+    s_sim.work[len - 1] = 0;
+  }
+  if (take_fault(CAM_SIM_FAULT_TRUNCATE, &keep)) {
+    len = keep && keep < len ? keep : len / 2U;
+  }
+  out->drop_eof = take_fault(CAM_SIM_FAULT_DROP_EOF, NULL);
+  out->drop_vsync = take_fault(CAM_SIM_FAULT_DROP_VSYNC, NULL);
+  pthread_mutex_unlock(&s_sim.lock);
+  return len;
+}
+
+static bool fault_held(cam_sim_fault_t fault) {
+  pthread_mutex_lock(&s_sim.lock);
+  bool held = s_sim.pending[fault] != 0;
+  pthread_mutex_unlock(&s_sim.lock);
+  return held;
+}
+
+// Locks the bus if the interface is enabled.
+static bool bus_begin(void) {
+  pthread_mutex_lock(&s_sim.bus);
+  if (atomic_load(&s_sim.vsync_enabled)) {
+    return true;
+  }
+  pthread_mutex_unlock(&s_sim.bus);
+  return false;
+}
+
+// Waits for cam_task to restart the DMA after a VSYNC (ll_cam_start bumps
+// start_seq). Without a free frame buffer it never does, and the sensor's
+// data for this frame is lost, as on hardware.
+static bool wait_for_start(unsigned seq, uint32_t vblank_us, bool lossless) {
+  struct timespec deadline;
+  host_deadline_us(&deadline, lossless ? 100000 : vblank_us);
+  pthread_mutex_lock(&s_sim.lock);
+  while (atomic_load(&s_sim.start_seq) == seq && atomic_load(&s_sim.vsync_enabled)) {
+    if (pthread_cond_timedwait(&s_sim.started, &s_sim.lock, &deadline) == ETIMEDOUT) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&s_sim.lock);
+  return atomic_load(&s_sim.start_seq) != seq && atomic_load(&s_sim.dma_running);
+}
+
+// Writes len bytes at the DMA position, node by node, raising EOF at every
+// dma_half_buffer_size boundary. Returns false if the transfer was cut off.
+static bool dma_write(const uint8_t *src, size_t len, size_t *offset, const frame_faults_t *ff,
+                      const cam_sim_config_t *cfg, int64_t *bus_us) {
+  while (len > 0) {
+    if (!bus_begin()) {
+      return false;
+    }
+    cam_obj_t *cam = s_sim.cam;
+    if (!atomic_load(&s_sim.dma_running)) {
+      pthread_mutex_unlock(&s_sim.bus);
+      return false;
+    }
+    if (fault_held(CAM_SIM_FAULT_DMA_STALL)) {
+      pthread_mutex_unlock(&s_sim.bus);
+      return false;
+    }
+    const size_t node_size = cam->dma_node_buffer_size;
+    const size_t half = cam->dma_half_buffer_size;
+    lldesc_t *desc = cam->psram_mode ? cam->frames[atomic_load(&s_sim.frame_pos)].dma : cam->dma;
+    size_t node = (*offset / node_size) % cam->dma_node_cnt;
+    size_t in_node = *offset % node_size;
+    size_t n = node_size - in_node;
+    if (n > half - *offset % half) {
+      n = half - *offset % half;
+    }
+    if (n > len) {
+      n = len;
+    }
+    memcpy((uint8_t *)desc[node].buf + in_node, src, n);
+    *offset += n;
+    src += n;
+    len -= n;
+    pthread_mutex_lock(&s_sim.lock);
+    s_sim.stats.bytes += n;
+    pthread_mutex_unlock(&s_sim.lock);
+    if (*offset % half == 0 && atomic_load(&s_sim.eof_enabled) && !ff->drop_eof) {
+      raise_event(CAM_IN_SUC_EOF_EVENT, cfg->lossless);
+    }
+    pthread_mutex_unlock(&s_sim.bus);
+    if (cfg->pclk_bytes_per_s) {
+      *bus_us += (int64_t)n * 1000000 / cfg->pclk_bytes_per_s;
+      sleep_until_us(*bus_us);
+    }
+  }
+  return true;
+}
+
+static void *source_thread(void *arg) {
+  (void)arg;
+  int64_t next_frame_us = esp_timer_get_time();
+  bool carry = false;  // previous frame's VSYNC was dropped
+  size_t offset = 0;
+  while (atomic_load(&s_sim.running)) {
+    pthread_mutex_lock(&s_sim.lock);
+    cam_sim_config_t cfg = s_sim.cfg;
+    pthread_mutex_unlock(&s_sim.lock);
+
+    if (!atomic_load(&s_sim.vsync_enabled) || fault_held(CAM_SIM_FAULT_SENSOR_HANG) ||
+        fault_held(CAM_SIM_FAULT_WEDGED)) {
+      sleep_until_us(esp_timer_get_time() + 1000);
+      next_frame_us = esp_timer_get_time();
+      carry = false;
+      continue;
+    }
+    if (cfg.fps) {
+      int64_t period = 1000000 / cfg.fps;
+      int64_t now = esp_timer_get_time();
+      if (next_frame_us < now - period) {
+        next_frame_us = now;  // fell behind: drop the backlog, keep the rate
+      }
+      sleep_until_us(next_frame_us);
+      next_frame_us += period;
+    }
+
+    if (!carry) {
+      unsigned seq = atomic_load(&s_sim.start_seq);
+      if (!bus_begin()) {
+        continue;
+      }
+      raise_event(CAM_VSYNC_EVENT, cfg.lossless);
+      pthread_mutex_unlock(&s_sim.bus);
+      offset = 0;
+      if (!wait_for_start(seq, cfg.vblank_us, cfg.lossless)) {
+        pthread_mutex_lock(&s_sim.lock);
+        s_sim.stats.frames++;
+        s_sim.stats.frames_missed++;
+        pthread_mutex_unlock(&s_sim.lock);
+        continue;
+      }
+    }
+
+    // The sensor state is only valid while the interface is enabled.
+    if (!bus_begin()) {
+      continue;
+    }
+    size_t len = next_frame();
+    pthread_mutex_unlock(&s_sim.bus);
+    frame_faults_t ff;
+    len = apply_faults(len, &ff);
+    count_stat(&s_sim.stats.frames);
+    int64_t bus_us = esp_timer_get_time();
+    dma_write(s_sim.work, len, &offset, &ff, &cfg, &bus_us);
+    carry = ff.drop_vsync;
+  }
+  return NULL;
+}
+
+// ---- ll_cam interface ----
+
+bool ll_cam_stop(cam_obj_t *cam) {
+  if (cam->jpeg_mode || !cam->psram_mode) {
+    atomic_store(&s_sim.eof_enabled, false);
+  }
+  atomic_store(&s_sim.dma_running, false);
+  return true;
+}
+
+bool ll_cam_start(cam_obj_t *cam, int frame_pos) {
+  atomic_store(&s_sim.frame_pos, frame_pos);
+  atomic_store(&s_sim.eof_enabled, cam->jpeg_mode || !cam->psram_mode);
+  atomic_store(&s_sim.dma_running, true);
+  pthread_mutex_lock(&s_sim.lock);
+  atomic_fetch_add(&s_sim.start_seq, 1);
+  pthread_cond_broadcast(&s_sim.started);
+  pthread_mutex_unlock(&s_sim.lock);
+  return true;
+}
+
+esp_err_t ll_cam_deinit(cam_obj_t *cam) {
+  (void)cam;
+  if (atomic_exchange(&s_sim.running, false)) {
+    ll_cam_vsync_intr_enable(cam, false);
+    pthread_join(s_sim.thread, NULL);
+  }
+  s_sim.cam = NULL;
+  clear_held(CAM_SIM_FAULT_WEDGED);
+  return ESP_OK;
+}
+
+esp_err_t ll_cam_config(cam_obj_t *cam, const camera_config_t *config) {
+  (void)cam;
+  (void)config;
+  return ESP_OK;
+}
+
+void ll_cam_vsync_intr_enable(cam_obj_t *cam, bool en) {
+  (void)cam;
+  atomic_store(&s_sim.vsync_enabled, en);
+  if (!en) {
+    // Wait out a write or event in flight, and wake a pending start wait.
+    pthread_mutex_lock(&s_sim.bus);
+    pthread_mutex_unlock(&s_sim.bus);
+    pthread_mutex_lock(&s_sim.lock);
+    pthread_cond_broadcast(&s_sim.started);
+    pthread_mutex_unlock(&s_sim.lock);
+  }
+}
+
+esp_err_t ll_cam_set_pin(cam_obj_t *cam, const camera_config_t *config) {
+  (void)cam;
+  (void)config;
+  return ESP_OK;
+}
+
+esp_err_t ll_cam_init_isr(cam_obj_t *cam) {
+  s_sim.cam = cam;
+  atomic_store(&s_sim.running, true);
+  if (pthread_create(&s_sim.thread, NULL, source_thread, NULL) != 0) {
+    atomic_store(&s_sim.running, false);
+    return ESP_FAIL;
+  }
+  return ESP_OK;
+}
+
+void ll_cam_do_vsync(cam_obj_t *cam) {
+  (void)cam;
+}
+
+uint8_t ll_cam_get_dma_align(cam_obj_t *cam) {
+  (void)cam;
+  return 16;
+}
+
+// Same node/half-buffer search as target/esp32s3/ll_cam.c.
+static bool ll_cam_calc_rgb_dma(cam_obj_t *cam) {
+  size_t node_max = LCD_CAM_DMA_NODE_BUFFER_MAX_SIZE / cam->dma_bytes_per_item;
+  size_t line_width = cam->width * cam->in_bytes_per_pixel;
+  size_t node_size = node_max;
+  size_t nodes_per_line = 1;
+  size_t lines_per_node = 1;
+
+  if (line_width >= node_max) {
+    for (size_t i = node_max; i > 0; i = i - 1) {
+      if ((line_width % i) == 0) {
+        node_size = i;
+        nodes_per_line = line_width / node_size;
+        break;
+      }
+    }
+  } else {
+    for (size_t i = node_max; i > 0; i = i - 1) {
+      if ((i % line_width) == 0) {
+        node_size = i;
+        lines_per_node = node_size / line_width;
+        while ((cam->height % lines_per_node) != 0) {
+          lines_per_node = lines_per_node - 1;
+          node_size = lines_per_node * line_width;
+        }
+        break;
+      }
+    }
+  }
+  cam->dma_node_buffer_size = node_size * cam->dma_bytes_per_item;
+
+  size_t dma_half_buffer_max = CONFIG_CAMERA_DMA_BUFFER_SIZE_MAX / 2 / cam->dma_bytes_per_item;
+  if (line_width > dma_half_buffer_max) {
+    ESP_LOGE(TAG, "Resolution too high");
+    return false;
+  }
+  size_t dma_half_buffer_min = node_size * nodes_per_line;
+  size_t dma_half_buffer = (dma_half_buffer_max / dma_half_buffer_min) * dma_half_buffer_min;
+  size_t lines_per_half_buffer = dma_half_buffer / line_width;
+  while ((cam->height % lines_per_half_buffer) != 0) {
+    dma_half_buffer = dma_half_buffer - dma_half_buffer_min;
+    lines_per_half_buffer = dma_half_buffer / line_width;
+  }
+  size_t dma_buffer_max = 2 * dma_half_buffer_max;
+  if (cam->psram_mode) {
+    dma_buffer_max = cam->recv_size / cam->dma_bytes_per_item;
+  }
+  size_t dma_buffer_size = dma_buffer_max;
+  if (!cam->psram_mode) {
+    dma_buffer_size = (dma_buffer_max / dma_half_buffer) * dma_half_buffer;
+  }
+  cam->dma_buffer_size = dma_buffer_size * cam->dma_bytes_per_item;
+  cam->dma_half_buffer_size = dma_half_buffer * cam->dma_bytes_per_item;
+  cam->dma_half_buffer_cnt = cam->dma_buffer_size / cam->dma_half_buffer_size;
+  return true;
+}
+
+bool ll_cam_dma_sizes(cam_obj_t *cam) {
+  cam->dma_bytes_per_item = 1;
+  if (!cam->jpeg_mode) {
+    return ll_cam_calc_rgb_dma(cam);
+  }
+  if (cam->psram_mode) {
+    cam->dma_buffer_size = cam->recv_size;
+    cam->dma_half_buffer_size = 1024;
+    cam->dma_half_buffer_cnt = cam->dma_buffer_size / cam->dma_half_buffer_size;
+    cam->dma_node_buffer_size = cam->dma_half_buffer_size;
+  } else {
+    cam->dma_half_buffer_cnt = 16;
+    cam->dma_buffer_size = cam->dma_half_buffer_cnt * 1024;
+    cam->dma_half_buffer_size = cam->dma_buffer_size / cam->dma_half_buffer_cnt;
+    cam->dma_node_buffer_size = cam->dma_half_buffer_size;
+  }
+  return true;
+}
+
+size_t ll_cam_memcpy(cam_obj_t *cam, uint8_t *out, const uint8_t *in, size_t len) {
+  if (cam->in_bytes_per_pixel == 2 && cam->fb_bytes_per_pixel == 1) {
+    size_t end = len / 8;
+    for (size_t i = 0; i < end; ++i) {
+      out[0] = in[0];
+      out[1] = in[2];
+      out[2] = in[4];
+      out[3] = in[6];
+      out += 4;
+      in += 8;
+    }
+    return len / 2;
+  }
+  memcpy(out, in, len);
+  return len;
+}
+
+esp_err_t ll_cam_set_sample_mode(cam_obj_t *cam, pixformat_t pix_format, uint32_t xclk_freq_hz, uint16_t sensor_pid) {
+  (void)xclk_freq_hz;
+  if (pix_format == PIXFORMAT_GRAYSCALE) {
+    cam->in_bytes_per_pixel = sensor_pid == OV2640_PID ? 2 : 1;
+    cam->fb_bytes_per_pixel = 1;
+  } else if (pix_format == PIXFORMAT_YUV422 || pix_format == PIXFORMAT_RGB565) {
+    cam->in_bytes_per_pixel = 2;
+    cam->fb_bytes_per_pixel = 2;
+  } else if (pix_format == PIXFORMAT_JPEG) {
+    cam->in_bytes_per_pixel = 1;
+    cam->fb_bytes_per_pixel = 1;
+  } else {
+    ESP_LOGE(TAG, "Requested format is not supported");
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  return ESP_OK;
+}
+
+void ll_cam_dma_print_state(cam_obj_t *cam) {
+  (void)cam;
+  ESP_LOGI(TAG, "dma running %d, eof %d, start %u", (int)atomic_load(&s_sim.dma_running),
+           (int)atomic_load(&s_sim.eof_enabled), atomic_load(&s_sim.start_seq));
+}
+
+void ll_cam_dma_reset(cam_obj_t *cam) {
+  (void)cam;
+  pthread_mutex_lock(&s_sim.lock);
+  s_sim.stats.dma_resets++;
+  s_sim.pending[CAM_SIM_FAULT_DMA_STALL] = 0;
+  pthread_mutex_unlock(&s_sim.lock);
+}
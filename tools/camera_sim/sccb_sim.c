@@ -0,0 +1,134 @@
+// SCCB bus with a single OV2640 on it: a two-bank register file selected by
+// register 0xFF, preloaded with the chip ID. Writes are stored and read back;
+// a COM7 soft reset restores the power-on values and tells the simulator.
+// Also provides the xclk hooks the sensor drivers link against.
+
+#include <pthread.h>
+#include <string.h>
+
+#include "cam_sim.h"
+#include "esp_err.h"
+#include "sccb.h"
+#include "xclk.h"
+
+#define OV2640_ADDR 0x30
+#define REG_BANK_SEL 0xFF
+#define BANK_SENSOR 1
+#define REG_COM7 0x12
+#define COM7_SRST 0x80
+
+static uint8_t s_regs[2][256];
+static bool s_loaded;
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void power_on_values(void) {
+  uint8_t bank = s_regs[0][REG_BANK_SEL];
+  memset(s_regs, 0, sizeof(s_regs));
+  s_regs[BANK_SENSOR][0x0A] = 0x26;  // PID
+  s_regs[BANK_SENSOR][0x0B] = 0x42;  // VER
+  s_regs[BANK_SENSOR][0x1C] = 0x7F;  // MIDH
+  s_regs[BANK_SENSOR][0x1D] = 0xA2;  // MIDL
+  // The driver caches the selected bank across resets, so keep it.
+  s_regs[0][REG_BANK_SEL] = bank;
+  s_regs[1][REG_BANK_SEL] = bank;
+  s_loaded = true;
+}
+
+int SCCB_Init(int pin_sda, int pin_scl) {
+  (void)pin_sda;
+  (void)pin_scl;
+  pthread_mutex_lock(&s_lock);
+  if (!s_loaded) {
+    power_on_values();
+  }
+  pthread_mutex_unlock(&s_lock);
+  return ESP_OK;
+}
+
+int SCCB_Use_Port(int sccb_i2c_port) {
+  (void)sccb_i2c_port;
+  return SCCB_Init(-1, -1);
+}
+
+int SCCB_Deinit(void) {
+  return ESP_OK;
+}
+
+int SCCB_Probe(uint8_t slv_addr) {
+  return slv_addr == OV2640_ADDR ? ESP_OK : ESP_FAIL;
+}
+
+uint8_t SCCB_Read(uint8_t slv_addr, uint8_t reg) {
+  if (slv_addr != OV2640_ADDR) {
+    return 0xFF;
+  }
+  pthread_mutex_lock(&s_lock);
+  uint8_t bank = s_regs[0][REG_BANK_SEL] & 1U;
+  uint8_t v = s_regs[bank][reg];
+  pthread_mutex_unlock(&s_lock);
+  return v;
+}
+
+int SCCB_Write(uint8_t slv_addr, uint8_t reg, uint8_t data) {
+  if (slv_addr != OV2640_ADDR) {
+    return ESP_FAIL;
+  }
+  bool reset = false;
+  pthread_mutex_lock(&s_lock);
+  if (reg == REG_BANK_SEL) {
+    s_regs[0][reg] = data;
+    s_regs[1][reg] = data;
+  } else {
+    uint8_t bank = s_regs[0][REG_BANK_SEL] & 1U;
+    s_regs[bank][reg] = data;
+    if (bank == BANK_SENSOR && reg == REG_COM7 && (data & COM7_SRST)) {
+      power_on_values();
+      reset = true;
+    }
+  }
+  pthread_mutex_unlock(&s_lock);
+  if (reset) {
+    cam_sim_sensor_reset();
+  }
+  return ESP_OK;
+}
+
+// 16-bit register sensors are not simulated.
+uint8_t SCCB_Read16(uint8_t slv_addr, uint16_t reg) {
+  (void)slv_addr;
+  (void)reg;
+  return 0xFF;
+}
+
+int SCCB_Write16(uint8_t slv_addr, uint16_t reg, uint8_t data) {
+  (void)slv_addr;
+  (void)reg;
+  (void)data;
+  return ESP_FAIL;
+}
+
+uint16_t SCCB_Read_Addr16_Val16(uint8_t slv_addr, uint16_t reg) {
+  (void)slv_addr;
+  (void)reg;
+  return 0xFFFF;
+}
+
+int SCCB_Write_Addr16_Val16(uint8_t slv_addr, uint16_t reg, uint16_t data) {
+  (void)slv_addr;
+  (void)reg;
+  (void)data;
+  return ESP_FAIL;
+}
+
+esp_err_t xclk_timer_conf(int ledc_timer, int xclk_freq_hz) {
+  (void)ledc_timer;
+  return xclk_freq_hz > 0 ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t camera_enable_out_clock(const camera_config_t *config) {
+  (void)config;
+  return ESP_OK;
+}
+
+void camera_disable_out_clock(void) {
+}
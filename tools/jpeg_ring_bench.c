@@ -0,0 +1,159 @@
+// Measures the firmware's pre-trigger JPEG ring on Linux: insertion and
+// eviction throughput for mixed frame sizes, against a malloc-per-frame FIFO
+// holding the same byte budget.
+//
+// Build from the repository root:
+//   cc -O2 -o jpeg_ring_bench tools/jpeg_ring_bench.c
+//      MVP/components/vision_pipeline/jpeg_ring.c
+//      -IMVP/components/vision_pipeline/include
+//
+// Usage:
+//   jpeg_ring_bench [--frames N] [--arena-kb KB]
+//
+// Frame sizes are drawn from per-resolution ranges typical of OV2640 JPEGs at
+// quality 12 (QVGA ~4-12 kB up to UXGA ~90-220 kB). Throughput is one core;
+// the device copies from PSRAM to PSRAM, so expect it to be memory-bound.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "jpeg_ring.h"
+
+typedef struct {
+  const char *name;
+  size_t min_bytes;
+  size_t max_bytes;
+} size_mix_t;
+
+static const size_mix_t k_mixes[] = {
+    {"QVGA", 4000, 12000},
+    {"VGA", 12000, 35000},
+    {"SVGA", 20000, 60000},
+    {"UXGA", 90000, 220000},
+    {"mixed", 4000, 220000},
+};
+
+typedef struct {
+  void *data;
+  size_t len;
+} heap_frame_t;
+
+static double now_s(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint32_t lcg(uint32_t *state) {
+  *state = *state * 1664525U + 1013904223U;
+  return *state >> 8;
+}
+
+static void make_sizes(size_t *sizes, size_t n, const size_mix_t *mix) {
+  uint32_t state = 12345U;
+  for (size_t i = 0; i < n; i++) {
+    sizes[i] = mix->min_bytes + lcg(&state) % (mix->max_bytes - mix->min_bytes + 1);
+  }
+}
+
+// Baseline: malloc each frame, free the oldest while over the byte budget.
+static double run_heap(const uint8_t *src, const size_t *sizes, size_t n, size_t budget, size_t max_frames,
+                       uint32_t *evicted) {
+  heap_frame_t *q = calloc(max_frames, sizeof(*q));
+  size_t first = 0;
+  size_t count = 0;
+  size_t used = 0;
+  *evicted = 0;
+  double t0 = now_s();
+  for (size_t i = 0; i < n; i++) {
+    while (count > 0 && (used + sizes[i] > budget || count == max_frames)) {
+      used -= q[first].len;
+      free(q[first].data);
+      first = (first + 1) % max_frames;
+      count--;
+      (*evicted)++;
+    }
+    heap_frame_t *f = &q[(first + count) % max_frames];
+    f->data = malloc(sizes[i]);
+    memcpy(f->data, src, sizes[i]);
+    f->len = sizes[i];
+    used += sizes[i];
+    count++;
+  }
+  double dt = now_s() - t0;
+  for (size_t i = 0; i < count; i++) {
+    free(q[(first + i) % max_frames].data);
+  }
+  free(q);
+  return dt;
+}
+
+int main(int argc, char **argv) {
+  size_t frames = 200000;
+  size_t arena_kb = 2048;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+      frames = (size_t)atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--arena-kb") && i + 1 < argc) {
+      arena_kb = (size_t)atol(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--frames N] [--arena-kb KB]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  const size_t max_frames = 256;
+  size_t arena_bytes = arena_kb * 1024U;
+  uint32_t *arena = malloc(arena_bytes);
+  jpeg_ring_slot_t *slots = calloc(max_frames, sizeof(*slots));
+  uint8_t *src = malloc(k_mixes[3].max_bytes);
+  size_t *sizes = malloc(frames * sizeof(*sizes));
+  if (!arena || !slots || !src || !sizes) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+  memset(src, 0xA5, k_mixes[3].max_bytes);
+
+  printf("arena %zu kB, %zu slots, %zu frames per run\n", arena_kb, max_frames, frames);
+  printf("%-6s %12s %10s %10s %8s %14s %10s\n", "mix", "ring fr/s", "ring MB/s", "evict/s", "held",
+         "malloc fr/s", "speedup");
+  for (size_t m = 0; m < sizeof(k_mixes) / sizeof(k_mixes[0]); m++) {
+    make_sizes(sizes, frames, &k_mixes[m]);
+    size_t bytes = 0;
+    for (size_t i = 0; i < frames; i++) {
+      bytes += sizes[i];
+    }
+
+    jpeg_ring_t ring;
+    if (!jpeg_ring_init(&ring, arena, arena_bytes, slots, max_frames)) {
+      fprintf(stderr, "jpeg_ring_init failed\n");
+      return 1;
+    }
+    double t0 = now_s();
+    size_t held = 0;
+    for (size_t i = 0; i < frames; i++) {
+      if (!jpeg_ring_push(&ring, src, sizes[i], (int64_t)i)) {
+        fprintf(stderr, "push of %zu bytes failed\n", sizes[i]);
+        return 1;
+      }
+      held += jpeg_ring_count(&ring);
+    }
+    double ring_s = now_s() - t0;
+
+    uint32_t heap_evicted = 0;
+    double heap_s = run_heap(src, sizes, frames, arena_bytes, max_frames, &heap_evicted);
+
+    printf("%-6s %12.0f %10.0f %10.0f %8.1f %14.0f %9.2fx\n", k_mixes[m].name, (double)frames / ring_s,
+           (double)bytes / ring_s / 1e6, (double)ring.stats.evicted / ring_s, (double)held / (double)frames,
+           (double)frames / heap_s, heap_s / ring_s);
+  }
+
+  free(sizes);
+  free(src);
+  free(slots);
+  free(arena);
+  return 0;
+}
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Generates a deterministic synthetic WAV corpus for audio_detect_replay.
+
+Each file is 16 kHz mono PCM16 with a known number of events; manifest.csv
+lists them as "file.wav,expected_events". Real field recordings can be added
+to the same directory and manifest alongside these.
+
+    python3 tools/make_audio_corpus.py /tmp/audio_corpus
+    ./audio_detect_replay --manifest /tmp/audio_corpus/manifest.csv
+"""
+import argparse
+import math
+import random
+import struct
+import wave
+from pathlib import Path
+
+RATE = 16000
+
+
+def clamp16(v: float) -> int:
+    return max(-32768, min(32767, int(round(v))))
+
+
+def white(rng: random.Random, n: int, amp: float) -> list:
+    return [rng.gauss(0.0, amp) for _ in range(n)]
+
+
+def wind(rng: random.Random, n: int, amp: float, gust_hz: float = 0.08) -> list:
+    """Low-passed noise with slow gusts, the case the old threshold failed on."""
+    out = []
+    y = 0.0
+    for i in range(n):
+        y += 0.02 * (rng.gauss(0.0, 1.0) - y)
+        gust = 0.55 + 0.45 * math.sin(2 * math.pi * gust_hz * i / RATE)
+        out.append(y * amp * 7.0 * gust)
+    return out
+
+
+def add_chirps(buf: list, times_s: list, amp: float, dur_s: float = 0.3) -> None:
+    n = int(dur_s * RATE)
+    for t in times_s:
+        start = int(t * RATE)
+        phase = 0.0
+        for i in range(n):
+            if start + i >= len(buf):
+                break
+            f = 2000.0 + 2000.0 * i / n
+            phase += 2 * math.pi * f / RATE
+            env = math.sin(math.pi * i / n)
+            buf[start + i] += amp * env * math.sin(phase)
+
+
+def write_wav(path: Path, samples: list) -> None:
+    with wave.open(str(path), "wb") as w:
+        w.setnchannels(1)
+        w.setsampwidth(2)
+        w.setframerate(RATE)
+        w.writeframes(b"".join(struct.pack("<h", clamp16(s)) for s in samples))
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("out_dir", type=Path)
+    parser.add_argument("--seconds", type=float, default=60.0)
+    args = parser.parse_args()
+
+    args.out_dir.mkdir(parents=True, exist_ok=True)
+    rng = random.Random(1234)
+    n = int(args.seconds * RATE)
+    events = [5.0 + i * (args.seconds - 10.0) / 5 for i in range(5)]
+    cases = []
+
+    quiet = white(rng, n, 60.0)
+    cases.append(("quiet.wav", quiet, 0))
+
+    dc = [s + 4000.0 for s in white(rng, n, 80.0)]
+    cases.append(("dc_offset.wav", dc, 0))
+
+    windy = wind(rng, n, 900.0)
+    cases.append(("wind.wav", windy, 0))
+
+    birds = white(rng, n, 60.0)
+    add_chirps(birds, events, 4000.0)
+    cases.append(("birds_quiet.wav", birds, len(events)))
+
+    wind_birds = wind(rng, n, 900.0)
+    add_chirps(wind_birds, events[::2], 12000.0)
+    cases.append(("birds_wind.wav", wind_birds, len(events[::2])))
+
+    with open(args.out_dir / "manifest.csv", "w") as m:
+        m.write("# file,expected_events\n")
+        for name, samples, expected in cases:
+            write_wav(args.out_dir / name, samples)
+            m.write(f"{name},{expected}\n")
+            print(f"wrote {name} ({expected} events)")
+
+
+if __name__ == "__main__":
+    main()
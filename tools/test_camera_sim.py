@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""Capture path checks and benchmarks on the host camera simulator.
+
+Builds the unmodified esp32_camera driver (cam_hal.c, esp_camera.c,
+ov2640.c) and bsp_camera against tools/camera_sim: IDF shims, a simulated
+ll_cam target that plays frames from test/pictures through the real DMA
+event sequence, and an OV2640 on a simulated SCCB bus. Then runs
+camera_sim_check (byte-exact capture, injected frame and DMA faults, the
+three recovery tiers, profile switches, raw formats, PSRAM DMA policy and
+path counters) and, with --bench, camera_sim_bench (SOI/EOI probe cost per
+frame size, cam_take throughput and per-path copy and cache sync time).
+
+Run from the repository root:
+
+    python3 tools/test_camera_sim.py [--bench] [--quick] [--no-sanitize]
+"""
+
+import argparse
+import os
+import subprocess
+import tempfile
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+SIM = ROOT / "tools" / "camera_sim"
+CAM = ROOT / "MVP" / "components" / "esp32_camera"
+BSP = ROOT / "MVP" / "components" / "bsp_camera"
+PICTURES = CAM / "test" / "pictures"
+
+DRIVER = [CAM / "driver" / "esp_camera.c", CAM / "driver" / "jpeg_marker.c", CAM / "driver" / "sensor.c",
+          CAM / "sensors" / "ov2640.c"]
+HOST = [SIM / "idf_host.c", SIM / "ll_cam_sim.c", SIM / "sccb_sim.c"]
+INCLUDES = [
+    SIM, SIM / "idf", CAM / "driver" / "include", CAM / "driver" / "private_include",
+    CAM / "sensors" / "private_include", CAM / "target" / "private_include", CAM / "conversions" / "include",
+    BSP / "include",
+]
+# The vendored driver prints uint32_t with %u and casts pointers to 32-bit
+# integers, both fine on the target and noisy on a 64-bit host.
+CFLAGS = ["-Wall", "-Wno-format", "-Wno-pointer-to-int-cast"]
+
+
+def check_sources() -> list:
+    return [SIM / "camera_sim_check.c", CAM / "driver" / "cam_hal.c", *DRIVER,
+            BSP / "bsp_camera.c", BSP / "camera_recovery.c", BSP / "jpeg_quality.c", *HOST]
+
+
+def bench_sources() -> list:
+    # camera_sim_bench.c includes cam_hal.c to reach its static probes.
+    return [SIM / "camera_sim_bench.c", *DRIVER, *HOST]
+
+
+def compile_cmd(exe: Path, sources: list, flags: list) -> list:
+    return [os.environ.get("CC", "cc"), *flags, *CFLAGS, "-o", str(exe), *map(str, sources),
+            *(f"-I{d}" for d in INCLUDES), f"-I{CAM / 'driver'}", "-lpthread"]
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--bench", action="store_true", help="also run camera_sim_bench")
+    parser.add_argument("--quick", action="store_true", help="shorter benchmark runs")
+    parser.add_argument("--no-sanitize", action="store_true", help="build the checks without ASan/UBSan")
+    parser.add_argument("--only", help="run a single check scenario")
+    parser.add_argument("--print-build", action="store_true", help="print the compiler commands and exit")
+    args = parser.parse_args()
+
+    check_flags = ["-g", "-O1"] if args.no_sanitize else ["-g", "-O1", "-fsanitize=address,undefined"]
+    with tempfile.TemporaryDirectory() as tmp:
+        check_exe = Path(tmp) / "camera_sim_check"
+        bench_exe = Path(tmp) / "camera_sim_bench"
+        check_cmd = compile_cmd(check_exe, check_sources(), check_flags)
+        bench_cmd = compile_cmd(bench_exe, bench_sources(), ["-O2"])
+        if args.print_build:
+            print(" ".join(check_cmd))
+            print(" ".join(bench_cmd))
+            return 0
+
+        subprocess.run(check_cmd, check=True)
+        run = [str(check_exe), "--pictures", str(PICTURES)]
+        if args.only:
+            run += ["--only", args.only]
+        status = subprocess.run(run).returncode
+        if args.bench:
+            subprocess.run(bench_cmd, check=True)
+            subprocess.run([str(bench_exe), *(["--quick"] if args.quick else [])], check=True)
+    return 1 if status else 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
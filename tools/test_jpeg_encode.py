@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""JPEG encoder checks and benchmark on the host.
+
+Builds the esp32_camera conversions (to_jpg.cpp, jpge.cpp, line_conv.c,
+yuv.c) against the camera simulator's IDF shims, where FreeRTOS tasks are
+POSIX threads, and runs four programs from tools/camera_sim:
+
+- line_conv_bench: the line colour conversion kernels, checked bit-exact
+  against the per-pixel code they replaced, and their cycles per pixel;
+- jpeg_encode_bench: fmt2jpg_cb() with 1, 2 and N strip workers on RGB565
+  and YUV422 frames from QVGA to UXGA. Every output is decoded with libjpeg;
+  split encodes must decode to the serial encode's pixels;
+- jpge_corpus_bench: the encoder core's throughput in MB/s on the pictures
+  in test/pictures, in every chroma mode and at several qualities, and its
+  PSNR against libjpeg encoding with the same tables (must be on par);
+- jpge_stress: fmt2jpg_cb() called from several threads at once over many
+  formats, sizes and qualities; every output must match the same encode run
+  alone. Built with ThreadSanitizer when the compiler has it, so a race in
+  the encoder fails the run even if the bytes come out right.
+
+Needs libjpeg headers (libjpeg-dev or libjpeg-turbo). Run from the
+repository root:
+
+    python3 tools/test_jpeg_encode.py [--quick] [--workers N] [--no-sanitize]
+"""
+
+import argparse
+import os
+import subprocess
+import tempfile
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+SIM = ROOT / "tools" / "camera_sim"
+CAM = ROOT / "MVP" / "components" / "esp32_camera"
+CONV = CAM / "conversions"
+PICTURES = CAM / "test" / "pictures"
+
+ENCODER = [CONV / "to_jpg.cpp", CONV / "jpge.cpp", CONV / "line_conv.c", CONV / "yuv.c", SIM / "idf_host.c"]
+KERNELS = [CONV / "line_conv.c", CONV / "yuv.c"]
+INCLUDES = [SIM, SIM / "idf", CAM / "driver" / "include", CONV / "include", CONV / "private_include"]
+CFLAGS = ["-Wall", "-Wno-format"]
+
+
+def build(tmp: Path, exe: Path, sources: list, flags: list, libs: list, dry_run: bool) -> bool:
+    objects = []
+    commands = []
+    for src in sources:
+        obj = tmp / f"{exe.name}-{src.name}.o"
+        cpp = src.suffix == ".cpp"
+        compiler = os.environ.get("CXX", "c++") if cpp else os.environ.get("CC", "cc")
+        commands.append([compiler, *flags, *CFLAGS, "-c", "-o", str(obj), str(src), *(f"-I{d}" for d in INCLUDES)])
+        objects.append(str(obj))
+    commands.append([os.environ.get("CXX", "c++"), *flags, "-o", str(exe), *objects, *libs])
+    for cmd in commands:
+        if dry_run:
+            print(" ".join(cmd))
+        else:
+            subprocess.run(cmd, check=True)
+    return not dry_run
+
+
+def compiler_accepts(tmp: Path, flags: list) -> bool:
+    src = tmp / "probe.c"
+    src.write_text("int main(void) { return 0; }\n")
+    cmd = [os.environ.get("CC", "cc"), *flags, "-o", str(tmp / "probe"), str(src)]
+    return subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL).returncode == 0
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--quick", action="store_true", help="shorter timing runs")
+    parser.add_argument("--workers", type=int, default=4, help="largest worker count (2-8)")
+    parser.add_argument("--no-sanitize", action="store_true", help="build without ASan/UBSan (for timing)")
+    parser.add_argument("--print-build", action="store_true", help="print the compiler commands and exit")
+    args = parser.parse_args()
+
+    # jpge's DCT left-shifts negative coefficients; GCC defines that, so
+    # UBSan's shift-base check is only noise here.
+    sanitize = ["-fsanitize=address,undefined", "-fno-sanitize=shift-base"]
+    flags = ["-g", "-O2"] if args.no_sanitize else ["-g", "-O1", *sanitize]
+    with tempfile.TemporaryDirectory() as tmp:
+        kernels_exe = Path(tmp) / "line_conv_bench"
+        encode_exe = Path(tmp) / "jpeg_encode_bench"
+        corpus_exe = Path(tmp) / "jpge_corpus_bench"
+        stress_exe = Path(tmp) / "jpge_stress"
+        # The kernel checks are exhaustive and the timings need -O2; no sanitizers.
+        built = build(Path(tmp), kernels_exe, [SIM / "line_conv_bench.c", *KERNELS], ["-O2"], ["-lm"], args.print_build)
+        built = build(Path(tmp), encode_exe, [SIM / "jpeg_encode_bench.c", *ENCODER], flags, ["-ljpeg", "-lpthread", "-lm"],
+                      args.print_build) and built
+        built = build(Path(tmp), corpus_exe, [SIM / "jpge_corpus_bench.c", *ENCODER], flags, ["-ljpeg", "-lpthread", "-lm"],
+                      args.print_build) and built
+        # ThreadSanitizer can't be combined with ASan, so the stress test gets its own build.
+        tsan = ["-g", "-O1", "-fsanitize=thread"]
+        if args.no_sanitize or not compiler_accepts(Path(tmp), tsan):
+            tsan = flags
+        built = build(Path(tmp), stress_exe, [SIM / "jpge_stress.c", *ENCODER], tsan, ["-ljpeg", "-lpthread", "-lm"],
+                      args.print_build) and built
+        if not built:
+            return 0
+        quick = ["--quick"] if args.quick else []
+        if subprocess.run([str(kernels_exe), *quick]).returncode:
+            return 1
+        print()
+        run = [str(encode_exe), "--pictures", str(PICTURES), "--workers", str(max(args.workers, 2)), *quick]
+        if subprocess.run(run).returncode:
+            return 1
+        print()
+        if subprocess.run([str(corpus_exe), "--pictures", str(PICTURES), *quick]).returncode:
+            return 1
+        print()
+        rounds = ["--rounds", "1"] if args.quick else []
+        return subprocess.run([str(stress_exe), "--pictures", str(PICTURES), *rounds]).returncode
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
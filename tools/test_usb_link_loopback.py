@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Loopback test for the USB link framing over a pseudo-terminal.
+
+Builds tools/usb_link_loopback.c against the firmware's usb_frame.c, runs it
+on the slave side of a pty and decodes the master side with usb_frame.py,
+the same decoder usb_image_monitor.py uses. Checks that every transfer
+arrives byte-exact, that log lines pass through untouched, that a corrupted
+frame is rejected without losing the transfers after it, and compares wire
+size and throughput against the legacy base64 text encoding.
+
+Run from the repository root:
+
+    python3 tools/test_usb_link_loopback.py [--count N] [--size BYTES]
+"""
+
+import argparse
+import base64
+import os
+import select
+import subprocess
+import tempfile
+import time
+import tty
+from pathlib import Path
+
+from usb_frame import TYPE_IMAGE, FrameDecoder
+
+ROOT = Path(__file__).resolve().parent.parent
+LINK_DIR = ROOT / "MVP" / "components" / "usb_link"
+
+# Just enough of esp_err.h for usb_frame.c to build on the host.
+ESP_ERR_SHIM = """#pragma once
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_SIZE 0x104
+"""
+
+
+def payload(index: int, size: int) -> bytes:
+    """Mirrors fill_payload() in usb_link_loopback.c."""
+    out = bytearray(size)
+    x = index + 1
+    for i in range(size):
+        x = (x * 1664525 + 1013904223) & 0xFFFFFFFF
+        out[i] = x >> 24
+    return bytes(out)
+
+
+def build(work: Path) -> Path:
+    (work / "esp_err.h").write_text(ESP_ERR_SHIM)
+    exe = work / "usb_link_loopback"
+    cmd = [
+        os.environ.get("CC", "cc"), "-O2", "-Wall", "-Wextra", "-o", str(exe),
+        str(ROOT / "tools" / "usb_link_loopback.c"), str(LINK_DIR / "usb_frame.c"),
+        f"-I{LINK_DIR / 'include'}", f"-I{work}",
+    ]
+    subprocess.run(cmd, check=True)
+    return exe
+
+
+def run(exe: Path, extra: list) -> tuple:
+    """Runs the sender on a raw pty; returns (bytes received, seconds)."""
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    start = time.perf_counter()
+    proc = subprocess.Popen([str(exe), *extra, os.ttyname(slave)])
+    received = bytearray()
+    try:
+        while True:
+            ready, _, _ = select.select([master], [], [], 0.2)
+            if ready:
+                received += os.read(master, 65536)
+            elif proc.poll() is not None:
+                break
+        elapsed = time.perf_counter() - start
+    finally:
+        os.close(master)
+        os.close(slave)
+    if proc.wait() != 0:
+        raise SystemExit(f"sender exited with {proc.returncode}")
+    return bytes(received), elapsed
+
+
+def decode_legacy(stream: bytes) -> list:
+    """The old monitor's parse: base64 between BEGIN/END marker lines."""
+    images, block = [], None
+    for line in stream.split(b"\n"):
+        if line.startswith(b"[USB_IMAGE_BEGIN]"):
+            block = []
+        elif line.startswith(b"[USB_IMAGE_END]") and block is not None:
+            images.append(base64.b64decode(b"".join(block)))
+            block = None
+        elif block is not None:
+            block.append(line.strip())
+    return images
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--count", type=int, default=16)
+    parser.add_argument("--size", type=int, default=60000, help="bytes per transfer (a typical SVGA JPEG)")
+    args = parser.parse_args()
+    expected = [payload(i, args.size) for i in range(args.count)]
+    common = ["--count", str(args.count), "--size", str(args.size)]
+    failures = 0
+
+    def check(cond: bool, what: str) -> None:
+        nonlocal failures
+        print(f"{'PASS' if cond else 'FAIL'}: {what}")
+        failures += 0 if cond else 1
+
+    with tempfile.TemporaryDirectory() as tmp:
+        exe = build(Path(tmp))
+
+        stream, binary_s = run(exe, common)
+        decoder = FrameDecoder()
+        events = decoder.feed(stream) + decoder.flush_text()
+        transfers = [e[1] for e in events if e[0] == "transfer"]
+        lines = [e[1] for e in events if e[0] == "text"]
+        check([t.data for t in transfers] == expected, f"{args.count} transfers byte-exact")
+        check(all(t.kind == TYPE_IMAGE for t in transfers), "transfer type preserved")
+        check([t.seq for t in transfers] == list(range(args.count)), "sequence numbers consecutive")
+        check(len(lines) == args.count + 1 and all("SYS_VISION" in l for l in lines), "log lines pass through")
+        check(decoder.crc_errors == 0 and decoder.dropped_transfers == 0, "no CRC errors on a clean link")
+
+        corrupt = args.count // 2
+        bad_stream, _ = run(exe, common + ["--corrupt", str(corrupt)])
+        decoder = FrameDecoder()
+        events = decoder.feed(bad_stream) + decoder.flush_text()
+        got = [e[1].data for e in events if e[0] == "transfer"]
+        check(decoder.crc_errors >= 1, "corrupted frame fails CRC")
+        check(got == expected[:corrupt] + expected[corrupt + 1 :], "only the corrupted transfer is lost")
+
+        legacy, legacy_s = run(exe, common + ["--base64"])
+        check(decode_legacy(legacy) == expected, "legacy base64 stream decodes (baseline sanity)")
+
+    payload_bytes = args.count * args.size
+    wire_ratio = len(legacy) / len(stream)
+    print(
+        f"wire bytes: binary {len(stream)} ({len(stream) / payload_bytes:.4f}x payload), "
+        f"base64 {len(legacy)} ({len(legacy) / payload_bytes:.4f}x payload)"
+    )
+    print(
+        f"pty throughput: binary {payload_bytes / binary_s / 1024:.0f} kB/s, "
+        f"base64 {payload_bytes / legacy_s / 1024:.0f} kB/s (payload bytes per second)"
+    )
+    # On a byte-rate-limited link (USB-Serial-JTAG CDC) payload throughput
+    # scales with wire efficiency, which is what the 1.33x target refers to.
+    check(wire_ratio >= 1.33, f"binary framing moves {wire_ratio:.2f}x more payload per wire byte than base64")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
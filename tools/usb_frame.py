@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Host side of the firmware's binary USB framing (components/usb_link).
+
+Frame layout (little endian), see usb_frame.h:
+
+    magic 0xA5 0x5A | ver<<4|type | flags | seq u16 | len u16 |
+    offset u32 | total u32 | payload[len] | crc32 u32
+
+The CRC is zlib's CRC-32 over header and payload. Anything on the serial
+stream that is not a valid frame is passed through as text lines, so ESP_LOG
+output keeps working alongside transfers.
+"""
+
+import struct
+import zlib
+from dataclasses import dataclass
+from typing import Dict, List, Optional, Tuple, Union
+
+MAGIC = b"\xa5\x5a"
+VERSION = 1
+HEADER = struct.Struct("<2sBBHHII")
+TRAILER = struct.Struct("<I")
+MAX_PAYLOAD = 16384
+
+TYPE_IMAGE = 1
+TYPE_AUDIO = 2
+TYPE_TELEMETRY = 3
+TYPE_NAMES = {TYPE_IMAGE: "IMAGE", TYPE_AUDIO: "AUDIO", TYPE_TELEMETRY: "TELEMETRY"}
+
+FLAG_FIRST = 0x01
+FLAG_LAST = 0x02
+
+
+@dataclass
+class Transfer:
+    kind: int
+    seq: int
+    data: bytes
+
+    @property
+    def name(self) -> str:
+        return TYPE_NAMES.get(self.kind, f"TYPE{self.kind}")
+
+
+Event = Tuple[str, Union[str, Transfer]]
+
+
+def encode_transfer(kind: int, seq: int, data: bytes, chunk: int = MAX_PAYLOAD) -> bytes:
+    """Encodes one transfer exactly as usb_frame_send() does."""
+    out = bytearray()
+    off = 0
+    while True:
+        n = min(chunk, len(data) - off)
+        flags = (FLAG_FIRST if off == 0 else 0) | (FLAG_LAST if off + n == len(data) else 0)
+        header = HEADER.pack(MAGIC, (VERSION << 4) | kind, flags, seq & 0xFFFF, n, off, len(data))
+        payload = data[off : off + n]
+        out += header + payload + TRAILER.pack(zlib.crc32(header + payload))
+        off += n
+        if off >= len(data):
+            return bytes(out)
+
+
+class FrameDecoder:
+    """Incremental decoder: feed() raw serial bytes, get text lines and
+    completed transfers back in stream order."""
+
+    def __init__(self) -> None:
+        self._buf = bytearray()
+        self._text = bytearray()
+        self._partial: Dict[int, Tuple[int, int, bytearray]] = {}
+        self.frames = 0
+        self.crc_errors = 0
+        self.dropped_transfers = 0
+
+    def feed(self, data: bytes) -> List[Event]:
+        events: List[Event] = []
+        self._buf += data
+        buf = self._buf
+        while buf:
+            i = buf.find(MAGIC)
+            if i < 0:
+                # Keep a trailing first magic byte; the second may be in flight.
+                keep = 1 if buf[-1] == MAGIC[0] else 0
+                self._add_text(buf[: len(buf) - keep], events)
+                del buf[: len(buf) - keep]
+                break
+            if i > 0:
+                self._add_text(buf[:i], events)
+                del buf[:i]
+            if len(buf) < HEADER.size:
+                break
+
+            _, ver_type, flags, seq, length, offset, total = HEADER.unpack_from(buf)
+            if (ver_type >> 4) != VERSION or length > MAX_PAYLOAD or offset + length > total:
+                self._add_text(buf[:1], events)
+                del buf[:1]
+                continue
+            frame_len = HEADER.size + length + TRAILER.size
+            if len(buf) < frame_len:
+                break
+            (crc,) = TRAILER.unpack_from(buf, HEADER.size + length)
+            if crc != zlib.crc32(bytes(buf[: HEADER.size + length])):
+                self.crc_errors += 1
+                self._add_text(buf[:1], events)
+                del buf[:1]
+                continue
+
+            self.frames += 1
+            payload = bytes(buf[HEADER.size : HEADER.size + length])
+            del buf[:frame_len]
+            done = self._assemble(ver_type & 0x0F, flags, seq, offset, total, payload, events)
+            if done:
+                events.append(("transfer", done))
+        return events
+
+    def flush_text(self) -> List[Event]:
+        events: List[Event] = []
+        if self._text:
+            events.append(("text", self._text.decode("utf-8", errors="replace").rstrip("\r")))
+            self._text.clear()
+        return events
+
+    def _add_text(self, data: bytes, events: List[Event]) -> None:
+        self._text += data
+        while True:
+            nl = self._text.find(b"\n")
+            if nl < 0:
+                return
+            line = self._text[:nl].decode("utf-8", errors="replace").rstrip("\r")
+            del self._text[: nl + 1]
+            events.append(("text", line))
+
+    def _assemble(
+        self, kind: int, flags: int, seq: int, offset: int, total: int, payload: bytes, events: List[Event]
+    ) -> Optional[Transfer]:
+        if flags & FLAG_FIRST:
+            if kind in self._partial:
+                self.dropped_transfers += 1
+                events.append(("error", f"{TYPE_NAMES.get(kind, kind)} seq {self._partial[kind][0]} incomplete"))
+            self._partial[kind] = (seq, total, bytearray())
+        part = self._partial.get(kind)
+        if part is None or part[0] != seq or part[1] != total or len(part[2]) != offset:
+            if part is not None:
+                del self._partial[kind]
+            self.dropped_transfers += 1
+            events.append(("error", f"{TYPE_NAMES.get(kind, kind)} seq {seq}: frame at {offset} out of order"))
+            return None
+        part[2].extend(payload)
+        if flags & FLAG_LAST:
+            del self._partial[kind]
+            if len(part[2]) != total:
+                self.dropped_transfers += 1
+                events.append(("error", f"{TYPE_NAMES.get(kind, kind)} seq {seq}: short transfer"))
+                return None
+            return Transfer(kind, seq, bytes(part[2]))
+        return None
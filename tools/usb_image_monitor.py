@@ -1,9 +1,7 @@
 #!/usr/bin/env python3
 import argparse
-import base64
 import html
 import os
-import re
 import subprocess
 import sys
 import threading
@@ -18,10 +16,7 @@ except Exception:
     print("Install with: python3 -m pip install pyserial", file=sys.stderr)
     sys.exit(1)
 
-
-BEGIN_RE = re.compile(r"USB_(IMAGE|AUDIO)_BEGIN.*bytes=(\d+).*b64=(\d+)")
-END_RE = re.compile(r"USB_(IMAGE|AUDIO)_END")
-BASE64_RE = re.compile(r"[A-Za-z0-9+/=]+")
+from usb_frame import TYPE_AUDIO, TYPE_IMAGE, TYPE_TELEMETRY, FrameDecoder
 
 
 def open_image(path: Path) -> None:
@@ -213,7 +208,7 @@ setInterval(async () => {{
 
 
 def main() -> int:
-    parser = argparse.ArgumentParser(description="Serial monitor that decodes USB base64 images/audio")
+    parser = argparse.ArgumentParser(description="Serial monitor that decodes binary USB image/audio frames")
     parser.add_argument("--port", default="/dev/cu.usbmodem101")
     parser.add_argument("--baud", type=int, default=115200)
     parser.add_argument("--out", default="captures")
@@ -246,18 +241,13 @@ def main() -> int:
         if not args.no_open:
             open_url(url)
 
-    collecting = False
-    collecting_kind = ""
-    b64_chunks = []
-    expected_bytes = None
-    expected_b64 = None
+    decoder = FrameDecoder()
     latest_image_path = out_dir / "latest.jpg"
-    latest_audio_path = out_dir / "latest.wav"
     opened_latest = False
 
     while True:
         try:
-            raw = ser.readline()
+            raw = ser.read(max(1, ser.in_waiting))
         except Exception as exc:
             print(f"[serial] read error ({exc}), reconnecting...", file=sys.stderr)
             try:
@@ -265,89 +255,51 @@ def main() -> int:
             except Exception:
                 pass
             ser = open_serial()
-            collecting = False
-            collecting_kind = ""
-            b64_chunks = []
-            expected_bytes = None
-            expected_b64 = None
+            decoder = FrameDecoder()
             continue
         if not raw:
             continue
 
-        line = raw.decode("utf-8", errors="replace").rstrip("\r\n")
-
-        if not collecting:
-            print(line)
-            m = BEGIN_RE.search(line)
-            if m:
-                collecting = True
-                collecting_kind = m.group(1)
-                b64_chunks = []
-                expected_bytes = int(m.group(2))
-                expected_b64 = int(m.group(3))
-            continue
-
-        m_end = END_RE.search(line)
-        if m_end:
-            if m_end.group(1) != collecting_kind:
-                print(f"[decode] mismatched end marker for {m_end.group(1)} while collecting {collecting_kind}", file=sys.stderr)
-                collecting = False
-                collecting_kind = ""
-                b64_chunks = []
-                expected_bytes = None
-                expected_b64 = None
+        for kind, item in decoder.feed(raw):
+            if kind == "text":
+                print(item)
                 continue
-
-            b64_data = "".join(b64_chunks)
-            try:
-                decoded = base64.b64decode(b64_data, validate=False)
-            except Exception as exc:
-                print(f"[decode] failed: {exc}", file=sys.stderr)
-                collecting = False
-                collecting_kind = ""
-                b64_chunks = []
+            if kind == "error":
+                print(f"[decode] {item}", file=sys.stderr)
                 continue
 
-            is_image = collecting_kind == "IMAGE"
-            suffix = "jpg" if is_image else "wav"
-            latest_path = latest_image_path if is_image else latest_audio_path
-            write_atomic(latest_path, decoded)
+            if item.kind == TYPE_TELEMETRY:
+                print(f"[telemetry] {item.data.decode('utf-8', errors='replace')}")
+                continue
+            if item.kind == TYPE_IMAGE:
+                suffix = "jpg"
+            elif item.kind == TYPE_AUDIO:
+                suffix = "flac" if item.data.startswith(b"fLaC") else "wav"
+            else:
+                print(f"[decode] ignoring {item.name} transfer ({len(item.data)} bytes)", file=sys.stderr)
+                continue
 
+            latest_path = out_dir / f"latest.{suffix}"
+            write_atomic(latest_path, item.data)
             ts_path = None
             if args.keep_all:
                 ts = int(time.time() * 1000)
-                ts_path = out_dir / f"{collecting_kind.lower()}_{ts}.{suffix}"
-                ts_path.write_bytes(decoded)
+                ts_path = out_dir / f"{item.name.lower()}_{ts}.{suffix}"
+                ts_path.write_bytes(item.data)
 
             print(
                 f"[saved] latest={latest_path}"
                 + (f" ts={ts_path}" if ts_path else "")
-                + " "
-                f"(decoded={len(decoded)} bytes, expected={expected_bytes}, b64_len={len(b64_data)}, expected_b64={expected_b64})"
+                + f" ({len(item.data)} bytes, seq={item.seq}, crc_errors={decoder.crc_errors})"
             )
 
-            if is_image and not args.no_open and not args.live_web:
+            if item.kind == TYPE_IMAGE and not args.no_open and not args.live_web:
                 if not opened_latest:
                     open_image(latest_image_path)
                     opened_latest = True
                 elif args.refresh_preview:
                     refresh_preview_document(latest_image_path)
 
-            collecting = False
-            collecting_kind = ""
-            b64_chunks = []
-            expected_bytes = None
-            expected_b64 = None
-            continue
-
-        # Keep only base64 content while in image block.
-        tokens = BASE64_RE.findall(line)
-        if tokens:
-            b64_chunks.extend(tokens)
-        else:
-            # Preserve non-base64 logs while suppressing large payload dumps.
-            print(line)
-
 
 if __name__ == "__main__":
     try:
@@ -0,0 +1,145 @@
+// Host stand-in for the firmware side of the USB link: streams synthetic
+// JPEG-sized payloads with the firmware's own usb_frame.c, interleaved with
+// log lines, to a file descriptor (a pty in test_usb_link_loopback.py).
+//
+// Build from the repository root:
+//   cc -O2 -o usb_link_loopback tools/usb_link_loopback.c
+//      MVP/components/usb_link/usb_frame.c
+//      -IMVP/components/usb_link/include -I<dir with an esp_err.h>
+//
+// Usage:
+//   usb_link_loopback [--base64] [--corrupt N] [--count N] [--size BYTES] PATH
+//
+// --base64 sends the legacy [USB_IMAGE_BEGIN] text encoding instead, for
+// throughput comparison. --corrupt N flips one payload bit in transfer N.
+// Payload i is bytes of lcg(seed = i + 1); the test regenerates them.
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "usb_frame.h"
+
+typedef struct {
+  int fd;
+  long corrupt_at;  // absolute byte to flip, -1 = none
+  long written;
+} fd_sink_t;
+
+static esp_err_t fd_write(void *ctx, const void *data, size_t len) {
+  fd_sink_t *sink = (fd_sink_t *)ctx;
+  const uint8_t *p = (const uint8_t *)data;
+  uint8_t flipped[USB_FRAME_MAX_PAYLOAD];
+  if (sink->corrupt_at >= sink->written && sink->corrupt_at < sink->written + (long)len && len <= sizeof(flipped)) {
+    memcpy(flipped, data, len);
+    flipped[sink->corrupt_at - sink->written] ^= 0x10;
+    p = flipped;
+  }
+  size_t off = 0;
+  while (off < len) {
+    ssize_t n = write(sink->fd, p + off, len - off);
+    if (n <= 0) {
+      return ESP_FAIL;
+    }
+    off += (size_t)n;
+  }
+  sink->written += (long)len;
+  return ESP_OK;
+}
+
+static void fill_payload(uint8_t *buf, size_t len, uint32_t seed) {
+  uint32_t x = seed;
+  for (size_t i = 0; i < len; i++) {
+    x = x * 1664525U + 1013904223U;
+    buf[i] = (uint8_t)(x >> 24);
+  }
+}
+
+static size_t base64_encode(const uint8_t *in, size_t len, char *out) {
+  static const char tbl[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  size_t o = 0;
+  for (size_t i = 0; i < len; i += 3) {
+    uint32_t v = (uint32_t)in[i] << 16;
+    if (i + 1 < len) {
+      v |= (uint32_t)in[i + 1] << 8;
+    }
+    if (i + 2 < len) {
+      v |= in[i + 2];
+    }
+    out[o++] = tbl[(v >> 18) & 63];
+    out[o++] = tbl[(v >> 12) & 63];
+    out[o++] = i + 1 < len ? tbl[(v >> 6) & 63] : '=';
+    out[o++] = i + 2 < len ? tbl[v & 63] : '=';
+  }
+  return o;
+}
+
+int main(int argc, char **argv) {
+  int count = 8;
+  size_t size = 60000;
+  int use_base64 = 0;
+  int corrupt = -1;
+  const char *path = NULL;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--base64")) {
+      use_base64 = 1;
+    } else if (!strcmp(argv[i], "--corrupt") && i + 1 < argc) {
+      corrupt = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+      count = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--size") && i + 1 < argc) {
+      size = (size_t)atol(argv[++i]);
+    } else {
+      path = argv[i];
+    }
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [--base64] [--corrupt N] [--count N] [--size BYTES] PATH\n", argv[0]);
+    return 2;
+  }
+
+  fd_sink_t sink = {.fd = open(path, O_WRONLY | O_NOCTTY), .corrupt_at = -1};
+  uint8_t *payload = malloc(size);
+  char *b64 = malloc(4 * ((size + 2) / 3) + 1);
+  if (sink.fd < 0 || !payload || !b64) {
+    perror(path);
+    return 1;
+  }
+  usb_frame_sender_t sender = {.write = fd_write, .ctx = &sink};
+
+  for (int t = 0; t < count; t++) {
+    char line[96];
+    int n = snprintf(line, sizeof(line), "I (%d) SYS_VISION: PIR trigger %d\n", 1000 + t, t);
+    if (fd_write(&sink, line, (size_t)n) != ESP_OK) {
+      return 1;
+    }
+    fill_payload(payload, size, (uint32_t)t + 1U);
+
+    if (use_base64) {
+      size_t out_len = base64_encode(payload, size, b64);
+      n = snprintf(line, sizeof(line), "[USB_IMAGE_BEGIN] bytes=%u b64=%u\n", (unsigned)size, (unsigned)out_len);
+      if (fd_write(&sink, line, (size_t)n) != ESP_OK || fd_write(&sink, b64, out_len) != ESP_OK ||
+          fd_write(&sink, "\n[USB_IMAGE_END]\n", 17) != ESP_OK) {
+        return 1;
+      }
+      continue;
+    }
+
+    if (t == corrupt) {
+      sink.corrupt_at = sink.written + USB_FRAME_HEADER_BYTES + (long)size / 3;
+    }
+    if (usb_frame_send(&sender, USB_FRAME_IMAGE, payload, size) != ESP_OK) {
+      return 1;
+    }
+  }
+  const char *done = "I (9999) SYS_VISION: loopback done\n";
+  fd_write(&sink, done, strlen(done));
+  close(sink.fd);
+  free(payload);
+  free(b64);
+  return 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+// WAV loader shared by the host tools in this directory.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  int16_t *pcm;
+  size_t samples;
+  uint32_t rate;
+} wav_data_t;
+
+static uint32_t get_le32(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t get_le16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// Loads the first channel of a PCM WAV (16/24/32-bit) as PCM16.
+static int load_wav(const char *path, wav_data_t *out) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return -1;
+  }
+
+  uint8_t hdr[12];
+  if (fread(hdr, 1, 12, f) != 12 || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+    fprintf(stderr, "%s: not a RIFF/WAVE file\n", path);
+    fclose(f);
+    return -1;
+  }
+
+  uint16_t channels = 0;
+  uint16_t bits = 0;
+  uint32_t rate = 0;
+  uint8_t chunk[8];
+  while (fread(chunk, 1, 8, f) == 8) {
+    uint32_t size = get_le32(chunk + 4);
+    if (memcmp(chunk, "fmt ", 4) == 0) {
+      uint8_t fmt[16];
+      if (size < 16 || fread(fmt, 1, 16, f) != 16) {
+        break;
+      }
+      channels = get_le16(fmt + 2);
+      rate = get_le32(fmt + 4);
+      bits = get_le16(fmt + 14);
+      fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+    } else if (memcmp(chunk, "data", 4) == 0) {
+      if (channels == 0 || (bits != 16 && bits != 24 && bits != 32)) {
+        break;
+      }
+      size_t frame_bytes = (size_t)channels * bits / 8;
+      uint8_t *raw = malloc(size);
+      size_t got = raw ? fread(raw, 1, size, f) : 0;
+      out->samples = got / frame_bytes;
+      out->pcm = malloc(out->samples * sizeof(int16_t) + 1);
+      if (!raw || !out->pcm) {
+        free(raw);
+        break;
+      }
+      for (size_t i = 0; i < out->samples; i++) {
+        const uint8_t *s = raw + i * frame_bytes;
+        out->pcm[i] = (int16_t)(s[bits / 8 - 2] | (s[bits / 8 - 1] << 8));
+      }
+      out->rate = rate;
+      free(raw);
+      fclose(f);
+      return 0;
+    } else {
+      fseek(f, (long)(size + (size & 1)), SEEK_CUR);
+    }
+  }
+
+  fprintf(stderr, "%s: unsupported or truncated WAV\n", path);
+  fclose(f);
+  return -1;
+}